@@ -25,7 +25,10 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 */
 
+#include "stdio.h"
+
 #include "HD3DO.h"
+#include "HD3DOMem.h"
 
 
 CCB *cel_Numbers[10];
@@ -43,16 +46,16 @@ void InitNumberCels(int count)
 	
 	CelNumberCount = count;
 	
-	cel_Numbers[0] = LoadCel("data/num0.cel", MEMTYPE_CEL);
-	cel_Numbers[1] = LoadCel("data/num1.cel", MEMTYPE_CEL);
-	cel_Numbers[2] = LoadCel("data/num2.cel", MEMTYPE_CEL);
-	cel_Numbers[3] = LoadCel("data/num3.cel", MEMTYPE_CEL);
-	cel_Numbers[4] = LoadCel("data/num4.cel", MEMTYPE_CEL);
-	cel_Numbers[5] = LoadCel("data/num5.cel", MEMTYPE_CEL);
-	cel_Numbers[6] = LoadCel("data/num6.cel", MEMTYPE_CEL);
-	cel_Numbers[7] = LoadCel("data/num7.cel", MEMTYPE_CEL);
-	cel_Numbers[8] = LoadCel("data/num8.cel", MEMTYPE_CEL);
-	cel_Numbers[9] = LoadCel("data/num9.cel", MEMTYPE_CEL);
+	cel_Numbers[0] = MemLoadCel(MEM_TAG_HUD, "data/num0.cel");
+	cel_Numbers[1] = MemLoadCel(MEM_TAG_HUD, "data/num1.cel");
+	cel_Numbers[2] = MemLoadCel(MEM_TAG_HUD, "data/num2.cel");
+	cel_Numbers[3] = MemLoadCel(MEM_TAG_HUD, "data/num3.cel");
+	cel_Numbers[4] = MemLoadCel(MEM_TAG_HUD, "data/num4.cel");
+	cel_Numbers[5] = MemLoadCel(MEM_TAG_HUD, "data/num5.cel");
+	cel_Numbers[6] = MemLoadCel(MEM_TAG_HUD, "data/num6.cel");
+	cel_Numbers[7] = MemLoadCel(MEM_TAG_HUD, "data/num7.cel");
+	cel_Numbers[8] = MemLoadCel(MEM_TAG_HUD, "data/num8.cel");
+	cel_Numbers[9] = MemLoadCel(MEM_TAG_HUD, "data/num9.cel");
 	
 	if (count > MAXNUMCOUNT) count = MAXNUMCOUNT; // Max allocated
 
@@ -60,7 +63,7 @@ void InitNumberCels(int count)
 	{
 		for (i = 0; i < 9; i++)
 		{
-			TrackedNumbers[x].cel_NumCels[i] = CloneCel(cel_Numbers[0], 0); // Just zero
+			TrackedNumbers[x].cel_NumCels[i] = MemCloneCel(MEM_TAG_HUD, cel_Numbers[0], 0); // Just zero
 			
 			ClearFlag(TrackedNumbers[x].cel_NumCels[i]->ccb_Flags, CCB_LAST);
 			SetFlag(TrackedNumbers[x].cel_NumCels[i]->ccb_Flags, CCB_SKIP);
@@ -102,9 +105,9 @@ void InitNumberCel(int idx, int x, int y, uint32 value, bool rightAlign)
 	SetCelNumbers(idx, value);
 }
 
-CCB *InitAndPositionCel(char *path, int x, int y)
+CCB *InitAndPositionCelAt(char *path, int x, int y, char *file, int line)
 {
-	CCB *cel = LoadCel(path, MEMTYPE_CEL);
+	CCB *cel = MemLoadCelAt(MEM_TAG_MENUS, path, file, line); // Only the transient overlays come through here
 	
 	PositionCel(cel, x, y);
 	
@@ -182,7 +185,7 @@ void ResetCelNumbers()
 
 void SetCelNumbers(int idx, uint32 value)
 {
-	char buffer[9]; // 999999999
+	char buffer[10]; // 999999999 and the terminator
 	int i, sLen, currVal;
 	
 	if (ValidAndReady(idx) == false) return;
@@ -256,14 +259,14 @@ void CleanupNumberCels()
 	
 	for (x = 0; x < 10; x++)
 	{
-		UnloadCel(cel_Numbers[x]);
+		MemUnloadCel(cel_Numbers[x]);
 	}
 	
 	for (x = 0; x < CelNumberCount; x++) // All initialized CELs
 	{
 		for (i = 0; i < 9; i++)
 		{
-			UnloadCel(TrackedNumbers[x].cel_NumCels[i]);
+			MemUnloadCel(TrackedNumbers[x].cel_NumCels[i]);
 		}
 	}
 }
@@ -62,8 +62,10 @@ typedef struct TrackedNumber
 } TrackedNumber;
 
 void InitNumberCels(int count); // Call this first
+void InitNumberCel(int idx, int x, int y, uint32 value, bool rightAlign);
 void SetCelNumbers(int idx, uint32 value);
-CCB *InitAndPositionCel(char *path, int x, int y);
+CCB *InitAndPositionCelAt(char *path, int x, int y, char *file, int line);
+#define InitAndPositionCel(path, x, y) InitAndPositionCelAt(path, x, y, __FILE__, __LINE__) // Leak reports name the caller
 void PositionLoadedCel(CCB *cel, int x, int y);
 void PositionCel(CCB *cel, int x, int y);
 void PositionCelColumn(CCB *cel, int x, int y, int xOffset, int yOffset);
@@ -0,0 +1,419 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Audio command ring and the thread that runs it, see HD3DOAudio.h. The
+//	thread sleeps on WakeSignal and runs the ring empty each time it wakes.
+//	A signal sent while it's running stays pending, so nothing queued is
+//	left behind
+//
+//	Score music is loaded here with the effects, so the disc read is part of
+//	AudioStart and the music file named by AUDIO_MUSIC_START only matters to
+//	the spooler
+//
+
+*/
+
+#include "types.h"
+#include "stdio.h"
+#include "strings.h"
+#include "kernel.h"
+#include "task.h"
+#include "audio.h"
+
+#include "HD3DOAudio.h"
+#include "HD3DOAudioSFX.h"
+#include "HD3DOAudioSpool.h"
+#include "HD3DOAudioSoundInterface.h"
+#include "HD3DOMem.h"
+#include "tools.h"
+
+#define AUDIO_OVERLAY_LINES 6
+#define AUDIO_OVERLAY_X (320 - (16 * FONT_WIDTH) - 4)
+#define AUDIO_OVERLAY_Y (240 - (AUDIO_OVERLAY_LINES * 9) - 4) // Bottom right, across from the memory tags
+
+AudioQueue Audio;
+
+static char audioText[AUDIO_OVERLAY_LINES][MAX_STRING_LENGTH];
+static int audioRefreshCount = AUDIO_REFRESH;
+
+/* ----- Thread side ----- */
+
+static void Run(AudioCommand *c)
+{
+	switch (c->What)
+	{
+		case AUDIO_PLAY:
+			if (c->Arg != AUDIO_PAN_NONE) pansound(c->Id, c->Arg); // Two gain knobs, nothing reconnected
+			playsound(c->Id);
+			break;
+		case AUDIO_STOP: stopsound(c->Id); break;
+		case AUDIO_VOLUME: setsoundampl(c->Id, c->Arg); break;
+#if AUDIO_MUSIC_SCORE
+		case AUDIO_MUSIC_START: ScoreStart(c->Arg); break;
+		case AUDIO_MUSIC_STOP: ScoreStop(c->Arg); break;
+		case AUDIO_MUSIC_TEMPO: ScoreTempo(c->Arg); break;
+		case AUDIO_MUSIC_PLAYLIST: if (ScorePlaying() == false) ScoreStart(AUDIO_MUSIC_REPS); break;
+#else
+		case AUDIO_MUSIC_START: spoolsound(c->File, c->Arg); break;
+		case AUDIO_MUSIC_STOP: stopspoolsound(c->Arg); break;
+		case AUDIO_MUSIC_BUSY: SpoolBusy(c->Arg); break;
+		case AUDIO_MUSIC_PLAYLIST: spoolplaylist(c->Tracks); break;
+#endif
+	}
+
+	Audio.Ran[c->What]++;
+}
+
+// The library's counts where the game can read them, GetSoundResources is ours alone
+
+static void PublishResources()
+{
+	Audio.ResourcesSeq++;
+
+	AUDIO_BARRIER(); // Odd before the copy changes
+
+	GetSoundResources(&Audio.Resources);
+
+	AUDIO_BARRIER();
+
+	Audio.ResourcesSeq++;
+}
+
+// Runs everything queued, false once it has run AUDIO_QUIT
+
+static bool RunQueued()
+{
+	AudioCommand c;
+
+	while (Audio.Tail != Audio.Head)
+	{
+		AUDIO_BARRIER(); // Head was moved after the command was written, read it after Head
+
+		c = Audio.Ring[Audio.Tail & (AUDIO_QUEUE_COMMANDS - 1)];
+
+		if (c.Seq != Audio.Tail) Audio.Misordered++;
+
+		AUDIO_BARRIER(); // Copied before the slot is handed back
+
+		Audio.Tail++;
+
+		Run(&c);
+
+		if (c.What == AUDIO_QUIT) return false;
+	}
+
+	return true;
+}
+
+static void AudioThread()
+{
+	OpenAudioFolio(); // Every thread that makes audio calls opens the folio for itself
+
+	Audio.WakeSignal = AllocSignal(0);
+
+	initsound();
+	loadsfx();
+
+	(void)ScoreLoad(AUDIO_MUSIC_FILE); // Without it the music commands do nothing, the effects still play
+
+	PublishResources();
+
+	SendSignal(Audio.Parent, Audio.DoneSignal);
+
+	while (true)
+	{
+		WaitSignal(Audio.WakeSignal | ScoreSignal());
+
+		if (RunQueued() == false) break;
+
+		ScoreService();
+
+		PublishResources();
+	}
+
+	PublishResources(); // As the last commands left it, for AudioReport after AudioStop
+
+	ScoreUnload();
+
+	closesound();
+
+	FreeSignal(Audio.WakeSignal);
+
+	CloseAudioFolio();
+
+	SendSignal(Audio.Parent, Audio.DoneSignal);
+
+	WaitSignal(0); // Until AudioStop deletes the thread
+}
+
+/* ----- Game side ----- */
+
+bool AudioStart()
+{
+	if (Audio.Thread > 0) return true;
+
+	Audio.Parent = CURRENTTASK->t.n_Item;
+	Audio.DoneSignal = AllocSignal(0);
+	Audio.Head = 0;
+	Audio.Tail = 0;
+
+	MemTrack(MEM_TAG_AUDIO, &SoundSampleBytes, SoundSampleBytes); // The audio and spooler threads only resize their records, see HD3DOMem.h
+	MemTrack(MEM_TAG_MUSIC, &Spool, 0);
+
+	Audio.Thread = CreateThread("AudioQueue", AUDIO_THREAD_PRIORITY, AudioThread, AUDIO_STACK_SIZE);
+
+	if (Audio.Thread < 0)
+	{
+		MemUntrack(&SoundSampleBytes);
+		MemUntrack(&Spool);
+
+		FreeSignal(Audio.DoneSignal);
+
+		Audio.Thread = 0;
+
+		return false;
+	}
+
+	WaitSignal(Audio.DoneSignal); // Loading the effects reads the disc, only startup waits for it
+
+	return true;
+}
+
+static bool Queue(int32 what, int32 id, int32 arg, char *file, char **tracks)
+{
+	AudioCommand *c;
+
+	if (Audio.Thread <= 0) return false;
+
+	if (Audio.Head - Audio.Tail == AUDIO_QUEUE_COMMANDS)
+	{
+		Audio.Full++;
+
+		return false;
+	}
+
+	c = &Audio.Ring[Audio.Head & (AUDIO_QUEUE_COMMANDS - 1)];
+
+	c->Seq = Audio.Head;
+	c->What = what;
+	c->Id = id;
+	c->Arg = arg;
+	c->File = file;
+	c->Tracks = tracks;
+
+	AUDIO_BARRIER(); // The command is all there before the thread can see it
+
+	Audio.Head++;
+
+	SendSignal(Audio.Thread, Audio.WakeSignal);
+
+	return true;
+}
+
+void AudioStop()
+{
+	if (Audio.Thread <= 0) return;
+
+	while (Audio.Head - Audio.Tail == AUDIO_QUEUE_COMMANDS)
+	{
+		Yield(); // Full, the thread is above us and empties it as soon as we let it
+	}
+
+	Queue(AUDIO_QUIT, 0, 0, NULL, NULL);
+
+	WaitSignal(Audio.DoneSignal);
+
+	DeleteThread(Audio.Thread);
+	FreeSignal(Audio.DoneSignal);
+
+	MemUntrack(&SoundSampleBytes); // Both threads are gone
+	MemUntrack(&Spool);
+
+	Audio.Thread = 0;
+}
+
+bool AudioPlay(int32 id)
+{
+	return Queue(AUDIO_PLAY, id, AUDIO_PAN_NONE, NULL, NULL);
+}
+
+void AudioTrigger(int32 id)
+{
+	AudioTriggerAt(id, AUDIO_PAN_NONE);
+}
+
+void AudioTriggerAt(int32 id, int32 pan)
+{
+	uint32 bit;
+
+	if (id <= 0 || id >= AUDIO_SFX_IDS) return;
+
+	bit = 1 << id;
+
+	if (Audio.Pending & bit)
+	{
+		Audio.Coalesced++;
+		Audio.Pan[id] = pan;
+	}
+	else if ((int32)(Audio.Frame - Audio.NextStart[id]) < 0)
+	{
+		Audio.RateLimited++;
+	}
+	else
+	{
+		Audio.Pending |= bit;
+		Audio.Pan[id] = pan;
+	}
+}
+
+int32 AudioFlush()
+{
+	int32 voices[MAX_SFXCAT];
+	int32 id, best, cat, sent = 0;
+
+	memset(voices, 0, sizeof(voices));
+
+	while (Audio.Pending != 0)
+	{
+		for (best = 0, id = 1; id < AUDIO_SFX_IDS; id++) // Highest priority first, the lower id on a tie
+		{
+			if ((Audio.Pending & (1 << id)) && (best == 0 || soundpriority(id) > soundpriority(best))) best = id;
+		}
+
+		Audio.Pending &= ~(1 << best);
+
+		cat = soundcategory(best);
+
+		if (sent >= AUDIO_SFX_PER_FRAME || cat < 0 || voices[cat] >= categoryvoices(cat))
+		{
+			Audio.Capped++;
+
+			continue;
+		}
+
+		if (Queue(AUDIO_PLAY, best, Audio.Pan[best], NULL, NULL) == false) continue; // Counted in Full
+
+		Audio.NextStart[best] = Audio.Frame + soundinterval(best);
+
+		voices[cat]++;
+		sent++;
+	}
+
+	Audio.Frame++;
+
+	return sent;
+}
+
+bool AudioStopSound(int32 id)
+{
+	return Queue(AUDIO_STOP, id, 0, NULL, NULL);
+}
+
+bool AudioVolume(int32 id, int32 amplitude)
+{
+	return Queue(AUDIO_VOLUME, id, amplitude, NULL, NULL);
+}
+
+bool AudioMusicStart(char *file, int32 reps)
+{
+	return Queue(AUDIO_MUSIC_START, 0, reps, file, NULL);
+}
+
+bool AudioMusicStop(int32 seconds)
+{
+	return Queue(AUDIO_MUSIC_STOP, 0, seconds, NULL, NULL);
+}
+
+bool AudioMusicTempo(frac16 tempo)
+{
+	return Queue(AUDIO_MUSIC_TEMPO, 0, tempo, NULL, NULL);
+}
+
+bool AudioMusicBusy(bool busy)
+{
+	return Queue(AUDIO_MUSIC_BUSY, 0, busy, NULL, NULL);
+}
+
+bool AudioMusicPlaylist(char **tracks)
+{
+	return Queue(AUDIO_MUSIC_PLAYLIST, 0, 0, NULL, tracks);
+}
+
+/* ----- Resources ----- */
+
+// The thread's last copy, taken again if it was writing one meanwhile
+
+static void ReadResources(SoundResourceRec *sr)
+{
+	uint32 seq;
+
+	do
+	{
+		seq = Audio.ResourcesSeq;
+
+		AUDIO_BARRIER();
+
+		*sr = Audio.Resources;
+
+		AUDIO_BARRIER();
+	}
+	while ((seq & 1) != 0 || seq != Audio.ResourcesSeq);
+}
+
+void AudioDrawOverlay(Item bitmapItem)
+{
+	SoundResourceRec sr;
+	int i;
+
+	if (++audioRefreshCount >= AUDIO_REFRESH)
+	{
+		ReadResources(&sr);
+
+		sprintf(audioText[0], "DSP %3d/%3d", sr.dspTicks, kDSPTicks);
+		sprintf(audioText[1], "PEAK %3d INS %d", sr.dspTicksPeak, sr.instruments);
+		sprintf(audioText[2], "VOICE %d FREE %d", sr.voices, sr.channelsFree);
+		sprintf(audioText[3], "NORSRC %d FAIL %d", sr.noResource, sr.failedAssigns);
+		sprintf(audioText[4], "EVICT %d STEAL %d", sr.evictions, sr.steals);
+		sprintf(audioText[5], "DROP %d SILENT %d", sr.drops, sr.silentStarts);
+
+		audioRefreshCount = 0;
+	}
+
+	for (i = 0; i < AUDIO_OVERLAY_LINES; i++)
+	{
+		drawText(AUDIO_OVERLAY_X, AUDIO_OVERLAY_Y + (i * 9), audioText[i], bitmapItem);
+	}
+}
+
+void AudioReport()
+{
+	SoundResourceRec sr;
+
+	ReadResources(&sr);
+
+	printf("SND  DSP %d of %d ticks, peak %d, %d instruments, %d voices, %d mixer channels free\n",
+		sr.dspTicks, kDSPTicks, sr.dspTicksPeak, sr.instruments, sr.voices, sr.channelsFree);
+	printf("SND  %u loads the DSP refused, %u sounds left without a voice, %u voices evicted\n",
+		sr.noResource, sr.failedAssigns, sr.evictions);
+	printf("SND  %u starts stole a voice, %u dropped, %u silent\n", sr.steals, sr.drops, sr.silentStarts);
+	printf("SND  %u triggers coalesced, %u rate limited, %u capped over %u frames\n", Audio.Coalesced, Audio.RateLimited,
+		Audio.Capped, Audio.Frame);
+}
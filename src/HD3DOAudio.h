@@ -0,0 +1,158 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Audio commands from the game loop to a thread of their own. AudioStart
+//	creates the thread the way the sound library creates its spooler, and
+//	the thread owns the sound library from then on: it initializes it and
+//	loads the effects, runs every command, and closes it at AudioStop. The
+//	game only writes commands into a ring and signals the thread, so it
+//	never waits on the audio folio, the spooler or the disk
+//
+//	The ring has one writer and one reader. The game moves Head, the thread
+//	moves Tail, and neither writes the other's. A full ring drops the
+//	command and counts it in Full rather than wait. Each command carries
+//	its position in the ring as Seq, and the thread counts any that arrive
+//	out of that order in Misordered
+//
+//	With AUDIO_MUSIC_SCORE set the music commands go to the score player
+//	(HD3DOAudioScore.h) rather than the spooler, and the thread wakes for
+//	the score's cue as well as for commands. There is one score, so a
+//	playlist only starts it if it isn't playing
+//
+//	The game triggers effects with AudioTrigger and AudioFlush sends them
+//	once a frame, as the frame is shown. Repeats of an effect on the same
+//	frame collapse into one, an effect triggered again within its interval
+//	(soundinterval) is dropped, and the rest go out highest priority first,
+//	no more than categoryvoices of a category and AUDIO_SFX_PER_FRAME in
+//	all. The ones left out are counted, nothing carries over to the next
+//	frame
+//
+//	AudioTriggerAt places the effect across the stereo field as well, the
+//	last position triggered on the frame wins. The thread sets the gains
+//	just before it starts the effect, and an effect played without one
+//	keeps where it was last put
+//
+//	The debug overlay and AudioReport show what the sound library holds in
+//	the DSP and the mixer, and how often a sound went without because of
+//	it. The thread copies GetSoundResources into Resources each time it
+//	empties the ring, bumping ResourcesSeq before and after, and the game
+//	only ever reads that copy
+//
+
+*/
+
+#ifndef HD3DOAUDIO_H
+#define HD3DOAUDIO_H
+
+#include "types.h"
+
+#include "HD3DOAudioScore.h"
+#include "HD3DOAudioSoundInterface.h"
+
+#ifndef AUDIO_BARRIER
+#define AUDIO_BARRIER()				// One ARM60 and no data cache, the stores land in program order. Hosts with more cores set this
+#endif
+
+#define AUDIO_QUEUE_COMMANDS 32		// Power of 2, a frame queues a handful at most
+#define AUDIO_THREAD_PRIORITY 170	// Above the game so commands run as soon as they're queued, below the spooler
+#define AUDIO_STACK_SIZE 8192		// Loading and spooling go through here, the spooler gets 10000
+
+#if AUDIO_MUSIC_SCORE
+#define AUDIO_MUSIC_FILE "music/tetris.mf"		// MIDI, loaded with its samples when the thread starts
+#else
+#define AUDIO_MUSIC_FILE "music/tetrismono.aiff"	// Spooled from the disc while it plays
+#endif
+
+#define AUDIO_MUSIC_REPS 256		// A playlist plays until stopped, the score this many times
+#define AUDIO_REFRESH 30			// Frames between overlay text updates
+
+#define AUDIO_SFX_IDS 32			// Effect ids below this, a bit each in Pending
+#define AUDIO_SFX_PER_FRAME 2		// Most effects AudioFlush starts, the library has 4 voices
+#define AUDIO_PAN_NONE -1			// Played where it was last placed
+
+// Commands
+
+#define AUDIO_PLAY 0				// Id is the sound, Arg its pan position or AUDIO_PAN_NONE
+#define AUDIO_STOP 1
+#define AUDIO_VOLUME 2				// Arg is the amplitude, variable rate sounds only
+#define AUDIO_MUSIC_START 3			// File to play, Arg repetitions
+#define AUDIO_MUSIC_STOP 4			// Arg is the fade in seconds, 0 stops at once
+#define AUDIO_MUSIC_TEMPO 5			// Arg is frac16, score music only
+#define AUDIO_MUSIC_BUSY 6			// Arg true while the game is reading the disc, the spooler buffers more
+#define AUDIO_MUSIC_PLAYLIST 7		// Tracks to play in turn, from the next track if music is playing already
+#define AUDIO_QUIT 8
+#define AUDIO_COMMANDS 9
+
+typedef struct AudioCommand
+{
+	uint32 Seq;					// Head when it was queued
+	int32 What;					// AUDIO_*
+	int32 Id;
+	int32 Arg;
+	char *File;
+	char **Tracks;				// NULL terminated, the game keeps it
+} AudioCommand;
+
+typedef struct AudioQueue
+{
+	AudioCommand Ring[AUDIO_QUEUE_COMMANDS];
+	volatile uint32 Head;		// Game side, next to write
+	volatile uint32 Tail;		// Thread side, next to run
+	Item Thread;
+	Item Parent;				// Who AudioStart and AudioStop wait in
+	int32 WakeSignal;			// The thread's, sent with every command
+	int32 DoneSignal;			// The parent's, the thread is ready or has finished
+	uint32 Full;				// Commands dropped on a full ring
+	uint32 Misordered;
+	uint32 Ran[AUDIO_COMMANDS];	// By command, as the thread ran them
+	volatile uint32 ResourcesSeq;	// Odd while the thread is writing Resources
+	SoundResourceRec Resources;	// Thread side, as of the last command it ran
+
+	uint32 Pending;				// Effects triggered this frame, game side only
+	uint32 Frame;				// AudioFlush calls
+	uint32 NextStart[AUDIO_SFX_IDS];	// Frame each effect may start again
+	int32 Pan[AUDIO_SFX_IDS];	// Of each one pending
+	uint32 Coalesced;			// Triggers of an effect already pending
+	uint32 RateLimited;			// Triggers within the effect's interval
+	uint32 Capped;				// Left out by the category or frame cap
+} AudioQueue;
+
+extern AudioQueue Audio;
+
+bool AudioStart(void);				// Thread up, sound library initialized and the effects loaded
+void AudioStop(void);				// Runs what's queued, closes the library and ends the thread
+
+bool AudioPlay(int32 id);			// At once, false if the command was dropped
+void AudioTrigger(int32 id);		// Sent by the next AudioFlush, if it makes the cut
+void AudioTriggerAt(int32 id, int32 pan);	// The same, at a pan position (SFX_PAN_POSITIONS)
+int32 AudioFlush(void);				// Once a frame, returns the effects sent
+bool AudioStopSound(int32 id);
+bool AudioVolume(int32 id, int32 amplitude);
+bool AudioMusicStart(char *file, int32 reps);
+bool AudioMusicStop(int32 seconds);
+bool AudioMusicTempo(frac16 tempo);	// SCORE_TEMPO_ONE plays the file as written
+bool AudioMusicBusy(bool busy);
+bool AudioMusicPlaylist(char **tracks);	// No stop or fade, a new list takes over at the end of the track playing
+
+void AudioDrawOverlay(Item bitmapItem);
+void AudioReport(void);
+
+#endif
@@ -25,6 +25,83 @@ static char	*ramfx[] = {
 	"music/gameover.aiff"
 };
 
+/*
+ * Who keeps a voice when there aren't enough, higher wins.  A four line
+ * clear shouldn't be cut off by the tick of the next block moving.
+ */
+static int32	ramfxpri[] = {
+	4,	/*  SFX_CLEAR  */
+	6,	/*  SFX_CLEAR4  */
+	3,	/*  SFX_SUCCESS  */
+	0,	/*  SFX_TICK  */
+	1,	/*  SFX_HOLD  */
+	2,	/*  SFX_DROP  */
+	5	/*  SFX_GAMEOVER  */
+};
+
+/*
+ * What each is for, see categoryvoices().
+ */
+static int32	ramfxcat[] = {
+	SFXCAT_CLEAR,	/*  SFX_CLEAR  */
+	SFXCAT_CLEAR,	/*  SFX_CLEAR4  */
+	SFXCAT_CLEAR,	/*  SFX_SUCCESS  */
+	SFXCAT_MENU,	/*  SFX_TICK  */
+	SFXCAT_PIECE,	/*  SFX_HOLD  */
+	SFXCAT_PIECE,	/*  SFX_DROP  */
+	SFXCAT_END	/*  SFX_GAMEOVER  */
+};
+
+/*
+ * Triggers closer together than this, in frames, are dropped rather than
+ * restarting the instrument.  Long enough that the restart is heard as a
+ * new sound, short enough that a held or repeated button still gets one.
+ */
+static int32	ramfxgap[] = {
+	8,	/*  SFX_CLEAR  */
+	8,	/*  SFX_CLEAR4  */
+	8,	/*  SFX_SUCCESS  */
+	4,	/*  SFX_TICK  */
+	6,	/*  SFX_HOLD  */
+	4,	/*  SFX_DROP  */
+	60	/*  SFX_GAMEOVER  */
+};
+
+/*
+ * Starts of each kind a frame.  Two clears or two piece sounds on the same
+ * frame only smear into each other.
+ */
+static int32	catvoices[] = {
+	1,	/*  SFXCAT_MENU  */
+	1,	/*  SFXCAT_PIECE  */
+	1,	/*  SFXCAT_CLEAR  */
+	1	/*  SFXCAT_END  */
+};
+
+/*
+ * Left and right gains for each pan position, frac16 shares of the
+ * effect's amplitude.  Constant power, sqrt(2) cos and sin across the
+ * middle 60% of the quarter circle, so the centre is the balance of 50
+ * the effects load with and the ends still leave the far speaker some.
+ */
+static int32	pangains[SFX_PAN_POSITIONS][2] = {
+	{ 0xAC29, 0x37F0 },	/*   0  */
+	{ 0xA802, 0x4364 },	/*   1  */
+	{ 0xA318, 0x4E8B },	/*   2  */
+	{ 0x9D71, 0x5956 },	/*   3  */
+	{ 0x9713, 0x63B9 },	/*   4  */
+	{ 0x9006, 0x6DA9 },	/*   5  */
+	{ 0x8852, 0x771A },	/*   6  */
+	{ 0x8000, 0x8000 },	/*   7, SFX_PAN_CENTRE  */
+	{ 0x771A, 0x8852 },	/*   8  */
+	{ 0x6DA9, 0x9006 },	/*   9  */
+	{ 0x63B9, 0x9713 },	/*  10  */
+	{ 0x5956, 0x9D71 },	/*  11  */
+	{ 0x4E8B, 0xA318 },	/*  12  */
+	{ 0x4364, 0xA802 },	/*  13  */
+	{ 0x37F0, 0xAC29 }	/*  14  */
+};
+
 /***************************************************************************
  * Code.
  */
@@ -39,6 +116,45 @@ void playsound (int id)
 }
 
 
+void stopsound (int32 id)
+{
+	RAMSoundRec	rs;
+
+	rs.whatIWant	= kStopRAMSound;
+	rs.soundID	= id;
+
+	CallSound ((CallSoundRec *) &rs);
+}
+
+void setsoundampl (int32 id, int32 level)
+{
+	SetRAMSoundRec	ss;
+
+	ss.whatIWant	= kSetRAMSoundAmpl;
+	ss.soundID	= id;
+	ss.level	= level;
+
+	CallSound ((CallSoundRec *) &ss);
+}
+
+void pansound (int32 id, int32 position)
+{
+	SetRAMSoundPanRec	sp;
+
+	if (position < 0)
+		position = 0;
+	if (position >= SFX_PAN_POSITIONS)
+		position = SFX_PAN_POSITIONS - 1;
+
+	sp.whatIWant	= kSetRAMSoundPan;
+	sp.soundID	= id;
+	sp.left		= pangains[position][0];
+	sp.right	= pangains[position][1];
+
+	CallSound ((CallSoundRec *) &sp);
+}
+
+
 void initsound ()
 {
 	int32 whatIWant;
@@ -70,6 +186,7 @@ void loadsfx ()
 		lrs.amplitude = 0x3800;
 		lrs.balance = 50;
 		lrs.frequency = 0;
+		lrs.priority = ramfxpri[i - 1];
 
 		CallSound ((CallSoundRec *) &lrs);
 	}
@@ -101,6 +218,7 @@ int32 loadsound (char *filename, int32 id)
 	lrs.amplitude = MAXAMPLITUDE;
 	lrs.balance = 50;
 	lrs.frequency = 0;
+	lrs.priority = 0;
 
 	return (CallSound ((CallSoundRec *) &lrs));
 }
@@ -127,6 +245,16 @@ void spoolsound (char *filename, int32 nreps)
 
 }
 
+void spoolplaylist (char **tracks)
+{
+	SpoolPlaylistRec	spr;
+
+	spr.whatIWant	= kSpoolPlaylist;
+	spr.tracks	= tracks;
+	spr.amplitude	= 0x7FFF;
+	CallSound ((CallSoundRec *) &spr);
+}
+
 void stopspoolsound (int32 nsecs)
 {
 	SpoolFadeSoundRec	sr;
@@ -151,4 +279,35 @@ int issoundspooling ()
 	whatIWant = kIsSoundSpooling;
 
 	return (CallSound ((CallSoundRec *) &whatIWant));
-}
\ No newline at end of file
+}
+int32 soundpriority (int32 id)
+{
+	if (id < 1  ||  id >= MAX_SFX)
+		return (-1);
+
+	return (ramfxpri[id - 1]);
+}
+
+int32 soundcategory (int32 id)
+{
+	if (id < 1  ||  id >= MAX_SFX)
+		return (-1);
+
+	return (ramfxcat[id - 1]);
+}
+
+int32 soundinterval (int32 id)
+{
+	if (id < 1  ||  id >= MAX_SFX)
+		return (0);
+
+	return (ramfxgap[id - 1]);
+}
+
+int32 categoryvoices (int32 cat)
+{
+	if (cat < 0  ||  cat >= MAX_SFXCAT)
+		return (0);
+
+	return (catvoices[cat]);
+}
@@ -14,4 +14,48 @@ enum SoundFX {
 	SFX_DROP,
 	SFX_GAMEOVER,
 	MAX_SFX 
-}; 
\ No newline at end of file
+}; 
+
+/*
+ * Places across the stereo field an effect can start at, left to right.
+ */
+#define	SFX_PAN_POSITIONS	15
+#define	SFX_PAN_CENTRE		7
+
+/*
+ * What an effect is for.  HD3DOAudio.c starts at most categoryvoices() of
+ * each a frame.
+ */
+enum SoundCategory {
+	SFXCAT_MENU,
+	SFXCAT_PIECE,
+	SFXCAT_CLEAR,
+	SFXCAT_END,
+	MAX_SFXCAT
+};
+
+/*
+ * Called only from the audio thread once HD3DOAudio.c has started it.
+ */
+void playsound (int id);
+void stopsound (int32 id);
+void setsoundampl (int32 id, int32 level);
+void pansound (int32 id, int32 position);	/*  0 - SFX_PAN_POSITIONS-1, kept until the next  */
+void initsound (void);
+void closesound (void);
+void loadsfx (void);
+void freesfx (void);
+int32 loadsound (char *filename, int32 id);
+void unloadsound (int32 id);
+void spoolsound (char *filename, int32 nreps);
+void stopspoolsound (int32 nsecs);
+void spoolplaylist (char **tracks);
+int issoundspooling (void);
+int32 soundpriority (int32 id);	/*  Who keeps a voice, higher wins  */
+
+/*
+ * Constant tables, any thread can ask.
+ */
+int32 soundcategory (int32 id);
+int32 soundinterval (int32 id);	/*  Frames before it starts again  */
+int32 categoryvoices (int32 cat);	/*  Starts a frame  */
@@ -0,0 +1,300 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Score player music, see HD3DOAudioScore.h. One collection is loaded for
+//	the life of the audio thread and started, stopped and restarted as the
+//	options say. Fading steps MIDI volume (controller 7) down on every
+//	channel, the cue wakes the thread for each step as well as for events
+//
+
+*/
+
+#include "types.h"
+#include "kernel.h"
+#include "audio.h"
+#include "juggler.h"
+#include "midifile.h"
+#include "score.h"
+
+#include "HD3DOAudioScore.h"
+
+#if AUDIO_MUSIC_SCORE
+
+#define SCORE_CHANNELS 16
+#define SCORE_VOLUME 127			// MIDI full volume
+#define SCORE_TICKS_PER_SECOND 240	// Audio clock, the juggler's too at tempo 1
+#define SCORE_WAIT_MAX 0x7fff		// Audio ticks, keeps the tempo scaling in 32 bits
+
+typedef struct ScoreState
+{
+	ScoreContext *Context;
+	Collection *Music;
+	Item Cue;
+	int32 CueSignal;
+
+	bool Loaded;
+	bool Playing;
+
+	frac16 Tempo;
+	uint32 ScoreTime;				// Juggler time, runs at Tempo
+	uint32 ScoreFraction;			// Of the next score tick, frac16, carried so the clock doesn't drift
+	uint32 RealTime;				// Audio time ScoreTime was last advanced at
+
+	int32 Volume;					// Fading when FadeStep is set
+	int32 FadeStep;
+	uint32 NextFade;
+} ScoreState;
+
+static ScoreState Score;
+
+static void SetVolume(int32 volume)
+{
+	int32 ch;
+
+	for (ch = 0; ch < SCORE_CHANNELS; ch++)
+	{
+		ChangeScoreControl(Score.Context, ch, 7, volume);
+	}
+
+	Score.Volume = volume;
+}
+
+static void Advance(uint32 now)
+{
+	uint32 scaled = ((now - Score.RealTime) * Score.Tempo) + Score.ScoreFraction;
+
+	Score.ScoreTime += scaled >> 16;
+	Score.ScoreFraction = scaled & 0xffff;
+	Score.RealTime = now;
+}
+
+static void Halt()
+{
+	int32 ch;
+
+	StopObject(Score.Music, Score.ScoreTime);
+
+	for (ch = 0; ch < SCORE_CHANNELS; ch++)
+	{
+		FreeChannelInstruments(Score.Context, ch); // Any notes still sounding
+	}
+
+	Score.Playing = false;
+	Score.FadeStep = 0;
+}
+
+bool ScoreLoad(char *file)
+{
+	MIDIFileParser parser;
+	TagArg tags[3];
+	Sequence *seq;
+	int32 i;
+
+	if (Score.Loaded) return true;
+
+	if (InitJuggler() < 0) return false;
+
+	Score.Context = CreateScoreContext(SCORE_PROGRAMS);
+
+	if (Score.Context == NULL) goto fail;
+
+	if (InitScoreMixer(Score.Context, "mixer8x2.dsp", SCORE_VOICES, SCORE_AMPLITUDE) < 0) goto fail;
+
+	if (LoadPIMap(Score.Context, SCORE_PIMAP_FILE) < 0) goto fail; // Reads every sample it names
+
+	Score.Music = (Collection *)CreateObject(&CollectionClass);
+
+	if (Score.Music == NULL) goto fail;
+
+	parser.mfp_Rate = SCORE_TICKS_PER_SECOND;
+
+	if (MFLoadCollection(&parser, file, Score.Music) < 0) goto fail;
+
+	tags[0].ta_Tag = JGLR_TAG_INTERPRETER_FUNCTION;
+	tags[0].ta_Arg = (void *)InterpretMIDIEvent;
+	tags[1].ta_Tag = JGLR_TAG_CONTEXT;
+	tags[1].ta_Arg = (void *)Score.Context;
+	tags[2].ta_Tag = TAG_END;
+
+	for (i = 0; GetNthFromObject(Score.Music, i, &seq) == 0; i++)
+	{
+		SetObjectInfo(seq, tags);
+	}
+
+	Score.Cue = CreateItem(MKNODEID(AUDIONODE, AUDIO_CUE_NODE), NULL);
+
+	if (Score.Cue < 0) goto fail;
+
+	Score.CueSignal = GetCueSignal(Score.Cue);
+	Score.Tempo = SCORE_TEMPO_ONE;
+	Score.Loaded = true;
+
+	return true;
+
+fail:
+
+	ScoreUnload();
+
+	return false;
+}
+
+void ScoreUnload()
+{
+	if (Score.Playing) Halt();
+
+	if (Score.Cue > 0) DeleteItem(Score.Cue);
+
+	if (Score.Music != NULL)
+	{
+		MFUnloadCollection(Score.Music);
+		DestroyObject(Score.Music);
+	}
+
+	if (Score.Context != NULL)
+	{
+		UnloadPIMap(Score.Context);
+		TermScoreMixer(Score.Context);
+		DeleteScoreContext(Score.Context);
+	}
+
+	TermJuggler();
+
+	Score.Cue = 0;
+	Score.CueSignal = 0;
+	Score.Music = NULL;
+	Score.Context = NULL;
+	Score.Loaded = false;
+}
+
+void ScoreStart(int32 reps)
+{
+	if (Score.Loaded == false) return;
+
+	if (Score.Playing) Halt();
+
+	Score.RealTime = GetAudioTime();
+	Score.ScoreTime = 0;
+	Score.ScoreFraction = 0;
+
+	SetVolume(SCORE_VOLUME);
+
+	StartObject(Score.Music, Score.ScoreTime, reps, NULL);
+
+	Score.Playing = true;
+
+	ScoreService(); // First events and the cue for the next
+}
+
+void ScoreStop(int32 seconds)
+{
+	if (Score.Playing == false) return;
+
+	if (seconds <= 0)
+	{
+		Halt();
+
+		return;
+	}
+
+	// SCORE_VOLUME over seconds in SCORE_FADE_STEP steps, at least 1 a step
+
+	Score.FadeStep = (SCORE_VOLUME * SCORE_FADE_STEP) / (seconds * SCORE_TICKS_PER_SECOND);
+
+	if (Score.FadeStep < 1) Score.FadeStep = 1;
+
+	Score.NextFade = GetAudioTime() + SCORE_FADE_STEP;
+
+	ScoreService();
+}
+
+void ScoreTempo(frac16 tempo)
+{
+	if (tempo <= 0) return;
+
+	if (Score.Playing)
+	{
+		Advance(GetAudioTime()); // Time so far at the old tempo
+
+		Score.Tempo = tempo;
+
+		ScoreService(); // The cue was set for the old tempo
+	}
+	else
+	{
+		Score.Tempo = tempo;
+	}
+}
+
+bool ScorePlaying()
+{
+	return Score.Playing;
+}
+
+int32 ScoreSignal()
+{
+	return Score.Playing ? Score.CueSignal : 0;
+}
+
+void ScoreService()
+{
+	uint32 now, next, wake;
+	int32 nextSignals, wait;
+
+	if (Score.Playing == false) return;
+
+	now = GetAudioTime();
+
+	if (Score.FadeStep > 0 && (int32)(now - Score.NextFade) >= 0)
+	{
+		if (Score.Volume <= Score.FadeStep)
+		{
+			Halt();
+
+			return;
+		}
+
+		SetVolume(Score.Volume - Score.FadeStep);
+
+		Score.NextFade += SCORE_FADE_STEP;
+	}
+
+	Advance(now);
+
+	if (BumpJuggler(Score.ScoreTime, &next, 0, &nextSignals) < 0)
+	{
+		Halt(); // Nothing left to play
+
+		return;
+	}
+
+	wait = (int32)(next - Score.ScoreTime);
+
+	if (wait < 1) wait = 1;
+	if (wait > SCORE_WAIT_MAX) wait = SCORE_WAIT_MAX;
+
+	wake = now + (((uint32)wait << 16) - Score.ScoreFraction + Score.Tempo - 1) / Score.Tempo; // Rounded up, never early
+
+	if (Score.FadeStep > 0 && (int32)(Score.NextFade - wake) < 0) wake = Score.NextFade;
+
+	SignalAtTime(Score.Cue, wake);
+}
+
+#endif
@@ -0,0 +1,80 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Music from a MIDI file through the score player (score.h) instead of the
+//	spooler. The collection, the PIMap and every sample it names are read at
+//	ScoreLoad, so once the game is running music never touches the disc and
+//	the drive is free for everything else
+//
+//	The juggler is driven on a score clock of our own that runs at Tempo
+//	against the audio clock, 0x10000 being the file's own tempo. The audio
+//	thread waits on the cue's signal alongside its command signal and calls
+//	ScoreService when either arrives: the juggler plays everything due on the
+//	score clock and the cue is set for the real time the next event falls at
+//	the current tempo. A tempo change takes effect from the next event
+//
+//	Everything here runs on the audio thread (HD3DOAudio.c). Only built with
+//	AUDIO_MUSIC_SCORE set, otherwise the calls compile to nothing
+//
+
+*/
+
+#ifndef HD3DOAUDIOSCORE_H
+#define HD3DOAUDIOSCORE_H
+
+#include "types.h"
+
+#ifndef AUDIO_MUSIC_SCORE
+#define AUDIO_MUSIC_SCORE 0			// Set on the compiler command line, it also decides whether the spooler keeps DSP room
+#endif
+
+#define SCORE_PIMAP_FILE "music/tetris.pimap"	// Program to sample map, read with the collection
+#define SCORE_VOICES 8				// Score mixer inputs, separate from the effects mixer
+#define SCORE_AMPLITUDE (0x7fff / SCORE_VOICES)	// Per voice, all of them at once can't clip
+#define SCORE_PROGRAMS 128
+#define SCORE_FADE_STEP 24			// Audio ticks between volume steps while fading (0.1s)
+#define SCORE_TEMPO_ONE 0x10000		// frac16, the file's own tempo
+
+#if AUDIO_MUSIC_SCORE
+
+bool ScoreLoad(char *file);			// Collection, PIMap and samples, false if any are missing
+void ScoreUnload(void);
+void ScoreStart(int32 reps);
+void ScoreStop(int32 seconds);		// 0 stops at once, otherwise fades out
+void ScoreTempo(frac16 tempo);
+bool ScorePlaying(void);
+int32 ScoreSignal(void);			// For the audio thread to wait on, 0 when nothing is playing
+void ScoreService(void);
+
+#else
+
+#define ScoreLoad(file) false
+#define ScoreUnload()
+#define ScoreStart(reps)
+#define ScoreStop(seconds)
+#define ScoreTempo(tempo)
+#define ScorePlaying() false
+#define ScoreSignal() 0
+#define ScoreService()
+
+#endif
+
+#endif
@@ -46,10 +46,32 @@ Change History:
 			halfmono8.dsp to determine the size because it takes up a lot of room and trying
 			to use fixedstereosample.dsp didn't save enough). This should prevent the loading of too many
 			RAM sounds precluding the use of the dsp for spooling.
+10/19/26	A sound's voice (instrument, attachment, mixer channels and frequency knob) is set
+			up by LoadRAMSound and kept, StartRAMSound only starts it so nothing is loaded,
+			connected or looked up by name while the game is running. Voices go to the higher
+			priority sounds when they run out, and starting a sound when kMaxPlayingSounds
+			are already playing stops the lowest priority one first.
+			The spooler threads signal whichever task or thread initialized the library
+			instead of THREAD_PARENT, which is always the main task, so the library can be
+			run from a thread of its own.
+			The spooler room instrument is only loaded with RESERVE_SPOOLER_ROOM set.
+			The spooler's player comes from HD3DOAudioSpool.c, which picks the buffer count
+			for each pass of the file and counts fill, underruns and service time.
+			Added kSpoolPlaylist (new data structure, too). The spooler plays a list of files
+			in turn and reads each next one in while the last plays out, so there's no gap
+			between them. kSpoolSound is a list of one.
+			LoadRAMSound fails for a sample SelectSamplePlayer has no player for, the sound
+			effects are SDX2 compressed AIFCs now.
+			Added kSetRAMSoundPan. A sound's gains come from its pan, which starts out as its
+			balance, and only that sound's knobs are tweaked when it changes.
+			Added GetSoundResources(). Loads that run out of dsp or mixer channels, the voices
+			they take and the starts that go silent are counted rather than just given up on.
 ***************************************************************/
 
 #include "types.h"
+#include "stdio.h"
 #include "debug.h"
+#include "strings.h"
 #include "operror.h"
 #include "filefunctions.h"
 #include "audio.h" 
@@ -57,16 +79,16 @@ Change History:
 #include "soundfile.h"
 #include "operamath.h"
 #include "HD3DOAudioSoundInterface.h"  
+#include "HD3DOAudioSpool.h"
+#include "HD3DOMem.h"
 
 
 // PVC This might be a bit big
 #define STACKSIZE (10000)
 
-// PVC These might be a bit big
-#define NUMBLOCKS (24)
-#define BLOCKSIZE (2048)  
-#define BUFSIZE (NUMBLOCKS*BLOCKSIZE)   
-#define NUMBUFFS  (4)
+// Spooler buffer count and size are in HD3DOAudioSpool.h
+
+#define AUDIO_TICKS_PER_SECOND (240)
 
 
 /*
@@ -77,6 +99,8 @@ static int32 InitializeSoundLibrary( void );
 static int32 SetMixerLevels( int32 theLevel );
 static int32 CleanupSoundLibrary( void );
 static int32 SpoolASound( SpoolSoundPtr spoolSndPtr );
+static int32 SpoolAPlaylist( SpoolPlaylistPtr spoolListPtr );
+static int32 StartSpooling( char **tracks, int32 numReps, int32 amplitude );
 static int32 StopSpoolingSound( void );
 static int32 StopSpoolingSoundFade( int32 seconds );
 static void  StopSpoolOnFadeThread( void );
@@ -92,7 +116,16 @@ static int32 StartRAMSound( int32 soundID );
 static int32 StopRAMSound( int32 soundID );  
 static int32 SetRAMSoundFreq( SetRAMSoundPtr setSndPtr );
 static int32 SetRAMSoundAmpl( SetRAMSoundPtr setSndPtr );
+static int32 SetRAMSoundPan( SetRAMSoundPanPtr panSndPtr );
+static void  SetSoundLevels( SoundDataPtr theSound );
 static int32 FlushInstrument( Item SamplerIns ); 
+static int32 SampleByteCount( Item sample );
+static void  TrackSampleBytes( int32 bytes );
+static int32 SampleTicks( Item sample, int32 frequency );
+static SoundDataPtr LowestPrioritySound( int32 belowPriority, int32 playingOnly );
+static int32 ChannelsInUse( void );
+static int32 DSPTicksFor( char *instrName );
+static int32 DSPTicksInUse( int32 *instruments );
 
 /*
 **	Main Internal Variables
@@ -103,16 +136,16 @@ static	ulong	spoolerOuttaHereSignal = 0;				// Spooler Is Done Signal
 static	ulong	spoolerFaderOuttaHereSignal = 0;		// Spooler Fader Is Done Signal
 static	ulong	spoolerHasStoppedSignal = 0;			// Spooler Is Done Stopping a Sound
 static	int32	soundLibraryMainLevel = MAXAMPLITUDE;	// Main Volume Level
+static	Item	soundLibraryOwner = -1;					// Task or thread that initialized us; it
+														// owns the signals and gets the spooler's
 
 /*
 **	RAM-Resident Sound Internal Variables 
 */
 
 static	SoundDataRec	sounds[kMaxRamSounds]; // Info about each RAM resident sound
-static	int32			numSoundsAssigned;
-static	int32			assignQueue[kMaxRamSounds];	// List of sounds assigned in the order
-												// they were assigned. Unassign the 0th element
-												// in the queue whenever we need room.
+
+uint32	SoundSampleBytes = 0;
 
 /*
 **	Mixer Internal Variables
@@ -134,8 +167,9 @@ static Item 	spoolerThread = -1;			// Thread that does spooling
 static Item 	spoolerFaderThread = -1;	// Thread that does spooling fade
 static int32 	spoolerRunning = false;		// Is a sound currently being spooled? If not, the
 											// spooler thread is just hanging out
-static int32	spoolerNumReps = 0;			// reps left to play
-static	char *	spoolerFileName;			// Pointer to string of name of file to play
+static int32	spoolerNumReps = 0;			// times through the list to play
+static	char **	spoolerTracks;				// NULL terminated list of files to play in turn
+static	char *	spoolerOneTrack[2];			// The list kSpoolSound plays
 static int32	spoolerAmplitude;			// Volume to set for spooling
 static	ulong	spoolerStartSignal = 0;
 static	ulong	spoolerStopSignal = 0;
@@ -146,7 +180,6 @@ static	ulong	spoolerFaderQuitSignal = 0;
 static	int32	spoolerFaderTime = 0;
 static	int8	spoolerFading = FALSE;
 
-static	SoundFilePlayer *spoolerSFP = NULL;
 
 static	Item	spoolerEnvIns = -1;		// Envelope used on spooler to do fades
 static	Item	spoolerRoomIns = -1;	// When a sound isn't being spooled, this instrument
@@ -158,6 +191,38 @@ static	int32	numCachedInstrs = 0;
 static	char	cachedInstrName[MAX_CACHED_INSTRUMENTS][100];
 static	Item	cachedInstrItem[MAX_CACHED_INSTRUMENTS];
 
+//	Resource counters. The audio thread counts, GetSoundResources() fills in the rest
+
+static	SoundResourceRec	soundResources;
+
+//	What each instrument takes of the dsp a frame, near enough. Anything else is charged
+//	kUnlistedDSPTicks
+
+typedef struct DSPCostRec
+{
+	char	*instrName;
+	int32	ticks;
+} DSPCostRec;
+
+#define	kUnlistedDSPTicks	40
+
+static	DSPCostRec	dspCosts[] =
+{
+	{ kMixerFileName,			70 },
+	{ kEnvelopeFileName,		12 },
+	{ "fixedmonosample.dsp",	22 },
+	{ "halfmonosample.dsp",		24 },
+	{ "varmono16.dsp",			36 },
+	{ "fixedstereosample.dsp",	36 },
+	{ "fixedmono8.dsp",			20 },
+	{ "halfmono8.dsp",			24 },
+	{ "varmono8.dsp",			34 },
+	{ "dcsqxdmono.dsp",			34 },
+	{ "dcsqxdhalfmono.dsp",		36 },
+	{ "dcsqxdvarmono.dsp",		48 },
+	{ "dcsqxdstereo.dsp",		54 }
+};
+
 // The Big Lollapalooza
 // Go wild on error checking! e.g. if they stop a sound that hasn't started...
 
@@ -238,6 +303,14 @@ int32 CallSound( union CallSoundRec *soundPtr )
 			result = spoolerRunning;
 			break;
 
+		case kSpoolPlaylist:
+			result = SpoolAPlaylist( &soundPtr->spoolPlaylist );
+			break;
+
+		case kSetRAMSoundPan:
+			result = SetRAMSoundPan( &soundPtr->panSound );
+			break;
+
 		default:
 			result = -1;
 			break;
@@ -272,6 +345,10 @@ static int32 InitializeSoundLibrary( void )
 
 	if ( result == noErr )
 	{
+		memset( &soundResources, 0, sizeof( soundResources ) );
+
+		soundLibraryOwner = CURRENTTASK->t.n_Item;
+
 		Priority = 180;
 		spoolerThread = CreateThread("SoundSpooler", Priority, SpoolSoundFileThread, STACKSIZE);
 		spoolerOuttaHereSignal = AllocSignal( 0 );
@@ -336,7 +413,7 @@ static int32 InitializeSoundLibrary( void )
 static int32 SetMixerLevels( int32 theLevel )
 {
 	int32 	result = noErr;
-	int32 	i, newLevelL, newLevelR;
+	int32 	i;
 	int32	channelIsHit = 0;
 
 	// This sets the mixer levels harshly; we probably want to throw Phil's
@@ -350,25 +427,12 @@ static int32 SetMixerLevels( int32 theLevel )
 			{
 				channelIsHit |= (1 << sounds[i].channel[0]);
 
-				newLevelL = ( ((sounds[i].amplitude * sounds[i].balance) / 100) / kNumChannels) * AUDIO_MULTIPLIER;
-
-				newLevelR = ( ((sounds[i].amplitude * (100 - sounds[i].balance)) / 100) / kNumChannels)  * AUDIO_MULTIPLIER;
-
 				if ( sounds[i].channel[1] >= 0 )	// stereo
 				{
 					channelIsHit |= (1 << sounds[i].channel[1]);
-
-					TweakKnob( leftGainKnob[sounds[i].channel[0]], newLevelL );
-					TweakKnob( rightGainKnob[sounds[i].channel[0]], 0 );
-
-					TweakKnob( leftGainKnob[sounds[i].channel[1]], 0 );
-					TweakKnob( rightGainKnob[sounds[i].channel[1]], newLevelR );
-				}
-				else		// mono
-				{
-					TweakKnob( leftGainKnob[sounds[i].channel[0]], newLevelL );
-					TweakKnob( rightGainKnob[sounds[i].channel[0]], newLevelR );
 				}
+
+				SetSoundLevels( &sounds[i] );
 			}
 		}
 	}
@@ -388,6 +452,33 @@ static int32 SetMixerLevels( int32 theLevel )
 }
 
 
+/*
+**	SetSoundLevels() - The gain knobs of one sound's mixer channels, from its amplitude and pan
+*/
+static void SetSoundLevels( SoundDataPtr theSound )
+{
+	int32	newLevelL, newLevelR;
+
+	newLevelL = ( ( (theSound->amplitude * theSound->pan[0]) >> 16 ) / kNumChannels) * AUDIO_MULTIPLIER;
+
+	newLevelR = ( ( (theSound->amplitude * theSound->pan[1]) >> 16 ) / kNumChannels) * AUDIO_MULTIPLIER;
+
+	if ( theSound->channel[1] >= 0 )	// stereo
+	{
+		TweakKnob( leftGainKnob[theSound->channel[0]], newLevelL );
+		TweakKnob( rightGainKnob[theSound->channel[0]], 0 );
+
+		TweakKnob( leftGainKnob[theSound->channel[1]], 0 );
+		TweakKnob( rightGainKnob[theSound->channel[1]], newLevelR );
+	}
+	else		// mono
+	{
+		TweakKnob( leftGainKnob[theSound->channel[0]], newLevelL );
+		TweakKnob( rightGainKnob[theSound->channel[0]], newLevelR );
+	}
+}
+
+
 /*
 **	CleanupSoundLibrary()
 */
@@ -483,22 +574,58 @@ static int32 SpoolASound( SpoolSoundPtr spoolSndPtr )
 			// ERROR
 		}
 
-		spoolerFileName = spoolSndPtr->fileToSpool;
-		spoolerNumReps = spoolSndPtr->numReps;
-		spoolerAmplitude = spoolSndPtr->amplitude;
+		spoolerOneTrack[0] = spoolSndPtr->fileToSpool;
+		spoolerOneTrack[1] = NULL;
 
-		if (spoolerFading)
-		{
-			WaitSignal (spoolerHasStoppedSignal);
-			spoolerFading = FALSE;
-		}
+		result = StartSpooling( spoolerOneTrack, spoolSndPtr->numReps, spoolSndPtr->amplitude );
+	}
 
-			SendSignal( spoolerThread, spoolerStartSignal );
-		}
+	return ( result );
+}
+
+/*
+**	SpoolAPlaylist()
+*/
+static int32 SpoolAPlaylist( SpoolPlaylistPtr spoolListPtr )
+{
+	int32 result = 0;
+
+	if ( spoolListPtr->tracks == 0 || spoolListPtr->tracks[0] == 0 )
+	{
+		result = -1;
+	}
+	else if ( spoolerRunning  &&  !spoolerFading )
+	{
+		SpoolQueueTracks( spoolListPtr->tracks );	// No stop, no fade, the spooler changes lists at its next track
+	}
+	else
+	{
+		result = StartSpooling( spoolListPtr->tracks, 0x7FFFFFFF, spoolListPtr->amplitude );
+	}
 
 	return ( result );
 }
 
+/*
+**	StartSpooling()
+*/
+static int32 StartSpooling( char **tracks, int32 numReps, int32 amplitude )
+{
+	spoolerTracks = tracks;
+	spoolerNumReps = numReps;
+	spoolerAmplitude = amplitude;
+
+	if (spoolerFading)
+	{
+		WaitSignal (spoolerHasStoppedSignal);
+		spoolerFading = FALSE;
+	}
+
+	SendSignal( spoolerThread, spoolerStartSignal );
+
+	return ( 0 );
+}
+
 /*
 **	StopSpoolingSound()
 */
@@ -555,7 +682,7 @@ static int32 StopSpoolingSoundFade( int32 seconds )
 static void StopSpoolOnFadeThread( void )
 {
 	int32 			SignalIn;
-	Item 			myParent = THREAD_PARENT;
+	Item 			myParent = soundLibraryOwner;
 
 	if (OpenAudioFolio())
 	{
@@ -609,8 +736,8 @@ static void StopSpoolOnFadeThread( void )
 static void SpoolSoundFileThread( void )
 {
 	int32 			result = 0;
-	int32 			SignalIn, spoolServiceSignal;
-	Item 			myParent = THREAD_PARENT;
+	int32 			SignalIn;
+	Item 			myParent = soundLibraryOwner;
 	Item			spoolerEnvAttachment;
 	Item			spoolerEnvelope; 
 
@@ -625,19 +752,19 @@ static void SpoolSoundFileThread( void )
 
 	/* Set up Sound File Player Once at Beginning */
 
-	spoolerSFP = CreateSoundFilePlayer ( NUMBUFFS, BUFSIZE, NULL );
+	SpoolCreatePlayer();	// Buffers as HD3DOAudioSpool.c says, it tracks them too
 
 	// Set room aside for later use
 
+#if RESERVE_SPOOLER_ROOM
 	spoolerRoomIns = LoadInstrument( spoolSaveFileName, 0, 100 ); 
+#endif
 
 	/* Set up spooler signals */
 
 	spoolerStartSignal = AllocSignal(0);
 	spoolerStopSignal = AllocSignal(0);
 	spoolerQuitSignal = AllocSignal(0);
-	
-	spoolServiceSignal = 0;		// Allocated by Spool File Player
 
 	/* Here's our infinite loop - keep waiting or playing until it is time to quit */
 
@@ -673,11 +800,7 @@ static void SpoolSoundFileThread( void )
 			spoolerRoomIns = -1;
 		}
 
-		result = LoadSoundFile( spoolerSFP, spoolerFileName );
-
-		/* Set up our envelope control over it */
-
-		result = ConnectInstruments ( spoolerEnvIns, "Output", spoolerSFP->sfp_SamplerIns, "Amplitude");
+		/* Set up our envelope control, HD3DOAudioSpool.c connects it to each track's sampler */
 
 		spoolerEnvPoints[0].dtpr_Data = 0;
 		spoolerEnvPoints[0].dtpr_Time = 0;
@@ -694,52 +817,10 @@ static void SpoolSoundFileThread( void )
 
 		result = StartInstrument( spoolerEnvIns, NULL );
 
-		SignalIn = 0;
-		
-		while ( spoolerNumReps > 0 )
-		{
-			spoolerNumReps--;
-
-			result = RewindSoundFile( spoolerSFP );
-
-			result = StartSoundFile( spoolerSFP, spoolerAmplitude );
-
-			/* Keep playing until no more samples. */
-			spoolServiceSignal = 0;
-			
-			do
-			{
-				if ( spoolServiceSignal )
-				{
-					SignalIn = WaitSignal(spoolServiceSignal | spoolerStopSignal | spoolerQuitSignal );
-				}
-				else
-				{
-					SignalIn = 0;
-				}
-
-				if ( (SignalIn & spoolerStopSignal) || (SignalIn & spoolerQuitSignal))
-				{
-					spoolerNumReps = 0;
-					break;
-				}
-
-				// signal must be a service routine
+		/* Keep playing until the list runs out, the next track read in while the last plays */
 
-				result = ServiceSoundFile(spoolerSFP, SignalIn, &spoolServiceSignal);
-
-			} while ( spoolServiceSignal );
-
-
-			result = StopSoundFile (spoolerSFP);
-			
-#if 0
-			if ( spoolerNumReps )
-			{
-				result = RewindSoundFile( spoolerSFP );
-			}
-#endif
-		}
+		SignalIn = SpoolPlayTracks( spoolerTracks, spoolerNumReps, spoolerAmplitude, spoolerEnvIns,
+				spoolerStopSignal | spoolerQuitSignal );
 
 		StopInstrument( spoolerEnvIns, 0 );
 
@@ -747,12 +828,12 @@ static void SpoolSoundFileThread( void )
 
 		DeleteEnvelope( spoolerEnvelope );
 
-		result = UnloadSoundFile( spoolerSFP );
-
+#if RESERVE_SPOOLER_ROOM
 		if ( spoolerRoomIns < 0 )
 		{
 			spoolerRoomIns = LoadInstrument( spoolSaveFileName, 0, 100 );
 		}
+#endif
 
 		spoolerRunning = false;
 
@@ -776,8 +857,7 @@ static void SpoolSoundFileThread( void )
 	if ( spoolerQuitSignal ) FreeSignal( spoolerQuitSignal );
 	spoolerQuitSignal = 0;
 
-	if ( spoolerSFP ) DeleteSoundFilePlayer( spoolerSFP );
-	spoolerSFP = 0;
+	SpoolDeletePlayer();
 
 	if ( spoolerRoomIns >= 0 )
 	{
@@ -838,15 +918,29 @@ static int32 LoadRAMSound( LoadRAMSoundPtr loadSndPtr )
 	sounds[soundSlot].soundID = loadSndPtr->soundID;
 	sounds[soundSlot].amplitude = loadSndPtr->amplitude;
 	sounds[soundSlot].balance = loadSndPtr->balance;
+	sounds[soundSlot].pan[0] = ( loadSndPtr->balance * 0x10000 ) / 100;
+	sounds[soundSlot].pan[1] = ( ( 100 - loadSndPtr->balance ) * 0x10000 ) / 100;
 	sounds[soundSlot].frequency = loadSndPtr->frequency;
+	sounds[soundSlot].priority = loadSndPtr->priority;
+	sounds[soundSlot].endTime = 0;
 
 	sounds[soundSlot].sample = LoadSample( loadSndPtr->soundFileName );
+	sounds[soundSlot].playTicks = SampleTicks( sounds[soundSlot].sample, loadSndPtr->frequency );
+
+	TrackSampleBytes( SampleByteCount( sounds[soundSlot].sample ) );
+
+	// The player follows the sample's format, so SDX2 compressed AIFCs get a decompressing one.
+	// A format none of them plays leaves the slot free rather than a sound that can't start
 
 	instrName = SelectSamplePlayer( sounds[soundSlot].sample, loadSndPtr->frequency );
 	
 	if (instrName == NULL)
 	{
-		// ERROR
+		TrackSampleBytes( -SampleByteCount( sounds[soundSlot].sample ) );
+		UnloadSample( sounds[soundSlot].sample );
+		sounds[soundSlot].soundID = 0;
+
+		return (-1);
 	}
 	
 	strcpy( sounds[soundSlot].instrName, instrName );
@@ -854,11 +948,112 @@ static int32 LoadRAMSound( LoadRAMSoundPtr loadSndPtr )
 	sounds[soundSlot].channel[0] = -1;	// The important one; if this is -1, we haven't assigned a channel
 	sounds[soundSlot].channel[1] = -1;
 
-	AssignChannels( &sounds[soundSlot], false );	// assign a channel if possible
+	// The voice is set up now and kept; if there's no room, lower priority sounds give up theirs.
+	// A sound left without one stays silent rather than being loaded in the middle of a game
+
+	AssignChannels( &sounds[soundSlot], true );
 
 	return ( result );
 }
 
+/*
+**	SampleByteCount() - Size of the sample data for the memory tracker
+*/
+static int32 SampleByteCount( Item sample )
+{
+	TagArg	tags[2];
+
+	tags[0].ta_Tag = AF_TAG_NUMBYTES;
+	tags[0].ta_Arg = 0;
+	tags[1].ta_Tag = TAG_END;
+	tags[1].ta_Arg = 0;
+
+	if ( GetAudioItemInfo( sample, tags ) < 0 )
+	{
+		return 0;
+	}
+
+	return (int32) (long) tags[0].ta_Arg;	// Numbers come back in the pointer, long is its width on either side
+}
+
+/*
+**	TrackSampleBytes() - Adds to the loaded sample total and resizes its memory record. Only the
+**	size, the record was tracked before this thread started
+*/
+static void TrackSampleBytes( int32 bytes )
+{
+	SoundSampleBytes += bytes;
+
+	MemResize( &SoundSampleBytes, SoundSampleBytes );
+}
+
+/*
+**	SampleTicks() - How long one play of a sample lasts in audio ticks. Sounds don't loop
+*/
+static int32 SampleTicks( Item sample, int32 frequency )
+{
+	TagArg	tags[3];
+	int32	frames, rate;
+
+	tags[0].ta_Tag = AF_TAG_FRAMES;
+	tags[0].ta_Arg = 0;
+	tags[1].ta_Tag = AF_TAG_SAMPLE_RATE;
+	tags[1].ta_Arg = 0;
+	tags[2].ta_Tag = TAG_END;
+	tags[2].ta_Arg = 0;
+
+	if ( GetAudioItemInfo( sample, tags ) < 0 )
+	{
+		return 0;
+	}
+
+	frames = (int32) (long) tags[0].ta_Arg;
+	rate = (int32) ( ( (uint32) (long) tags[1].ta_Arg ) >> 16 );	// ufrac16 Hz, unsigned or 44.1kHz and up come out negative
+
+	if ( rate <= 0 )
+	{
+		rate = 44100;
+	}
+
+	if ( frequency )	// 0x8000 is the sampled rate
+	{
+		frames = (int32) ( ( (uint32) ( frames >> 4 ) * 0x8000 ) / (uint32) frequency ) << 4;
+	}
+
+	return ( ( frames / rate ) * AUDIO_TICKS_PER_SECOND ) + ( ( ( frames % rate ) * AUDIO_TICKS_PER_SECOND ) / rate ) + 1;
+}
+
+/*
+**	LowestPrioritySound() - The sound with a voice that gives it up first, NULL if none is
+**	below belowPriority
+*/
+static SoundDataPtr LowestPrioritySound( int32 belowPriority, int32 playingOnly )
+{
+	SoundDataPtr	lowest = NULL;
+	uint32			now = GetAudioTime();
+	int32			i;
+
+	for ( i = 0; i < kMaxRamSounds; i++ )
+	{
+		if ( sounds[i].soundID == 0 || sounds[i].channel[0] < 0 || sounds[i].priority >= belowPriority )
+		{
+			continue;
+		}
+
+		if ( playingOnly && (int32) ( sounds[i].endTime - now ) <= 0 )
+		{
+			continue;
+		}
+
+		if ( lowest == NULL || sounds[i].priority < lowest->priority )
+		{
+			lowest = &sounds[i];
+		}
+	}
+
+	return lowest;
+}
+
 /*
 **	AssignChannels()
 */
@@ -866,7 +1061,8 @@ static int32 AssignChannels( SoundDataPtr theSound, int32 mustSucceed )
 {
 	int32 	result = noErr;
 	char	aName[50];
-	int32	aSlot, anotherSlot, i;
+	int32	aSlot, anotherSlot;
+	SoundDataPtr victim;
 
 	if ( theSound->channel[0] >= 0 )
 	{
@@ -882,21 +1078,28 @@ static int32 AssignChannels( SoundDataPtr theSound, int32 mustSucceed )
 	{
 		if ( mustSucceed == false )
 		{
+			if ( theSound->instrument >= 0 )
+			{
+				MyUnloadInstrument( theSound );
+			}
+
+			theSound->instrument = -1;
+			soundResources.failedAssigns++;
+
 			return noErr;
 		}
 		else
 		{
-			while ( numSoundsAssigned > 0 && (theSound->instrument == AF_ERR_NORSRC || ( theSound->instrument >= 0 && aSlot == -1 ) ) )
+			while ( theSound->instrument == AF_ERR_NORSRC || ( theSound->instrument >= 0 && aSlot == -1 ) )
 			{
-				for ( i = 0; i < kMaxRamSounds; i++ )
+				if ( ( victim = LowestPrioritySound( theSound->priority, false ) ) == NULL )
 				{
-					if ( sounds[i].soundID == assignQueue[0] )
-					{
-						UnassignChannels( &sounds[i] );
-						break;
-					}
+					break;
 				}
 
+				UnassignChannels( victim );
+				soundResources.evictions++;
+
 				if ( theSound->instrument < 0 )
 				{
 					theSound->instrument = MyLoadInstrument( theSound->instrName );
@@ -907,12 +1110,15 @@ static int32 AssignChannels( SoundDataPtr theSound, int32 mustSucceed )
 		}
 	}
 		
-	if ( aSlot == -1 )
+	if ( aSlot == -1 || theSound->instrument < 0 )
 	{		
 		if ( theSound->instrument >= 0 )
 		{
 			MyUnloadInstrument( theSound );
 		}
+
+		theSound->instrument = -1;
+		soundResources.failedAssigns++;
 		
 		return (-1);
 	}
@@ -951,6 +1157,8 @@ static int32 AssignChannels( SoundDataPtr theSound, int32 mustSucceed )
 		
 		if ( anotherSlot == -1 )
 		{
+			soundResources.failedAssigns++;
+
 			if ( mustSucceed )
 			{
 				return (-1);
@@ -977,24 +1185,27 @@ static int32 AssignChannels( SoundDataPtr theSound, int32 mustSucceed )
 		}
 	}
 
+	// Grabbed once here, starting the sound doesn't look the knob up by name
+
+	if ( theSound->frequency && theSound->channel[0] != -1 )
+	{
+		theSound->freqKnob = GrabKnob( theSound->instrument, "Frequency" );
+	}
+
+	DSPTicksInUse( NULL );	// For the peak
+
 	// Make Sure all our mixer levels are correct
 
 	result = SetMixerLevels( soundLibraryMainLevel );
 
-	if ( theSound->channel[0] != -1 && result == noErr )
-	{
-		assignQueue[numSoundsAssigned++] = theSound->soundID;	// add to end of queue
-	}
-		
 	return ( result );
 }
 
 /*
-**	FindEmptyChannel()
+**	ChannelsInUse() - A bit for each mixer channel a sound has
 */
-static int32 FindEmptyChannel()
+static int32 ChannelsInUse()
 {
-	int32	foundChannel = -1;
 	int32	i, j;
 	int32	channelIsHit = 0;
 
@@ -1002,7 +1213,7 @@ static int32 FindEmptyChannel()
 	{
 		if ( sounds[i].soundID )
 		{
-			for ( j = 0; j < 1; j++ )
+			for ( j = 0; j < 2; j++ )	// Both of a stereo sound's channels are taken
 			{
 				if ( sounds[i].channel[j] >= 0 )
 				{
@@ -1012,6 +1223,18 @@ static int32 FindEmptyChannel()
 		}
 	}
 
+	return channelIsHit;
+}
+
+/*
+**	FindEmptyChannel()
+*/
+static int32 FindEmptyChannel()
+{
+	int32	foundChannel = -1;
+	int32	i;
+	int32	channelIsHit = ChannelsInUse();
+
 	for ( i = 0; i < kNumChannels; i++  )
 	{
 		if ( (channelIsHit & (1 << i)) == 0 )
@@ -1029,30 +1252,39 @@ static int32 FindEmptyChannel()
 */
 static Item MyLoadInstrument( char *instrName )
 {
-	int32	 result = noErr;
+	Item	instrument = -1;
 	int32 	i;
 
 	for ( i = 0; i < numCachedInstrs; i++ )
 	{
 		if ( strcmp( instrName, cachedInstrName[i] ) == 0 )
 		{
-			return AllocInstrument( cachedInstrItem[i], 100 );
+			break;
 		}
 	}
 
-	if (numCachedInstrs < MAX_CACHED_INSTRUMENTS)
+	if ( i < numCachedInstrs )
+	{
+		instrument = AllocInstrument( cachedInstrItem[i], 100 );
+	}
+	else if (numCachedInstrs < MAX_CACHED_INSTRUMENTS)
 	{
 		strcpy( cachedInstrName[numCachedInstrs], instrName );
 		cachedInstrItem[numCachedInstrs] = LoadInsTemplate( instrName, 0 );
 
-		return AllocInstrument( cachedInstrItem[numCachedInstrs++], 100 );
+		instrument = AllocInstrument( cachedInstrItem[numCachedInstrs++], 100 );
 	}
 	else
 	{
-		return LoadInstrument( instrName, 0, 100 );
+		instrument = LoadInstrument( instrName, 0, 100 );
+	}
+
+	if ( instrument == AF_ERR_NORSRC )
+	{
+		soundResources.noResource++;
 	}
 		
-	return (-1);
+	return instrument;
 }
 
 /*
@@ -1094,6 +1326,7 @@ static int32 UnloadRAMSound( int32 soundID )
 
 			UnassignChannels( &sounds[i] );
 
+			TrackSampleBytes( -SampleByteCount( sounds[i].sample ) );
 			UnloadSample( sounds[i].sample );
 			sounds[i].sample = -1;
 
@@ -1116,7 +1349,6 @@ static int32 UnassignChannels( SoundDataPtr theSound )
 {
 	char	aName[50];
 	int32	result = noErr;
-	int32	i;
 	int32	channel0, channel1;
 
 	if ( theSound->channel[0] == -1 )
@@ -1124,16 +1356,6 @@ static int32 UnassignChannels( SoundDataPtr theSound )
 		return noErr;
 	}
 
-	for ( i = 0; i < numSoundsAssigned; i++ )
-	{
-		if ( assignQueue[i] == theSound->soundID )
-		{
-			numSoundsAssigned--;
-			memcpy( (void *) &assignQueue[i], (void *) &assignQueue[i+1], (numSoundsAssigned - i) * sizeof(int32) );
-			break;
-		}
-	}
-
 	channel0 = theSound->channel[0];
 	channel1 = theSound->channel[1];
 
@@ -1159,6 +1381,7 @@ static int32 UnassignChannels( SoundDataPtr theSound )
 	}
 
 	StopInstrument( theSound->instrument, 0 );
+	theSound->endTime = 0;
 
 	if ( theSound->freqKnob != -1 )
 	{
@@ -1189,12 +1412,15 @@ TagArg VariableRAMSoundTags[] =
 };
 
 /*
-**	StartRAMSound()
+**	StartRAMSound() - Only starts the instrument LoadRAMSound set up. At kMaxPlayingSounds
+**	the lowest priority sound playing is stopped first, unless this one is lower still
 */
 static int32 StartRAMSound( int32 soundID )
 {
  	int32 	result = noErr;
-	int32 	i, soundSlot;
+	int32 	i, soundSlot, playing;
+	uint32	now;
+	SoundDataPtr victim;
 
 	soundSlot = -1;
 	
@@ -1212,25 +1438,59 @@ static int32 StartRAMSound( int32 soundID )
 		return (-1);
 	}
 
-	if ( AssignChannels( &sounds[soundSlot], true ) )
+	if ( sounds[soundSlot].channel[0] == -1 )
 	{
-		return (-1);
+		soundResources.silentStarts++;
+
+		return (-1);	// Lost its voice at load time
+	}
+
+	now = GetAudioTime();
+	playing = 0;
+
+	for ( i = 0; i < kMaxRamSounds; i++ )
+	{
+		if ( i != soundSlot && sounds[i].channel[0] >= 0 && (int32) ( sounds[i].endTime - now ) > 0 )
+		{
+			playing++;
+		}
+	}
+
+	if ( playing >= kMaxPlayingSounds && (int32) ( sounds[soundSlot].endTime - now ) <= 0 )
+	{
+		victim = LowestPrioritySound( sounds[soundSlot].priority + 1, true );
+
+		if ( victim == NULL )
+		{
+			soundResources.drops++;
+
+			return (-1);	// Everything playing outranks it
+		}
+
+		StopInstrument( victim->instrument, NULL );
+		victim->endTime = now;
+		soundResources.steals++;
+	}
+
+	if ( (int32) ( sounds[soundSlot].endTime - now ) > 0 )
+	{
+		StopInstrument( sounds[soundSlot].instrument, NULL );	// Restart from the top
 	}
 
 	if ( sounds[soundSlot].frequency ) 
 	{
 		VariableRAMSoundTags[0].ta_Arg = (int32 *) MAXAMPLITUDE;
-		VariableRAMSoundTags[1].ta_Arg = (int32 *) sounds[soundSlot].frequency;
+		VariableRAMSoundTags[1].ta_Arg = (int32 *) (long) sounds[soundSlot].frequency;
 		
-		StartInstrument( sounds[soundSlot].instrument, &VariableRAMSoundTags[0] );
-
-		sounds[soundSlot].freqKnob = GrabKnob( sounds[soundSlot].instrument, "Frequency" );
+		result = StartInstrument( sounds[soundSlot].instrument, &VariableRAMSoundTags[0] );
 	}
 	else
 	{
 		FixedRAMSoundTags[0].ta_Arg = (int32 *) MAXAMPLITUDE;
-		StartInstrument( sounds[soundSlot].instrument, &FixedRAMSoundTags[0] );
+		result = StartInstrument( sounds[soundSlot].instrument, &FixedRAMSoundTags[0] );
 	}
+
+	sounds[soundSlot].endTime = now + sounds[soundSlot].playTicks;
 	
 	return result;
 }
@@ -1259,7 +1519,13 @@ static int32 StopRAMSound( int32 soundID )
 		return (-1);
 	}
 
+	if ( sounds[soundSlot].channel[0] == -1 )
+	{
+		return (-1);
+	}
+
 	StopInstrument( sounds[soundSlot].instrument, NULL);
+	sounds[soundSlot].endTime = 0;
 
 	return result;
 }
@@ -1349,6 +1615,45 @@ static int32 SetRAMSoundAmpl( SetRAMSoundPtr setSndPtr )
 	return result;
 }
 
+/*
+**	SetRAMSoundPan() - Only the sound's own gain knobs, and only if they change
+*/
+static int32 SetRAMSoundPan( SetRAMSoundPanPtr panSndPtr )
+{
+	int32 	i, soundSlot;
+
+	soundSlot = -1;
+	
+	for ( i = 0; i < kMaxRamSounds; i++ )
+	{
+		if ( sounds[i].soundID == panSndPtr->soundID )
+		{
+			soundSlot = i;
+			break;
+		}
+	}
+
+	if ( soundSlot == -1 )
+	{
+		return (-1);
+	}
+
+	if ( sounds[soundSlot].pan[0] == panSndPtr->left && sounds[soundSlot].pan[1] == panSndPtr->right )
+	{
+		return noErr;
+	}
+
+	sounds[soundSlot].pan[0] = panSndPtr->left;
+	sounds[soundSlot].pan[1] = panSndPtr->right;
+
+	if ( sounds[soundSlot].channel[0] >= 0 )
+	{
+		SetSoundLevels( &sounds[soundSlot] );
+	}
+
+	return noErr;
+}
+
 /*
 **	FlushInstrument()
 */
@@ -1375,4 +1680,106 @@ static int32 FlushInstrument( Item SamplerIns )
 	DetachSample( Attachment );
 	
 	return result;
-}
\ No newline at end of file
+}
+
+/****************************************/
+/* Resources							*/
+/****************************************/
+
+/*
+**	DSPTicksFor() - What one instrument takes of the dsp a frame
+*/
+static int32 DSPTicksFor( char *instrName )
+{
+	int32	i;
+
+	for ( i = 0; i < (int32) ( sizeof( dspCosts ) / sizeof( dspCosts[0] ) ); i++ )
+	{
+		if ( strcmp( instrName, dspCosts[i].instrName ) == 0 )
+		{
+			return dspCosts[i].ticks;
+		}
+	}
+
+	return kUnlistedDSPTicks;
+}
+
+/*
+**	DSPTicksInUse() - What the library holds in the dsp now, and how many instruments. A
+**	spooler player is charged what its room held for it
+*/
+static int32 DSPTicksInUse( int32 *instruments )
+{
+	int32	i, ticks = 0, count = 0, players;
+
+	if ( MixerIns >= 0 )
+	{
+		ticks += DSPTicksFor( mixerFileName );
+		count++;
+	}
+
+	if ( spoolerEnvIns >= 0 )
+	{
+		ticks += DSPTicksFor( envelopeFileName );
+		count++;
+	}
+
+	players = ( spoolerRoomIns >= 0 ) + ( spoolerRunning ? 1 + Spool.Primed : 0 );
+
+	ticks += players * DSPTicksFor( spoolSaveFileName );
+	count += players;
+
+	for ( i = 0; i < kMaxRamSounds; i++ )
+	{
+		if ( sounds[i].soundID && sounds[i].channel[0] >= 0 )
+		{
+			ticks += DSPTicksFor( sounds[i].instrName );
+			count++;
+		}
+	}
+
+	if ( ticks > soundResources.dspTicksPeak )
+	{
+		soundResources.dspTicksPeak = ticks;
+	}
+
+	if ( instruments )
+	{
+		*instruments = count;
+	}
+
+	return ticks;
+}
+
+/*
+**	GetSoundResources()
+*/
+void GetSoundResources( SoundResourcePtr resources )
+{
+	int32	i, inUse;
+
+	soundResources.dspTicks = DSPTicksInUse( &soundResources.instruments );
+
+	inUse = ChannelsInUse();
+
+	soundResources.voices = 0;
+	soundResources.channelsFree = kNumChannels;
+
+	for ( i = 0; i < kMaxRamSounds; i++ )
+	{
+		if ( sounds[i].soundID && sounds[i].channel[0] >= 0 )
+		{
+			soundResources.voices++;
+		}
+	}
+
+	for ( i = 0; i < kNumChannels; i++ )
+	{
+		if ( inUse & (1 << i) )
+		{
+			soundResources.channelsFree--;
+		}
+	}
+
+	*resources = soundResources;
+}
@@ -32,8 +32,22 @@ Change History:
 			loading of too many RAM sounds precluding the use of the dsp for spooling.
 			DSP instruments I use (the mixer, the envelope, and the spooler room reserver)
 			no longer have pathnames, as they are not needed.
+10/19/26	Sounds get their instrument, attachment and mixer channels when they're loaded and
+			keep them, kStartRAMSound only starts the instrument. When the dsp or the mixer
+			runs out a load takes the voice of a lower priority sound, and kMaxPlayingSounds
+			caps how many sound at once the same way.
+10/19/26	RESERVE_SPOOLER_ROOM, off for score music, decides whether the spooler room
+			instrument is loaded at all.
+10/19/26	Added kSetRAMSoundPan (new data structure, too). It moves a loaded sound between the
+			speakers by tweaking its two gain knobs, nothing is reloaded or reconnected.
+10/19/26	GetSoundResources() reports what the library holds in the dsp and the mixer, and
+			counts the loads and starts that went without because of it.
+10/19/26	Loaded samples are counted in SoundSampleBytes, one MEM_TAG_AUDIO record the
+			game thread tracks before the library's thread starts. The library only resizes it.
 ***************************************************************/
 
+#ifndef HD3DOAUDIOSOUNDINTERFACE_H
+#define HD3DOAUDIOSOUNDINTERFACE_H
 
 
 /************************************************************/
@@ -73,6 +87,22 @@ enum {
 
 #define	kMaxRamSounds	7 
 
+// Most RAM sounds that sound at once. Starting another one past this steals the voice of
+// the lowest priority sound playing, or is dropped if everything playing outranks it.
+
+#define	kMaxPlayingSounds	4
+
+// Keep room in the dsp for the spooler instrument while nothing is spooling. Score music
+// (AUDIO_MUSIC_SCORE) never spools and wants that room for its own voices.
+
+#ifndef RESERVE_SPOOLER_ROOM
+#if AUDIO_MUSIC_SCORE
+#define	RESERVE_SPOOLER_ROOM	0
+#else
+#define	RESERVE_SPOOLER_ROOM	1
+#endif
+#endif
+
 /************************************************************/
 /* Section2 - Things you don't want to change.				*/
 /************************************************************/
@@ -85,6 +115,7 @@ enum {
 #define	kEnvelopeFileName 		"envelope.dsp"
 #define	kSpoolerRoomSaveName	"halfmono8.dsp"
 #define	kNumChannels	8
+#define	kDSPTicks		565		// DSP instructions a frame at 44.1kHz, shared by every instrument
 
 #define THREAD_PARENT	((Item)KernelBase->kb_CurrentTask->t_ThreadTask->t.n_Item)
 
@@ -96,6 +127,8 @@ typedef struct SoundDataRec
 									// no sound for this channel
 	int32	amplitude;				// Channel Volume Level - if stereo, this is divided
 	int32	balance;				// For stereo sounds, how much left and right
+	int32	pan[2];					// Left and right shares of amplitude, frac16. From
+									// balance at load, kSetRAMSoundPan after
 	int32	frequency;				// If non-zero, frequency to play sound at
 	Item	sample;					// Sample
 	char	instrName[100];			// name of instrument being used
@@ -107,8 +140,32 @@ typedef struct SoundDataRec
 	Item	instrument;				// Instrument
 	Item	attachment;				// Attachment of sample to instrument
 	Item	freqKnob;				// frequency knob (for variable rate sounds)
+
+	int32	priority;				// Higher keeps its voice when another sound needs one
+	int32	playTicks;				// Audio ticks one play lasts
+	uint32	endTime;				// Audio time the last start runs out
 } SoundDataRec, *SoundDataPtr, **SoundDataHdl;
 
+// Resources the library holds and what running out of them cost. The folio doesn't say how
+// much of the dsp an instrument takes, so dspTicks is the library's own estimate. Score
+// music's voices aren't the library's and aren't counted
+
+typedef struct SoundResourceRec
+{
+	int32	dspTicks;				// In use now, of kDSPTicks
+	int32	dspTicksPeak;
+	int32	instruments;			// Mixer, envelope, spooler room or players, and voices
+	int32	voices;					// Sounds with an instrument and mixer channels
+	int32	channelsFree;			// Mixer inputs no sound has
+
+	uint32	noResource;				// Instrument loads the dsp had no room for
+	uint32	failedAssigns;			// Loads that left a sound without a voice
+	uint32	evictions;				// Voices taken from lower priority sounds by a load
+	uint32	steals;					// Sounds stopped at kMaxPlayingSounds for another to start
+	uint32	drops;					// Starts dropped, everything playing outranked them
+	uint32	silentStarts;			// Starts of a sound that has no voice
+} SoundResourceRec, *SoundResourcePtr, **SoundResourceHdl;
+
 
 /************************************************************/
 /* Section3 - How to call my sound interface				*/
@@ -130,7 +187,11 @@ enum {
 	kSetRAMSoundFreq,		// Set frequency of a variable-rate RAM sound.
 	kSetRAMSoundAmpl,		// Set the amplitude of a variable-rate RAM sound.
 	kStopFadeSpoolSound,	// Fade spooled sound out over number of seconds specified
-	kIsSoundSpooling		// Returns a non-zero value if a sound is currently being spooled
+	kIsSoundSpooling,		// Returns a non-zero value if a sound is currently being spooled
+	kSpoolPlaylist,			// Spools a list of files in turn until stopped. If one is already spooling,
+							// the new list takes over from its next track.
+	kSetRAMSoundPan			// Set the left and right gains of a RAM sound. Only its gain knobs change,
+							// so it's cheap enough to do before every start.
 };
 
 //	Data Structures (Parameter Blocks) you pass to CallSound()
@@ -150,6 +211,8 @@ typedef	struct LoadRAMSoundRec
 	int32	frequency;				// If non-zero, sound is variable-rate and value
 									// specifies rate to play sound at. 0x8000 is sampled
 									// rate, 0x4000 is 1/2 rate, etc.
+	int32	priority;				// Which sound gets the voice when there aren't enough;
+									// higher wins, equal steals from the one playing
 } LoadRAMSoundRec, *LoadRAMSoundPtr, **LoadRAMSoundHdl;
 
 //	Start, Stop, and Unload RAM Sound Parameter Block
@@ -174,6 +237,20 @@ typedef	struct SetRAMSoundRec
 } SetRAMSoundRec, *SetRAMSoundPtr, **SetRAMSoundHdl;
 
 
+// Set left and right gains for RAM Sound Parameter Block
+
+typedef	struct SetRAMSoundPanRec
+{
+	int32	whatIWant;				// Union Structure Identifier; must be the first
+									// field for all parameter blocks
+	int32	soundID;				// unique sound identifier used to refer to sound
+									// from now on when playing it, stopping it, etc.
+	int32	left;					// Share of the sound's amplitude each side gets, frac16.
+	int32	right;					// 0x8000 each is balance 50; keep left^2 + right^2 the
+									// same to keep it as loud as it moves
+} SetRAMSoundPanRec, *SetRAMSoundPanPtr, **SetRAMSoundPanHdl;
+
+
 // Spool Sound Parameter Block
 
 typedef	struct SpoolSoundRec
@@ -185,6 +262,17 @@ typedef	struct SpoolSoundRec
 	int32	amplitude;				// Amplitude of sound when played (0-0x7FFF)
 }	SpoolSoundRec, *SpoolSoundPtr, **SpoolSoundHdl;
 
+// Spool Playlist Parameter Block
+
+typedef	struct SpoolPlaylistRec
+{
+	int32	whatIWant;				// Union Structure Identifier; must be the first
+									// field for all parameter blocks
+	char **	tracks;					// NULL terminated list of files, played in turn and then
+									// again from the first. Must stay put while it plays
+	int32	amplitude;				// Amplitude of sound when played (0-0x7FFF)
+}	SpoolPlaylistRec, *SpoolPlaylistPtr, **SpoolPlaylistHdl;
+
 // Spool Sound Parameter Block
 
 typedef	struct SpoolFadeSoundRec
@@ -203,13 +291,27 @@ typedef union CallSoundRec
 										// field for all parameter blocks
 	LoadRAMSoundRec		loadSound;
 	SpoolSoundRec		spoolSound;
+	SpoolPlaylistRec	spoolPlaylist;
 	SpoolFadeSoundRec 	fadeSound;
 	RAMSoundRec			ramSound;
 	SetRAMSoundRec		setSound;
+	SetRAMSoundPanRec	panSound;
 } CallSoundRec, *CallSoundPtr, **CallSoundHdl;
 
 // 	This is the function you always call.
 //	This function definition shouldn't ever change, although the
 //	parameter blocks might (but hopefully not).
 
-int32	CallSound( union CallSoundRec *soundPtr );
\ No newline at end of file
+int32	CallSound( union CallSoundRec *soundPtr );
+
+//	Bytes of every loaded sample, tracked under &SoundSampleBytes by whoever starts the
+//	thread that loads them
+
+extern	uint32	SoundSampleBytes;
+
+//	Only from the thread that makes the other calls, it moves the peak. The counts
+//	are reset by kInitializeSound
+
+void	GetSoundResources( SoundResourcePtr resources );
+
+#endif
@@ -0,0 +1,388 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Spooler buffering, track changes and telemetry, see HD3DOAudioSpool.h.
+//	ServiceSoundFile hands back one signal per buffer it's waiting on, so
+//	the counts come from the signal masks either side of the call: signals
+//	we woke with are buffers that played, and any of the others already sent
+//	by the time it returns played while it was waiting on the drive. Buffers
+//	that came free without as many going back in mean the file has been read
+//	to the end, and that is when the next track is read into the standby
+//
+//	The buffers of both players are one MEM_TAG_MUSIC record under &Spool.
+//	Whoever starts the spooler tracks it first (AudioStart, before the audio
+//	thread that starts the spooler exists) and the spooler only resizes it,
+//	so it never takes a slot in the table from under the game
+//
+
+*/
+
+#include "types.h"
+#include "strings.h"
+#include "kernel.h"
+#include "audio.h"
+#include "soundfile.h"
+
+#include "HD3DOAudioSpool.h"
+#include "HD3DOMem.h"
+
+SpoolState Spool =
+{
+	SPOOL_IDLE_BUFFERS,
+	SPOOL_BUSY_BUFFERS,
+	SPOOL_BUFFER_SIZE
+};
+
+static uint32 CountBits(uint32 bits)
+{
+	uint32 n = 0;
+
+	for (; bits != 0; bits &= bits - 1) n++;
+
+	return n;
+}
+
+static int32 Wanted()
+{
+	int32 buffers = (Spool.Busy ? Spool.BusyBuffers : Spool.IdleBuffers) + Spool.Extra;
+
+	if (buffers < SPOOL_MIN_BUFFERS) return SPOOL_MIN_BUFFERS;
+	if (buffers > SPOOL_MAX_BUFFERS) return SPOOL_MAX_BUFFERS;
+
+	return buffers;
+}
+
+static SoundFilePlayer *Create(int32 buffers, int32 *created)
+{
+	SoundFilePlayer *sfp = NULL;
+
+	for (; buffers >= SPOOL_MIN_BUFFERS; buffers--) // Fewer than asked for beats no music
+	{
+		if ((sfp = CreateSoundFilePlayer(buffers, Spool.BufferSize, NULL)) != NULL) break;
+	}
+
+	*created = sfp != NULL ? buffers : 0;
+
+	return sfp;
+}
+
+static void Track()
+{
+	MemResize(&Spool, (Spool.Buffers + Spool.StandbyBuffers) * Spool.BufferSize);
+}
+
+/* ----- Configuration ----- */
+
+void SpoolConfigure(int32 idleBuffers, int32 busyBuffers, int32 bufferSize)
+{
+	if (idleBuffers > 0) Spool.IdleBuffers = idleBuffers;
+	if (busyBuffers > 0) Spool.BusyBuffers = busyBuffers;
+	if (bufferSize > 0) Spool.BufferSize = bufferSize;
+}
+
+void SpoolBusy(bool busy)
+{
+	Spool.Busy = busy;
+}
+
+void SpoolResetStats()
+{
+	Spool.Services = 0;
+	Spool.BuffersPlayed = 0;
+	Spool.Underruns = 0;
+	Spool.ServiceTicks = 0;
+	Spool.ServicePeak = 0;
+	Spool.Passes = 0;
+	Spool.Resizes = 0;
+	Spool.Changes = 0;
+	Spool.LateChanges = 0;
+
+	memset(Spool.Fill, 0, sizeof(Spool.Fill));
+}
+
+void SpoolQueueTracks(char **tracks)
+{
+	Spool.Want = tracks;
+}
+
+/* ----- Players ----- */
+
+void SpoolCreatePlayer()
+{
+	SpoolResetStats();
+
+	Spool.Player = Create(Wanted(), &Spool.Buffers);
+	Spool.Envelope = -1;
+
+	Track();
+}
+
+static void DeleteStandby()
+{
+	if (Spool.Standby == NULL) return;
+
+	DeleteSoundFilePlayer(Spool.Standby);
+
+	Spool.Standby = NULL;
+	Spool.StandbyBuffers = 0;
+
+	Track();
+}
+
+void SpoolDeletePlayer()
+{
+	if (Spool.Standby != NULL) DeleteSoundFilePlayer(Spool.Standby);
+	if (Spool.Player != NULL) DeleteSoundFilePlayer(Spool.Player);
+
+	Spool.Player = NULL;
+	Spool.Standby = NULL;
+	Spool.Buffers = 0;
+	Spool.StandbyBuffers = 0;
+
+	Track();
+}
+
+// An idle player, remade first if it isn't the size wanted now
+
+static bool Load(SoundFilePlayer **sfp, int32 *buffers, char *file)
+{
+	if (*sfp == NULL || *buffers != Wanted())
+	{
+		if (*sfp != NULL)
+		{
+			DeleteSoundFilePlayer(*sfp); // First, growing wants the memory back
+
+			Spool.Resizes++;
+		}
+
+		*buffers = 0;
+		*sfp = Create(Wanted(), buffers);
+
+		Track();
+	}
+
+	return *sfp != NULL && LoadSoundFile(*sfp, file) >= 0;
+}
+
+static void Connect(SoundFilePlayer *sfp)
+{
+	if (Spool.Envelope >= 0) ConnectInstruments(Spool.Envelope, "Output", sfp->sfp_SamplerIns, "Amplitude");
+}
+
+static void Disconnect(SoundFilePlayer *sfp)
+{
+	if (Spool.Envelope >= 0) DisconnectInstruments(Spool.Envelope, "Output", sfp->sfp_SamplerIns, "Amplitude");
+}
+
+// Up from the 0 it was paused at, unless the envelope has it
+
+static void Amplify(SoundFilePlayer *sfp)
+{
+	Item knob;
+
+	if (Spool.Envelope >= 0) return;
+
+	if ((knob = GrabKnob(sfp->sfp_SamplerIns, "Amplitude")) < 0) return;
+
+	TweakKnob(knob, Spool.Amplitude);
+	ReleaseKnob(knob);
+}
+
+static void Finish(SoundFilePlayer *sfp)
+{
+	StopSoundFile(sfp);
+	Disconnect(sfp);
+	UnloadSoundFile(sfp);
+}
+
+/* ----- Tracks ----- */
+
+static char *NextTrack()
+{
+	char **want = Spool.Want;
+
+	if (want != NULL && want != Spool.Tracks) // Queued since the last one
+	{
+		Spool.Tracks = want;
+		Spool.Track = 0;
+	}
+
+	if (Spool.Tracks == NULL || Spool.Tracks[0] == NULL) return NULL;
+
+	if (Spool.Tracks[Spool.Track] == NULL)
+	{
+		if (--Spool.Reps <= 0) return NULL;
+
+		Spool.Track = 0;
+	}
+
+	return Spool.Tracks[Spool.Track++];
+}
+
+// Reads the next track into the standby, its sampler paused at amplitude 0
+// so the moment it runs before the pause is silent. The envelope brings it
+// up once it's connected, or Amplify as it resumes
+
+static void Prefetch()
+{
+	char *file = NextTrack();
+
+	if (file == NULL) return;
+
+	if (Load(&Spool.Standby, &Spool.StandbyBuffers, file) == false) return;
+
+	StartSoundFile(Spool.Standby, 0);
+	PauseInstrument(Spool.Standby->sfp_SamplerIns);
+	Connect(Spool.Standby);
+
+	Spool.Primed = true;
+
+	if (Spool.Waiting != 0 && (GetCurrentSignals() & Spool.Waiting) == Spool.Waiting) Spool.LateChanges++; // All played while we read
+}
+
+/* ----- Playing ----- */
+
+// Returns true once the player has nothing left to read
+
+static bool Service(SoundFilePlayer *sfp, int32 signalIn, int32 *needed)
+{
+	uint32 start = GetAudioTime(), ticks;
+	int32 late, queued, kept = CountBits(Spool.Waiting & ~signalIn);
+	bool freed = (signalIn & Spool.Waiting) != 0;
+
+	ServiceSoundFile(sfp, signalIn, needed);
+
+	ticks = GetAudioTime() - start;
+	late = GetCurrentSignals() & Spool.Waiting & ~signalIn; // Played while it was in there
+	queued = CountBits(*needed & ~late);
+
+	Spool.Services++;
+	Spool.BuffersPlayed += CountBits(signalIn & Spool.Waiting);
+	Spool.ServiceTicks += ticks;
+
+	if (ticks > Spool.ServicePeak) Spool.ServicePeak = ticks;
+
+	Spool.Fill[queued < SPOOL_FILL_LEVELS ? queued : SPOOL_FILL_LEVELS - 1]++;
+
+	if (*needed != 0 && Spool.Waiting != 0 && (Spool.Waiting & ~(signalIn | late)) == 0) // The last one of a track drains by design
+	{
+		Spool.Underruns++;
+		Spool.TrackUnderran = true;
+	}
+
+	Spool.Waiting = *needed;
+
+	return freed && (int32)CountBits(*needed) <= kept; // Buffers came free and none were refilled
+}
+
+// The playing track to its end, the next one read into the standby on the way
+
+static int32 Play(int32 stopSignals)
+{
+	int32 signalIn = 0, needed = 0;
+	bool fetched = false;
+
+	Spool.Waiting = 0;
+	Spool.TrackUnderran = false;
+
+	do
+	{
+		if (needed != 0) signalIn = WaitSignal(needed | stopSignals);
+
+		if (signalIn & stopSignals) break;
+
+		if (Service(Spool.Player, signalIn, &needed) && fetched == false)
+		{
+			Prefetch(); // Once, the list may have run out
+
+			fetched = true;
+		}
+
+	} while (needed != 0);
+
+	if (needed == 0) Spool.Passes++;
+
+	if (Spool.TrackUnderran)
+	{
+		if (Wanted() < SPOOL_MAX_BUFFERS) Spool.Extra++;
+	}
+	else if (Spool.Extra > 0)
+	{
+		Spool.Extra--;
+	}
+
+	return signalIn & stopSignals;
+}
+
+int32 SpoolPlayTracks(char **tracks, int32 reps, int32 amplitude, Item envelope, int32 stopSignals)
+{
+	SoundFilePlayer *sfp;
+	int32 stopped = 0, buffers;
+	char *file;
+
+	Spool.Tracks = tracks;
+	Spool.Want = tracks;
+	Spool.Track = 0;
+	Spool.Reps = reps;
+	Spool.Envelope = envelope;
+	Spool.Amplitude = amplitude;
+	Spool.Primed = false;
+
+	file = NextTrack();
+
+	if (file == NULL || Load(&Spool.Player, &Spool.Buffers, file) == false) return 0;
+
+	Connect(Spool.Player);
+	StartSoundFile(Spool.Player, amplitude);
+
+	while (true)
+	{
+		stopped = Play(stopSignals);
+
+		if (stopped != 0 || Spool.Primed == false) break;
+
+		Amplify(Spool.Standby);
+		ResumeInstrument(Spool.Standby->sfp_SamplerIns); // First, the old one has just played its last
+
+		Finish(Spool.Player);
+
+		sfp = Spool.Player; // Swap, the old player waits for the track after
+		Spool.Player = Spool.Standby;
+		Spool.Standby = sfp;
+
+		buffers = Spool.Buffers;
+		Spool.Buffers = Spool.StandbyBuffers;
+		Spool.StandbyBuffers = buffers;
+
+		Spool.Primed = false;
+		Spool.Changes++;
+	}
+
+	Finish(Spool.Player);
+
+	if (Spool.Primed) Finish(Spool.Standby);
+
+	Spool.Primed = false;
+
+	DeleteStandby();
+
+	return stopped;
+}
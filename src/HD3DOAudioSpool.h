@@ -0,0 +1,112 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Buffering, track changes and telemetry for the music spooler. The sound
+//	library's spooler thread hands SpoolPlayTracks a list of files and it
+//	plays them in turn, counting what every ServiceSoundFile call did:
+//
+//	Fill		Buffers still queued to play when the service returned
+//	Underruns	Services that found every buffer they were waiting on had
+//				already played, the sampler ran dry before they refilled
+//	Service		Audio ticks spent in ServiceSoundFile, mostly waiting on
+//				the drive
+//
+//	A player's buffers are fixed while it plays, so the size changes only
+//	between tracks: Busy asks for BusyBuffers while the game is loading from
+//	the same disc, IdleBuffers otherwise to give the memory back, and a track
+//	that underran adds one more until a clean one
+//
+//	Track changes are gapless. Once the playing track has read its last
+//	buffer a second player, the standby, loads the next file, fills its
+//	buffers and is paused before a sample of it is heard. When the last
+//	buffer of the old track has played the standby resumes and the two swap
+//	over, so the drive is never in the way of a change. The standby is only
+//	there while tracks are playing, the memory goes back when they stop
+//
+//	SpoolQueueTracks swaps the list for another from any thread. Nothing is
+//	cut or faded, the new list starts with the next track the standby loads
+//
+
+*/
+
+#ifndef HD3DOAUDIOSPOOL_H
+#define HD3DOAUDIOSPOOL_H
+
+#include "types.h"
+#include "soundfile.h"
+
+#define SPOOL_BLOCK_SIZE 2048			// Disc block
+#define SPOOL_BUFFER_SIZE (24 * SPOOL_BLOCK_SIZE)	// ~0.56s of 44.1kHz mono, twice that SDX2 compressed
+#define SPOOL_IDLE_BUFFERS 2			// Nothing else reading, one plays while the other fills
+#define SPOOL_BUSY_BUFFERS 6			// Rides out a background load holding the drive for a second or two
+#define SPOOL_MIN_BUFFERS 2
+#define SPOOL_MAX_BUFFERS 8
+#define SPOOL_FILL_LEVELS (SPOOL_MAX_BUFFERS + 1)
+
+typedef struct SpoolState
+{
+	int32 IdleBuffers;					// Set by SpoolConfigure
+	int32 BusyBuffers;
+	int32 BufferSize;
+	volatile bool Busy;					// Written by the audio thread, read by the spooler between passes
+
+	SoundFilePlayer *Player;			// Playing
+	SoundFilePlayer *Standby;			// Next track, paused once it's read in
+	int32 Buffers;						// Each as it was created
+	int32 StandbyBuffers;
+	int32 Extra;						// Added after a track that underran
+	int32 Waiting;						// Signals the player was waiting on before this service
+	bool TrackUnderran;
+	bool Primed;						// Standby has the next track ready to resume
+
+	char **Tracks;						// NULL terminated, playing from this list
+	char ** volatile Want;				// Set by SpoolQueueTracks, read by the spooler at each prefetch
+	int32 Track;						// Next in Tracks to load
+	int32 Reps;							// Times through the list left, this one too
+	Item Envelope;						// Drives the playing sampler's amplitude, -1 for none
+	int32 Amplitude;					// The samplers' without one
+
+	uint32 Services;
+	uint32 BuffersPlayed;
+	uint32 Underruns;
+	uint32 Fill[SPOOL_FILL_LEVELS];		// Services by buffers still queued after them
+	uint32 ServiceTicks;				// Total and worst, audio ticks
+	uint32 ServicePeak;
+	uint32 Passes;						// Tracks played to the end
+	uint32 Resizes;
+	uint32 Changes;						// From one track to the next without stopping
+	uint32 LateChanges;					// Of those, the old track ran dry before the next was read in
+} SpoolState;
+
+extern SpoolState Spool;
+
+void SpoolConfigure(int32 idleBuffers, int32 busyBuffers, int32 bufferSize);	// Before initsound, 0 keeps the default
+void SpoolBusy(bool busy);
+void SpoolResetStats(void);
+void SpoolQueueTracks(char **tracks);	// Takes over from the next track, the same list again changes nothing
+
+// Spooler thread only
+
+void SpoolCreatePlayer(void);
+void SpoolDeletePlayer(void);
+int32 SpoolPlayTracks(char **tracks, int32 reps, int32 amplitude, Item envelope, int32 stopSignals);	// Returns the stop signals that ended it early
+
+#endif
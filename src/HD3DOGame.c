@@ -0,0 +1,618 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Gameplay rules on a GameState, see HD3DOGame.h. Board rows are 0 at the
+//	top and BOARD_HEIGHT - 1 at the bottom, the active block can sit above
+//	row 0 while it spawns
+//
+
+*/
+
+#include "types.h"
+#include "strings.h"
+
+#include "HD3DOGame.h"
+
+BlockCoord DefaultBlockCoords[PIECE_SHAPES][4] = // Relative to it's queue position
+{
+	{ { 21, 3 }, { 22, 3 }, { 23, 3 }, { 24, 3 } }, // 1.) I-Block
+	{ { 22, 3 }, { 22, 4 }, { 23, 3 }, { 23, 4 } }, // 2.) O-Block
+	{ { 21, 3 }, { 22, 3 }, { 22, 4 }, { 23, 3 } }, // 3.) T-Block
+	{ { 21, 4 }, { 22, 3 }, { 22, 4 }, { 23, 3 } }, // 4.) S-Block
+	{ { 21, 3 }, { 22, 3 }, { 22, 4 }, { 23, 4 } }, // 5.) Z-Block
+	{ { 21, 3 }, { 21, 4 }, { 22, 4 }, { 23, 4 } }, // 6.) J-Block
+	{ { 21, 4 }, { 21, 3 }, { 22, 3 }, { 23, 3 } }  // 7.) L-Block
+};
+
+int BlockPivotIdx[PIECE_SHAPES] = { 2, -1, 1, 1, 1, 2, 2 }; // The pivot / rotation point of each respective Tetrimino block
+
+static uint32 zCell[BOARD_WIDTH][BOARD_HEIGHT]; // Zobrist keys, see GameHash
+static uint32 zActive[BOARD_WIDTH][HASH_ACTIVE_ROWS];
+static uint32 zShape[3][8]; // Active, queued, held. 7 is none
+
+/* ----- Setup ----- */
+
+// Zobrist style: a key per board cell, XORed in and out as cells change, so locks and clears
+// cost a few lookups instead of a walk over the board. Moves and rotations cost nothing, the
+// active block's keys are looked up per call to GameHash
+
+void GameInitKeys()
+{
+	RandomState rs;
+	int x, y;
+
+	RandomSeed(&rs, 0x3d0f1e1d); // Fixed, so the ARM60 and host builds agree
+
+	for (x = 0; x < BOARD_WIDTH; x++)
+	{
+		for (y = 0; y < BOARD_HEIGHT; y++) zCell[x][y] = RandomNext(&rs);
+		for (y = 0; y < HASH_ACTIVE_ROWS; y++) zActive[x][y] = RandomNext(&rs);
+	}
+
+	for (x = 0; x < 3; x++)
+	{
+		for (y = 0; y < 8; y++) zShape[x][y] = RandomNext(&rs);
+	}
+}
+
+void GameInit(GameState *gs, uint32 seed)
+{
+	memset(gs, 0, sizeof(GameState));
+
+	RandomSeed(&gs->Pieces.Rng, seed);
+
+	gs->CanHold = true;
+
+	GameReset(gs);
+	GameRehash(gs);
+}
+
+void GameReset(GameState *gs)
+{
+	int x, y;
+
+	for (x = 0; x < BOARD_WIDTH; x++)
+	{
+		for (y = 0; y < BOARD_HEIGHT; y++) GameSetCell(gs, x, y, false);
+	}
+
+	gs->Gravity = 0;
+	gs->Speed = GAME_START_SPEED;
+	gs->Score = 0;
+	gs->Level = 1;
+	gs->Lines = 0;
+	gs->LevelLines = 0;
+	gs->TargetLines = GAME_START_TARGET;
+	gs->QueuedShape = -1;
+	gs->HeldShape = -1;
+	gs->QueueSwaps = 3;
+	gs->GameOver = false;
+	gs->FullRowCount = 0;
+
+	gs->Pieces.BagLeft = 0; // New bag, the generator carries on so games differ
+	gs->Pieces.Head = 0;
+	gs->Pieces.Count = 0;
+}
+
+void GameStart(GameState *gs)
+{
+	GameQueueNext(gs);
+	GameSpawn(gs);
+}
+
+/* ----- Pieces ----- */
+
+static void FillBag(PieceQueue *pq)
+{
+	int x, j;
+	ubyte t;
+
+	for (x = 0; x < PIECE_SHAPES; x++) pq->Bag[x] = x;
+
+	for (x = PIECE_SHAPES - 1; x > 0; x--) // Fisher-Yates
+	{
+		j = RandomBelow(&pq->Rng, x + 1);
+
+		t = pq->Bag[x];
+		pq->Bag[x] = pq->Bag[j];
+		pq->Bag[j] = t;
+	}
+
+	pq->BagLeft = PIECE_SHAPES;
+}
+
+static int NextPieceShape(PieceQueue *pq)
+{
+	int shape;
+
+	while (pq->Count < PIECE_AHEAD) // Keep the ring full so a longer preview can peek ahead
+	{
+		if (pq->BagLeft == 0) FillBag(pq);
+
+		pq->Ahead[(pq->Head + pq->Count) & (PIECE_AHEAD - 1)] = pq->Bag[--pq->BagLeft];
+		pq->Count++;
+	}
+
+	shape = pq->Ahead[pq->Head];
+
+	pq->Head = (pq->Head + 1) & (PIECE_AHEAD - 1);
+	pq->Count--;
+
+	return shape;
+}
+
+void GameQueueNext(GameState *gs)
+{
+	gs->QueuedShape = NextPieceShape(&gs->Pieces);
+}
+
+static void PlaceActive(GameState *gs, int shape, int dy) // Column position from the queue preview position, X offset 18, centred on wider boards
+{
+	int x;
+
+	for (x = 0; x < 4; x++)
+	{
+		gs->Active.Blocks[x].X = DefaultBlockCoords[shape][x].X - 18 + BOARD_SPAWN_X;
+		gs->Active.Blocks[x].Y = DefaultBlockCoords[shape][x].Y + dy;
+	}
+
+	gs->Active.PivotIdx = BlockPivotIdx[shape];
+	gs->Active.ShapeType = shape;
+}
+
+void GameSpawn(GameState *gs)
+{
+	PlaceActive(gs, gs->QueuedShape, -5);
+
+	GameQueueNext(gs);
+}
+
+bool GameSwapQueue(GameState *gs)
+{
+	if (gs->QueueSwaps <= 0) return false;
+
+	GameQueueNext(gs);
+
+	gs->QueueSwaps--;
+
+	return true;
+}
+
+// Callers check CanHold, it's cleared until the next block
+
+bool GameHold(GameState *gs)
+{
+	int held = gs->HeldShape;
+
+	gs->HeldShape = gs->Active.ShapeType;
+	gs->CanHold = false;
+
+	if (held < 0)
+	{
+		GameSpawn(gs);
+
+		return true;
+	}
+
+	PlaceActive(gs, held, -4);
+
+	return false;
+}
+
+/* ----- Movement ----- */
+
+// Whether every active block is free at dx, dy. Cells above the board are open on the way down or
+// sideways, but nothing moves up past row 0
+
+static bool Fits(GameState *gs, int dx, int dy)
+{
+	int x, nx, ny;
+
+	for (x = 0; x < 4; x++)
+	{
+		nx = gs->Active.Blocks[x].X + dx;
+		ny = gs->Active.Blocks[x].Y + dy;
+
+		if (nx < 0 || nx >= BOARD_WIDTH || ny >= BOARD_HEIGHT) return false;
+
+		if (ny < 0)
+		{
+			if (dy < 0) return false;
+		}
+		else if (gs->Board[nx][ny])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool GameCanMove(GameState *gs, int dx, int dy)
+{
+	return Fits(gs, dx, dy);
+}
+
+void GameMove(GameState *gs, int dx, int dy)
+{
+	int x;
+
+	for (x = 0; x < 4; x++)
+	{
+		gs->Active.Blocks[x].X += dx;
+		gs->Active.Blocks[x].Y += dy;
+	}
+}
+
+bool GameShift(GameState *gs, int dx)
+{
+	if (Fits(gs, dx, 0) == false) return false;
+
+	GameMove(gs, dx, 0);
+
+	return true;
+}
+
+bool GameMoveDown(GameState *gs)
+{
+	if (Fits(gs, 0, 1) == false) return false;
+
+	GameMove(gs, 0, 1);
+
+	gs->Gravity = 0;
+
+	return true;
+}
+
+bool GameHardDrop(GameState *gs)
+{
+	int d = GameDropDistance(gs);
+
+	if (d > 0) GameMove(gs, 0, d); // One move for the whole fall
+
+	gs->Gravity = gs->Speed; // Lock in the piece
+
+	gs->Score = gs->Score + 25;
+
+	return d > 0;
+}
+
+int GameDropDistance(GameState *gs)
+{
+	int d = 0;
+
+	while (Fits(gs, 0, d + 1)) d++;
+
+	return d;
+}
+
+static bool CanRotate(GameState *gs, bool counterClockwise) // Build new block in position.. See if any conflicts
+{
+	int x, pivotX, pivotY, offsetX, offsetY, newX, newY;
+	int dir = counterClockwise ? 1 : -1;
+
+	if (gs->Active.PivotIdx < 0) return false;
+
+	pivotX = gs->Active.Blocks[gs->Active.PivotIdx].X;
+	pivotY = gs->Active.Blocks[gs->Active.PivotIdx].Y;
+
+	for (x = 0; x < 4; x++)
+	{
+		offsetX = gs->Active.Blocks[x].X - pivotX; // Current X Position Relative to Pivot Point
+		offsetY = gs->Active.Blocks[x].Y - pivotY; // Current Y Position Relative to Pivot Point
+
+		newX = pivotX + (offsetY * dir);
+		newY = pivotY - (offsetX * dir);
+
+		if (newX < 0 || newX >= BOARD_WIDTH || newY >= BOARD_HEIGHT) return false;
+
+		if (newY >= 0 && gs->Board[newX][newY]) return false;
+	}
+
+	return true;
+}
+
+static void Rotate(GameState *gs, bool counterClockwise)
+{
+	int x, pivotX, pivotY, offsetX, offsetY;
+	int dir = counterClockwise ? 1 : -1;
+
+	pivotX = gs->Active.Blocks[gs->Active.PivotIdx].X;
+	pivotY = gs->Active.Blocks[gs->Active.PivotIdx].Y;
+
+	for (x = 0; x < 4; x++)
+	{
+		offsetX = gs->Active.Blocks[x].X - pivotX;
+		offsetY = gs->Active.Blocks[x].Y - pivotY;
+
+		gs->Active.Blocks[x].X = pivotX + (offsetY * dir);
+		gs->Active.Blocks[x].Y = pivotY - (offsetX * dir);
+	}
+
+	if (gs->Gravity + 12 >= gs->Speed) // Provide a little more time for last second adjustments if need be
+	{
+		gs->Gravity = gs->Gravity - 12;
+
+		if (gs->Gravity < 0) gs->Gravity = 0;
+	}
+}
+
+// With allowShift a blocked rotation tries one column right, then left, then one row up. Otherwise undo
+
+bool GameRotate(GameState *gs, bool counterClockwise, bool allowShift)
+{
+	if (CanRotate(gs, counterClockwise))
+	{
+		Rotate(gs, counterClockwise);
+
+		return true;
+	}
+
+	if (allowShift == false) return false;
+
+	if (Fits(gs, 1, 0))
+	{
+		GameMove(gs, 1, 0);
+
+		if (CanRotate(gs, counterClockwise))
+		{
+			Rotate(gs, counterClockwise);
+
+			return true;
+		}
+
+		GameMove(gs, -1, 0);
+	}
+	else if (Fits(gs, -1, 0))
+	{
+		GameMove(gs, -1, 0);
+
+		if (CanRotate(gs, counterClockwise))
+		{
+			Rotate(gs, counterClockwise);
+
+			return true;
+		}
+
+		GameMove(gs, 1, 0);
+	}
+
+	if (Fits(gs, 0, -1))
+	{
+		GameMove(gs, 0, -1);
+
+		if (CanRotate(gs, counterClockwise))
+		{
+			Rotate(gs, counterClockwise);
+
+			return true;
+		}
+
+		GameMove(gs, 0, 1);
+	}
+
+	return false;
+}
+
+/* ----- Gravity, locking and scoring ----- */
+
+int GameTick(GameState *gs)
+{
+	int x, y;
+	int timer = gs->Speed;
+
+	if (Fits(gs, 0, 1) == false)
+	{
+		if (timer < 10) timer = 10; // Allow for bottom last second adjustments
+	}
+
+	if (++gs->Gravity < timer) return GAME_TICK_NONE; // Start at 48 or a little under once per second
+
+	gs->Gravity = 0;
+
+	if (Fits(gs, 0, 1))
+	{
+		GameMove(gs, 0, 1);
+
+		return GAME_TICK_FELL;
+	}
+
+	for (x = 0; x < 4; x++) // Landed with any block above the limit
+	{
+		if (gs->Active.Blocks[x].Y < 0)
+		{
+			gs->GameOver = true;
+
+			return GAME_TICK_OVER;
+		}
+	}
+
+	for (x = 0; x < 4; x++)
+	{
+		y = gs->Active.Blocks[x].Y;
+
+		if (y >= 0 && y < BOARD_HEIGHT) GameSetCell(gs, gs->Active.Blocks[x].X, y, true);
+	}
+
+	return GAME_TICK_LOCKED;
+}
+
+int GameClearLines(GameState *gs)
+{
+	int x, y, i, count = 0;
+
+	for (y = 0; y < BOARD_HEIGHT; y++)
+	{
+		for (x = 0; x < BOARD_WIDTH; x++)
+		{
+			if (gs->Board[x][y] == false) break;
+		}
+
+		if (x == BOARD_WIDTH) gs->FullRows[count++] = y;
+	}
+
+	gs->FullRowCount = count;
+
+	if (count == 0) return 0;
+
+	gs->Score = gs->Score + (count * (count * 25));
+
+	gs->LevelLines += count;
+	gs->Lines += count;
+
+	for (i = 0; i < count; i++) // Top down, so each shift leaves the rows below where they were found
+	{
+		for (y = gs->FullRows[i]; y >= 0; y--)
+		{
+			for (x = 0; x < BOARD_WIDTH; x++)
+			{
+				GameSetCell(gs, x, y, y > 0 ? gs->Board[x][y - 1] : false);
+			}
+		}
+	}
+
+	return count;
+}
+
+bool GameNextLevel(GameState *gs)
+{
+	if (gs->LevelLines < gs->TargetLines) return false;
+
+	gs->TargetLines += 2;
+
+	gs->LevelLines = 0;
+
+	gs->Level++;
+
+	gs->Score = gs->Score + (gs->Level * 125); // New level bonus hurray
+
+	if (gs->Speed > 3) gs->Speed = gs->Speed - (gs->Level < 15 ? 2 : 1);
+
+	return true;
+}
+
+void GameScoreLock(GameState *gs)
+{
+	gs->Score = gs->Score + 25;
+}
+
+void GameNextBlock(GameState *gs)
+{
+	GameSpawn(gs);
+
+	gs->CanHold = true;
+}
+
+// The game runs these phases itself so the clear and the level change can play out between them
+
+int GameSettle(GameState *gs)
+{
+	int rows;
+
+	GameScoreLock(gs);
+
+	rows = GameClearLines(gs);
+
+	GameNextLevel(gs);
+
+	GameNextBlock(gs);
+
+	return rows;
+}
+
+/* ----- Hashing ----- */
+
+static uint32 ActiveKeys(GameState *gs)
+{
+	uint32 h = zShape[0][gs->Active.ShapeType & 7];
+	int x, bx, by;
+
+	for (x = 0; x < 4; x++)
+	{
+		bx = gs->Active.Blocks[x].X;
+		by = gs->Active.Blocks[x].Y + HASH_ACTIVE_ABOVE;
+
+		if (bx >= 0 && bx < BOARD_WIDTH && by >= 0 && by < HASH_ACTIVE_ROWS) h ^= zActive[bx][by];
+	}
+
+	return h;
+}
+
+void GameSetCell(GameState *gs, int x, int y, bool set)
+{
+	if ((gs->Board[x][y] != false) != (set != false)) gs->BoardHash ^= zCell[x][y];
+
+	gs->Board[x][y] = set;
+}
+
+static uint32 BoardKeys(GameState *gs)
+{
+	uint32 h = 0;
+	int x, y;
+
+	for (x = 0; x < BOARD_WIDTH; x++)
+	{
+		for (y = 0; y < BOARD_HEIGHT; y++)
+		{
+			if (gs->Board[x][y]) h ^= zCell[x][y];
+		}
+	}
+
+	return h;
+}
+
+void GameRehash(GameState *gs)
+{
+	gs->BoardHash = BoardKeys(gs);
+}
+
+static uint32 MixCounters(GameState *gs, uint32 h)
+{
+	int32 v[9];
+	int i;
+
+	v[0] = gs->Score; v[1] = gs->Level; v[2] = gs->Lines; v[3] = gs->LevelLines; v[4] = gs->TargetLines;
+	v[5] = gs->Speed; v[6] = gs->Gravity; v[7] = gs->QueueSwaps; v[8] = gs->CanHold ? 1 : 0;
+
+	for (i = 0; i < 9; i++) h = (h ^ (uint32)v[i]) * 16777619u; // FNV-1a step per counter
+
+	return h;
+}
+
+uint32 GameHash(GameState *gs)
+{
+	uint32 h = gs->BoardHash ^ ActiveKeys(gs);
+
+	h ^= zShape[1][gs->QueuedShape >= 0 ? gs->QueuedShape : 7];
+	h ^= zShape[2][gs->HeldShape >= 0 ? gs->HeldShape : 7];
+
+	return MixCounters(gs, h);
+}
+
+uint32 GameFullHash(GameState *gs) // Same value the slow way, to catch a board or block change that skipped the keys
+{
+	uint32 h = BoardKeys(gs) ^ ActiveKeys(gs);
+
+	h ^= zShape[1][gs->QueuedShape >= 0 ? gs->QueuedShape : 7];
+	h ^= zShape[2][gs->HeldShape >= 0 ? gs->HeldShape : 7];
+
+	return MixCounters(gs, h);
+}
@@ -0,0 +1,145 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Gameplay rules. Everything that decides where blocks are, what gets
+//	cleared and what it scores works on a GameState, with no cels, sound or
+//	pad reads, so any number of boards can run side by side. tetris.c keeps
+//	one for the screen and draws from it, the host simulator runs thousands
+//
+//	The Zobrist keys are shared and never change after GameInitKeys. Every
+//	state keeps its board's hash up to date as cells change, the active
+//	block's four keys are only looked up when GameHash is called
+//
+
+*/
+
+#ifndef HD3DOGAME_H
+#define HD3DOGAME_H
+
+#include "types.h"
+
+#include "HD3DORandom.h"
+
+#ifndef BOARD_WIDTH // Override both with -D for the wide and tall variants
+#define BOARD_WIDTH 10
+#endif
+
+#ifndef BOARD_HEIGHT
+#define BOARD_HEIGHT 18
+#endif
+
+#define BOARD_SPAWN_X ((BOARD_WIDTH - 10) / 2) // Spawn columns are laid out for 10 wide
+
+#define PIECE_SHAPES 7
+#define PIECE_AHEAD 8 // Upcoming shapes kept in the ring, a power of two
+
+#define HASH_ACTIVE_ABOVE 4 // Active block rows above the board that get their own hash keys
+#define HASH_ACTIVE_ROWS (BOARD_HEIGHT + HASH_ACTIVE_ABOVE)
+
+#define GAME_START_SPEED 48 // Ticks per row at level 1
+#define GAME_START_TARGET 10
+
+// GameTick results
+
+#define GAME_TICK_NONE 0
+#define GAME_TICK_FELL 1
+#define GAME_TICK_LOCKED 2 // Block written into the board, call GameSettle
+#define GAME_TICK_OVER 3 // Landed above the top, Active is left where it stopped
+
+typedef struct BlockCoord
+{
+	int X;
+	int Y;
+} BlockCoord;
+
+typedef struct Tetrimino
+{
+	int PivotIdx;
+	int ShapeType;
+	BlockCoord Blocks[4];
+} Tetrimino;
+
+typedef struct PieceQueue // 7-bag randomizer: every shape once per bag, dealt into a ring of upcoming shapes
+{
+	RandomState Rng;
+	ubyte Bag[PIECE_SHAPES];
+	int BagLeft;
+	ubyte Ahead[PIECE_AHEAD];
+	int Head;
+	int Count;
+} PieceQueue;
+
+typedef struct GameState
+{
+	bool Board[BOARD_WIDTH][BOARD_HEIGHT];
+	Tetrimino Active;
+	PieceQueue Pieces;
+	int QueuedShape;			// -1 before the first block
+	int HeldShape;				// -1 until something is held
+	bool CanHold;				// Once per block
+	int QueueSwaps;				// Right shift rerolls left this game
+	int Gravity;				// Ticks since the block last fell
+	int Speed;					// Ticks per row
+	int Score;
+	int Level;
+	int Lines;					// This game
+	int LevelLines;				// This level
+	int TargetLines;			// Lines to the next level
+	bool GameOver;
+	int FullRows[4];			// Rows the last GameClearLines took out, top down
+	int FullRowCount;
+	uint32 BoardHash;
+} GameState;
+
+extern BlockCoord DefaultBlockCoords[PIECE_SHAPES][4]; // Relative to the queue preview, spawns are offset from these
+extern int BlockPivotIdx[PIECE_SHAPES];
+
+void GameInitKeys(void);
+void GameInit(GameState *gs, uint32 seed);
+void GameReset(GameState *gs);			// New game, the piece generator carries on
+void GameStart(GameState *gs);			// First queued and active blocks
+
+void GameQueueNext(GameState *gs);
+void GameSpawn(GameState *gs);			// Queued block becomes active
+bool GameSwapQueue(GameState *gs);		// Rerolls the queued block while QueueSwaps last
+bool GameHold(GameState *gs);			// true when the active block came from the queue
+
+bool GameCanMove(GameState *gs, int dx, int dy);
+void GameMove(GameState *gs, int dx, int dy);
+bool GameShift(GameState *gs, int dx);
+bool GameMoveDown(GameState *gs);		// Soft drop, false once landed
+bool GameHardDrop(GameState *gs);		// false if it was already landed, locks on the next tick either way
+bool GameRotate(GameState *gs, bool counterClockwise, bool allowShift);
+int GameDropDistance(GameState *gs);
+
+int GameTick(GameState *gs);			// Gravity, GAME_TICK_*
+void GameScoreLock(GameState *gs);		// GameSettle's phases, in order
+int GameClearLines(GameState *gs);
+bool GameNextLevel(GameState *gs);
+void GameNextBlock(GameState *gs);		// Spawn and allow a hold again
+int GameSettle(GameState *gs);			// After GAME_TICK_LOCKED: score, clear, level up and spawn. Rows cleared
+
+void GameSetCell(GameState *gs, int x, int y, bool set);
+void GameRehash(GameState *gs);			// After writing Board directly
+uint32 GameHash(GameState *gs);			// Incremental board hash with the block, queue and counters folded in
+uint32 GameFullHash(GameState *gs);		// The same recomputed from scratch
+
+#endif
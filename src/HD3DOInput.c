@@ -0,0 +1,387 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Button table and repeat timing, see HD3DOInput.h. An update is one pass
+//	over eleven entries, a held button costs a compare until its next repeat
+//	is due
+//
+//	The broker side is what InitEventUtility / GetControlPad did for us, minus
+//	the sampling: every message on our port is an event record, its frames
+//	are copied into the ring and the message replied to so the broker can
+//	reuse it. The ring is read up to the first button pressed twice
+//
+
+*/
+
+#include "types.h"
+#include "strings.h"
+#include "msgport.h"
+#include "event.h"
+#include "timerutils.h"
+
+#include "HD3DOInput.h"
+
+InputState Input =
+{
+	{
+		{ ControlLeft, INPUT_REPEAT_SHIFT },
+		{ ControlRight, INPUT_REPEAT_SHIFT },
+		{ ControlUp, INPUT_REPEAT_HARD_DROP },
+		{ ControlDown, INPUT_REPEAT_SOFT_DROP },
+		{ ControlLeftShift, INPUT_REPEAT_NONE },
+		{ ControlRightShift, INPUT_REPEAT_NONE },
+		{ ControlA, INPUT_REPEAT_ROTATE },
+		{ ControlB, INPUT_REPEAT_NONE },
+		{ ControlC, INPUT_REPEAT_ROTATE },
+		{ ControlStart, INPUT_REPEAT_NONE },
+		{ ControlX, INPUT_REPEAT_NONE }
+	},
+	{
+		{ INPUT_DAS, INPUT_ARR },
+		{ INPUT_SDR, INPUT_SDR },
+		{ INPUT_ROTATE_REPEAT, INPUT_ROTATE_REPEAT },
+		{ INPUT_HARD_DROP_REPEAT, INPUT_HARD_DROP_REPEAT }
+	},
+	INPUT_LATE_LATCH
+};
+
+/* ----- Event broker ----- */
+
+static uint32 CountBits(uint32 bits)
+{
+	uint32 n = 0;
+
+	for (; bits != 0; bits &= bits - 1) n++;
+
+	return n;
+}
+
+static bool Configure(enum ListenerCategory category)
+{
+	ConfigurationRequest config;
+	Message *msg;
+	Item broker;
+
+	if ((broker = FindMsgPort(EventPortName)) < 0) return false;
+
+	memset(&config, 0, sizeof(config));
+
+	config.cr.ebh_Flavor = EB_Configure;
+	config.cr_Category = category;
+	config.cr_TriggerMask[0] = EVENTBIT0_ControlButtonPressed | EVENTBIT0_ControlButtonReleased;
+	config.cr_QueueMax = EVENT_QUEUE_MAX_PERMITTED;
+
+	if (SendMsg(broker, Input.Queue.Msg, &config, sizeof(config)) < 0) return false;
+
+	WaitPort(Input.Queue.Port, Input.Queue.Msg);
+
+	msg = (Message *)LookupItem(Input.Queue.Msg);
+
+	return msg->msg_Result >= 0;
+}
+
+static void Enqueue(EventFrame *ef)
+{
+	InputQueue *q = &Input.Queue;
+	InputEvent *e;
+
+	if (q->Count == INPUT_QUEUE_EVENTS)
+	{
+		q->Overflows++;
+
+		return;
+	}
+
+	e = &q->Ring[(q->Head + q->Count++) & (INPUT_QUEUE_EVENTS - 1)];
+
+	e->Bits = ((ControlPadEventData *)ef->ef_EventData)->cped_ButtonBits;
+	e->Field = ef->ef_SystemTimeStamp;
+}
+
+// Moves everything on the port into the ring and hands the messages straight back
+
+static void TakeMessages()
+{
+	InputQueue *q = &Input.Queue;
+	EventBrokerHeader *ebh;
+	EventFrame *ef;
+	Item msgItem;
+
+	while ((msgItem = GetMsg(q->Port)) > 0)
+	{
+		ebh = (EventBrokerHeader *)((Message *)LookupItem(msgItem))->msg_DataPtr;
+
+		if (ebh->ebh_Flavor == EB_EventRecord)
+		{
+			for (ef = (EventFrame *)(ebh + 1); ef->ef_ByteCount != 0; ef = (EventFrame *)((ubyte *)ef + ef->ef_ByteCount))
+			{
+				if (ef->ef_GenericPosition != INPUT_PAD) continue;
+
+				if (ef->ef_EventNumber == EVENTNUM_ControlButtonPressed || ef->ef_EventNumber == EVENTNUM_ControlButtonReleased) Enqueue(ef);
+			}
+		}
+
+		ReplyMsg(msgItem, 0, NULL, 0);
+	}
+}
+
+bool InputListen()
+{
+	InputQueue *q = &Input.Queue;
+
+	if (q->Port > 0) return true;
+
+	q->Port = CreateMsgPort(NULL, 0, 0);
+	q->Msg = q->Port > 0 ? CreateMsg(NULL, 0, q->Port) : -1;
+
+	// Nothing said what changed while we weren't listening, a button let go
+	// then would keep its next press from being an edge. Start from nothing
+	// held, like the broker does for a new listener, and drop what's stale
+
+	q->Bits = 0;
+	q->Head = 0;
+	q->Count = 0;
+
+	if (q->Msg > 0 && Configure(LC_Observer)) return true;
+
+	InputStopListening();
+
+	return false;
+}
+
+void InputStopListening()
+{
+	InputQueue *q = &Input.Queue;
+
+	if (q->Port <= 0) return;
+
+	if (q->Msg > 0)
+	{
+		Configure(LC_NoSeeUms);
+
+		DeleteMsg(q->Msg);
+	}
+
+	TakeMessages(); // Hands the messages back, InputListen drops what they held
+
+	DeleteMsgPort(q->Port);
+
+	q->Port = 0;
+	q->Msg = 0;
+}
+
+static uint32 Read(uint32 latchBits, uint32 *taps)
+{
+	InputQueue *q = &Input.Queue;
+	uint32 start = q->Bits, pressed = 0, press, wait;
+	VBlankTimeVal vbl;
+	InputEvent *e;
+
+	*taps = 0;
+
+	q->ReadEvents = 0;
+	q->ReadPresses = 0;
+
+	if (q->Port <= 0) return q->Bits;
+
+	TakeMessages();
+
+	SampleSystemTimeVBL(&vbl); // Same clock as ef_SystemTimeStamp
+
+	while (q->Count > 0)
+	{
+		e = &q->Ring[q->Head];
+		press = e->Bits & ~q->Bits;
+
+		if (press & pressed) break; // Pressed again, the next tick gets it so both presses fire
+
+		if (press & ~latchBits) break; // Left for the tick
+
+		pressed |= press;
+		wait = vbl.vbltv_VBlankLo32 - e->Field;
+
+		if (press != 0 && q->ReadPresses == 0) q->ReadPressField = e->Field;
+
+		q->ReadPresses += CountBits(press);
+		q->Presses += CountBits(press);
+		q->Bits = e->Bits;
+		q->Events++;
+
+		if (q->ReadEvents++ == 0) q->ReadLatency = wait; // In order, the first waited longest
+
+		q->Latency[wait < INPUT_LATENCY_FIELDS ? wait : INPUT_LATENCY_FIELDS - 1]++;
+
+		q->Head = (q->Head + 1) & (INPUT_QUEUE_EVENTS - 1);
+		q->Count--;
+	}
+
+	*taps = pressed & ~(q->Bits & ~start); // A press still held shows as an edge on its own
+
+	q->Taps += CountBits(*taps);
+
+	return q->Bits;
+}
+
+uint32 InputRead(uint32 *taps)
+{
+	return Read(0xffffffff, taps);
+}
+
+uint32 InputReadLatch(uint32 buttonBits, uint32 *taps)
+{
+	return Read(buttonBits, taps);
+}
+
+/* ----- Buttons ----- */
+
+void InputUpdate(uint32 buttonBits, uint32 taps, uint32 ms)
+{
+	InputButton *b;
+	InputRepeat *r;
+	uint32 due;
+	int i;
+
+	Input.Now = Input.Clock ? ms : Input.Now + 1;
+
+	for (i = 0; i < INPUT_BUTTONS; i++)
+	{
+		b = &Input.Buttons[i];
+
+		b->Pressed = false;
+		b->Released = false;
+		b->Fires = 0;
+
+		if (taps & b->Mask) // Pressed since the last update but the bits don't show it, count it anyway
+		{
+			b->Released = b->Down || (buttonBits & b->Mask) == 0;
+			b->Down = (buttonBits & b->Mask) != 0;
+			b->Pressed = true;
+			b->Fires = 1;
+
+			if (b->Repeat >= 0) b->Next = Input.Now + Input.Repeats[b->Repeat].Delay;
+
+			Input.Presses++;
+		}
+		else if ((buttonBits & b->Mask) == 0)
+		{
+			b->Released = b->Down;
+			b->Down = false;
+		}
+		else if (b->Down == false)
+		{
+			b->Down = true;
+			b->Pressed = true;
+			b->Fires = 1;
+
+			if (b->Repeat >= 0) b->Next = Input.Now + Input.Repeats[b->Repeat].Delay;
+
+			Input.Presses++;
+		}
+		else if (b->Repeat >= 0 && (int32)(Input.Now - b->Next) >= 0) // Wraps safely, the clock can run for weeks
+		{
+			r = &Input.Repeats[b->Repeat];
+
+			if (r->Rate == 0)
+			{
+				b->Fires = INPUT_FIRES_ALL;
+				b->Next = Input.Now + 1;
+			}
+			else
+			{
+				due = ((Input.Now - b->Next) / r->Rate) + 1; // More than one when the clock outruns the frame rate
+
+				b->Fires = due < INPUT_FIRES_ALL ? due : INPUT_FIRES_ALL;
+				b->Next += due * r->Rate;
+			}
+		}
+	}
+}
+
+void InputLatch(uint32 buttonBits, uint32 taps)
+{
+	InputButton *b;
+	int i;
+
+	for (i = 0; i < INPUT_BUTTONS; i++)
+	{
+		b = &Input.Buttons[i];
+
+		b->Pressed = (taps & b->Mask) || ((buttonBits & b->Mask) && b->Down == false);
+		b->Released = (b->Down || b->Pressed) && (buttonBits & b->Mask) == 0;
+		b->Down = (buttonBits & b->Mask) != 0;
+		b->Fires = b->Pressed;
+
+		if (b->Pressed == false) continue;
+
+		if (b->Repeat >= 0) b->Next = Input.Now + Input.Repeats[b->Repeat].Delay; // From the tick before, it's only part way to the next
+
+		Input.Presses++;
+	}
+}
+
+void InputRestart(int button)
+{
+	InputButton *b = &Input.Buttons[button];
+
+	if (b->Repeat >= 0) b->Next = Input.Now + Input.Repeats[b->Repeat].Rate;
+}
+
+static uint32 Convert(uint32 v, uint32 mul, uint32 div)
+{
+	return ((v * mul) + (div / 2)) / div;
+}
+
+void InputUseClock(bool clock)
+{
+	InputRepeat *r;
+	int i;
+
+	if (clock == Input.Clock) return;
+
+	for (i = 0; i < INPUT_REPEATS; i++)
+	{
+		r = &Input.Repeats[i];
+
+		r->Delay = clock ? Convert(r->Delay, 1000, INPUT_TICKS_PER_SECOND) : Convert(r->Delay, INPUT_TICKS_PER_SECOND, 1000);
+		r->Rate = clock ? Convert(r->Rate, 1000, INPUT_TICKS_PER_SECOND) : Convert(r->Rate, INPUT_TICKS_PER_SECOND, 1000);
+	}
+
+	for (i = 0; i < INPUT_BUTTONS; i++)
+	{
+		Input.Buttons[i].Down = false; // Repeats due in the old units mean nothing now, held buttons start over
+	}
+
+	Input.Clock = clock;
+	Input.Now = 0;
+}
+
+uint32 InputDownBits()
+{
+	uint32 bits = 0;
+	int i;
+
+	for (i = 0; i < INPUT_BUTTONS; i++)
+	{
+		if (Input.Buttons[i].Down) bits |= 1 << i;
+	}
+
+	return bits;
+}
@@ -0,0 +1,181 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Pad buttons as a table. InputUpdate walks every button once per tick and
+//	leaves Pressed, Released and Fires set, Fires counting the press plus any
+//	repeats that came due. The game only reads those, it keeps no per button
+//	flags or counters of its own
+//
+//	Each repeating button points at an InputRepeat: Delay is the DAS, how
+//	long it's held before the first repeat, Rate the ARR between repeats
+//	after that. Both count ticks unless InputUseClock switches them to
+//	milliseconds against the clock passed to InputUpdate. A Rate of 0 sets
+//	Fires to INPUT_FIRES_ALL, the caller repeats until the move fails
+//
+//	Ticks are what replays record, only use the clock outside of one
+//
+//	The pad is read from the event broker rather than sampled. InputListen
+//	joins it as an observer, the broker queues a message per change stamped
+//	with the field it happened in, and InputRead takes every one since the
+//	last tick in order. A press that was let go again before the tick, too
+//	short for a frame or during a long one, comes back in taps so it still
+//	fires. A button pressed twice in one tick leaves the second press and
+//	everything after it queued for the next, so each press fires once. Each
+//	event's wait in fields goes into Input.Queue.Latency
+//
+//	With LateLatch set the game reads the queue a second time just before it
+//	positions the active block's cels, InputReadLatch taking only events that
+//	press the buttons it's given and InputLatch marking those presses without
+//	starting a new tick. The next InputUpdate sees them as already down
+//
+
+*/
+
+#ifndef HD3DOINPUT_H
+#define HD3DOINPUT_H
+
+#include "types.h"
+
+// Buttons, in the order of the snapshot flag bits
+
+#define INPUT_LEFT 0
+#define INPUT_RIGHT 1
+#define INPUT_UP 2
+#define INPUT_DOWN 3
+#define INPUT_LS 4
+#define INPUT_RS 5
+#define INPUT_A 6
+#define INPUT_B 7
+#define INPUT_C 8
+#define INPUT_START 9
+#define INPUT_STOP 10
+#define INPUT_BUTTONS 11
+
+// Repeat timings
+
+#define INPUT_REPEAT_NONE -1 // Press only
+#define INPUT_REPEAT_SHIFT 0
+#define INPUT_REPEAT_SOFT_DROP 1
+#define INPUT_REPEAT_ROTATE 2
+#define INPUT_REPEAT_HARD_DROP 3
+#define INPUT_REPEATS 4
+
+#ifndef INPUT_DAS
+#define INPUT_DAS 9 // Ticks a shift is held before it repeats
+#endif
+
+#ifndef INPUT_ARR
+#define INPUT_ARR 5 // Ticks between repeated shifts, 0 slides to the wall
+#endif
+
+#ifndef INPUT_SDR
+#define INPUT_SDR 3 // Ticks between soft drop rows, 0 drops to the floor
+#endif
+
+#ifndef INPUT_LATE_LATCH
+#define INPUT_LATE_LATCH 0 // Shifts and rotations pressed during a frame's logic still make that frame
+#endif
+
+#ifndef INPUT_CLOCK_MS
+#define INPUT_CLOCK_MS 0 // Console builds set this to time repeats in milliseconds, see InputUseClock
+#endif
+
+#define INPUT_ROTATE_REPEAT 15
+#define INPUT_HARD_DROP_REPEAT 15
+
+#define INPUT_TICKS_PER_SECOND 60
+#define INPUT_FIRES_ALL 0x7fff
+
+#define INPUT_PAD 1					// Generic position of the pad we read
+#define INPUT_QUEUE_EVENTS 64		// Power of 2, the broker holds 20 messages of several events each
+#define INPUT_LATENCY_FIELDS 8		// Histogram buckets, the last holds anything later
+
+typedef struct InputRepeat
+{
+	uint32 Delay;
+	uint32 Rate;
+} InputRepeat;
+
+typedef struct InputButton
+{
+	uint32 Mask;				// Control* bit
+	int Repeat;					// INPUT_REPEAT_*
+	bool Down;
+	bool Pressed;				// This update only
+	bool Released;				// This update only
+	int Fires;					// This update, the press and any repeats
+	uint32 Next;				// When the next repeat is due while Down
+} InputButton;
+
+typedef struct InputEvent
+{
+	uint32 Bits;				// The whole pad after the change
+	uint32 Field;				// ef_SystemTimeStamp
+} InputEvent;
+
+typedef struct InputQueue
+{
+	Item Port;					// Ours, the broker's events and replies arrive here
+	Item Msg;					// Configuration requests to the broker
+	InputEvent Ring[INPUT_QUEUE_EVENTS];	// Taken from the broker, not yet read
+	uint32 Head;
+	uint32 Count;
+	uint32 Overflows;			// Events lost to a full ring
+	uint32 Bits;				// Pad after the last event read
+	uint32 Events;
+	uint32 Presses;				// Button down edges in those events
+	uint32 Taps;				// Presses gone again by the tick that read them
+	uint32 ReadEvents;			// Events the last InputRead took
+	uint32 ReadLatency;			// Fields the oldest of them waited
+	uint32 ReadPresses;			// Presses in them
+	uint32 ReadPressField;		// When the first of those happened
+	uint32 Latency[INPUT_LATENCY_FIELDS];	// Events by fields waited
+} InputQueue;
+
+typedef struct InputState
+{
+	InputButton Buttons[INPUT_BUTTONS];
+	InputRepeat Repeats[INPUT_REPEATS];
+	bool LateLatch;
+	bool Clock;					// Repeats in milliseconds, otherwise ticks
+	uint32 Now;					// Tick or millisecond of the last update
+	uint32 Presses;				// Every Pressed the updates have set
+	InputQueue Queue;
+} InputState;
+
+extern InputState Input;
+
+bool InputListen(void);						// Joins the event broker, false if it wouldn't have us
+void InputStopListening(void);
+uint32 InputRead(uint32 *taps);				// Pad bits now, taps the presses they no longer show
+uint32 InputReadLatch(uint32 buttonBits, uint32 *taps);	// The same, stops at an event pressing anything else
+
+void InputUpdate(uint32 buttonBits, uint32 taps, uint32 ms);	// ms is only read when Input.Clock is set
+void InputLatch(uint32 buttonBits, uint32 taps);	// Presses and releases for InputReadLatch's bits, no repeats
+void InputRestart(int button);				// Next repeat a full Rate from now, as if just past the delay
+void InputUseClock(bool clock);				// Converts the timings between ticks and milliseconds
+uint32 InputDownBits(void);					// Bit n set while button n is down
+
+#define InputPressed(button) (Input.Buttons[button].Pressed)
+#define InputFires(button) (Input.Buttons[button].Fires)
+#define InputDown(button) (Input.Buttons[button].Down)
+
+#endif
@@ -0,0 +1,321 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Tagged allocation tracking
+//
+
+*/
+
+#include "types.h"
+#include "stdio.h"
+#include "strings.h"
+#include "utils3do.h"
+
+#include "HD3DO.h"
+#include "HD3DOMem.h"
+#include "tools.h"
+
+#define MEM_REFRESH 30
+#define MEM_OVERLAY_Y (240 - ((MEM_TAGS + 1) * 9) - 4) // Bottom left, under the held block
+
+MemTagStats MemTags[MEM_TAGS];
+MemLeakStats MemLeaks;
+
+static MemRecord memRecords[MEM_MAX_RECORDS];
+static int memDropped = 0; // Allocations that didn't fit in the table, by tag in DroppedBytes
+static int memGen = 0;
+
+static char *memTagNames[MEM_TAGS] = { "BOARD", "HUD", "MENUS", "BGS", "AUDIO", "MUSIC" };
+
+static char memText[MEM_TAGS + 1][MAX_STRING_LENGTH];
+static int memRefreshCount = MEM_REFRESH;
+
+void MemTrackAt(int tag, void *ptr, uint32 size, char *file, int line)
+{
+	MemTagStats *ts = &MemTags[tag];
+	int i;
+
+	if (ptr == NULL) return;
+
+	for (i = 0; i < MEM_MAX_RECORDS; i++)
+	{
+		if (memRecords[i].Ptr == NULL)
+		{
+			memRecords[i].Ptr = ptr;
+			memRecords[i].Size = size;
+			memRecords[i].Tag = tag;
+			memRecords[i].File = file;
+			memRecords[i].Line = line;
+			memRecords[i].Gen = memGen;
+
+			break;
+		}
+	}
+
+	if (i == MEM_MAX_RECORDS) // MemUntrack won't find it, so it stays out of the live figures
+	{
+		ts->DroppedBytes += size;
+		ts->DroppedCount++;
+
+		memDropped++;
+
+		return;
+	}
+
+	ts->LiveBytes += size;
+	ts->LiveCount++;
+
+	if (ts->LiveBytes > ts->HighBytes) ts->HighBytes = ts->LiveBytes;
+	if (ts->LiveCount > ts->HighCount) ts->HighCount = ts->LiveCount;
+}
+
+void MemUntrack(void *ptr)
+{
+	int i;
+
+	if (ptr == NULL) return;
+
+	for (i = 0; i < MEM_MAX_RECORDS; i++)
+	{
+		if (memRecords[i].Ptr == ptr)
+		{
+			MemTags[memRecords[i].Tag].LiveBytes -= memRecords[i].Size;
+			MemTags[memRecords[i].Tag].LiveCount--;
+
+			memRecords[i].Ptr = NULL;
+
+			return;
+		}
+	}
+}
+
+void MemResize(void *ptr, uint32 size)
+{
+	MemTagStats *ts;
+	int i;
+
+	if (ptr == NULL) return;
+
+	for (i = 0; i < MEM_MAX_RECORDS; i++)
+	{
+		if (memRecords[i].Ptr == ptr)
+		{
+			ts = &MemTags[memRecords[i].Tag];
+
+			ts->LiveBytes = ts->LiveBytes - memRecords[i].Size + size;
+
+			if (ts->LiveBytes > ts->HighBytes) ts->HighBytes = ts->LiveBytes;
+
+			memRecords[i].Size = size;
+
+			return;
+		}
+	}
+}
+
+void MemTrackItemAt(int tag, Item item, uint32 size, char *file, int line)
+{
+	if (item < 0) return;
+
+	MemTrackAt(tag, (void *)(long)item, size, file, line);
+}
+
+void MemUntrackItem(Item item)
+{
+	if (item < 0) return;
+
+	MemUntrack((void *)(long)item);
+}
+
+CCB *MemLoadCelAt(int tag, char *path, char *file, int line)
+{
+	CCB *cel = LoadCel(path, MEMTYPE_CEL);
+
+	MemTrackAt(tag, cel, GetFileSize(path), file, line); // LoadCel keeps the whole file in one buffer
+
+	return cel;
+}
+
+CCB *MemCopyCelAt(int tag, CCB *src, char *file, int line)
+{
+	CCB *cel = CopyCel(src);
+
+	MemTrackAt(tag, cel, sizeof(CCB), file, line); // Shares the source pixels
+
+	return cel;
+}
+
+CCB *MemCloneCelAt(int tag, CCB *src, int32 options, char *file, int line)
+{
+	CCB *cel = CloneCel(src, options);
+
+	MemTrackAt(tag, cel, sizeof(CCB), file, line); // Only ever cloned CCB_ONLY here
+
+	return cel;
+}
+
+CCB *MemCreateCelAt(int tag, int32 width, int32 height, int32 bitsPerPixel, int32 options, void *dataBuf, char *file, int line)
+{
+	CCB *cel = CreateCel(width, height, bitsPerPixel, options, dataBuf);
+	uint32 size = sizeof(CCB);
+
+	if (dataBuf == NULL)
+	{
+		size += ((((width * bitsPerPixel) + 31) >> 5) << 2) * height; // Rows are word aligned
+	}
+
+	MemTrackAt(tag, cel, size, file, line);
+
+	return cel;
+}
+
+CCB *MemCreateBackdropCelAt(int tag, int32 width, int32 height, int32 color, int32 opacityPercent, char *file, int line)
+{
+	CCB *cel = CreateBackdropCel(width, height, color, opacityPercent);
+
+	MemTrackAt(tag, cel, sizeof(CCB) + sizeof(uint32), file, line); // Single pixel scaled up to size
+
+	return cel;
+}
+
+void MemUnloadCel(CCB *cel)
+{
+	MemUntrack(cel);
+
+	UnloadCel(cel);
+}
+
+void MemReleaseCel(CCB **cel)
+{
+	if (*cel == NULL) return; // Hide functions get called whether or not the menu was shown
+
+	MemUnloadCel(*cel);
+
+	*cel = NULL;
+}
+
+ubyte *MemLoadImageAt(int tag, char *path, ScreenContext *sc, char *file, int line)
+{
+	ubyte *image = LoadImage(path, NULL, (VdlChunk **)NULL, sc);
+
+	MemTrackAt(tag, image, sc->sc_nFrameByteCount, file, line);
+
+	return image;
+}
+
+void MemUnloadImage(ubyte *image)
+{
+	MemUntrack(image);
+
+	UnloadImage(image);
+}
+
+uint32 MemLiveBytes()
+{
+	uint32 total = 0;
+	int i;
+
+	for (i = 0; i < MEM_TAGS; i++)
+	{
+		total += MemTags[i].LiveBytes;
+	}
+
+	return total;
+}
+
+int32 MemGrowthBytes()
+{
+	if (MemLeaks.Checkpoints == 0) return 0;
+
+	return (int32)MemLeaks.LastBytes - (int32)MemLeaks.BaselineBytes;
+}
+
+int MemCheckpoint()
+{
+	MemRecord *mr;
+	int i;
+
+	MemLeaks.Outstanding = 0;
+	MemLeaks.LastBytes = MemLiveBytes();
+
+	if (MemLeaks.Checkpoints == 0) MemLeaks.BaselineBytes = MemLeaks.LastBytes;
+
+	for (i = 0; i < MEM_MAX_RECORDS; i++)
+	{
+		mr = &memRecords[i];
+
+		if (mr->Ptr == NULL || mr->Gen == 0) continue; // Startup allocations live for the whole session
+		if (mr->Tag == MEM_TAG_BACKGROUND) continue; // Swapped in place, there is always exactly one
+
+		if (MemLeaks.Outstanding++ < MEM_MAX_LEAK_LINES)
+		{
+			printf("LEAK %-5s %7d  %s:%d (round %d)\n", memTagNames[mr->Tag], mr->Size, mr->File, mr->Line, mr->Gen);
+		}
+	}
+
+	if (MemLeaks.Outstanding > 0 || MemLeaks.LastBytes != MemLeaks.BaselineBytes)
+	{
+		printf("LEAK checkpoint %d: %d outstanding, %d bytes growth\n", MemLeaks.Checkpoints, MemLeaks.Outstanding, MemGrowthBytes());
+	}
+
+	MemLeaks.Checkpoints++;
+	memGen++;
+
+	return MemLeaks.Outstanding;
+}
+
+void MemDrawOverlay(Item bitmapItem)
+{
+	int i;
+	int yp = MEM_OVERLAY_Y;
+
+	if (++memRefreshCount >= MEM_REFRESH)
+	{
+		sprintf(memText[0], "TAG      LIVE    HIGH");
+
+		for (i = 0; i < MEM_TAGS; i++)
+		{
+			sprintf(memText[i + 1], "%-5s %7d %7d", memTagNames[i], MemTags[i].LiveBytes, MemTags[i].HighBytes);
+		}
+
+		memRefreshCount = 0;
+	}
+
+	for (i = 0; i <= MEM_TAGS; i++)
+	{
+		drawText(4, yp + (i * 9), memText[i], bitmapItem);
+	}
+}
+
+void MemReport()
+{
+	int i;
+
+	printf("MEM  TAG      LIVE  COUNT     HIGH  COUNT  DROPPED  COUNT\n");
+
+	for (i = 0; i < MEM_TAGS; i++)
+	{
+		printf("MEM  %-5s %8d %6d %8d %6d %8d %6d\n", memTagNames[i], MemTags[i].LiveBytes, MemTags[i].LiveCount, MemTags[i].HighBytes,
+			MemTags[i].HighCount, MemTags[i].DroppedBytes, MemTags[i].DroppedCount);
+	}
+
+	printf("MEM  TOTAL %8d  (untracked records %d)\n", MemLiveBytes(), memDropped);
+}
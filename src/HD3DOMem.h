@@ -0,0 +1,118 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Tagged allocation tracking. Wraps the Lib3DO cel / image loaders and keeps
+//	live bytes and high water marks per game subsystem. Every record carries
+//	its call site so MemCheckpoint can name anything still live from a
+//	previous round when the game returns to the start menu
+//
+//	The record table belongs to the game thread, only it tracks and untracks.
+//	The audio and spooler threads each get one record, tracked at 0 bytes by
+//	the game thread before they start and untracked after they stop, under a
+//	tag nothing else uses. They only ever MemResize it, which writes that
+//	record and that tag's byte counts and nothing another thread touches
+//
+
+*/
+
+#ifndef HD3DOMEM_H
+#define HD3DOMEM_H
+
+#include "celutils.h"
+#include "displayutils.h"
+
+#define MEM_TAG_BOARD 0			// Block images and the playfield CCBs
+#define MEM_TAG_HUD 1			// Numbers, text, next / hold previews
+#define MEM_TAG_MENUS 2			// Start, options, paused, ready and game over overlays
+#define MEM_TAG_BACKGROUND 3	// Full screen SPORT images
+#define MEM_TAG_AUDIO 4			// Effect samples, the audio thread's record
+#define MEM_TAG_MUSIC 5			// Spooler buffers, the spooler thread's record
+#define MEM_TAGS 6
+
+#define MEM_MAX_RECORDS 512
+#define MEM_MAX_LEAK_LINES 16	// Outstanding records printed per checkpoint, the rest are only counted
+
+typedef struct MemRecord
+{
+	void *Ptr;					// NULL when the slot is free
+	uint32 Size;
+	int Tag;
+	char *File;					// __FILE__ of the allocating call
+	int Line;
+	int Gen;					// Checkpoints passed when it was allocated, 0 is startup
+} MemRecord;
+
+typedef struct MemTagStats
+{
+	uint32 LiveBytes;
+	uint32 HighBytes;
+	int LiveCount;
+	int HighCount;
+	uint32 DroppedBytes;		// Tracked with the table full, never live here since nothing can untrack them
+	int DroppedCount;
+} MemTagStats;
+
+typedef struct MemLeakStats
+{
+	int Checkpoints;
+	int Outstanding;			// Live records allocated after the first checkpoint, as of the last one
+	uint32 BaselineBytes;		// Live bytes at the first checkpoint
+	uint32 LastBytes;			// Live bytes at the last checkpoint
+} MemLeakStats;
+
+extern MemTagStats MemTags[MEM_TAGS];
+extern MemLeakStats MemLeaks;
+
+// The At versions take the call site, use the macros below
+
+void MemTrackAt(int tag, void *ptr, uint32 size, char *file, int line);
+void MemUntrack(void *ptr);
+void MemResize(void *ptr, uint32 size);	// In place, doesn't look for a free slot so another thread can use it on its own record
+void MemTrackItemAt(int tag, Item item, uint32 size, char *file, int line);
+void MemUntrackItem(Item item);
+
+CCB *MemLoadCelAt(int tag, char *path, char *file, int line);
+CCB *MemCopyCelAt(int tag, CCB *src, char *file, int line);
+CCB *MemCloneCelAt(int tag, CCB *src, int32 options, char *file, int line);
+CCB *MemCreateCelAt(int tag, int32 width, int32 height, int32 bitsPerPixel, int32 options, void *dataBuf, char *file, int line);
+CCB *MemCreateBackdropCelAt(int tag, int32 width, int32 height, int32 color, int32 opacityPercent, char *file, int line);
+void MemUnloadCel(CCB *cel);
+void MemReleaseCel(CCB **cel);
+
+ubyte *MemLoadImageAt(int tag, char *path, ScreenContext *sc, char *file, int line);
+void MemUnloadImage(ubyte *image);
+
+#define MemTrack(tag, ptr, size) MemTrackAt(tag, ptr, size, __FILE__, __LINE__)
+#define MemTrackItem(tag, item, size) MemTrackItemAt(tag, item, size, __FILE__, __LINE__)
+#define MemLoadCel(tag, path) MemLoadCelAt(tag, path, __FILE__, __LINE__)
+#define MemCopyCel(tag, src) MemCopyCelAt(tag, src, __FILE__, __LINE__)
+#define MemCloneCel(tag, src, options) MemCloneCelAt(tag, src, options, __FILE__, __LINE__)
+#define MemCreateCel(tag, w, h, bpp, options, dataBuf) MemCreateCelAt(tag, w, h, bpp, options, dataBuf, __FILE__, __LINE__)
+#define MemCreateBackdropCel(tag, w, h, color, opacity) MemCreateBackdropCelAt(tag, w, h, color, opacity, __FILE__, __LINE__)
+#define MemLoadImage(tag, path, sc) MemLoadImageAt(tag, path, sc, __FILE__, __LINE__)
+
+uint32 MemLiveBytes(void);
+int32 MemGrowthBytes(void);
+int MemCheckpoint(void);
+void MemDrawOverlay(Item bitmapItem);
+void MemReport(void);
+
+#endif
@@ -0,0 +1,151 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Rolling frame time histograms for the debug overlay
+//
+
+*/
+
+#include "types.h"
+#include "stdio.h"
+#include "strings.h"
+
+#include "HD3DOPerf.h"
+#include "tools.h"
+
+#define PERF_LINES (PERF_CHANNELS + 2)
+#define PERF_MS_MAX_US 999950 // Largest time FormatMS shows as itself
+#define PERF_MS_CHARS 8 // "999.9" and the terminator, with room to spare
+
+PerfStats Perf;
+
+static char perfText[PERF_LINES][MAX_STRING_LENGTH];
+
+static char *perfLabels[PERF_CHANNELS] = { "FRM", "LOG", "REN", "INP", "LAT", "SFX" };
+static uint32 perfBucketUS[PERF_CHANNELS] = { PERF_BUCKET_US, PERF_BUCKET_US, PERF_BUCKET_US, PERF_LATENCY_BUCKET_US, PERF_LATENCY_BUCKET_US, PERF_CALL_BUCKET_US };
+
+void PerfReset()
+{
+	memset(&Perf, 0, sizeof(PerfStats));
+
+	Perf.RefreshCount = PERF_REFRESH; // Build the text on the next draw
+}
+
+void PerfAddSample(int channel, uint32 us)
+{
+	PerfChannel *pc = &Perf.Channels[channel];
+	int bucket = us / perfBucketUS[channel];
+
+	if (bucket >= PERF_BUCKETS) bucket = PERF_BUCKETS - 1;
+
+	if (pc->WindowCount == PERF_WINDOW)
+	{
+		pc->Hist[pc->Window[pc->WindowIdx]]--; // Oldest sample falls out of the window
+	}
+	else
+	{
+		pc->WindowCount++;
+	}
+
+	pc->Window[pc->WindowIdx] = bucket;
+	pc->Hist[bucket]++;
+
+	if (++pc->WindowIdx >= PERF_WINDOW) pc->WindowIdx = 0;
+
+	pc->LastUS = us;
+
+	if (us > pc->PeakUS) pc->PeakUS = us;
+}
+
+void PerfAddFrame(uint32 logicUS, uint32 renderUS, uint32 frameUS)
+{
+	PerfAddSample(PERF_LOGIC, logicUS);
+	PerfAddSample(PERF_RENDER, renderUS);
+	PerfAddSample(PERF_FRAME, frameUS);
+
+	Perf.Frames++;
+
+	if (frameUS > PERF_VSYNC_US + (PERF_VSYNC_US >> 1)) Perf.MissedVsync++;
+}
+
+uint32 PerfPercentile(int channel, int pct)
+{
+	PerfChannel *pc = &Perf.Channels[channel];
+	int i, seen = 0;
+	int target = (pc->WindowCount * pct + 99) / 100;
+
+	if (pc->WindowCount == 0) return 0;
+	if (target < 1) target = 1;
+
+	for (i = 0; i < PERF_BUCKETS - 1; i++)
+	{
+		seen += pc->Hist[i];
+
+		if (seen >= target) return (i + 1) * perfBucketUS[channel] < pc->PeakUS ? (i + 1) * perfBucketUS[channel] : pc->PeakUS; // Upper edge of the bucket, never past the peak
+	}
+
+	return pc->PeakUS; // Past the histogram range, best we can say
+}
+
+static char *FormatMS(char *dst, uint32 us) // dst holds PERF_MS_CHARS
+{
+	uint32 tenths = us < PERF_MS_MAX_US ? (us + 50) / 100 : 9999; // A disc stall or a debugger break shows as 999.9, the column stays 5 wide
+
+	sprintf(dst, "%3u.%u", tenths / 10, tenths % 10);
+
+	return dst;
+}
+
+static void RefreshOverlayText()
+{
+	char p50[PERF_MS_CHARS], p95[PERF_MS_CHARS], p99[PERF_MS_CHARS], pmax[PERF_MS_CHARS];
+	int i;
+
+	sprintf(perfText[0], "      P50   P95   P99   MAX");
+
+	for (i = 0; i < PERF_CHANNELS; i++)
+	{
+		sprintf(perfText[i + 1], "%s %s %s %s %s", perfLabels[i],
+			FormatMS(p50, PerfPercentile(i, 50)),
+			FormatMS(p95, PerfPercentile(i, 95)),
+			FormatMS(p99, PerfPercentile(i, 99)),
+			FormatMS(pmax, Perf.Channels[i].PeakUS));
+	}
+
+	sprintf(perfText[PERF_CHANNELS + 1], "MISS %d OF %d", Perf.MissedVsync, Perf.Frames);
+}
+
+void PerfDrawOverlay(Item bitmapItem)
+{
+	int i;
+
+	if (++Perf.RefreshCount >= PERF_REFRESH) // sprintf only twice a second, the cels are redrawn every frame
+	{
+		RefreshOverlayText();
+
+		Perf.RefreshCount = 0;
+	}
+
+	for (i = 0; i < PERF_LINES; i++)
+	{
+		drawText(4, 2 + (i * 9), perfText[i], bitmapItem);
+	}
+}
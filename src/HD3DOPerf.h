@@ -0,0 +1,76 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Rolling frame time histograms for the debug overlay. Adding a sample is
+//	constant time, percentiles are only walked when the overlay refreshes
+//
+
+*/
+
+#ifndef HD3DOPERF_H
+#define HD3DOPERF_H
+
+#include "types.h"
+
+#define PERF_FRAME 0		// DisplayScreen to DisplayScreen
+#define PERF_LOGIC 1		// End of last frame to start of render
+#define PERF_RENDER 2		// DrawCels + DisplayScreen + SPORT clear
+#define PERF_INPUT 3		// Pad event to the tick that read it, whole fields
+#define PERF_PHOTON 4		// Pad press to the DisplayScreen of the first frame it changed, whole fields
+#define PERF_SFX 5			// A frame's effects, queued for the audio thread by AudioFlush
+#define PERF_CHANNELS 6
+
+#define PERF_BUCKET_US 250	// Histogram resolution of the frame channels
+#define PERF_LATENCY_BUCKET_US 1000	// And the latency channels, counted in fields they need the range
+#define PERF_CALL_BUCKET_US 10	// And single calls, 0 - 1.28ms
+#define PERF_BUCKETS 128	// 0 - 32ms / 128ms, anything longer lands in the last bucket
+#define PERF_WINDOW 512		// Rolling window in frames (~8.5 seconds)
+
+#define PERF_VSYNC_US 16683	// NTSC field
+#define PERF_REFRESH 30		// Frames between overlay text updates
+
+typedef struct PerfChannel
+{
+	uint16 Hist[PERF_BUCKETS];
+	uint8 Window[PERF_WINDOW];	// Bucket of each sample still in the window
+	int WindowIdx;
+	int WindowCount;
+	uint32 LastUS;
+	uint32 PeakUS;				// Since the last PerfReset, not just the window
+} PerfChannel;
+
+typedef struct PerfStats
+{
+	PerfChannel Channels[PERF_CHANNELS];
+	uint32 Frames;
+	uint32 MissedVsync;			// Frames that took longer than a field and a half
+	int RefreshCount;
+} PerfStats;
+
+extern PerfStats Perf;
+
+void PerfReset(void);
+void PerfAddSample(int channel, uint32 us);
+void PerfAddFrame(uint32 logicUS, uint32 renderUS, uint32 frameUS);
+uint32 PerfPercentile(int channel, int pct);
+void PerfDrawOverlay(Item bitmapItem);
+
+#endif
@@ -0,0 +1,52 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Seedable xorshift32, see HD3DORandom.h
+//
+
+*/
+
+#include "types.h"
+
+#include "HD3DORandom.h"
+
+void RandomSeed(RandomState *rs, uint32 seed)
+{
+	rs->S = seed != 0 ? seed : 0x6d2b79f5; // Zero would stick at zero
+}
+
+uint32 RandomNext(RandomState *rs)
+{
+	uint32 s = rs->S;
+
+	s ^= s << 13;
+	s ^= s >> 17;
+	s ^= s << 5;
+
+	rs->S = s;
+
+	return s;
+}
+
+uint32 RandomBelow(RandomState *rs, uint32 n)
+{
+	return ((RandomNext(rs) >> 16) * n) >> 16;
+}
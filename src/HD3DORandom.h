@@ -0,0 +1,45 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Small seedable generator (xorshift32). The state lives with whoever owns
+//	the sequence, so two boards or a replay and a benchmark never share one
+//
+//	RandomBelow avoids a divide, the ARM60 has none: the top 16 bits are
+//	scaled by n with a 16 x 16 multiply. The bias is under 1 / 65536
+//
+
+*/
+
+#ifndef HD3DORANDOM_H
+#define HD3DORANDOM_H
+
+#include "types.h"
+
+typedef struct RandomState
+{
+	uint32 S;
+} RandomState;
+
+void RandomSeed(RandomState *rs, uint32 seed);
+uint32 RandomNext(RandomState *rs);
+uint32 RandomBelow(RandomState *rs, uint32 n);	// 0 to n - 1, n up to 65536
+
+#endif
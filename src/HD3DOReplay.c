@@ -0,0 +1,500 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Input recording and replay, see HD3DOReplay.h for the format. Recording
+//	costs one compare per tick until the buttons change, a 30 minute session
+//	of normal play is a few thousand runs
+//
+
+*/
+
+#include "types.h"
+#include "stdio.h"
+#include "strings.h"
+#include "mem.h"
+
+#include "HD3DOReplay.h"
+
+#define REPLAY_MAX_RUN 0xffff
+
+ReplayState Replay;
+
+void (*ReplayHashHook)(uint32 tick, uint32 hash) = NULL;
+
+static int *watchScore = NULL;
+static int *watchLevel = NULL;
+static int *watchLines = NULL;
+static ubyte *watchBoard = NULL;
+static uint32 watchBoardBytes = 0;
+
+/* ----- Words ----- */
+
+// Each record checks for room up front so a full buffer never ends mid record
+
+static bool Room(uint32 bytes)
+{
+	if (Replay.Overflow || Replay.Size + bytes > Replay.Cap - REPLAY_TRAILER_BYTES) // The trailer always fits
+	{
+		Replay.Overflow = true;
+
+		return false;
+	}
+
+	return true;
+}
+
+static void Put16(uint32 v)
+{
+	Replay.Data[Replay.Size++] = (ubyte)(v >> 8);
+	Replay.Data[Replay.Size++] = (ubyte)v;
+}
+
+static void Put32(uint32 v)
+{
+	Put16(v >> 16);
+	Put16(v & 0xffff);
+}
+
+static uint32 Get16()
+{
+	uint32 v;
+
+	if (Replay.Pos + 2 > Replay.Size) return 0;
+
+	v = (Replay.Data[Replay.Pos] << 8) | Replay.Data[Replay.Pos + 1];
+
+	Replay.Pos += 2;
+
+	return v;
+}
+
+static uint32 Get32()
+{
+	uint32 hi = Get16();
+
+	return (hi << 16) | Get16();
+}
+
+static uint32 Peek32(uint32 pos)
+{
+	return (Replay.Data[pos] << 24) | (Replay.Data[pos + 1] << 16) | (Replay.Data[pos + 2] << 8) | Replay.Data[pos + 3];
+}
+
+/* ----- State ----- */
+
+void ReplayWatch(int *score, int *level, int *lines, void *board, uint32 boardBytes)
+{
+	watchScore = score;
+	watchLevel = level;
+	watchLines = lines;
+	watchBoard = (ubyte *)board;
+	watchBoardBytes = boardBytes;
+}
+
+void ReplaySample(ReplayCheck *check)
+{
+	uint32 h = 2166136261u, i;
+
+	for (i = 0; i < watchBoardBytes; i++)
+	{
+		h = (h ^ (watchBoard[i] != 0)) * 16777619u; // Only set / clear counts, not whatever true is stored as
+	}
+
+	check->Score = watchScore != NULL ? *watchScore : 0;
+	check->Level = watchLevel != NULL ? *watchLevel : 0;
+	check->Lines = watchLines != NULL ? *watchLines : 0;
+	check->Board = h;
+}
+
+// The state the trailer holds: the last game over. Once a game ends the board is cleared
+// for the next one, so sampling at the stop would only ever see the start menu
+
+void ReplayLast(ReplayCheck *check)
+{
+	if (Replay.HaveLast)
+	{
+		*check = Replay.LastCheck;
+	}
+	else
+	{
+		ReplaySample(check);
+	}
+}
+
+static bool SameCheck(ReplayCheck *a, ReplayCheck *b)
+{
+	return a->Score == b->Score && a->Level == b->Level && a->Lines == b->Lines && a->Board == b->Board;
+}
+
+static void Mismatch()
+{
+	if (Replay.Mismatches++ == 0) Replay.FirstMismatchTick = Replay.Ticks;
+}
+
+/* ----- Recording ----- */
+
+bool ReplayStartRecord(uint32 maxBytes, uint32 hashEvery)
+{
+	ReplayStop();
+
+	if (maxBytes < REPLAY_HEADER_BYTES + REPLAY_TRAILER_BYTES + 64) return false;
+
+	if ((Replay.Data = (ubyte *)malloc(maxBytes)) == NULL) return false;
+
+	Replay.Cap = maxBytes;
+	Replay.OwnsData = true;
+	Replay.Mode = REPLAY_RECORD;
+	Replay.HashEvery = hashEvery;
+
+	Put32(REPLAY_MAGIC);
+	Put16(REPLAY_VERSION);
+	Put16(hashEvery);
+
+	return true;
+}
+
+static void FlushRun()
+{
+	if (Replay.RunCount == 0) return;
+
+	if (Room(4))
+	{
+		Put16(Replay.RunBits);
+		Put16(Replay.RunCount);
+
+		Replay.Runs++;
+	}
+
+	Replay.RunCount = 0;
+}
+
+static bool PutControl(uint32 tag, uint32 payloadBytes)
+{
+	FlushRun();
+
+	if (Room(4 + payloadBytes) == false) return false;
+
+	Put16(tag);
+	Put16(0);
+
+	return true;
+}
+
+static void PutCheck(ReplayCheck *check)
+{
+	Put32(check->Score);
+	Put32(check->Level);
+	Put32(check->Lines);
+	Put32(check->Board);
+}
+
+// Writes the trailer. mark is opaque here, playback hands it back in Replay.EndMark
+
+void ReplayFinish(uint32 mark)
+{
+	ReplayCheck check;
+
+	if (Replay.Mode != REPLAY_RECORD) return;
+
+	FlushRun();
+
+	ReplayLast(&check);
+
+	Put16(REPLAY_TAG_END);
+	Put16(0);
+	Put32(mark);
+	Put32(Replay.Ticks);
+	PutCheck(&check);
+
+	Replay.EndMark = mark;
+	Replay.EndTicks = Replay.Ticks;
+	Replay.EndCheck = check;
+
+	Replay.Mode = REPLAY_OFF;
+}
+
+/* ----- Playback ----- */
+
+bool ReplayStartPlayback(ubyte *data, uint32 size)
+{
+	uint32 end;
+
+	ReplayStop();
+
+	if (size < REPLAY_HEADER_BYTES + REPLAY_TRAILER_BYTES) return false;
+
+	Replay.Data = data;
+	Replay.Size = size;
+
+	if (Get32() != REPLAY_MAGIC || Get16() != REPLAY_VERSION) return false;
+
+	Replay.HashEvery = Get16();
+
+	end = size - REPLAY_TRAILER_BYTES;
+
+	if ((Peek32(end) >> 16) != REPLAY_TAG_END) return false; // No trailer, the recording was never finished
+
+	Replay.EndMark = Peek32(end + 4);
+	Replay.EndTicks = Peek32(end + 8);
+	Replay.EndCheck.Score = Peek32(end + 12);
+	Replay.EndCheck.Level = Peek32(end + 16);
+	Replay.EndCheck.Lines = Peek32(end + 20);
+	Replay.EndCheck.Board = Peek32(end + 24);
+
+	Replay.Mode = REPLAY_PLAY;
+
+	return true;
+}
+
+// Reads the next record. Runs fill RunBits / RunCount, controls return their tag
+
+static uint32 NextRecord()
+{
+	uint32 bits, count;
+
+	if (Replay.Pos + 4 > Replay.Size)
+	{
+		Replay.Ended = true;
+
+		return REPLAY_TAG_END;
+	}
+
+	bits = Get16();
+	count = Get16();
+
+	if (count == 0)
+	{
+		if (bits == REPLAY_TAG_END)
+		{
+			Replay.Ended = true;
+			Replay.Pos -= 4; // Stay on the trailer
+		}
+
+		return bits;
+	}
+
+	Replay.RunBits = bits;
+	Replay.RunCount = count;
+	Replay.Runs++;
+
+	return 0;
+}
+
+/* ----- Game hooks ----- */
+
+uint32 ReplaySeed(uint32 seed)
+{
+	if (Replay.Mode == REPLAY_RECORD)
+	{
+		if (PutControl(REPLAY_TAG_SEED, 4))
+		{
+			Put32(seed);
+
+			Replay.Seeds++;
+		}
+	}
+	else if (Replay.Mode == REPLAY_PLAY && Replay.Ended == false)
+	{
+		if (Replay.RunCount > 0 || NextRecord() != REPLAY_TAG_SEED)
+		{
+			Mismatch(); // The game asked for a seed where the recording has input
+
+			return seed;
+		}
+
+		Replay.Seeds++;
+
+		return Get32();
+	}
+
+	return seed;
+}
+
+uint32 ReplayInput(uint32 buttonBits, uint32 *taps)
+{
+	uint32 tag;
+
+	if (Replay.Mode == REPLAY_RECORD)
+	{
+		uint32 bits = buttonBits >> 16; // Every pad button is in the top half
+
+		if (*taps != 0 && PutControl(REPLAY_TAG_TAPS, 4)) // Rare, a tap always starts a new run
+		{
+			Put32(*taps >> 16);
+
+			Replay.Taps++;
+		}
+
+		if (Replay.RunCount > 0 && (bits != Replay.RunBits || Replay.RunCount == REPLAY_MAX_RUN)) FlushRun();
+
+		Replay.RunBits = bits;
+		Replay.RunCount++;
+		Replay.Ticks++;
+
+		return buttonBits;
+	}
+
+	if (Replay.Mode != REPLAY_PLAY)
+	{
+		Replay.Ticks++;
+
+		return buttonBits;
+	}
+
+	*taps = 0;
+
+	if (Replay.RunCount == 0 && Replay.Ended == false)
+	{
+		tag = NextRecord();
+
+		if (tag == REPLAY_TAG_TAPS)
+		{
+			*taps = Get32() << 16;
+
+			Replay.Taps++;
+
+			tag = NextRecord();
+		}
+
+		if (tag != 0 && Replay.Ended == false)
+		{
+			Mismatch(); // A seed or check where the game wants input, the two have drifted apart
+
+			Replay.Ended = true;
+		}
+	}
+
+	if (Replay.Ended) return 0;
+
+	Replay.RunCount--;
+	Replay.Ticks++;
+
+	return Replay.RunBits << 16;
+}
+
+// Called at each game over. Recording writes the state, playback compares against it
+
+void ReplayCheckpoint()
+{
+	ReplayCheck now, then;
+
+	if (Replay.Mode == REPLAY_OFF) return;
+
+	ReplaySample(&now);
+
+	Replay.LastCheck = now;
+	Replay.HaveLast = true;
+
+	if (Replay.Mode == REPLAY_RECORD)
+	{
+		if (PutControl(REPLAY_TAG_CHECK, 16))
+		{
+			PutCheck(&now);
+
+			Replay.Checks++;
+		}
+
+		return;
+	}
+
+	if (Replay.Ended) return;
+
+	if (Replay.RunCount > 0 || NextRecord() != REPLAY_TAG_CHECK)
+	{
+		Mismatch();
+
+		return;
+	}
+
+	then.Score = Get32();
+	then.Level = Get32();
+	then.Lines = Get32();
+	then.Board = Get32();
+
+	Replay.Checks++;
+
+	if (SameCheck(&now, &then) == false) Mismatch();
+}
+
+// Called once per gameplay tick after the logic has run
+
+void ReplayTick(uint32 hash)
+{
+	if (Replay.LogHashes) printf("HASH %u %08x\n", Replay.Ticks, hash);
+
+	if (ReplayHashHook != NULL) ReplayHashHook(Replay.Ticks, hash);
+
+	if (Replay.HashEvery == 0 || (Replay.Ticks % Replay.HashEvery) != 0) return;
+
+	if (Replay.Mode == REPLAY_RECORD)
+	{
+		if (PutControl(REPLAY_TAG_HASH, 4))
+		{
+			Put32(hash);
+
+			Replay.Hashes++;
+		}
+
+		return;
+	}
+
+	if (Replay.Mode != REPLAY_PLAY || Replay.Ended) return;
+
+	if (Replay.RunCount > 0 || NextRecord() != REPLAY_TAG_HASH)
+	{
+		Mismatch();
+
+		return;
+	}
+
+	Replay.Hashes++;
+
+	if (Get32() == hash)
+	{
+		if (Replay.Mismatches == 0) Replay.LastHashTick = Replay.Ticks;
+	}
+	else
+	{
+		Mismatch();
+	}
+}
+
+// Compares the game state against the trailer, call it where the recording called ReplayFinish
+
+bool ReplayVerify()
+{
+	ReplayCheck now;
+
+	ReplayLast(&now);
+
+	return Replay.Mismatches == 0 && Replay.Ticks == Replay.EndTicks && SameCheck(&now, &Replay.EndCheck);
+}
+
+void ReplayStop()
+{
+	bool logHashes = Replay.LogHashes;
+
+	if (Replay.OwnsData && Replay.Data != NULL) free(Replay.Data);
+
+	memset(&Replay, 0, sizeof(ReplayState));
+
+	Replay.LogHashes = logHashes;
+}
@@ -0,0 +1,136 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Input recording and replay. Everything that makes a session differ from
+//	the next is the piece generator seed and the pad bits HandleInput reads once per
+//	tick, so that is all that gets recorded:
+//
+//		Header		"HDRP", version, hash interval in ticks (0 for none)
+//		Run			button bits >> 16, tick count (1 - 65535)
+//		Control		tag, 0 then the tag's payload
+//					SEED	the piece generator seed
+//					CHECK	score, level, lines, board hash at each game over
+//					HASH	GameHash after the tick, every hash interval ticks
+//					TAPS	presses the next tick's bits don't show (InputRead)
+//		Trailer		END control, stop mark, ticks, then the score, level, lines and board
+//					hash of the last game over (or of the stop if no game ended)
+//
+//	All fields are big endian 16 / 32 bit words. Playback hands back the same
+//	seeds and bits in the same order and compares every CHECK, every HASH and
+//	the trailer against the game. With an interval of 1 the first tick that
+//	differs is known exactly, otherwise it's somewhere since the last match
+//
+//	ReplayTick can also print every tick's hash (REPLAY_LOG_HASHES, or the
+//	host's --hash-log) so two builds can be compared line by line
+//
+
+*/
+
+#ifndef HD3DOREPLAY_H
+#define HD3DOREPLAY_H
+
+#include "types.h"
+
+#ifndef REPLAY_RECORD_BYTES
+#define REPLAY_RECORD_BYTES 0		// Debug builds set this to record from power on, the buffer is left in Replay.Data
+#endif
+
+#define REPLAY_MAGIC 0x48445250		// "HDRP"
+#define REPLAY_VERSION 5		// 2: one seed per session, pieces come from the 7-bag. 3: HASH records. 4: TAPS records. 5: END holds the last game over
+
+#ifndef REPLAY_LOG_HASHES
+#define REPLAY_LOG_HASHES 0			// Debug builds set this to print "HASH <tick> <hash>" every gameplay tick
+#endif
+
+#define REPLAY_HASH_EVERY 60		// Default interval between HASH records
+
+#define REPLAY_OFF 0
+#define REPLAY_RECORD 1
+#define REPLAY_PLAY 2
+
+#define REPLAY_TAG_SEED 1
+#define REPLAY_TAG_CHECK 2
+#define REPLAY_TAG_END 3
+#define REPLAY_TAG_HASH 4
+#define REPLAY_TAG_TAPS 5
+
+#define REPLAY_HEADER_BYTES 8
+#define REPLAY_TRAILER_BYTES 28
+
+typedef struct ReplayCheck
+{
+	uint32 Score;
+	uint32 Level;
+	uint32 Lines;
+	uint32 Board;				// FNV-1a of the playfield
+} ReplayCheck;
+
+typedef struct ReplayState
+{
+	int Mode;
+	ubyte *Data;
+	uint32 Size;				// Bytes written, or the whole file when playing
+	uint32 Cap;
+	uint32 Pos;					// Read position when playing
+	uint32 Ticks;				// HandleInput polls so far, counted whether recording or not
+	uint32 HashEvery;
+	uint32 Hashes;
+	uint32 LastHashTick;		// Last tick whose HASH matched when playing
+	bool LogHashes;
+	uint32 RunBits;
+	uint32 RunCount;			// Ticks left in the current run when playing
+	uint32 Runs;
+	uint32 Seeds;
+	uint32 Taps;				// TAPS records
+	uint32 Checks;
+	uint32 Mismatches;			// CHECKs that came out different, or records of the wrong kind
+	uint32 FirstMismatchTick;
+	bool Overflow;				// Recording stopped early, the buffer was full
+	bool Ended;					// Playback reached the trailer
+	bool OwnsData;
+	uint32 EndMark;				// Whatever the recorder passed to ReplayFinish (the host uses its frame count)
+	uint32 EndTicks;
+	ReplayCheck EndCheck;
+	ReplayCheck LastCheck;		// State at the most recent game over, what the trailer records
+	bool HaveLast;
+} ReplayState;
+
+extern ReplayState Replay;
+
+void ReplayWatch(int *score, int *level, int *lines, void *board, uint32 boardBytes);
+
+extern void (*ReplayHashHook)(uint32 tick, uint32 hash);	// Called with every tick's hash when set
+
+bool ReplayStartRecord(uint32 maxBytes, uint32 hashEvery);
+bool ReplayStartPlayback(ubyte *data, uint32 size);
+void ReplayStop(void);
+
+uint32 ReplaySeed(uint32 seed);
+uint32 ReplayInput(uint32 buttonBits, uint32 *taps);
+void ReplayCheckpoint(void);
+void ReplayTick(uint32 hash);
+
+void ReplayFinish(uint32 mark);
+bool ReplayVerify(void);
+void ReplaySample(ReplayCheck *check);
+void ReplayLast(ReplayCheck *check);
+
+#endif
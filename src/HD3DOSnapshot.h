@@ -0,0 +1,91 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Packed gameplay snapshot, 64 bytes. Everything HandleInput and
+//	HandleGameplayLogic read between two ticks, so restoring one and
+//	feeding the same input gives the same game. Save / Restore live in
+//	tetris.c next to the globals they copy, both are constant time
+//
+//	GameHash is the same state as a 32 bit hash, kept up to date as blocks
+//	lock, clear and move so it's cheap enough to take every tick
+//
+//	Cels aren't saved, Restore re-derives them. Locked blocks don't keep
+//	their colour, they are recoloured the way ApplySelectedColorPalette does
+//
+
+*/
+
+#ifndef HD3DOSNAPSHOT_H
+#define HD3DOSNAPSHOT_H
+
+#include "types.h"
+
+#include "HD3DOGame.h"
+
+#define SNAPSHOT_VERSION 2 // 2: input is the HD3DOInput.h button table
+
+#define SNAPSHOT_NONE 7					// Queued / held shape slot that's empty
+
+#define SNAPSHOT_WAIT_BITS 5			// Per repeating button in Counters
+#define SNAPSHOT_WAIT_MAX 31			// Waits past this are clamped, more than a DAS or ARR in ticks needs
+
+#define SNAPSHOT_ROWS_PER_WORD (32 / BOARD_WIDTH)	// Three at 10 wide
+#define SNAPSHOT_BOARD_WORDS ((BOARD_HEIGHT + SNAPSHOT_ROWS_PER_WORD - 1) / SNAPSHOT_ROWS_PER_WORD)
+#define SNAPSHOT_COLUMN_BITS (BOARD_WIDTH > 16 ? 8 : 4)	// Per active block column
+
+// Flags, bits 0 - 10 are the buttons held (bit n is INPUT_n, see HD3DOInput.h)
+
+#define SNAP_CAN_HOLD		0x2000
+#define SNAP_PAUSED			0x4000
+
+typedef struct GameSnapshot
+{
+	uint32 Board[SNAPSHOT_BOARD_WORDS];	// Bitboard, whole rows packed into each word, bit x is column x
+	uint32 Rng;					// Piece generator state
+	uint32 Bag;					// Shapes left in the bag, 3 bits each, count in bits 21 - 23
+	uint32 Ahead;				// Upcoming shapes from the ring head, 3 bits each, count in bits 24 - 27
+	uint32 Counters;			// Ticks to each repeating button's next repeat, SNAPSHOT_WAIT_BITS each in button order
+	int32 Score;
+	uint16 Flags;
+	uint16 Shapes;				// Active, queued, held 3 bits each then QueueSwaps 2 bits
+	uint16 Lines;				// TotLines
+	uint16 LevelLines;			// CurrLines
+	uint16 TargetLines;
+	uint8 BlockX[SNAPSHOT_COLUMN_BITS / 2];	// Active block columns, a nibble each up to 16 wide
+	int8 BlockY[4];
+	uint8 Version;
+	uint8 Level;
+	uint8 Speed;				// lvSpeed
+	uint8 Gravity;				// swGame
+} GameSnapshot;
+
+typedef char GameSnapshotWidth[BOARD_WIDTH <= 32 ? 1 : -1]; // A row has to fit in a word
+
+#if BOARD_WIDTH == 10 && BOARD_HEIGHT == 18
+typedef char GameSnapshotSize[sizeof(GameSnapshot) == 64 ? 1 : -1]; // Fails to compile if the layout grows
+#endif
+
+bool SaveSnapshot(GameSnapshot *gs);		// false outside of a game or during a line clear / game over
+bool RestoreSnapshot(GameSnapshot *gs);		// false on a version mismatch
+
+extern GameState Game;						// The board on screen, in tetris.c. GameHash / GameFullHash in HD3DOGame.h
+
+#endif
@@ -0,0 +1,1719 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Host stand-in folio layer. Loads the real CD/data cels and images, keeps
+//	the frame buffers in the console's line pair layout and counts / times
+//	every call so a run can be profiled without the hardware. DrawCels goes
+//	through the software cel engine in hostcel.c
+//
+
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "host3do.h"
+#include "HD3DOAudioSoundInterface.h"
+
+#define HOST_SCREEN_ITEM 0x100	// Screen n is HOST_SCREEN_ITEM + n, its bitmap HOST_BITMAP_ITEM + n
+#define HOST_BITMAP_ITEM 0x200
+#define HOST_VRAM_IOREQ 0x301
+#define HOST_VBL_IOREQ 0x302
+#define HOST_TIMER_IOREQ 0x303
+#define HOST_BROKER_PORT 0x401		// The event broker's port, FindMsgPort(EventPortName)
+#define HOST_LISTENER_PORT 0x402	// The one port CreateMsgPort hands out
+#define HOST_CONFIG_MSG 0x403		// The one message CreateMsg hands out
+#define HOST_EVENT_MSG 0x404		// Event records from the broker
+#define HOST_TASK_ITEM 0x500		// Task n is HOST_TASK_ITEM + n, the main task is 0
+#define HOST_TASKS 8
+#define HOST_FIRST_SIGNAL 0x100		// The kernel keeps the low byte for itself
+#define HOST_SLEEP_SIGNAL 0x10		// One of those, SleepAudioTicks waits on it
+#define HOST_CUES 32				// Signals waiting on the audio clock
+#define HOST_SAMPLER_ITEM 0x600
+#define HOST_CUE_ITEM 0x700
+#define HOST_CUE_ITEMS 4
+#define HOST_SAMPLERS 4				// Loaded sound files at once
+#define HOST_AUDIO_TICKS 240
+
+#define HOST_WIDTH 320
+#define HOST_HEIGHT 240
+#define HOST_FIELD_NS 16683000ULL
+
+#define HOST_BLOCK_MAGIC 0x484f5354	// 'HOST'
+
+#define HOST_SYS_DRAM (2 * 1024 * 1024)	// What AvailMem pretends the console has
+#define HOST_SYS_VRAM (1024 * 1024)
+
+HostStats Host;
+char *HostDataRoot = "../../CD";
+uint32 HostRandomSeed = 0x3D0;
+uint32 HostRandom = 0;
+bool HostVsync = false;
+bool HostRaster = true;
+
+typedef union HostBlock		// In front of everything handed to the game, keeps the payload 16 byte aligned
+{
+	struct
+	{
+		uint32 Magic;
+		uint32 Size;
+	} h;
+	long double align;
+} HostBlock;
+
+static char *hostCallNames[HOST_CALLS] =
+{
+	"DrawCels", "DisplayScreen", "DoIO", "DrawImage", "LoadCel", "UnloadCel", "CreateCel",
+	"LoadImage", "UnloadImage", "GetMsg", "SampleSystemTime", "CallSound", "WaitVBL"
+};
+
+static Bitmap hostBitmaps[MAXSCREENS];
+static int hostScreenCount = 0;
+static int hostShownScreen = 0;
+
+static uint32 hostCRCTable[256];
+
+static uint64 hostStartNS = 0;
+static uint64 hostLastFieldNS = 0;
+
+typedef struct HostTask
+{
+	Task Task;
+	pthread_t Thread;
+	void (*Code)();
+	bool Used;
+	int32 Allocated;			// AllocSignal bits
+	int32 Received;				// Sent and not waited for yet
+} HostTask;
+
+static HostTask hostTasks[HOST_TASKS];
+static __thread int hostTaskIdx = 0;
+static pthread_mutex_t hostSignalLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t hostSignalCond = PTHREAD_COND_INITIALIZER;
+
+typedef struct HostCue
+{
+	Item Task;
+	int32 Signal;
+	AudioTime Time;
+} HostCue;
+
+static HostCue hostCues[HOST_CUES];
+static int hostCueCount = 0;
+static HostCue hostCueItems[HOST_CUE_ITEMS];	// CreateItem's, Task 0 when free
+static AudioTime hostAudioTime = 0;
+
+static SoundFilePlayer *hostSamplers[HOST_SAMPLERS];
+
+static void HostCueAt(Item task, int32 signal, AudioTime time);
+static void HostCancelCues(Item task, int32 signals);
+
+HostDriveModel HostDrive =
+{
+	88200,	// 44.1kHz 16 bit mono
+	307200,	// Double speed
+	60
+};
+
+static bool hostListening = false;
+static bool hostEventOut = false;			// The record is with the listener until it replies
+static bool hostEventPolled = false;		// This read has asked HostPollPad already
+static uint32 hostPadBits = 0;				// The pad as the driver last set it
+static uint32 hostSentBits = 0;				// As the listener last heard it
+static uint32 hostListenField = 0;			// Changes before this went unheard
+static Message hostConfigMsg;
+static Message hostEventMsg;
+static uint32 hostEventRecord[(sizeof(EventBrokerHeader) + ((HOST_PAD_EVENTS + 1) * sizeof(EventFrame))) / 4];
+
+/* ----- Bookkeeping ----- */
+
+uint64 HostNowNS()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+void HostRecordCall(int call, uint64 startNS)
+{
+	HostCallStats *hc = &Host.Calls[call];
+	uint64 ns = HostNowNS() - startNS;
+
+	hc->Count++;
+	hc->TotalNS += ns;
+
+	if (ns > hc->MaxNS) hc->MaxNS = ns;
+}
+
+static void *HostAlloc(uint32 size)
+{
+	HostBlock *hb = (HostBlock *)calloc(1, sizeof(HostBlock) + size);
+
+	if (hb == NULL) return NULL;
+
+	hb->h.Magic = HOST_BLOCK_MAGIC;
+	hb->h.Size = size;
+
+	Host.LiveBytes += size;
+	Host.LiveBlocks++;
+
+	if (Host.LiveBytes > Host.HighBytes) Host.HighBytes = Host.LiveBytes;
+
+	return hb + 1;
+}
+
+static void HostFree(void *ptr)
+{
+	HostBlock *hb;
+
+	if (ptr == NULL) return;
+
+	hb = (HostBlock *)ptr - 1;
+
+	if (hb->h.Magic != HOST_BLOCK_MAGIC)
+	{
+		fprintf(stderr, "host: free of %p that the stand-in didn't allocate (double free?)\n", ptr);
+		abort();
+	}
+
+	hb->h.Magic = 0;
+
+	Host.LiveBytes -= hb->h.Size;
+	Host.LiveBlocks--;
+
+	free(hb);
+}
+
+static uint32 GetBE32(ubyte *p)
+{
+	return ((uint32)p[0] << 24) | ((uint32)p[1] << 16) | ((uint32)p[2] << 8) | p[3];
+}
+
+static void SwapPixels16(uint16 *dst, ubyte *src, int32 count)
+{
+	int32 i;
+
+	for (i = 0; i < count; i++)
+	{
+		dst[i] = (uint16)((src[i * 2] << 8) | src[(i * 2) + 1]);
+	}
+}
+
+static char *HostPath(char *path, char *buffer, int size)
+{
+	snprintf(buffer, size, "%s/%s", HostDataRoot, path);
+
+	return buffer;
+}
+
+ubyte *HostReadFile(char *path, int32 *size)
+{
+	char full[512];
+	FILE *fp = fopen(HostPath(path, full, sizeof(full)), "rb");
+	ubyte *data;
+
+	*size = 0;
+
+	if (fp == NULL)
+	{
+		fprintf(stderr, "host: can't open %s\n", full);
+
+		return NULL;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	*size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	data = (ubyte *)malloc(*size);
+
+	if (data != NULL && fread(data, 1, *size, fp) != (size_t)*size)
+	{
+		free(data);
+		data = NULL;
+	}
+
+	fclose(fp);
+
+	return data;
+}
+
+// Walks the 3DO chunk list, returns the first chunk with the given ID
+
+static ubyte *FindChunk(ubyte *data, int32 size, char *id, int32 *chunkSize)
+{
+	int32 offset = 0;
+	int32 len;
+
+	while (offset + 8 <= size)
+	{
+		len = GetBE32(data + offset + 4);
+
+		if (len < 8) break;
+
+		if (memcmp(data + offset, id, 4) == 0 && offset + len <= size)
+		{
+			*chunkSize = len;
+
+			return data + offset;
+		}
+
+		offset += (len + 3) & ~3;
+	}
+
+	return NULL;
+}
+
+int32 GetFileSize(char *path)
+{
+	char full[512];
+	struct stat st;
+
+	if (stat(HostPath(path, full, sizeof(full)), &st) != 0) return -1;
+
+	return (int32)st.st_size;
+}
+
+/* ----- Graphics folio ----- */
+
+Err OpenGraphicsFolio() { return 0; }
+Err CloseGraphicsFolio() { return 0; }
+
+bool CreateBasicDisplay(ScreenContext *sc, uint32 displayType, uint32 numScreens)
+{
+	uint32 i;
+
+	if (numScreens > MAXSCREENS) numScreens = MAXSCREENS;
+
+	sc->sc_nScreens = numScreens;
+	sc->sc_curScreen = 0;
+	sc->sc_nFrameBufferPages = 1;
+	sc->sc_nFrameByteCount = HOST_WIDTH * HOST_HEIGHT * 2;
+
+	for (i = 0; i < numScreens; i++)
+	{
+		hostBitmaps[i].bm_Buffer = (ubyte *)HostAlloc(sc->sc_nFrameByteCount);
+		hostBitmaps[i].bm_Width = HOST_WIDTH;
+		hostBitmaps[i].bm_Height = HOST_HEIGHT;
+
+		sc->sc_Screens[i] = HOST_SCREEN_ITEM + i;
+		sc->sc_BitmapItems[i] = HOST_BITMAP_ITEM + i;
+		sc->sc_Bitmaps[i] = &hostBitmaps[i];
+	}
+
+	hostScreenCount = numScreens;
+
+	return true;
+}
+
+void CloseGraphics(ScreenContext *sc)
+{
+	int i;
+
+	for (i = 0; i < hostScreenCount; i++)
+	{
+		HostFree(hostBitmaps[i].bm_Buffer);
+		hostBitmaps[i].bm_Buffer = NULL;
+	}
+
+	hostScreenCount = 0;
+}
+
+Err DisableVAVG(Item screenItem) { return 0; }
+Err DisableHAVG(Item screenItem) { return 0; }
+
+static void HostWaitField()
+{
+	uint64 now = HostNowNS();
+	uint64 due = hostLastFieldNS + HOST_FIELD_NS;
+	struct timespec ts;
+
+	if (hostLastFieldNS != 0 && now < due)
+	{
+		ts.tv_sec = (due - now) / 1000000000ULL;
+		ts.tv_nsec = (due - now) % 1000000000ULL;
+
+		nanosleep(&ts, NULL);
+	}
+
+	hostLastFieldNS = HostNowNS();
+}
+
+Err DisplayScreen(Item screenItem0, Item screenItem1)
+{
+	uint64 t0 = HostNowNS();
+
+	int idx = screenItem0 - HOST_SCREEN_ITEM;
+
+	if (HostVsync) HostWaitField();
+
+	if (idx >= 0 && idx < hostScreenCount) hostShownScreen = idx;
+
+	Host.Frames++;
+	Host.Fields++;
+
+	Host.LastFrame = Host.Frame;
+
+	if (Host.Frame.PixelsFilled > Host.PeakFrame.PixelsFilled)
+	{
+		Host.PeakFrame = Host.Frame;
+		Host.PeakFrameNum = Host.Frames;
+	}
+
+	memset(&Host.Frame, 0, sizeof(Host.Frame));
+
+	HostRecordCall(HOST_CALL_DISPLAYSCREEN, t0);
+
+	HostFrameDone();
+
+	return 0;
+}
+
+static Err HostDrawCels(int idx, CCB *ccb)
+{
+	uint64 t0 = HostNowNS();
+
+	HostRasterCels((HostRaster && idx >= 0 && idx < hostScreenCount) ? &hostBitmaps[idx] : NULL, ccb);
+
+	HostRecordCall(HOST_CALL_DRAWCELS, t0);
+
+	return 0;
+}
+
+Err DrawCels(Item bitmapItem, CCB *ccb)
+{
+	return HostDrawCels(bitmapItem - HOST_BITMAP_ITEM, ccb);
+}
+
+Err DrawScreenCels(Item screenItem, CCB *ccb)
+{
+	return HostDrawCels(screenItem - HOST_SCREEN_ITEM, ccb);
+}
+
+bool DrawImage(Item screenItem, ubyte *image, ScreenContext *sc)
+{
+	uint64 t0 = HostNowNS();
+	int idx = screenItem - HOST_SCREEN_ITEM;
+
+	if (idx >= 0 && idx < hostScreenCount && image != NULL)
+	{
+		memcpy(hostBitmaps[idx].bm_Buffer, image, sc->sc_nFrameByteCount);
+	}
+
+	HostRecordCall(HOST_CALL_DRAWIMAGE, t0);
+
+	return true;
+}
+
+void FadeToBlack(ScreenContext *sc, int32 frameCount)
+{
+	WaitVBL(HOST_VBL_IOREQ, frameCount);
+}
+
+void FadeFromBlack(ScreenContext *sc, int32 frameCount)
+{
+	WaitVBL(HOST_VBL_IOREQ, frameCount);
+}
+
+/* ----- Cels ----- */
+
+CCB *AllocMagicCel_(int32 extraBytes, uint32 magic, void *dataBuf, void *plutBuf)
+{
+	return (CCB *)HostAlloc(sizeof(CCB) + extraBytes);
+}
+
+void UnloadCel(CCB *cel)
+{
+	uint64 t0 = HostNowNS();
+
+	HostFree(cel);
+
+	HostRecordCall(HOST_CALL_UNLOADCEL, t0);
+}
+
+// Cels are normalised on load: absolute pointers, preamble words in the CCB,
+// PLUT entries and unpacked 16 bit pixels in host byte order. Packed and
+// coded pixel data is left as the big endian bytes from the file
+
+CCB *LoadCel(char *name, uint32 memTypeBits)
+{
+	uint64 t0 = HostNowNS();
+	int32 size, ccbLen, plutLen = 0, pdatLen = 0, plutCount = 0, skip, bpp;
+	ubyte *data = HostReadFile(name, &size);
+	ubyte *ccbChunk, *plutChunk, *pdatChunk;
+	CCB *cel = NULL;
+	ubyte *pixels;
+
+	if (data == NULL) goto done;
+
+	ccbChunk = FindChunk(data, size, "CCB ", &ccbLen);
+	plutChunk = FindChunk(data, size, "PLUT", &plutLen);
+	pdatChunk = FindChunk(data, size, "PDAT", &pdatLen);
+
+	if (ccbChunk == NULL || pdatChunk == NULL || ccbLen < 80)
+	{
+		fprintf(stderr, "host: %s isn't a cel file\n", name);
+		goto done;
+	}
+
+	if (plutChunk != NULL) plutCount = GetBE32(plutChunk + 8);
+
+	pdatLen -= 8;
+
+	cel = (CCB *)HostAlloc(sizeof(CCB) + (plutCount * 2) + pdatLen + 4);
+
+	cel->ccb_Flags = GetBE32(ccbChunk + 12) | CCB_NPABS | CCB_SPABS | CCB_PPABS;
+	cel->ccb_XPos = GetBE32(ccbChunk + 28);
+	cel->ccb_YPos = GetBE32(ccbChunk + 32);
+	cel->ccb_HDX = GetBE32(ccbChunk + 36);
+	cel->ccb_HDY = GetBE32(ccbChunk + 40);
+	cel->ccb_VDX = GetBE32(ccbChunk + 44);
+	cel->ccb_VDY = GetBE32(ccbChunk + 48);
+	cel->ccb_HDDX = GetBE32(ccbChunk + 52);
+	cel->ccb_HDDY = GetBE32(ccbChunk + 56);
+	cel->ccb_PIXC = GetBE32(ccbChunk + 60);
+	cel->ccb_PRE0 = GetBE32(ccbChunk + 64);
+	cel->ccb_PRE1 = GetBE32(ccbChunk + 68);
+	cel->ccb_Width = GetBE32(ccbChunk + 72);
+	cel->ccb_Height = GetBE32(ccbChunk + 76);
+
+	pdatChunk += 8;
+
+	if ((cel->ccb_Flags & CCB_CCBPRE) == 0) // Preamble is at the front of the pixel data
+	{
+		skip = (cel->ccb_Flags & CCB_PACKED) ? 4 : 8;
+
+		cel->ccb_PRE0 = GetBE32(pdatChunk);
+		if (skip == 8) cel->ccb_PRE1 = GetBE32(pdatChunk + 4);
+
+		cel->ccb_Flags |= CCB_CCBPRE;
+
+		pdatChunk += skip;
+		pdatLen -= skip;
+	}
+
+	pixels = (ubyte *)(cel + 1);
+
+	if (plutCount > 0)
+	{
+		SwapPixels16((uint16 *)pixels, plutChunk + 12, plutCount);
+
+		cel->ccb_PLUTPtr = pixels;
+
+		pixels += (plutCount * 2 + 3) & ~3;
+	}
+
+	bpp = cel->ccb_PRE0 & PRE0_BPP_MASK;
+
+	if (bpp == PRE0_BPP_16 && (cel->ccb_Flags & CCB_PACKED) == 0)
+	{
+		SwapPixels16((uint16 *)pixels, pdatChunk, pdatLen / 2);
+	}
+	else
+	{
+		memcpy(pixels, pdatChunk, pdatLen);
+	}
+
+	cel->ccb_SourcePtr = (CelData *)pixels;
+	cel->ccb_NextPtr = NULL;
+
+done:
+	free(data);
+
+	HostRecordCall(HOST_CALL_LOADCEL, t0);
+
+	return cel;
+}
+
+CCB *CloneCel(CCB *src, int32 options)
+{
+	uint64 t0 = HostNowNS();
+	CCB *cel = (CCB *)HostAlloc(sizeof(CCB));
+
+	memcpy(cel, src, sizeof(CCB)); // Only CCB_ONLY is used, pixels stay shared
+
+	HostRecordCall(HOST_CALL_CREATECEL, t0);
+
+	return cel;
+}
+
+static uint32 RowBytes(int32 width, int32 bitsPerPixel)
+{
+	return ((((width * bitsPerPixel) + 31) >> 5) << 2); // Rows are word aligned
+}
+
+static uint32 BppCode(int32 bitsPerPixel)
+{
+	switch (bitsPerPixel)
+	{
+		case 1: return PRE0_BPP_1;
+		case 2: return PRE0_BPP_2;
+		case 4: return PRE0_BPP_4;
+		case 6: return PRE0_BPP_6;
+		case 8: return PRE0_BPP_8;
+	}
+
+	return PRE0_BPP_16;
+}
+
+static void InitCreatedCel(CCB *cel, int32 width, int32 height, int32 bitsPerPixel, int32 options)
+{
+	uint32 rowWords = RowBytes(width, bitsPerPixel) >> 2;
+
+	cel->ccb_Flags = CCB_LAST | CCB_NPABS | CCB_SPABS | CCB_PPABS | CCB_LDSIZE | CCB_LDPRS | CCB_LDPPMP | CCB_LDPLUT
+		| CCB_CCBPRE | CCB_YOXY | CCB_ACW | CCB_ACCW | CCB_ACE | CCB_USEAV | CCB_NOBLK;
+
+	cel->ccb_HDX = 1 << 20;
+	cel->ccb_VDY = 1 << 16;
+	cel->ccb_PIXC = PIXC_OPAQUE;
+	cel->ccb_Width = width;
+	cel->ccb_Height = height;
+
+	cel->ccb_PRE0 = BppCode(bitsPerPixel) | ((height - 1) << PRE0_VCNT_SHIFT);
+
+	if ((options & CREATECEL_CODED) == 0) cel->ccb_PRE0 |= PRE0_UNCODED;
+
+	cel->ccb_PRE1 = ((rowWords - 2) << (bitsPerPixel >= 8 ? PRE1_WOFFSET10_SHIFT : PRE1_WOFFSET8_SHIFT)) | (width - 1);
+}
+
+CCB *CreateCel(int32 width, int32 height, int32 bitsPerPixel, int32 options, void *dataBuf)
+{
+	uint64 t0 = HostNowNS();
+	uint32 pixelBytes = dataBuf ? 0 : RowBytes(width, bitsPerPixel) * height;
+	CCB *cel = (CCB *)HostAlloc(sizeof(CCB) + pixelBytes);
+
+	InitCreatedCel(cel, width, height, bitsPerPixel, options);
+
+	cel->ccb_SourcePtr = (CelData *)(dataBuf ? dataBuf : (void *)(cel + 1));
+
+	HostRecordCall(HOST_CALL_CREATECEL, t0);
+
+	return cel;
+}
+
+// Translucency is the frame buffer scaled by (100 - opacity) in eighths plus the
+// pixel, which is pre-scaled by the opacity. Under 1/16 it's left opaque
+
+CCB *CreateBackdropCel(int32 width, int32 height, int32 color, int32 opacityPercent)
+{
+	uint64 t0 = HostNowNS();
+	CCB *cel = (CCB *)HostAlloc(sizeof(CCB) + sizeof(uint32));
+	uint16 *pixel = (uint16 *)(cel + 1);
+	int32 behind = (((100 - opacityPercent) * 8) + 50) / 100;
+	int32 sh;
+
+	InitCreatedCel(cel, 1, 1, 16, CREATECEL_UNCODED);
+
+	*pixel = (uint16)color;
+
+	if (behind > 0 && behind < 8)
+	{
+		*pixel = 0;
+
+		for (sh = 10; sh >= 0; sh -= 5)
+		{
+			*pixel |= (uint16)((((((color >> sh) & 0x1f) * (8 - behind)) + 4) / 8) << sh);
+		}
+
+		// 1S frame buffer, MF behind, DF /8, 2S cel pixel
+		cel->ccb_PIXC = 0x80008000 | ((behind - 1) << 26) | ((behind - 1) << 10) | 0x03c003c0;
+	}
+
+	cel->ccb_SourcePtr = (CelData *)pixel;
+	cel->ccb_HDX = width << 20; // One pixel stretched over the whole area
+	cel->ccb_VDY = height << 16;
+
+	HostRecordCall(HOST_CALL_CREATECEL, t0);
+
+	return cel;
+}
+
+void LinkCel(CCB *ccb, CCB *nextCCB)
+{
+	ccb->ccb_NextPtr = nextCCB;
+	ccb->ccb_Flags &= ~CCB_LAST;
+}
+
+/* ----- Images ----- */
+
+ubyte *LoadImage(char *name, ubyte *dest, VdlChunk **rawVDLPtr, ScreenContext *sc)
+{
+	uint64 t0 = HostNowNS();
+	int32 size, pdatLen = 0;
+	ubyte *data = HostReadFile(name, &size);
+	ubyte *pdat;
+	ubyte *image = dest;
+
+	if (data == NULL) goto done;
+
+	pdat = FindChunk(data, size, "PDAT", &pdatLen);
+
+	if (pdat == NULL)
+	{
+		fprintf(stderr, "host: %s has no pixel data\n", name);
+		goto done;
+	}
+
+	pdatLen -= 8;
+
+	if (pdatLen > sc->sc_nFrameByteCount) pdatLen = sc->sc_nFrameByteCount;
+
+	if (image == NULL) image = (ubyte *)HostAlloc(sc->sc_nFrameByteCount);
+
+	SwapPixels16((uint16 *)image, pdat + 8, pdatLen / 2); // Images are stored in frame buffer (line pair) order already
+
+done:
+	free(data);
+
+	HostRecordCall(HOST_CALL_LOADIMAGE, t0);
+
+	return image;
+}
+
+void UnloadImage(ubyte *image)
+{
+	uint64 t0 = HostNowNS();
+
+	HostFree(image);
+
+	HostRecordCall(HOST_CALL_UNLOADIMAGE, t0);
+}
+
+/* ----- Memory ----- */
+
+void AvailMem(MemInfo *minfo, uint32 flags)
+{
+	uint32 total = (flags & MEMTYPE_VRAM) ? HOST_SYS_VRAM : HOST_SYS_DRAM;
+	uint32 used = Host.LiveBytes < total ? Host.LiveBytes : total;
+
+	minfo->minfo_SysFree = total - used;
+	minfo->minfo_SysLargest = total - used;
+	minfo->minfo_TaskFree = 0;
+	minfo->minfo_TaskLargest = 0;
+}
+
+/* ----- IO ----- */
+
+Item CreateVRAMIOReq() { return HOST_VRAM_IOREQ; }
+Item GetVBLIOReq() { return HOST_VBL_IOREQ; }
+
+Err WaitVBL(Item ioreq, uint32 numFields)
+{
+	uint64 t0 = HostNowNS();
+	uint32 i;
+
+	if (HostVsync)
+	{
+		for (i = 0; i < numFields; i++) HostWaitField();
+	}
+
+	Host.Fields += numFields;
+
+	HostRecordCall(HOST_CALL_WAITVBL, t0);
+
+	return 0;
+}
+
+Err DoIO(Item ioreq, IOInfo *ioInfo)
+{
+	uint64 t0 = HostNowNS();
+	uint32 *dst = (uint32 *)ioInfo->ioi_Recv.iob_Buffer;
+	int32 i;
+
+	if (dst != NULL)
+	{
+		if (ioInfo->ioi_Command == SPORTCMD_COPY && ioInfo->ioi_Send.iob_Buffer != NULL)
+		{
+			memcpy(dst, ioInfo->ioi_Send.iob_Buffer, ioInfo->ioi_Recv.iob_Len);
+		}
+		else if (ioInfo->ioi_Command == FLASHWRITE_CMD)
+		{
+			for (i = 0; i < ioInfo->ioi_Recv.iob_Len / 4; i++) dst[i] = ioInfo->ioi_Offset;
+		}
+	}
+
+	HostRecordCall(HOST_CALL_DOIO, t0);
+
+	return 0;
+}
+
+/* ----- Timer ----- */
+
+void SampleSystemTimeTV(TimeVal *tv)
+{
+	uint64 t0 = HostNowNS();
+	uint64 us;
+
+	if (hostStartNS == 0) hostStartNS = t0;
+
+	us = (t0 - hostStartNS) / 1000;
+
+	tv->tv_Seconds = (int32)(us / 1000000);
+	tv->tv_Microseconds = (int32)(us % 1000000);
+
+	HostRecordCall(HOST_CALL_SYSTEMTIME, t0);
+}
+
+void SampleSystemTimeVBL(VBlankTimeVal *vbl)
+{
+	vbl->vbltv_VBlankHi32 = 0;
+	vbl->vbltv_VBlankLo32 = Host.Fields; // Counted, not timed, so the same run gives the same stamps
+}
+
+void SubTimes(TimeVal *tv1, TimeVal *tv2, TimeVal *tv3) // tv3 = tv2 - tv1
+{
+	int32 s = tv2->tv_Seconds - tv1->tv_Seconds;
+	int32 us = tv2->tv_Microseconds - tv1->tv_Microseconds;
+
+	if (us < 0)
+	{
+		us += 1000000;
+		s--;
+	}
+
+	tv3->tv_Seconds = s;
+	tv3->tv_Microseconds = us;
+}
+
+Item GetTimerIOReq() { return HOST_TIMER_IOREQ; }
+
+int32 GetMSecTime(Item ioreq)
+{
+	if (hostStartNS == 0) hostStartNS = HostNowNS();
+
+	return (int32)((HostNowNS() - hostStartNS) / 1000000);
+}
+
+uint32 GetTime(Item ioreq)
+{
+	return GetMSecTime(ioreq) / 1000;
+}
+
+/* ----- Events ----- */
+
+// One listener, one configuration message and one event record. Each read of
+// the port asks HostPollPad once, so a driver hands over one tick's worth of
+// pad changes at a time and the game's reads stay in step with it
+
+Item CreateMsgPort(const char *name, uint8 pri, uint32 signal) { return HOST_LISTENER_PORT; }
+Err DeleteMsgPort(Item port) { return 0; }
+Item CreateMsg(const char *name, uint8 pri, Item replyPort) { return HOST_CONFIG_MSG; }
+Err DeleteMsg(Item msg) { return 0; }
+Item WaitPort(Item port, Item msg) { return msg; } // Replies are immediate
+
+Item FindMsgPort(const char *name)
+{
+	return strcmp(name, EventPortName) == 0 ? HOST_BROKER_PORT : -1;
+}
+
+void *LookupItem(Item item)
+{
+	if (item == HOST_CONFIG_MSG) return &hostConfigMsg;
+	if (item == HOST_EVENT_MSG) return &hostEventMsg;
+
+	return NULL;
+}
+
+Err SendMsg(Item port, Item msg, const void *data, int32 size)
+{
+	ConfigurationRequest *config = (ConfigurationRequest *)data;
+
+	if (port != HOST_BROKER_PORT || msg != HOST_CONFIG_MSG || config->cr.ebh_Flavor != EB_Configure) return -1;
+
+	hostListening = config->cr_Category != LC_NoSeeUms;
+	hostListenField = Host.Fields;
+	hostSentBits = 0; // A new listener has heard nothing, what's down goes out as pressed
+
+	hostConfigMsg.msg_ReplyPort = HOST_LISTENER_PORT;
+	hostConfigMsg.msg_Result = 0;
+
+	return 0;
+}
+
+Err ReplyMsg(Item msg, int32 result, const void *data, int32 size)
+{
+	if (msg == HOST_EVENT_MSG) hostEventOut = false;
+
+	return 0;
+}
+
+static uint32 HostCountBits(uint32 bits)
+{
+	uint32 n = 0;
+
+	for (; bits != 0; bits &= bits - 1) n++;
+
+	return n;
+}
+
+static bool HostFillEventRecord()
+{
+	HostPadEvent events[HOST_PAD_EVENTS];
+	EventBrokerHeader *ebh = (EventBrokerHeader *)hostEventRecord;
+	EventFrame *ef = (EventFrame *)(ebh + 1);
+	int i, count = HostPollPad(events);
+	uint32 pushed;
+
+	ebh->ebh_Flavor = EB_EventRecord;
+
+	for (i = 0; i < count; i++)
+	{
+		if (events[i].Bits == hostPadBits) continue; // The broker only reports changes
+
+		pushed = events[i].Bits & ~hostPadBits;
+		hostPadBits = events[i].Bits;
+
+		if (events[i].Field < hostListenField) continue; // Happened while nobody listened, the console's broker drops those too
+
+		Host.PadPushes += HostCountBits(pushed);
+
+		memset(ef, 0, sizeof(EventFrame));
+
+		ef->ef_ByteCount = sizeof(EventFrame);
+		ef->ef_SystemTimeStamp = events[i].Field;
+		ef->ef_EventNumber = (events[i].Bits & ~hostSentBits) ? EVENTNUM_ControlButtonPressed : EVENTNUM_ControlButtonReleased;
+		ef->ef_GenericPosition = 1;
+		ef->ef_EventData[0] = events[i].Bits;
+
+		Host.PadEvents++;
+		Host.PadPresses += HostCountBits(events[i].Bits & ~hostSentBits);
+
+		hostSentBits = events[i].Bits;
+
+		ef++;
+	}
+
+	ef->ef_ByteCount = 0;
+
+	hostEventMsg.msg_DataPtr = hostEventRecord;
+	hostEventMsg.msg_DataSize = (ubyte *)(ef + 1) - (ubyte *)hostEventRecord;
+
+	return ef != (EventFrame *)(ebh + 1);
+}
+
+Item GetMsg(Item port)
+{
+	uint64 t0 = HostNowNS();
+	Item msg = 0;
+
+	if (port == HOST_LISTENER_PORT && hostListening && hostEventOut == false)
+	{
+		if (hostEventPolled)
+		{
+			hostEventPolled = false; // The port is empty, the next GetMsg starts the next read
+		}
+		else
+		{
+			hostEventPolled = true;
+
+			if (HostFillEventRecord())
+			{
+				hostEventOut = true;
+				msg = HOST_EVENT_MSG;
+			}
+			else
+			{
+				hostEventPolled = false;
+			}
+		}
+	}
+
+	HostRecordCall(HOST_CALL_GETMSG, t0);
+
+	return msg;
+}
+
+/* ----- Math ----- */
+
+Err OpenMathFolio() { return 0; }
+Err CloseMathFolio() { return 0; }
+
+frac16 DivSF16(frac16 d1, frac16 d2)
+{
+	if (d2 == 0) return d1 < 0 ? (frac16)0x80000000 : 0x7fffffff;
+
+	return (frac16)(((int64)d1 << 16) / d2);
+}
+
+frac16 MulSF16(frac16 m1, frac16 m2)
+{
+	return (frac16)(((int64)m1 * m2) >> 16);
+}
+
+/* ----- Audio clock ----- */
+
+AudioTime GetAudioTime()
+{
+	return hostAudioTime;
+}
+
+Err SleepAudioTicks(int32 ticks)
+{
+	pthread_mutex_lock(&hostSignalLock);
+
+	HostCueAt(HOST_TASK_ITEM + hostTaskIdx, HOST_SLEEP_SIGNAL, hostAudioTime + ticks);
+
+	pthread_mutex_unlock(&hostSignalLock);
+
+	WaitSignal(HOST_SLEEP_SIGNAL); // Nothing else comes for it, so the clock runs straight there
+
+	return 0;
+}
+
+static HostCue *HostCueItem(Item cue)
+{
+	int idx = cue - HOST_CUE_ITEM;
+
+	return idx >= 0 && idx < HOST_CUE_ITEMS && hostCueItems[idx].Task != 0 ? &hostCueItems[idx] : NULL;
+}
+
+int32 GetCueSignal(Item cue)
+{
+	HostCue *c = HostCueItem(cue);
+
+	return c != NULL ? c->Signal : 0;
+}
+
+Err SignalAtTime(Item cue, AudioTime time)
+{
+	HostCue *c = HostCueItem(cue);
+
+	if (c == NULL) return AF_ERR_BADITEM;
+
+	pthread_mutex_lock(&hostSignalLock);
+
+	HostCancelCues(c->Task, c->Signal);
+	HostCueAt(c->Task, c->Signal, time);
+
+	pthread_cond_broadcast(&hostSignalCond); // Set for now or earlier, the owner sends it to itself
+
+	pthread_mutex_unlock(&hostSignalLock);
+
+	return 0;
+}
+
+int HostCuesSet(int32 signals)
+{
+	Item self = HOST_TASK_ITEM + hostTaskIdx;
+	int i, n = 0;
+
+	pthread_mutex_lock(&hostSignalLock);
+
+	for (i = 0; i < hostCueCount; i++)
+	{
+		if (hostCues[i].Task == self && (hostCues[i].Signal & signals)) n++;
+	}
+
+	pthread_mutex_unlock(&hostSignalLock);
+
+	return n;
+}
+
+void HostAudioRun(uint32 ticks)
+{
+	pthread_mutex_lock(&hostSignalLock);
+
+	hostAudioTime += ticks;
+
+	pthread_cond_broadcast(&hostSignalCond); // Waiters send themselves any cues now due
+
+	pthread_mutex_unlock(&hostSignalLock);
+}
+
+/* ----- Sound file player ----- */
+
+static uint32 HostTicks(uint32 bytes, uint32 bytesPerSecond)
+{
+	return (uint32)(((uint64)bytes * HOST_AUDIO_TICKS + bytesPerSecond - 1) / bytesPerSecond);
+}
+
+// The drive, the clock moves while the caller waits on it
+
+static void HostDriveRead(uint32 bytes)
+{
+	HostDriveModel *d = &HostDrive;
+	uint32 phase;
+
+	pthread_mutex_lock(&hostSignalLock);
+
+	if (d->LoadEvery > 0)
+	{
+		phase = hostAudioTime % d->LoadEvery;
+
+		if (phase >= d->LoadEvery - d->LoadTicks) // Held by a load, last LoadTicks of every LoadEvery
+		{
+			hostAudioTime += d->LoadEvery - phase;
+			d->ReadWaits++;
+		}
+	}
+
+	hostAudioTime += HostTicks(bytes, d->ReadBytesPerSecond);
+	d->Reads++;
+
+	pthread_mutex_unlock(&hostSignalLock);
+}
+
+static bool HostRefill(SoundFilePlayer *sfp)
+{
+	int i = sfp->Next;
+	uint32 bytes = sfp->FileBytes - sfp->Cursor;
+
+	if (bytes == 0 || sfp->Queued[i]) return false;
+
+	if (bytes > (uint32)sfp->sfp_BufSize) bytes = sfp->sfp_BufSize;
+
+	HostDriveRead(bytes);
+
+	sfp->Cursor += bytes;
+	sfp->Bytes[i] = bytes;
+	sfp->Queued[i] = true;
+	sfp->Next = (i + 1) % sfp->sfp_NumBuffers;
+
+	if (sfp->Paused) return true; // Plays from HostPlay
+
+	pthread_mutex_lock(&hostSignalLock);
+
+	if ((int32)(hostAudioTime - sfp->PlayedTo) > 0)
+	{
+		HostDrive.Gaps++;
+
+		sfp->PlayedTo = hostAudioTime;
+	}
+
+	sfp->PlayedTo += HostTicks(bytes, HostDrive.PlayBytesPerSecond);
+
+	HostCueAt(sfp->Owner, sfp->Signal[i], sfp->PlayedTo);
+
+	pthread_mutex_unlock(&hostSignalLock);
+
+	return true;
+}
+
+// Everything queued plays from now, oldest first. hostSignalLock held
+
+static void HostPlay(SoundFilePlayer *sfp)
+{
+	int i, n;
+
+	sfp->PlayedTo = hostAudioTime;
+	sfp->Paused = false;
+
+	for (n = 0; n < sfp->sfp_NumBuffers; n++)
+	{
+		i = (sfp->Next + n) % sfp->sfp_NumBuffers;
+
+		if (sfp->Queued[i] == false) continue;
+
+		sfp->PlayedTo += HostTicks(sfp->Bytes[i], HostDrive.PlayBytesPerSecond);
+
+		HostCueAt(sfp->Owner, sfp->Signal[i], sfp->PlayedTo);
+	}
+}
+
+SoundFilePlayer *CreateSoundFilePlayer(int32 numBuffers, int32 bufSize, void *buffers[])
+{
+	SoundFilePlayer *sfp;
+	int i;
+
+	if (numBuffers < 1 || numBuffers > HOST_SFP_BUFFERS) return NULL;
+
+	sfp = (SoundFilePlayer *)HostAlloc(sizeof(SoundFilePlayer));
+
+	if (sfp == NULL) return NULL;
+
+	sfp->sfp_NumBuffers = numBuffers;
+	sfp->sfp_BufSize = bufSize;
+	sfp->Owner = CURRENTTASK->t.n_Item;
+	sfp->Buffers = buffers == NULL ? HostAlloc(numBuffers * bufSize) : NULL;
+
+	for (i = 0; i < numBuffers; i++)
+	{
+		sfp->Signal[i] = AllocSignal(0);
+	}
+
+	return sfp;
+}
+
+int32 StopSoundFile(SoundFilePlayer *sfp)
+{
+	int32 signals = 0;
+	int i;
+
+	for (i = 0; i < sfp->sfp_NumBuffers; i++)
+	{
+		signals |= sfp->Signal[i];
+		sfp->Queued[i] = false;
+	}
+
+	pthread_mutex_lock(&hostSignalLock);
+
+	HostCancelCues(sfp->Owner, signals);
+
+	pthread_mutex_unlock(&hostSignalLock);
+
+	sfp->Next = 0;
+	sfp->Paused = false;
+
+	return 0;
+}
+
+int32 DeleteSoundFilePlayer(SoundFilePlayer *sfp)
+{
+	int i;
+
+	StopSoundFile(sfp);
+	UnloadSoundFile(sfp);
+
+	for (i = 0; i < sfp->sfp_NumBuffers; i++)
+	{
+		FreeSignal(sfp->Signal[i]);
+	}
+
+	HostFree(sfp->Buffers);
+	HostFree(sfp);
+
+	return 0;
+}
+
+static SoundFilePlayer *HostSampler(Item ins)
+{
+	int idx = ins - HOST_SAMPLER_ITEM;
+
+	return idx >= 0 && idx < HOST_SAMPLERS ? hostSamplers[idx] : NULL;
+}
+
+int32 *HostSamplerAmplitude(Item ins)
+{
+	SoundFilePlayer *sfp = HostSampler(ins);
+
+	return sfp != NULL ? &sfp->Amplitude : NULL;
+}
+
+int32 LoadSoundFile(SoundFilePlayer *sfp, char *fileName)
+{
+	int i;
+
+	if (HostSampler(sfp->sfp_SamplerIns) != sfp)
+	{
+		for (i = 0; i < HOST_SAMPLERS && hostSamplers[i] != NULL; i++);
+
+		if (i == HOST_SAMPLERS) return -1;
+
+		hostSamplers[i] = sfp;
+		sfp->sfp_SamplerIns = HOST_SAMPLER_ITEM + i;
+	}
+
+	sfp->FileBytes = HostDrive.FileSeconds * HostDrive.PlayBytesPerSecond;
+	sfp->Cursor = 0;
+
+	return 0;
+}
+
+int32 UnloadSoundFile(SoundFilePlayer *sfp)
+{
+	if (HostSampler(sfp->sfp_SamplerIns) == sfp) hostSamplers[sfp->sfp_SamplerIns - HOST_SAMPLER_ITEM] = NULL;
+
+	sfp->FileBytes = 0;
+	sfp->sfp_SamplerIns = -1;
+
+	return 0;
+}
+
+int32 RewindSoundFile(SoundFilePlayer *sfp)
+{
+	sfp->Cursor = 0;
+
+	return 0;
+}
+
+int32 StartSoundFile(SoundFilePlayer *sfp, int32 amplitude)
+{
+	sfp->Paused = true;
+	sfp->Amplitude = amplitude;
+
+	while (HostRefill(sfp)); // Fills them all, then the sampler starts
+
+	pthread_mutex_lock(&hostSignalLock);
+
+	HostPlay(sfp);
+
+	pthread_mutex_unlock(&hostSignalLock);
+
+	return 0;
+}
+
+int32 ServiceSoundFile(SoundFilePlayer *sfp, int32 signalIn, int32 *signalNeeded)
+{
+	int i;
+
+	for (i = 0; i < sfp->sfp_NumBuffers; i++)
+	{
+		if (signalIn & sfp->Signal[i]) sfp->Queued[i] = false;
+	}
+
+	while (HostRefill(sfp));
+
+	*signalNeeded = 0;
+
+	for (i = 0; i < sfp->sfp_NumBuffers; i++)
+	{
+		if (sfp->Queued[i]) *signalNeeded |= sfp->Signal[i];
+	}
+
+	return 0;
+}
+
+Err PauseInstrument(Item ins)
+{
+	SoundFilePlayer *sfp = HostSampler(ins);
+	int32 signals = 0;
+	int i;
+
+	if (sfp == NULL) return -1;
+
+	for (i = 0; i < sfp->sfp_NumBuffers; i++)
+	{
+		signals |= sfp->Signal[i];
+	}
+
+	pthread_mutex_lock(&hostSignalLock);
+
+	HostCancelCues(sfp->Owner, signals); // Only whole buffers, a Pause right after StartSoundFile loses nothing
+
+	pthread_mutex_unlock(&hostSignalLock);
+
+	sfp->Paused = true;
+
+	return 0;
+}
+
+Err ResumeInstrument(Item ins)
+{
+	SoundFilePlayer *sfp = HostSampler(ins);
+	int i;
+
+	if (sfp == NULL || sfp->Paused == false) return -1;
+
+	if (sfp->Amplitude == 0) HostDrive.SilentTracks++;
+
+	pthread_mutex_lock(&hostSignalLock);
+
+	for (i = 0; i < HOST_SAMPLERS; i++) // The one that played before it is still loaded
+	{
+		if (hostSamplers[i] != NULL && hostSamplers[i] != sfp && hostSamplers[i]->Paused == false &&
+			(int32)(hostAudioTime - hostSamplers[i]->PlayedTo) > 0) HostDrive.TrackGaps++;
+	}
+
+	HostPlay(sfp);
+
+	pthread_mutex_unlock(&hostSignalLock);
+
+	return 0;
+}
+
+/* ----- Kernel ----- */
+
+uint32 ReadHardwareRandomNumber()
+{
+	if (HostRandom == 0) HostRandom = HostRandomSeed ? HostRandomSeed : 1;
+
+	HostRandom ^= HostRandom << 13; // Seeded so scripted runs repeat exactly
+	HostRandom ^= HostRandom >> 17;
+	HostRandom ^= HostRandom << 5;
+
+	return HostRandom;
+}
+
+Item CreateItem(int32 cType, TagArg *tags)
+{
+	int32 signal;
+	int i;
+
+	if (cType != MKNODEID(AUDIONODE, AUDIO_CUE_NODE)) return -1;
+
+	for (i = 0; i < HOST_CUE_ITEMS && hostCueItems[i].Task != 0; i++);
+
+	if (i == HOST_CUE_ITEMS || (signal = AllocSignal(0)) == 0) return -1;
+
+	hostCueItems[i].Task = HOST_TASK_ITEM + hostTaskIdx;
+	hostCueItems[i].Signal = signal;
+
+	return HOST_CUE_ITEM + i;
+}
+
+Err DeleteItem(Item item)
+{
+	HostCue *c = HostCueItem(item);
+
+	if (c == NULL) return -1;
+
+	pthread_mutex_lock(&hostSignalLock);
+
+	HostCancelCues(c->Task, c->Signal);
+
+	pthread_mutex_unlock(&hostSignalLock);
+
+	FreeSignal(c->Signal); // From the task that made it, as on the console
+
+	c->Task = 0;
+
+	return 0;
+}
+
+/* ----- Threads ----- */
+
+static HostTask *HostFindTask(Item item)
+{
+	int idx = item - HOST_TASK_ITEM;
+
+	if (idx < 0 || idx >= HOST_TASKS || (idx > 0 && hostTasks[idx].Used == false)) return NULL;
+
+	return &hostTasks[idx];
+}
+
+Task *HostCurrentTask()
+{
+	hostTasks[hostTaskIdx].Task.t.n_Item = HOST_TASK_ITEM + hostTaskIdx;
+
+	return &hostTasks[hostTaskIdx].Task;
+}
+
+static void *HostThreadMain(void *arg)
+{
+	hostTaskIdx = (int)(intptr_t)arg;
+
+	hostTasks[hostTaskIdx].Code();
+
+	return NULL;
+}
+
+Item CreateThread(const char *name, uint8 pri, void (*code)(), int32 stacksize)
+{
+	HostTask *ht;
+	int i;
+
+	for (i = 1; i < HOST_TASKS && hostTasks[i].Used; i++);
+
+	if (i == HOST_TASKS) return -1;
+
+	ht = &hostTasks[i];
+
+	memset(ht, 0, sizeof(HostTask));
+
+	ht->Code = code;
+	ht->Used = true;
+
+	if (pthread_create(&ht->Thread, NULL, HostThreadMain, (void *)(intptr_t)i) != 0)
+	{
+		ht->Used = false;
+
+		return -1;
+	}
+
+	return HOST_TASK_ITEM + i;
+}
+
+Err DeleteThread(Item thread)
+{
+	HostTask *ht = HostFindTask(thread);
+
+	if (ht == NULL || ht == &hostTasks[0]) return -1;
+
+	pthread_join(ht->Thread, NULL); // It has finished or is parked in WaitSignal(0), which ends it
+
+	ht->Used = false;
+
+	return 0;
+}
+
+int32 AllocSignal(int32 sigMask)
+{
+	HostTask *ht = &hostTasks[hostTaskIdx];
+	uint32 bit;
+
+	pthread_mutex_lock(&hostSignalLock);
+
+	if (sigMask != 0) bit = (ht->Allocated & sigMask) ? 0 : sigMask;
+	else for (bit = HOST_FIRST_SIGNAL; bit != 0 && (ht->Allocated & bit) != 0; bit <<= 1);
+
+	ht->Allocated |= bit;
+
+	pthread_mutex_unlock(&hostSignalLock);
+
+	return bit;
+}
+
+Err FreeSignal(int32 sigMask)
+{
+	HostTask *ht = &hostTasks[hostTaskIdx];
+
+	pthread_mutex_lock(&hostSignalLock);
+
+	ht->Allocated &= ~sigMask;
+	ht->Received &= ~sigMask;
+
+	pthread_mutex_unlock(&hostSignalLock);
+
+	return 0;
+}
+
+Err SendSignal(Item task, int32 sigMask)
+{
+	HostTask *ht = HostFindTask(task);
+
+	if (ht == NULL) return -1;
+
+	pthread_mutex_lock(&hostSignalLock);
+
+	ht->Received |= sigMask;
+
+	pthread_cond_broadcast(&hostSignalCond);
+	pthread_mutex_unlock(&hostSignalLock);
+
+	return 0;
+}
+
+// The audio clock, hostSignalLock held for all of these
+
+static void HostCueAt(Item task, int32 signal, AudioTime time)
+{
+	if (hostCueCount == HOST_CUES) return;
+
+	hostCues[hostCueCount].Task = task;
+	hostCues[hostCueCount].Signal = signal;
+	hostCues[hostCueCount].Time = time;
+
+	hostCueCount++;
+}
+
+static void HostCancelCues(Item task, int32 signals)
+{
+	int i = 0;
+
+	while (i < hostCueCount)
+	{
+		if (hostCues[i].Task == task && (hostCues[i].Signal & signals)) hostCues[i] = hostCues[--hostCueCount];
+		else i++;
+	}
+}
+
+static void HostSendDueCues(Item task)
+{
+	HostTask *ht = HostFindTask(task);
+	int i = 0;
+
+	while (i < hostCueCount)
+	{
+		if (hostCues[i].Task == task && (int32)(hostCues[i].Time - hostAudioTime) <= 0)
+		{
+			ht->Received |= hostCues[i].Signal;
+			hostCues[i] = hostCues[--hostCueCount];
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+// Moves the clock to the first cue for one of sigMask, false if there's none
+
+static bool HostRunToCue(Item task, int32 sigMask)
+{
+	AudioTime first = 0;
+	bool found = false;
+	int i;
+
+	for (i = 0; i < hostCueCount; i++)
+	{
+		if (hostCues[i].Task != task || (hostCues[i].Signal & sigMask) == 0) continue;
+
+		if (found == false || (int32)(hostCues[i].Time - first) < 0) first = hostCues[i].Time;
+
+		found = true;
+	}
+
+	if (found == false) return false;
+
+	if ((int32)(first - hostAudioTime) > 0) hostAudioTime = first;
+
+	HostSendDueCues(task);
+
+	return true;
+}
+
+int32 WaitSignal(int32 sigMask)
+{
+	HostTask *ht = &hostTasks[hostTaskIdx];
+	Item self = HOST_TASK_ITEM + hostTaskIdx;
+	int32 got;
+
+	if (sigMask == 0 && hostTaskIdx > 0) pthread_exit(NULL);
+
+	pthread_mutex_lock(&hostSignalLock);
+
+	HostSendDueCues(self);
+
+	while ((ht->Received & sigMask) == 0)
+	{
+		if (HostRunToCue(self, sigMask)) continue; // Nothing else is coming, the clock runs to it
+
+		pthread_cond_wait(&hostSignalCond, &hostSignalLock);
+	}
+
+	got = ht->Received & sigMask;
+	ht->Received &= ~got;
+
+	pthread_mutex_unlock(&hostSignalLock);
+
+	return got;
+}
+
+int32 GetCurrentSignals()
+{
+	HostTask *ht = &hostTasks[hostTaskIdx];
+	int32 got;
+
+	pthread_mutex_lock(&hostSignalLock);
+
+	HostSendDueCues(HOST_TASK_ITEM + hostTaskIdx);
+
+	got = ht->Received;
+
+	pthread_mutex_unlock(&hostSignalLock);
+
+	return got;
+}
+
+void Yield()
+{
+	sched_yield();
+}
+
+/* ----- Frames ----- */
+
+uint32 HostFrameCRC()
+{
+	uint16 *px;
+	uint32 crc = 0xffffffff, c, i, k;
+	ubyte b[2];
+
+	if (hostScreenCount == 0) return 0;
+
+	if (hostCRCTable[1] == 0)
+	{
+		for (i = 0; i < 256; i++)
+		{
+			for (c = i, k = 0; k < 8; k++) c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+
+			hostCRCTable[i] = c;
+		}
+	}
+
+	px = (uint16 *)hostBitmaps[hostShownScreen].bm_Buffer;
+
+	for (i = 0; i < HOST_WIDTH * HOST_HEIGHT; i++) // Big endian like the console's frame buffer, so it's the same on any host
+	{
+		b[0] = (ubyte)(px[i] >> 8);
+		b[1] = (ubyte)px[i];
+
+		crc = hostCRCTable[(crc ^ b[0]) & 0xff] ^ (crc >> 8);
+		crc = hostCRCTable[(crc ^ b[1]) & 0xff] ^ (crc >> 8);
+	}
+
+	return crc ^ 0xffffffff;
+}
+
+bool HostWriteFramePPM(char *path)
+{
+	FILE *fp = fopen(path, "wb");
+	uint16 *px, p;
+	int x, y;
+
+	if (fp == NULL || hostScreenCount == 0)
+	{
+		if (fp != NULL) fclose(fp);
+
+		return false;
+	}
+
+	px = (uint16 *)hostBitmaps[hostShownScreen].bm_Buffer;
+
+	fprintf(fp, "P6\n%d %d\n255\n", HOST_WIDTH, HOST_HEIGHT);
+
+	for (y = 0; y < HOST_HEIGHT; y++)
+	{
+		for (x = 0; x < HOST_WIDTH; x++)
+		{
+			p = px[((y >> 1) * HOST_WIDTH * 2) + (x * 2) + (y & 1)];
+
+			fputc((((p >> 10) & 0x1f) * 255) / 31, fp);
+			fputc((((p >> 5) & 0x1f) * 255) / 31, fp);
+			fputc(((p & 0x1f) * 255) / 31, fp);
+		}
+	}
+
+	fclose(fp);
+
+	return true;
+}
+
+/* ----- Report ----- */
+
+void HostReport()
+{
+	HostCallStats *hc;
+	int i;
+
+	printf("HOST CALL                COUNT    TOTAL ms   AVG us   MAX us\n");
+
+	for (i = 0; i < HOST_CALLS; i++)
+	{
+		hc = &Host.Calls[i];
+
+		if (hc->Count == 0) continue;
+
+		printf("HOST %-18s %9u %11.2f %8.2f %8.1f\n", hostCallNames[i], hc->Count,
+			hc->TotalNS / 1e6, (hc->TotalNS / 1e3) / hc->Count, hc->MaxNS / 1e3);
+	}
+
+	printf("HOST frames %u, per frame: cels drawn %.1f, skipped %.1f, pixels filled %.0f%s\n", Host.Frames,
+		Host.Frames ? (double)Host.CelsDrawn / Host.Frames : 0.0, Host.Frames ? (double)Host.CelsSkipped / Host.Frames : 0.0,
+		Host.Frames ? (double)Host.PixelsFilled / Host.Frames : 0.0, HostRaster ? "" : " (raster off)");
+
+	printf("HOST peak frame %u: cels drawn %u, skipped %u, pixels filled %u\n", Host.PeakFrameNum,
+		Host.PeakFrame.CelsDrawn, Host.PeakFrame.CelsSkipped, Host.PeakFrame.PixelsFilled);
+
+	printf("HOST heap live %u bytes in %d blocks, high %u\n", Host.LiveBytes, Host.LiveBlocks, Host.HighBytes);
+
+	printf("HOST sound: load %u, start %u, spool %u, stop spool %u\n",
+		Host.SoundCommands[kLoadRAMSound], Host.SoundCommands[kStartRAMSound],
+		Host.SoundCommands[kSpoolSound], Host.SoundCommands[kStopSpoolingSound] + Host.SoundCommands[kStopFadeSpoolSound]);
+}
@@ -0,0 +1,1184 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Audio folio stand-in, see the host mixer in host3do.h. Templates,
+//	instruments, samples, attachments, knobs and envelopes are all items
+//	in one table. Samples are decoded to 16 bit when they load, SDX2 the
+//	way sdx2enc.c decodes it, so the mix is what the DSP would play
+//
+//	The DSP ticks each template takes are rough, they're there so the
+//	budget runs out somewhere near where it does on the console and the
+//	sound library's AF_ERR_NORSRC paths get run
+//
+
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "host3do.h"
+
+#define AUDIO_ITEM 0x700			// Item n in the table is AUDIO_ITEM + n
+#define AUDIO_ITEMS 512
+#define AUDIO_TICKS 240
+#define AUDIO_FULL_SCALE 0x7FFF
+
+#define ITEM_FREE 0
+#define ITEM_TEMPLATE 1
+#define ITEM_INSTRUMENT 2
+#define ITEM_SAMPLE 3
+#define ITEM_ATTACHMENT 4			// Of a sample or an envelope to an instrument
+#define ITEM_KNOB 5
+#define ITEM_ENVELOPE 6
+
+#define KIND_MIXER 0
+#define KIND_ENVELOPE 1
+#define KIND_SAMPLER 2
+
+#define FORMAT_16 0
+#define FORMAT_8 1
+#define FORMAT_SDX2 2
+
+#define RATE_FULL 0					// One sample a frame
+#define RATE_HALF 1					// Every sample twice
+#define RATE_VARIABLE 2				// AF_TAG_RATE or the Frequency knob
+
+#define KNOB_LEFT_GAIN 0			// + the mixer input
+#define KNOB_RIGHT_GAIN HOST_MIX_INPUTS
+#define KNOB_FREQUENCY (2 * HOST_MIX_INPUTS)
+#define KNOB_AMPLITUDE (KNOB_FREQUENCY + 1)
+#define KNOB_SAMPLER_AMPLITUDE (KNOB_AMPLITUDE + 1)	// A spooler's sampler, host3do.c has those
+
+typedef struct Template
+{
+	char *Name;
+	uint32 Ticks;
+	int Kind;
+	int Format;						// Samplers only from here
+	int Channels;
+	int Rate;
+} Template;
+
+static Template templates[] =
+{
+	{ "mixer8x2.dsp",			70,	KIND_MIXER },
+	{ "envelope.dsp",			12,	KIND_ENVELOPE },
+	{ "fixedmonosample.dsp",	22,	KIND_SAMPLER, FORMAT_16,	1, RATE_FULL },
+	{ "halfmonosample.dsp",		24,	KIND_SAMPLER, FORMAT_16,	1, RATE_HALF },
+	{ "varmono16.dsp",			36,	KIND_SAMPLER, FORMAT_16,	1, RATE_VARIABLE },
+	{ "fixedstereosample.dsp",	36,	KIND_SAMPLER, FORMAT_16,	2, RATE_FULL },
+	{ "fixedmono8.dsp",			20,	KIND_SAMPLER, FORMAT_8,		1, RATE_FULL },
+	{ "halfmono8.dsp",			24,	KIND_SAMPLER, FORMAT_8,		1, RATE_HALF },
+	{ "varmono8.dsp",			34,	KIND_SAMPLER, FORMAT_8,		1, RATE_VARIABLE },
+	{ "dcsqxdmono.dsp",			34,	KIND_SAMPLER, FORMAT_SDX2,	1, RATE_FULL },
+	{ "dcsqxdhalfmono.dsp",		36,	KIND_SAMPLER, FORMAT_SDX2,	1, RATE_HALF },
+	{ "dcsqxdvarmono.dsp",		48,	KIND_SAMPLER, FORMAT_SDX2,	1, RATE_VARIABLE },
+	{ "dcsqxdstereo.dsp",		54,	KIND_SAMPLER, FORMAT_SDX2,	2, RATE_FULL }
+};
+
+#define TEMPLATES (sizeof(templates) / sizeof(templates[0]))
+
+typedef struct AudioItem
+{
+	int Type;						// ITEM_*
+	Template *Template;				// Templates and instruments
+	Item Owner;						// An instrument's template, an attachment's or a knob's instrument
+	Item Target;					// What an attachment attaches
+	int32 Param;					// A knob's KNOB_*
+	bool OwnTemplate;				// From LoadInstrument, UnloadInstrument unloads it too
+
+	bool Started;					// Instruments from here
+	Item Sample;					// Attached, 0 for none
+	int32 Out[2];					// Mixer input each output is connected to, -1 for none
+	uint64 Pos;						// 16.16 frames into the sample
+	uint32 Step;					// Per frame mixed
+	int32 Amplitude;
+	int32 Rate;						// 0x8000 plays the sample at its own rate
+	bool Audible;					// Since this start
+	uint64 StartNS;
+
+	char Name[32];					// Samples from here
+	int16 *Data;					// Interleaved
+	int32 Frames;
+	int32 Channels;
+	int32 SampleRate;
+	int32 Format;
+	uint32 NumBytes;
+} AudioItem;
+
+HostMixStats HostMix = { HOST_MIX_DSP_TICKS };
+HostMixEvent HostMixEvents[HOST_MIX_EVENTS];
+
+static AudioItem items[AUDIO_ITEMS];
+static pthread_mutex_t mixLock = PTHREAD_MUTEX_INITIALIZER;
+static Item mixer = 0;				// The one mixer8x2 there can be
+static int16 squares[256];
+
+static int16 *recording = NULL;		// Stereo
+static uint64 recordFrom = 0;		// The frame it starts at
+static uint32 recordFrames = 0;		// Room for
+
+/* ----- Items ----- */
+
+static AudioItem *Find(Item item, int type)
+{
+	int idx = item - AUDIO_ITEM;
+
+	if (idx < 0 || idx >= AUDIO_ITEMS || items[idx].Type != type) return NULL;
+
+	return &items[idx];
+}
+
+static Item New(int type)
+{
+	int i;
+
+	for (i = 0; i < AUDIO_ITEMS && items[i].Type != ITEM_FREE; i++);
+
+	if (i == AUDIO_ITEMS) return AF_ERR_NORSRC;
+
+	memset(&items[i], 0, sizeof(AudioItem));
+
+	items[i].Type = type;
+	items[i].Out[0] = -1;
+	items[i].Out[1] = -1;
+
+	return AUDIO_ITEM + i;
+}
+
+static Item ItemOf(AudioItem *ai)
+{
+	return AUDIO_ITEM + (ai - items);
+}
+
+static char *SampleName(AudioItem *ins)
+{
+	AudioItem *s = Find(ins->Sample, ITEM_SAMPLE);
+
+	return s != NULL ? s->Name : "";
+}
+
+static void Note(uint32 type, AudioItem *ins, int32 input, uint64 frame, uint64 ns)
+{
+	HostMixEvent *e;
+
+	if (HostMix.Events == HOST_MIX_EVENTS)
+	{
+		HostMix.Dropped++;
+
+		return;
+	}
+
+	e = &HostMixEvents[HostMix.Events++];
+
+	e->Type = type;
+	e->Voice = ItemOf(ins);
+	e->Input = input;
+	e->Frame = frame;
+	e->NS = ns;
+
+	strncpy(e->Sample, SampleName(ins), sizeof(e->Sample) - 1);
+	e->Sample[sizeof(e->Sample) - 1] = 0;
+}
+
+/* ----- Mixing ----- */
+
+static bool Voice(AudioItem *ai)
+{
+	return ai->Type == ITEM_INSTRUMENT && ai->Template->Kind == KIND_SAMPLER;
+}
+
+// Everything up to now as it stands, mixLock held
+
+static void MixTo(AudioTime now)
+{
+	uint64 to = ((uint64)now * HOST_MIX_RATE) / AUDIO_TICKS;
+	AudioItem *voices[AUDIO_ITEMS], *v, *s;
+	AudioItem *mix = Find(mixer, ITEM_INSTRUMENT);
+	int32 left, right, x, ch, in;
+	uint64 f;
+	int16 *out;
+	int i, n = 0;
+	uint64 idx;
+
+	if (to <= HostMix.Frames) return;
+
+	for (i = 0; i < AUDIO_ITEMS; i++)
+	{
+		if (Voice(&items[i]) && items[i].Started) voices[n++] = &items[i];
+	}
+
+	if (n == 0 && recording == NULL) // Silence nobody keeps
+	{
+		HostMix.Frames = to;
+
+		return;
+	}
+
+	for (f = HostMix.Frames; f < to; f++)
+	{
+		left = 0;
+		right = 0;
+
+		for (i = 0; i < n; i++)
+		{
+			v = voices[i];
+
+			if (v->Started == false) continue;
+
+			s = Find(v->Sample, ITEM_SAMPLE);
+			idx = v->Pos >> 16;
+
+			if (s == NULL || idx >= (uint64)s->Frames)
+			{
+				v->Started = false;
+
+				Note(HOST_MIX_END, v, v->Out[0], f, HostNowNS());
+
+				continue;
+			}
+
+			for (ch = 0; ch < s->Channels; ch++)
+			{
+				x = (s->Data[(idx * s->Channels) + ch] * v->Amplitude) >> 15;
+
+				if (v->Audible == false && (x >= HOST_MIX_AUDIBLE || x <= -HOST_MIX_AUDIBLE))
+				{
+					v->Audible = true;
+
+					Note(HOST_MIX_AUDIBLE_AT, v, v->Out[0], f, v->StartNS);
+				}
+
+				in = v->Out[s->Channels > 1 ? ch : 0];
+
+				if (in < 0 || mix == NULL || mix->Started == false) continue;
+
+				left += (x * HostMix.Gain[in][0]) >> 15;
+				right += (x * HostMix.Gain[in][1]) >> 15;
+			}
+
+			v->Pos += v->Step;
+		}
+
+		if (left > AUDIO_FULL_SCALE || left < -AUDIO_FULL_SCALE || right > AUDIO_FULL_SCALE || right < -AUDIO_FULL_SCALE)
+		{
+			HostMix.Clipped++;
+
+			left = left > AUDIO_FULL_SCALE ? AUDIO_FULL_SCALE : left < -AUDIO_FULL_SCALE ? -AUDIO_FULL_SCALE : left;
+			right = right > AUDIO_FULL_SCALE ? AUDIO_FULL_SCALE : right < -AUDIO_FULL_SCALE ? -AUDIO_FULL_SCALE : right;
+		}
+
+		if (recording != NULL && f >= recordFrom && f - recordFrom < recordFrames)
+		{
+			out = recording + ((f - recordFrom) * 2);
+			out[0] = (int16)left;
+			out[1] = (int16)right;
+		}
+	}
+
+	HostMix.Frames = to;
+}
+
+static void Lock()
+{
+	pthread_mutex_lock(&mixLock);
+
+	MixTo(GetAudioTime());
+}
+
+static void Unlock()
+{
+	pthread_mutex_unlock(&mixLock);
+}
+
+void HostMixRecord(uint32 seconds)
+{
+	Lock();
+
+	free(recording);
+
+	recordFrames = seconds * HOST_MIX_RATE;
+	recording = (int16 *)calloc(recordFrames, 2 * sizeof(int16));
+	recordFrom = HostMix.Frames;
+
+	Unlock();
+}
+
+void HostMixFlush()
+{
+	Lock();
+	Unlock();
+}
+
+bool HostMixPlaying(Item voice)
+{
+	AudioItem *ai;
+	bool playing;
+
+	Lock();
+
+	ai = Find(voice, ITEM_INSTRUMENT);
+	playing = ai != NULL && Voice(ai) && ai->Started;
+
+	Unlock();
+
+	return playing;
+}
+
+static void Put16(ubyte *p, uint32 v) { p[0] = v; p[1] = v >> 8; }
+static void Put32(ubyte *p, uint32 v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+
+bool HostMixWriteWAV(char *path)
+{
+	static char *types[] = { "start", "stop", "end", "audible", "connect", "disconnect", "norsrc" };
+	uint64 frames;
+	ubyte head[44];
+	ubyte *data;
+	HostMixEvent *e;
+	char log[512];
+	FILE *fp;
+	uint32 i;
+
+	Lock();
+
+	frames = HostMix.Frames - recordFrom;
+
+	if (recording == NULL) frames = 0;
+	if (frames > recordFrames) frames = recordFrames;
+
+	memset(head, 0, sizeof(head));
+	memcpy(head, "RIFF", 4);
+	memcpy(head + 8, "WAVEfmt ", 8);
+	memcpy(head + 36, "data", 4);
+	Put32(head + 4, 36 + (frames * 4));
+	Put32(head + 16, 16);
+	Put16(head + 20, 1);			// PCM
+	Put16(head + 22, 2);
+	Put32(head + 24, HOST_MIX_RATE);
+	Put32(head + 28, HOST_MIX_RATE * 4);
+	Put16(head + 32, 4);
+	Put16(head + 34, 16);
+	Put32(head + 40, frames * 4);
+
+	data = (ubyte *)malloc((frames * 4) + 1);
+
+	for (i = 0; i < frames * 2; i++)
+	{
+		Put16(data + (i * 2), (uint16)recording[i]); // Little endian whatever the host is
+	}
+
+	fp = fopen(path, "wb");
+
+	if (fp != NULL)
+	{
+		fwrite(head, 1, sizeof(head), fp);
+		fwrite(data, 1, frames * 4, fp);
+		fclose(fp);
+	}
+
+	free(data);
+
+	snprintf(log, sizeof(log), "%s.log", path);
+
+	if (fp != NULL && (fp = fopen(log, "w")) != NULL)
+	{
+		fprintf(fp, "# frame\tms\tevent\tvoice\tinput\tsample\n");
+
+		for (i = 0; i < HostMix.Events; i++)
+		{
+			e = &HostMixEvents[i];
+
+			if (e->Frame < recordFrom || e->Frame - recordFrom >= frames) continue;
+
+			fprintf(fp, "%llu\t%.2f\t%s\t0x%x\t%d\t%s\n", (unsigned long long)(e->Frame - recordFrom),
+				(e->Frame - recordFrom) * 1000.0 / HOST_MIX_RATE, types[e->Type], e->Voice, e->Input, e->Sample);
+		}
+
+		fclose(fp);
+	}
+
+	Unlock();
+
+	return fp != NULL;
+}
+
+/* ----- Folio ----- */
+
+Err OpenAudioFolio() { return 0; }
+Err CloseAudioFolio() { return 0; }
+
+Item LoadInsTemplate(char *name, Item aiffFile)
+{
+	AudioItem *ai;
+	Item item;
+	uint32 i;
+
+	for (i = 0; i < TEMPLATES && strcmp(templates[i].Name, name) != 0; i++);
+
+	if (i == TEMPLATES) return AF_ERR_BADNAME;
+
+	Lock();
+
+	if ((item = New(ITEM_TEMPLATE)) >= 0)
+	{
+		ai = Find(item, ITEM_TEMPLATE);
+		ai->Template = &templates[i];
+	}
+
+	Unlock();
+
+	return item;
+}
+
+static void FreeItem(AudioItem *ai);
+
+// An instrument and everything hanging off it, mixLock held
+
+static void FreeVoice(AudioItem *ins)
+{
+	int i;
+
+	if (ins->Started && Voice(ins)) Note(HOST_MIX_STOP, ins, ins->Out[0], HostMix.Frames, HostNowNS());
+
+	for (i = 0; i < AUDIO_ITEMS; i++)
+	{
+		if ((items[i].Type == ITEM_ATTACHMENT || items[i].Type == ITEM_KNOB) && items[i].Owner == ItemOf(ins)) FreeItem(&items[i]);
+	}
+
+	for (i = 0; i < HOST_MIX_INPUTS; i++)
+	{
+		if (HostMix.Voice[i] == ItemOf(ins)) HostMix.Voice[i] = 0;
+	}
+
+	if (ItemOf(ins) == mixer) mixer = 0;
+
+	HostMix.DSPUsed -= ins->Template->Ticks;
+	HostMix.Instruments--;
+}
+
+static void FreeItem(AudioItem *ai)
+{
+	int i;
+
+	switch (ai->Type)
+	{
+		case ITEM_TEMPLATE:
+			for (i = 0; i < AUDIO_ITEMS; i++) // Its instruments go with it
+			{
+				if (items[i].Type == ITEM_INSTRUMENT && items[i].Owner == ItemOf(ai)) FreeItem(&items[i]);
+			}
+			break;
+
+		case ITEM_INSTRUMENT:
+			FreeVoice(ai);
+			break;
+
+		case ITEM_SAMPLE:
+			for (i = 0; i < AUDIO_ITEMS; i++)
+			{
+				if (items[i].Type == ITEM_ATTACHMENT && items[i].Target == ItemOf(ai)) FreeItem(&items[i]);
+			}
+
+			free(ai->Data);
+
+			HostMix.Samples--;
+			HostMix.SampleBytes -= ai->NumBytes;
+			break;
+
+		case ITEM_ATTACHMENT:
+			for (i = 0; i < AUDIO_ITEMS; i++)
+			{
+				if (items[i].Type == ITEM_INSTRUMENT && ItemOf(&items[i]) == ai->Owner && items[i].Sample == ai->Target)
+				{
+					items[i].Sample = 0; // It can't play what isn't there
+					items[i].Started = false;
+				}
+			}
+			break;
+
+		case ITEM_ENVELOPE:
+			for (i = 0; i < AUDIO_ITEMS; i++)
+			{
+				if (items[i].Type == ITEM_ATTACHMENT && items[i].Target == ItemOf(ai)) FreeItem(&items[i]);
+			}
+			break;
+	}
+
+	ai->Type = ITEM_FREE;
+}
+
+static Err Free(Item item, int type)
+{
+	AudioItem *ai;
+	Err result = AF_ERR_BADITEM;
+
+	Lock();
+
+	if ((ai = Find(item, type)) != NULL)
+	{
+		FreeItem(ai);
+
+		result = 0;
+	}
+
+	Unlock();
+
+	return result;
+}
+
+Err UnloadInsTemplate(Item tmpl)
+{
+	return Free(tmpl, ITEM_TEMPLATE);
+}
+
+Item AllocInstrument(Item tmpl, uint8 priority)
+{
+	AudioItem *t, *ins;
+	Item item = AF_ERR_BADITEM;
+
+	Lock();
+
+	if ((t = Find(tmpl, ITEM_TEMPLATE)) != NULL)
+	{
+		if (HostMix.DSPUsed + t->Template->Ticks > HostMix.DSPTicks || (t->Template->Kind == KIND_MIXER && mixer != 0))
+		{
+			HostMix.NoResource++;
+
+			item = AF_ERR_NORSRC;
+		}
+		else if ((item = New(ITEM_INSTRUMENT)) >= 0)
+		{
+			ins = Find(item, ITEM_INSTRUMENT);
+			ins->Template = t->Template;
+			ins->Owner = tmpl;
+			ins->Amplitude = AUDIO_FULL_SCALE;
+			ins->Rate = 0x8000;
+
+			if (t->Template->Kind == KIND_MIXER) mixer = item;
+
+			HostMix.DSPUsed += t->Template->Ticks;
+			HostMix.Instruments++;
+
+			if (HostMix.DSPUsed > HostMix.DSPPeak) HostMix.DSPPeak = HostMix.DSPUsed;
+		}
+	}
+
+	Unlock();
+
+	return item;
+}
+
+Err FreeInstrument(Item ins)
+{
+	return Free(ins, ITEM_INSTRUMENT);
+}
+
+Item LoadInstrument(char *name, Item aiffFile, uint8 priority)
+{
+	Item tmpl = LoadInsTemplate(name, aiffFile), ins;
+
+	if (tmpl < 0) return tmpl;
+
+	ins = AllocInstrument(tmpl, priority);
+
+	if (ins < 0)
+	{
+		UnloadInsTemplate(tmpl);
+
+		return ins;
+	}
+
+	items[ins - AUDIO_ITEM].OwnTemplate = true;
+
+	return ins;
+}
+
+Err UnloadInstrument(Item ins)
+{
+	AudioItem *ai = Find(ins, ITEM_INSTRUMENT);
+
+	if (ai == NULL) return AF_ERR_BADITEM;
+
+	if (ai->OwnTemplate) return UnloadInsTemplate(ai->Owner);
+
+	return FreeInstrument(ins);
+}
+
+// Where a sampler is in its sample each frame, mixLock held
+
+static void SetStep(AudioItem *ins)
+{
+	AudioItem *s = Find(ins->Sample, ITEM_SAMPLE);
+	uint32 rate = s != NULL ? s->SampleRate : HOST_MIX_RATE;
+
+	switch (ins->Template->Rate)
+	{
+		case RATE_FULL: ins->Step = 1 << 16; break;
+		case RATE_HALF: ins->Step = 1 << 15; break;
+		default: ins->Step = (uint32)((((uint64)rate << 16) * ins->Rate) / (0x8000ULL * HOST_MIX_RATE)); break;
+	}
+}
+
+Err StartInstrument(Item ins, TagArg *tags)
+{
+	AudioItem *ai;
+	Err result = AF_ERR_BADITEM;
+
+	Lock();
+
+	if ((ai = Find(ins, ITEM_INSTRUMENT)) != NULL)
+	{
+		for (; tags != NULL && tags->ta_Tag != TAG_END; tags++)
+		{
+			if (tags->ta_Tag == AF_TAG_AMPLITUDE) ai->Amplitude = (int32)(intptr_t)tags->ta_Arg;
+			if (tags->ta_Tag == AF_TAG_RATE) ai->Rate = (int32)(intptr_t)tags->ta_Arg;
+		}
+
+		if (Voice(ai))
+		{
+			if (ai->Started) Note(HOST_MIX_STOP, ai, ai->Out[0], HostMix.Frames, HostNowNS()); // From the top again
+
+			ai->Pos = 0;
+			ai->Audible = false;
+			ai->StartNS = HostNowNS();
+
+			SetStep(ai);
+
+			Note(HOST_MIX_START, ai, ai->Out[0], HostMix.Frames, ai->StartNS);
+		}
+
+		ai->Started = true;
+		result = 0;
+	}
+
+	Unlock();
+
+	return result;
+}
+
+Err ReleaseInstrument(Item ins, TagArg *tags)
+{
+	return Find(ins, ITEM_INSTRUMENT) != NULL ? 0 : AF_ERR_BADITEM; // Nothing here loops or sustains
+}
+
+Err StopInstrument(Item ins, TagArg *tags)
+{
+	AudioItem *ai;
+	Err result = AF_ERR_BADITEM;
+
+	Lock();
+
+	if ((ai = Find(ins, ITEM_INSTRUMENT)) != NULL)
+	{
+		if (ai->Started && Voice(ai)) Note(HOST_MIX_STOP, ai, ai->Out[0], HostMix.Frames, HostNowNS());
+
+		ai->Started = false;
+		result = 0;
+	}
+
+	Unlock();
+
+	return result;
+}
+
+// Which output of src a port is, -1 if it hasn't got it
+
+static int OutputPort(AudioItem *src, char *name)
+{
+	int channels = src->Template->Kind == KIND_SAMPLER ? src->Template->Channels : 1;
+
+	if (channels == 1) return strcmp(name, "Output") == 0 ? 0 : -1;
+
+	if (strcmp(name, "LeftOutput") == 0) return 0;
+	if (strcmp(name, "RightOutput") == 0) return 1;
+
+	return -1;
+}
+
+static int MixerInput(AudioItem *dst, char *name)
+{
+	int in;
+
+	if (dst->Template->Kind != KIND_MIXER || sscanf(name, "Input%d", &in) != 1) return -1;
+
+	return in >= 0 && in < HOST_MIX_INPUTS ? in : -1;
+}
+
+static Err Patch(Item src, char *srcName, Item dst, char *dstName, bool connect)
+{
+	AudioItem *s, *d;
+	Err result = AF_ERR_BADITEM;
+	int out, in;
+
+	Lock();
+
+	s = Find(src, ITEM_INSTRUMENT);
+	d = Find(dst, ITEM_INSTRUMENT);
+
+	if (s != NULL && (out = OutputPort(s, srcName)) < 0)
+	{
+		result = AF_ERR_BADNAME;
+	}
+	else if (s != NULL && d == NULL)
+	{
+		result = 0; // Into a sound file player's sampler, timing only
+	}
+	else if (s != NULL && (in = MixerInput(d, dstName)) < 0)
+	{
+		result = s->Template->Kind == KIND_ENVELOPE && strcmp(dstName, "Amplitude") == 0 ? 0 : AF_ERR_BADNAME;
+	}
+	else if (s != NULL && connect)
+	{
+		if (HostMix.Voice[in] == 0 || HostMix.Voice[in] == src)
+		{
+			HostMix.Voice[in] = src;
+			s->Out[out] = in;
+
+			Note(HOST_MIX_CONNECT, s, in, HostMix.Frames, HostNowNS());
+
+			result = 0;
+		}
+		else
+		{
+			result = AF_ERR_NORSRC; // Somebody else's
+		}
+	}
+	else if (s != NULL)
+	{
+		if (HostMix.Voice[in] == src) HostMix.Voice[in] = 0;
+
+		s->Out[out] = -1;
+
+		Note(HOST_MIX_DISCONNECT, s, in, HostMix.Frames, HostNowNS());
+
+		result = 0;
+	}
+
+	Unlock();
+
+	return result;
+}
+
+Err ConnectInstruments(Item src, char *srcName, Item dst, char *dstName)
+{
+	return Patch(src, srcName, dst, dstName, true);
+}
+
+Err DisconnectInstruments(Item src, char *srcName, Item dst, char *dstName)
+{
+	return Patch(src, srcName, dst, dstName, false);
+}
+
+/* ----- Knobs ----- */
+
+Item GrabKnob(Item ins, char *name)
+{
+	AudioItem *ai, *knob;
+	Item item = AF_ERR_BADITEM;
+	int32 param = -1, in = 0;
+
+	Lock();
+
+	if ((ai = Find(ins, ITEM_INSTRUMENT)) != NULL)
+	{
+		if (ai->Template->Kind == KIND_MIXER && sscanf(name, "LeftGain%d", &in) == 1) param = KNOB_LEFT_GAIN + in;
+		else if (ai->Template->Kind == KIND_MIXER && sscanf(name, "RightGain%d", &in) == 1) param = KNOB_RIGHT_GAIN + in;
+		else if (Voice(ai) && ai->Template->Rate == RATE_VARIABLE && strcmp(name, "Frequency") == 0) param = KNOB_FREQUENCY;
+		else if (Voice(ai) && strcmp(name, "Amplitude") == 0) param = KNOB_AMPLITUDE;
+
+		if (ai->Template->Kind == KIND_MIXER && (in < 0 || in >= HOST_MIX_INPUTS)) param = -1;
+
+		item = AF_ERR_BADNAME;
+
+		if (param >= 0 && (item = New(ITEM_KNOB)) >= 0)
+		{
+			knob = Find(item, ITEM_KNOB);
+			knob->Owner = ins;
+			knob->Param = param;
+		}
+	}
+	else if (HostSamplerAmplitude(ins) != NULL)
+	{
+		item = AF_ERR_BADNAME;
+
+		if (strcmp(name, "Amplitude") == 0 && (item = New(ITEM_KNOB)) >= 0)
+		{
+			knob = Find(item, ITEM_KNOB);
+			knob->Owner = ins;
+			knob->Param = KNOB_SAMPLER_AMPLITUDE;
+		}
+	}
+
+	Unlock();
+
+	return item;
+}
+
+Err ReleaseKnob(Item knob)
+{
+	return Free(knob, ITEM_KNOB);
+}
+
+Err TweakRawKnob(Item knob, int32 value)
+{
+	AudioItem *k, *ins;
+	Err result = AF_ERR_BADITEM;
+
+	Lock();
+
+	if ((k = Find(knob, ITEM_KNOB)) != NULL && k->Param == KNOB_SAMPLER_AMPLITUDE)
+	{
+		if (HostSamplerAmplitude(k->Owner) != NULL)
+		{
+			*HostSamplerAmplitude(k->Owner) = value;
+
+			result = 0;
+		}
+	}
+	else if ((k = Find(knob, ITEM_KNOB)) != NULL && (ins = Find(k->Owner, ITEM_INSTRUMENT)) != NULL)
+	{
+		if (k->Param < KNOB_RIGHT_GAIN) HostMix.Gain[k->Param - KNOB_LEFT_GAIN][0] = value;
+		else if (k->Param < KNOB_FREQUENCY) HostMix.Gain[k->Param - KNOB_RIGHT_GAIN][1] = value;
+		else if (k->Param == KNOB_AMPLITUDE) ins->Amplitude = value;
+		else
+		{
+			ins->Rate = value;
+
+			SetStep(ins);
+		}
+
+		result = 0;
+	}
+
+	Unlock();
+
+	return result;
+}
+
+Err TweakKnob(Item knob, int32 value)
+{
+	AudioItem *k = Find(knob, ITEM_KNOB);
+
+	if (k != NULL && k->Param != KNOB_FREQUENCY) // Gains and amplitude are 0 to full scale
+	{
+		if (value < 0) value = 0;
+		if (value > AUDIO_FULL_SCALE) value = AUDIO_FULL_SCALE;
+	}
+
+	return TweakRawKnob(knob, value);
+}
+
+/* ----- Samples ----- */
+
+static uint32 Get16(ubyte *p) { return (p[0] << 8) | p[1]; }
+static uint32 Get32(ubyte *p) { return ((uint32)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+
+static int32 GetRate(ubyte *p) // 80 bit extended, whole numbers only
+{
+	int32 exponent = ((p[0] & 0x7f) << 8) | p[1];
+	int32 shift = 16383 + 31 - exponent;
+
+	return shift >= 0 && shift < 32 ? (int32)(Get32(p + 2) >> shift) : 0;
+}
+
+static ubyte *FindChunk(ubyte *data, int32 size, char *id, int32 *length)
+{
+	int32 offset = 12, len;
+
+	while (offset + 8 <= size)
+	{
+		len = Get32(data + offset + 4);
+
+		if (memcmp(data + offset, id, 4) == 0 && offset + 8 + len <= size)
+		{
+			*length = len;
+
+			return data + offset + 8;
+		}
+
+		offset += 8 + ((len + 1) & ~1);
+	}
+
+	return NULL;
+}
+
+static int32 Decode(int32 code, int32 prev)
+{
+	int32 v = squares[code & 0xff];
+
+	if (code & 1) v += prev;
+
+	return v < -32768 ? -32768 : v > 32767 ? 32767 : v;
+}
+
+static bool Parse(AudioItem *s, ubyte *file, int32 size)
+{
+	ubyte *comm, *ssnd, *src;
+	int32 commLen, ssndLen, bits, i, n, ch, prev[2] = { 0, 0 };
+	bool aifc;
+
+	if (size < 12 || memcmp(file, "FORM", 4) != 0) return false;
+
+	aifc = memcmp(file + 8, "AIFC", 4) == 0;
+
+	if (aifc == false && memcmp(file + 8, "AIFF", 4) != 0) return false;
+
+	if ((comm = FindChunk(file, size, "COMM", &commLen)) == NULL || commLen < 18) return false;
+	if ((ssnd = FindChunk(file, size, "SSND", &ssndLen)) == NULL || ssndLen < 8) return false;
+
+	s->Channels = Get16(comm);
+	s->Frames = Get32(comm + 2);
+	s->SampleRate = GetRate(comm + 8);
+	bits = Get16(comm + 6);
+
+	s->Format = bits == 8 ? FORMAT_8 : FORMAT_16;
+
+	if (aifc && commLen >= 22 && memcmp(comm + 18, "SDX2", 4) == 0) s->Format = FORMAT_SDX2;
+	else if (aifc && (commLen < 22 || memcmp(comm + 18, "NONE", 4) != 0)) return false;
+
+	if (s->Channels < 1 || s->Channels > 2 || (bits != 8 && bits != 16)) return false;
+
+	src = ssnd + 8 + Get32(ssnd);
+	n = s->Frames * s->Channels;
+
+	s->NumBytes = s->Format == FORMAT_16 ? n * 2 : n;
+
+	if (src + s->NumBytes > ssnd + ssndLen) return false;
+
+	s->Data = (int16 *)malloc((n + 1) * sizeof(int16));
+
+	if (s->Data == NULL) return false;
+
+	for (i = 0; i < n; i++)
+	{
+		ch = i % s->Channels;
+
+		switch (s->Format)
+		{
+			case FORMAT_16: s->Data[i] = (int16)Get16(src + (i * 2)); break;
+			case FORMAT_8: s->Data[i] = (int16)((int8)src[i] << 8); break;
+			default: s->Data[i] = prev[ch] = Decode((int8)src[i], prev[ch]); break;
+		}
+	}
+
+	return true;
+}
+
+static void InitSquares()
+{
+	int32 n;
+
+	for (n = -128; n < 128; n++)
+	{
+		squares[n & 0xff] = (int16)(2 * n * (n < 0 ? -n : n));
+	}
+}
+
+static Item AddSample(AudioItem *s)
+{
+	Item item = New(ITEM_SAMPLE);
+	AudioItem *ai = Find(item, ITEM_SAMPLE);
+
+	if (ai == NULL)
+	{
+		free(s->Data);
+
+		return item;
+	}
+
+	s->Type = ITEM_SAMPLE;
+	*ai = *s;
+
+	HostMix.Samples++;
+	HostMix.SampleBytes += s->NumBytes;
+
+	return item;
+}
+
+Item LoadSample(char *name)
+{
+	AudioItem s;
+	ubyte *file;
+	int32 size;
+	char *base = strrchr(name, '/');
+	Item item = AF_ERR_BADITEM;
+
+	if (squares[1] == 0) InitSquares();
+
+	memset(&s, 0, sizeof(s));
+
+	strncpy(s.Name, base != NULL ? base + 1 : name, sizeof(s.Name) - 1);
+
+	if ((file = HostReadFile(name, &size)) == NULL) return AF_ERR_BADNAME;
+
+	Lock();
+
+	if (Parse(&s, file, size)) item = AddSample(&s);
+
+	Unlock();
+
+	free(file);
+
+	return item;
+}
+
+Item MakeSample(uint32 numBytes, TagArg *tags)
+{
+	AudioItem s;
+	Item item;
+
+	memset(&s, 0, sizeof(s));
+
+	strcpy(s.Name, "(made)");
+
+	s.Frames = numBytes / 2;
+	s.Channels = 1;
+	s.SampleRate = HOST_MIX_RATE;
+	s.Format = FORMAT_16;
+	s.NumBytes = numBytes;
+	s.Data = (int16 *)calloc(s.Frames + 1, sizeof(int16));
+
+	Lock();
+
+	item = AddSample(&s);
+
+	Unlock();
+
+	return item;
+}
+
+Err UnloadSample(Item sample)
+{
+	return Free(sample, ITEM_SAMPLE); // Its attachments go too, the folio does the same
+}
+
+static Item Attach(Item ins, Item target, int type)
+{
+	AudioItem *ai, *att;
+	Item item = AF_ERR_BADITEM;
+
+	Lock();
+
+	if ((ai = Find(ins, ITEM_INSTRUMENT)) != NULL && Find(target, type) != NULL && (item = New(ITEM_ATTACHMENT)) >= 0)
+	{
+		att = Find(item, ITEM_ATTACHMENT);
+		att->Owner = ins;
+		att->Target = target;
+
+		if (type == ITEM_SAMPLE)
+		{
+			ai->Sample = target;
+
+			SetStep(ai);
+		}
+	}
+
+	Unlock();
+
+	return item;
+}
+
+Item AttachSample(Item ins, Item sample, char *hookName)
+{
+	return Attach(ins, sample, ITEM_SAMPLE);
+}
+
+Err DetachSample(Item attachment)
+{
+	return Free(attachment, ITEM_ATTACHMENT);
+}
+
+char *SelectSamplePlayer(Item sample, bool ifVariable)
+{
+	AudioItem *s = Find(sample, ITEM_SAMPLE);
+	int rate;
+	uint32 i;
+
+	if (s == NULL) return NULL;
+
+	if (ifVariable) rate = RATE_VARIABLE;
+	else if (s->SampleRate == HOST_MIX_RATE) rate = RATE_FULL;
+	else if (s->SampleRate == HOST_MIX_RATE / 2) rate = RATE_HALF;
+	else return NULL;
+
+	for (i = 0; i < TEMPLATES; i++)
+	{
+		if (templates[i].Kind == KIND_SAMPLER && templates[i].Format == s->Format && templates[i].Channels == s->Channels &&
+			templates[i].Rate == rate) return templates[i].Name;
+	}
+
+	return NULL;
+}
+
+Err GetAudioItemInfo(Item item, TagArg *tags)
+{
+	AudioItem *s = Find(item, ITEM_SAMPLE);
+
+	if (s == NULL) return AF_ERR_BADITEM;
+
+	for (; tags->ta_Tag != TAG_END; tags++)
+	{
+		switch (tags->ta_Tag)
+		{
+			case AF_TAG_NUMBYTES: tags->ta_Arg = (void *)(intptr_t)s->NumBytes; break;
+			case AF_TAG_FRAMES: tags->ta_Arg = (void *)(intptr_t)s->Frames; break;
+			case AF_TAG_SAMPLE_RATE: tags->ta_Arg = (void *)(intptr_t)((uint32)s->SampleRate << 16); break;
+			case AF_TAG_CHANNELS: tags->ta_Arg = (void *)(intptr_t)s->Channels; break;
+		}
+	}
+
+	return 0;
+}
+
+/* ----- Envelopes ----- */
+
+Item CreateEnvelope(DataTimePair *points, int32 numPoints, int32 sustainBegin, int32 sustainEnd)
+{
+	Item item;
+
+	Lock();
+
+	item = New(ITEM_ENVELOPE);
+
+	Unlock();
+
+	return item;
+}
+
+Err DeleteEnvelope(Item env)
+{
+	return Free(env, ITEM_ENVELOPE);
+}
+
+Item AttachEnvelope(Item ins, Item env, char *hookName)
+{
+	return Attach(ins, env, ITEM_ENVELOPE);
+}
+
+Err DetachEnvelope(Item attachment)
+{
+	return Free(attachment, ITEM_ATTACHMENT);
+}
@@ -0,0 +1,760 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Gameplay micro-benchmarks. Includes tetris.c so the static board and
+//	block state can be set up directly, then times the per-frame paths on
+//	seeded random fixtures and on the worst case boards for each one. The
+//	fill_ cases time the software cel engine on the gameplay chain, the
+//	explosion, the options overlay and the text cels. They're the only ones
+//	run with the raster on, the rest only count the cels they draw so the
+//	explode_ cases time the clear and its animation logic, not the fill
+//
+//	Each benchmark is calibrated to BENCH_REP_NS per repetition and run
+//	--reps times. Median, mean and deviation are reported, the fastest
+//	repetition is what gets compared to a baseline file written by an earlier
+//	--write-baseline run since it's the one least disturbed by the rest of the
+//	machine. A case slower than the baseline by more than --tolerance percent
+//	(and BENCH_SLACK_NS) is run again, up to BENCH_RETRIES times, since a
+//	neighbour on a shared machine can hold the caches for a whole case. If it
+//	stays slower it's reported and the run exits 1, so does a --baseline that
+//	can't be read. The baseline's first line names the host it was recorded
+//	on, which is printed with the comparison
+//
+//	audio_queue times AudioPlay against the real audio thread draining the
+//	ring on another core. Back to back it fills the ring, so a full ring
+//	waits for room and the number is the sustained rate, an upper bound on
+//	what one PlaySFX costs the game. At the end every play that was queued
+//	has to have run, in order
+//
+
+*/
+
+#define main tetris_main // As tetris.o is built, this file takes its place in the link
+#include "tetris.c"
+#undef main
+
+#include <unistd.h>
+
+#define BENCH_REP_NS 5000000		// Calibrate each repetition to about 5ms
+#define BENCH_MAX_REPS 64
+#define BENCH_DEFAULT_REPS 11
+#define BENCH_DEFAULT_TOLERANCE 25	// Percent, a shared desktop still moves the ~10ns cases by 15
+#define BENCH_SLACK_NS 3.0			// Noise floor for the ~10ns benchmarks, a few cache misses
+#define BENCH_FIXTURES 64			// Must be a power of two
+#define BENCH_MAX_BASELINE 64
+#define BENCH_RETRIES 2
+#define BENCH_HOST_CHARS 160
+
+typedef struct BenchCase
+{
+	char *Name;
+	void (*Setup)(int arg);
+	void (*Op)(void);
+	int Arg;
+	bool Raster;				// Fill the frame buffers, the fill_ cases only
+} BenchCase;
+
+typedef struct BenchResult
+{
+	double Median;
+	double Mean;
+	double StdDev;
+	double Min;
+	double Pixels;				// Frame buffer writes per op, the fill cases only
+} BenchResult;
+
+typedef struct BaselineEntry
+{
+	char Name[32];
+	double Best;
+} BaselineEntry;
+
+static bool benchBoard[BOARD_WIDTH][BOARD_HEIGHT];					// Restored into Game.Board by the ops that change it
+static Tetrimino benchBlocks[BENCH_FIXTURES];	// Valid active block positions on benchBoard
+static uint32 benchValues[BENCH_FIXTURES];
+static uint32 benchIdx = 0;
+static uint32 benchState = 0x2545f491;
+
+static CCB *benchOverlay = NULL;
+
+static BaselineEntry baseline[BENCH_MAX_BASELINE];
+static int baselineCount = 0;
+static char baselineHost[BENCH_HOST_CHARS] = "an unnamed host";
+
+static volatile bool benchSink; // Keeps the Try results live
+
+static uint32 BenchRandom()
+{
+	benchState ^= benchState << 13;
+	benchState ^= benchState >> 17;
+	benchState ^= benchState << 5;
+
+	return benchState;
+}
+
+int HostPollPad(HostPadEvent *events)
+{
+	return 0;
+}
+
+void HostFrameDone()
+{
+}
+
+/* ----- Fixtures ----- */
+
+// Random stack from startRow down with no complete rows, then fullRows complete rows at the bottom
+
+static void BuildBoard(int startRow, int density, int fullRows)
+{
+	int x, y, filled;
+
+	for (y = 0; y < BOARD_HEIGHT; y++)
+	{
+		filled = 0;
+
+		for (x = 0; x < BOARD_WIDTH; x++)
+		{
+			benchBoard[x][y] = (y >= BOARD_HEIGHT - fullRows) || (y >= startRow && (int)(BenchRandom() % 100) < density);
+
+			if (benchBoard[x][y]) filled++;
+		}
+
+		if (filled == BOARD_WIDTH && y < BOARD_HEIGHT - fullRows) benchBoard[BenchRandom() % BOARD_WIDTH][y] = false;
+	}
+
+	memcpy(Game.Board, benchBoard, sizeof(benchBoard));
+}
+
+static bool BlockFits(Tetrimino *t)
+{
+	int i;
+
+	for (i = 0; i < 4; i++)
+	{
+		if (t->Blocks[i].X < 0 || t->Blocks[i].X >= BOARD_WIDTH || t->Blocks[i].Y < 0 || t->Blocks[i].Y >= BOARD_HEIGHT) return false;
+		if (benchBoard[t->Blocks[i].X][t->Blocks[i].Y]) return false;
+	}
+
+	return true;
+}
+
+// Same spawn offsets as GameSpawn, then moved by dx, dy
+
+static void PlaceBlock(Tetrimino *t, int shape, int dx, int dy)
+{
+	int i;
+
+	t->ShapeType = shape;
+	t->PivotIdx = BlockPivotIdx[shape];
+
+	for (i = 0; i < 4; i++)
+	{
+		t->Blocks[i].X = DefaultBlockCoords[shape][i].X - 18 + BOARD_SPAWN_X + dx;
+		t->Blocks[i].Y = DefaultBlockCoords[shape][i].Y - 5 + dy;
+	}
+}
+
+static void BuildBlocks(bool rotatable)
+{
+	int i = 0;
+
+	while (i < BENCH_FIXTURES)
+	{
+		int shape = BenchRandom() % 7;
+
+		if (rotatable && BlockPivotIdx[shape] < 0) continue;
+
+		PlaceBlock(&benchBlocks[i], shape, (int)(BenchRandom() % (BOARD_WIDTH - 2)) - (3 + BOARD_SPAWN_X), 2 + (BenchRandom() % (BOARD_HEIGHT - 2)));
+
+		if (BlockFits(&benchBlocks[i])) i++;
+	}
+
+	Game.Active = benchBlocks[0];
+	benchIdx = 0;
+}
+
+static void SetupRandom(int rotatable)
+{
+	BuildBoard(6, 45, 0);
+	BuildBlocks(rotatable);
+}
+
+static void SetupEmpty(int shape) // Nothing to collide with, every check runs and the ghost falls the full height
+{
+	int i;
+
+	BuildBoard(BOARD_HEIGHT, 0, 0);
+
+	for (i = 0; i < BENCH_FIXTURES; i++)
+	{
+		PlaceBlock(&benchBlocks[i], shape, 0, 8);
+	}
+
+	Game.Active = benchBlocks[0];
+	benchIdx = 0;
+}
+
+static void SetupSpawn(int density) // Block where GameSpawn puts it, like the first frame of a turn
+{
+	int i;
+
+	BuildBoard(6, density, 0);
+
+	for (i = 0; i < BENCH_FIXTURES; i++)
+	{
+		PlaceBlock(&benchBlocks[i], density > 0 ? BenchRandom() % 7 : 0, 0, 0);
+	}
+
+	Game.Active = benchBlocks[0];
+	benchIdx = 0;
+}
+
+static void SetupExplode(int rows)
+{
+	BuildBoard(6, 45, rows);
+}
+
+static void SetupFull(int unused) // Every cell gets a palette entry
+{
+	BuildBoard(0, 100, BOARD_HEIGHT);
+}
+
+// Board cels as DrawGamePlayScreen leaves them, the explosion scale and MARIA flag put back
+
+static void SetupFill(int density)
+{
+	int x, y;
+
+	if (density >= 100) SetupFull(0);
+	else SetupSpawn(density);
+
+	for (x = 0; x < BOARD_WIDTH; x++)
+	{
+		for (y = 0; y < BOARD_HEIGHT; y++)
+		{
+			ClearFlag(cels_GPB[x][y]->ccb_Flags, CCB_MARIA);
+
+			PositionBoardCel(cels_GPB[x][y], x, y);
+			ScaleBoardCel(cels_GPB[x][y]);
+		}
+	}
+
+	DrawGamePlayScreen();
+}
+
+static void SetupMaria(int frame) // Every board cel part way through the four line explosion
+{
+	int x, y;
+
+	SetupFill(100);
+
+	for (x = 0; x < BOARD_WIDTH; x++)
+	{
+		for (y = 0; y < BOARD_HEIGHT; y++)
+		{
+			SetFlag(cels_GPB[x][y]->ccb_Flags, CCB_MARIA);
+
+			cels_GPB[x][y]->ccb_HDX = BLOCK_SCALED(DivSF16(Convert32_F16(12 + (frame * 6)), Convert32_F16(12)) << 4);
+			cels_GPB[x][y]->ccb_VDY = BLOCK_SCALED(DivSF16(Convert32_F16(12 + (frame * 12)), Convert32_F16(12)));
+		}
+	}
+}
+
+static void SetupOverlay(int opacity)
+{
+	if (benchOverlay == NULL) benchOverlay = MemCreateBackdropCel(MEM_TAG_MENUS, 320, 240, MakeRGB15(1, 1, 1), opacity);
+}
+
+static void SetupNumbers(int unused)
+{
+	int i;
+
+	for (i = 0; i < BENCH_FIXTURES; i++)
+	{
+		benchValues[i] = BenchRandom() % 1000000000;
+	}
+}
+
+static void SetupInput(int held) // Pad bits for each tick, either random presses or everything held down
+{
+	int i;
+
+	for (i = 0; i < BENCH_FIXTURES; i++)
+	{
+		benchValues[i] = held ? 0xffe00000 : BenchRandom() & 0xffe00000; // The eleven pad buttons
+	}
+}
+
+/* ----- Operations ----- */
+
+static void NextBlock()
+{
+	Game.Active = benchBlocks[benchIdx++ & (BENCH_FIXTURES - 1)];
+}
+
+static void OpMoveLeft()
+{
+	NextBlock();
+	benchSink = GameCanMove(&Game, -1, 0);
+}
+
+static void OpMoveRight()
+{
+	NextBlock();
+	benchSink = GameCanMove(&Game, 1, 0);
+}
+
+static void OpMoveDown()
+{
+	NextBlock();
+	benchSink = GameCanMove(&Game, 0, 1);
+}
+
+static void OpRotate()
+{
+	NextBlock();
+
+	GameRotate(&Game, false, false);
+}
+
+static void OpGhost() // DrawGamePlayScreen is the board walk plus the guide block drop
+{
+	NextBlock();
+	DrawGamePlayScreen();
+}
+
+static void OpExplode() // Includes restoring the 180 byte board, see board_restore
+{
+	memcpy(Game.Board, benchBoard, sizeof(benchBoard));
+	GameClearLines(&Game);
+	Explode();
+}
+
+static void OpRestore()
+{
+	memcpy(Game.Board, benchBoard, sizeof(benchBoard));
+}
+
+static void OpQueueNext()
+{
+	GameQueueNext(&Game);
+	ShowQueuedBlock(Game.QueuedShape);
+}
+
+static void OpSetNumbers()
+{
+	uint32 i = benchIdx++;
+
+	SetCelNumbers(i % 6, benchValues[i & (BENCH_FIXTURES - 1)]);
+}
+
+static void OpPalette()
+{
+	localMainPalette = benchIdx++ % 6; // Not the easter egg palette
+	ApplySelectedColorPalette();
+}
+
+static void OpFillBoard() // The whole gameplay chain DisplayGameplayScreen hands to DrawCels
+{
+	DrawCels(bitmapItems[0], cels_GPB[0][0]);
+}
+
+static void OpFillOverlay()
+{
+	DrawCels(bitmapItems[0], benchOverlay);
+}
+
+static void OpFillText()
+{
+	drawText(4, 4, "SCORE 0123456789 LINES", bitmapItems[0]);
+}
+
+static void OpInput()
+{
+	InputUpdate(benchValues[benchIdx++ & (BENCH_FIXTURES - 1)], 0, 0);
+}
+
+static GameSnapshot benchSnapshot;
+
+static void SetupSnapshot(int density) // A game in progress, as SaveSnapshot requires
+{
+	SetupSpawn(density);
+
+	GameStarted = true;
+	Game.GameOver = false;
+	ClearingLines = false;
+	AcceptGameInput = true;
+
+	SaveSnapshot(&benchSnapshot);
+}
+
+static void OpSnapshotSave()
+{
+	SaveSnapshot(&benchSnapshot);
+}
+
+static void OpSnapshotRestore()
+{
+	RestoreSnapshot(&benchSnapshot);
+}
+
+static uint32 benchAudioQueued = 0;
+
+static void SetupAudio(int unused)
+{
+	AudioStart();
+}
+
+static void OpAudioQueue()
+{
+	while (AudioPlay(SFX_TICK) == false) Yield();
+
+	benchAudioQueued++;
+}
+
+static int CheckAudio()
+{
+	if (Audio.Thread <= 0) return 0;
+
+	AudioStop();
+
+	printf("BENCH audio queue: %u plays queued, %u ran, %u waits for room, %u out of order\n", benchAudioQueued,
+		Audio.Ran[AUDIO_PLAY], Audio.Full, Audio.Misordered);
+
+	if (Audio.Misordered == 0 && Audio.Ran[AUDIO_PLAY] == benchAudioQueued) return 0;
+
+	printf("BENCH FAIL: the audio thread lost commands or ran them out of order\n");
+
+	return 1;
+}
+
+static BenchCase benchCases[] =
+{
+	{ "move_left_rand", SetupRandom, OpMoveLeft, 0, false },
+	{ "move_left_worst", SetupEmpty, OpMoveLeft, 2, false },
+	{ "move_right_rand", SetupRandom, OpMoveRight, 0, false },
+	{ "move_right_worst", SetupEmpty, OpMoveRight, 2, false },
+	{ "move_down_rand", SetupRandom, OpMoveDown, 0, false },
+	{ "move_down_worst", SetupEmpty, OpMoveDown, 2, false },
+	{ "rotate_rand", SetupRandom, OpRotate, 1, false },
+	{ "rotate_worst", SetupEmpty, OpRotate, 0, false },
+	{ "ghost_rand", SetupSpawn, OpGhost, 45, false },
+	{ "ghost_worst", SetupSpawn, OpGhost, 0, false },
+	{ "board_restore", SetupExplode, OpRestore, 0, false },
+	{ "explode_0", SetupExplode, OpExplode, 0, false },
+	{ "explode_1", SetupExplode, OpExplode, 1, false },
+	{ "explode_2", SetupExplode, OpExplode, 2, false },
+	{ "explode_3", SetupExplode, OpExplode, 3, false },
+	{ "explode_4", SetupExplode, OpExplode, 4, false },
+	{ "queue_next", SetupRandom, OpQueueNext, 0, false },
+	{ "set_numbers", SetupNumbers, OpSetNumbers, 0, false },
+	{ "input_rand", SetupInput, OpInput, 0, false },
+	{ "input_held", SetupInput, OpInput, 1, false },
+	{ "palette_rand", SetupRandom, OpPalette, 0, false },
+	{ "palette_full", SetupFull, OpPalette, 0, false },
+	{ "snapshot_save", SetupSnapshot, OpSnapshotSave, 45, false },
+	{ "snapshot_restore", SetupSnapshot, OpSnapshotRestore, 45, false },
+	{ "audio_queue", SetupAudio, OpAudioQueue, 0, false },
+	{ "fill_board_rand", SetupFill, OpFillBoard, 45, true },
+	{ "fill_board_full", SetupFill, OpFillBoard, 100, true },
+	{ "fill_maria", SetupMaria, OpFillBoard, 7, true },
+	{ "fill_explode_4", SetupExplode, OpExplode, 4, true },
+	{ "fill_overlay90", SetupOverlay, OpFillOverlay, 90, true },
+	{ "fill_text", SetupNumbers, OpFillText, 0, true }
+};
+
+/* ----- Runner ----- */
+
+static double TimeOp(void (*op)(void), uint32 iterations)
+{
+	uint64 t0 = HostNowNS();
+	uint32 i;
+
+	for (i = 0; i < iterations; i++)
+	{
+		op();
+	}
+
+	return (double)(HostNowNS() - t0);
+}
+
+static int CompareDouble(const void *a, const void *b)
+{
+	double da = *(const double *)a, db = *(const double *)b;
+
+	return (da > db) - (da < db);
+}
+
+static void RunCase(BenchCase *bc, int reps, BenchResult *res)
+{
+	double samples[BENCH_MAX_REPS];
+	double sum = 0, sq = 0;
+	uint32 iterations = 1;
+	uint64 pixels;
+	int i;
+
+	benchState = 0x2545f491; // Same fixtures every run
+	HostRaster = bc->Raster;
+	GameInit(&Game, 1);
+
+	Game.QueuedShape = 0; // So the palette cases recolour the preview cels too
+	Game.HeldShape = 1;
+
+	bc->Setup(bc->Arg);
+
+	while (iterations < 0x40000000 && TimeOp(bc->Op, iterations) < BENCH_REP_NS / 2) // Also warms the caches
+	{
+		iterations <<= 1;
+	}
+
+	pixels = Host.PixelsFilled;
+
+	for (i = 0; i < reps; i++)
+	{
+		samples[i] = TimeOp(bc->Op, iterations) / iterations;
+		sum += samples[i];
+	}
+
+	res->Mean = sum / reps;
+
+	for (i = 0; i < reps; i++)
+	{
+		sq += (samples[i] - res->Mean) * (samples[i] - res->Mean);
+	}
+
+	qsort(samples, reps, sizeof(double), CompareDouble);
+
+	res->Median = samples[reps / 2];
+	res->Min = samples[0];
+	res->StdDev = sqrt(sq / reps);
+	res->Pixels = (double)(Host.PixelsFilled - pixels) / ((double)iterations * reps);
+}
+
+static bool LoadBaseline(char *path)
+{
+	FILE *fp = fopen(path, "r");
+	char line[128];
+
+	if (fp == NULL) return false;
+
+	while (fgets(line, sizeof(line), fp) != NULL && baselineCount < BENCH_MAX_BASELINE)
+	{
+		if (strncmp(line, "# recorded on ", 14) == 0)
+		{
+			strncpy(baselineHost, line + 14, BENCH_HOST_CHARS - 1);
+			baselineHost[strcspn(baselineHost, "\r\n")] = 0;
+		}
+
+		if (line[0] == '#') continue;
+
+		if (sscanf(line, "%31s %lf", baseline[baselineCount].Name, &baseline[baselineCount].Best) == 2) baselineCount++;
+	}
+
+	fclose(fp);
+
+	return true;
+}
+
+static void DescribeHost(char *buf, int size) // CPU model, cores and compiler, for the baseline's header
+{
+	FILE *fp = fopen("/proc/cpuinfo", "r");
+	char line[256], *model = "unknown cpu";
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	while (fp != NULL && fgets(line, sizeof(line), fp) != NULL)
+	{
+		if (strncmp(line, "model name", 10) != 0 || strchr(line, ':') == NULL) continue;
+
+		model = strchr(line, ':') + 2;
+		model[strcspn(model, "\r\n")] = 0;
+
+		break;
+	}
+
+	if (fp != NULL) fclose(fp);
+
+	snprintf(buf, size, "%s, %ld cpu%s, gcc %s", model, cpus, cpus == 1 ? "" : "s", __VERSION__);
+}
+
+static bool Regressed(BenchResult *res, BaselineEntry *be, double tolerance)
+{
+	return res->Min > be->Best * (1.0 + tolerance / 100.0) && (res->Min - be->Best) > BENCH_SLACK_NS;
+}
+
+static BaselineEntry *FindBaseline(char *name)
+{
+	int i;
+
+	for (i = 0; i < baselineCount; i++)
+	{
+		if (strcmp(baseline[i].Name, name) == 0) return &baseline[i];
+	}
+
+	return NULL;
+}
+
+static void BenchSetup()
+{
+	initSystem();
+	initGraphics();
+
+	initTools();
+
+	InitNumberCels(6); // Same layout as main, SetCelNumbers and the explode frames use them
+
+	InitNumberCel(0, 10, 99, 0, true);
+	InitNumberCel(1, 10, 147, 0, true);
+	InitNumberCel(2, 10, 195, 0, true);
+	InitNumberCel(3, 237, 99, 0, false);
+	InitNumberCel(4, 237, 147, 0, false);
+	InitNumberCel(5, 237, 195, 0, false);
+
+	loadData();
+
+	ApplySelectedColorPalette();
+
+	initSPORT();
+
+	OptionsPlaySFX = false; // The sound folio isn't opened, Explode would otherwise queue clears
+
+	RenderGameBlocks = true;
+	localShowGuides = true;
+
+	GameInitKeys();
+}
+
+static void Usage()
+{
+	printf("tetrisbench [--root dir] [--reps n] [--only name] [--baseline file] [--write-baseline file] [--tolerance pct]\n");
+
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	BenchResult res;
+	BaselineEntry *be;
+	char host[BENCH_HOST_CHARS];
+	FILE *out = NULL;
+	char *only = NULL, *basePath = NULL, *writePath = NULL;
+	int reps = BENCH_DEFAULT_REPS;
+	double tolerance = BENCH_DEFAULT_TOLERANCE;
+	int i, retry, regressions = 0;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (i + 1 >= argc) Usage();
+		else if (strcmp(argv[i], "--root") == 0) HostDataRoot = argv[++i];
+		else if (strcmp(argv[i], "--reps") == 0) reps = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--only") == 0) only = argv[++i];
+		else if (strcmp(argv[i], "--baseline") == 0) basePath = argv[++i];
+		else if (strcmp(argv[i], "--write-baseline") == 0) writePath = argv[++i];
+		else if (strcmp(argv[i], "--tolerance") == 0) tolerance = atof(argv[++i]);
+		else Usage();
+	}
+
+	if (reps < 1) reps = 1;
+	if (reps > BENCH_MAX_REPS) reps = BENCH_MAX_REPS;
+
+	DescribeHost(host, sizeof(host));
+
+	printf("BENCH host %s\n", host);
+
+	if (basePath != NULL)
+	{
+		if (LoadBaseline(basePath) == false || baselineCount == 0)
+		{
+			printf("BENCH FAIL: no baseline in %s, record one with --write-baseline\n", basePath);
+
+			return 1;
+		}
+
+		printf("BENCH baseline %s, recorded on %s\n", basePath, baselineHost);
+
+		if (strcmp(host, baselineHost) != 0) printf("BENCH note: this isn't the baseline's host, make bench-baseline records one for it\n");
+	}
+
+	if (writePath != NULL)
+	{
+		out = fopen(writePath, "w");
+
+		if (out == NULL)
+		{
+			fprintf(stderr, "can't write %s\n", writePath);
+
+			return 2;
+		}
+
+		fprintf(out, "# recorded on %s\n", host);
+		fprintf(out, "# name best_ns_per_op\n");
+	}
+
+	BenchSetup();
+
+	printf("BENCH %-17s %10s %10s %9s %6s %7s %10s %10s %8s\n", "NAME", "MEDIAN", "MEAN", "STDDEV", "CV%", "PX/OP", "BEST", "BASELINE", "DELTA%");
+
+	for (i = 0; i < (int)(sizeof(benchCases) / sizeof(BenchCase)); i++)
+	{
+		if (only != NULL && strstr(benchCases[i].Name, only) == NULL) continue;
+
+		be = FindBaseline(benchCases[i].Name);
+
+		RunCase(&benchCases[i], reps, &res);
+
+		for (retry = 0; retry < BENCH_RETRIES && be != NULL && Regressed(&res, be, tolerance); retry++)
+		{
+			RunCase(&benchCases[i], reps, &res);
+		}
+
+		printf("BENCH %-17s %10.2f %10.2f %9.2f %6.1f %7.0f %10.2f", benchCases[i].Name, res.Median, res.Mean, res.StdDev,
+			res.Mean > 0 ? (res.StdDev * 100.0) / res.Mean : 0.0, res.Pixels, res.Min);
+
+		if (be != NULL)
+		{
+			double delta = be->Best > 0 ? ((res.Min - be->Best) * 100.0) / be->Best : 0.0;
+			bool regressed = Regressed(&res, be, tolerance);
+
+			printf(" %10.2f %+8.1f%s", be->Best, delta, regressed ? "  REGRESSED" : "");
+
+			if (regressed) regressions++;
+		}
+
+		printf("\n");
+
+		if (out != NULL) fprintf(out, "%s %.3f\n", benchCases[i].Name, res.Min);
+	}
+
+	if (out != NULL) fclose(out);
+
+	if (CheckAudio() != 0) return 1;
+
+	if (regressions > 0)
+	{
+		printf("BENCH FAIL: %d benchmark%s slower than the baseline by more than %.0f%%\n", regressions, regressions == 1 ? "" : "s", tolerance);
+
+		return 1;
+	}
+
+	if (basePath != NULL) printf("BENCH PASS\n");
+
+	return 0;
+}
@@ -0,0 +1,118 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Placement bot, see hostbot.h. Shared by the board simulator and the
+//	game runner, so the placements tetrissim measures are the ones the
+//	host runs of the game play
+//
+
+*/
+
+#include "types.h"
+#include "hostbot.h"
+
+// Weights from the usual four feature placement heuristic, scaled by 100
+
+int BotScoreBoard(GameState *gs, int lines)
+{
+	int x, y, h, lastH = 0, height = 0, holes = 0, bump = 0;
+
+	for (x = 0; x < BOARD_WIDTH; x++)
+	{
+		for (y = 0; y < BOARD_HEIGHT && gs->Board[x][y] == false; y++);
+
+		h = BOARD_HEIGHT - y;
+
+		for (; y < BOARD_HEIGHT; y++)
+		{
+			if (gs->Board[x][y] == false) holes++;
+		}
+
+		height += h;
+
+		if (x > 0) bump += h > lastH ? h - lastH : lastH - h;
+
+		lastH = h;
+	}
+
+	return (76 * lines) - (51 * height) - (36 * holes) - (18 * bump);
+}
+
+bool BotSteer(GameState *gs, int turns, int shift)
+{
+	int i, dir = shift < 0 ? -1 : 1;
+
+	for (i = 0; i < turns; i++)
+	{
+		if (GameRotate(gs, false, false) == false) return false;
+	}
+
+	for (i = 0; i != shift; i += dir)
+	{
+		if (GameShift(gs, dir) == false) return false;
+	}
+
+	return true;
+}
+
+int BotPlacements(GameState *gs, BotPlacement *out)
+{
+	GameState trial;
+	int turns, shift, tick, count = 0;
+
+	for (turns = 0; turns < (gs->Active.PivotIdx < 0 ? 1 : 4); turns++)
+	{
+		for (shift = -(BOARD_WIDTH / 2); shift <= BOARD_WIDTH / 2; shift++)
+		{
+			trial = *gs;
+
+			if (BotSteer(&trial, turns, shift) == false) continue;
+
+			GameHardDrop(&trial);
+
+			while ((tick = GameTick(&trial)) != GAME_TICK_LOCKED && tick != GAME_TICK_OVER);
+
+			if (tick == GAME_TICK_OVER) continue;
+
+			out[count].Turns = turns;
+			out[count].Shift = shift;
+			out[count].Board = trial.BoardHash;
+			out[count].Lines = GameClearLines(&trial);
+			out[count].Score = BotScoreBoard(&trial, out[count].Lines);
+
+			count++;
+		}
+	}
+
+	return count;
+}
+
+int BotBest(BotPlacement *options, int count)
+{
+	int i, best = 0;
+
+	for (i = 1; i < count; i++)
+	{
+		if (options[i].Score > options[best].Score) best = i;
+	}
+
+	return best;
+}
@@ -0,0 +1,449 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Software cel engine. Covers what the game's CCBs use, not the whole of
+//	the hardware:
+//
+//		Coded 1 - 8 bpp through the PLUT, uncoded 8 and 16 bpp, packed rows
+//		and LRFORM (line pair) sources
+//		HDX / HDY / VDX / VDY projection, HDDX / HDDY are ignored
+//		CCB_SKIP / CCB_LAST chaining, LDSIZE / LDPPMP / LDPLUT carry state
+//		down the chain like the hardware does
+//		PIXC: ((primary * MF) >> DF) + secondary, then >> 2D, per channel
+//		CCB_MARIA plots one dot per source pixel at its projected corner
+//		instead of filling the area between corners
+//
+//	Zero pixels are transparent unless CCB_BGND is set
+//
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "host3do.h"
+
+#define CEL_TRANSPARENT 0x10000		// Set on decoded texels that aren't drawn
+#define CEL_MAX_TEXELS (1024 * 1024)
+
+typedef struct CelState		// What LDSIZE, LDPPMP and LDPLUT leave behind for the next cel in the chain
+{
+	int32 HDX, HDY, VDX, VDY;
+	uint32 PIXC;
+	uint16 *PLUT;
+} CelState;
+
+static uint32 *texels = NULL;
+static uint32 texelCap = 0;
+
+static int divShift[4] = { 4, 1, 2, 3 }; // DF field: /16, /2, /4, /8
+
+/* ----- Source decode ----- */
+
+typedef struct BitReader
+{
+	ubyte *Data;
+	uint32 Bit;
+} BitReader;
+
+static uint32 ReadBits(BitReader *br, int count)
+{
+	uint32 v = 0;
+
+	while (count-- > 0)
+	{
+		v = (v << 1) | ((br->Data[br->Bit >> 3] >> (7 - (br->Bit & 7))) & 1);
+		br->Bit++;
+	}
+
+	return v;
+}
+
+static int BppBits(uint32 code)
+{
+	static int bits[8] = { 0, 1, 2, 4, 6, 8, 16, 0 };
+
+	return bits[code & PRE0_BPP_MASK];
+}
+
+static uint32 DecodeTexel(uint32 raw, int bpp, bool coded, uint16 *plut, uint32 flags)
+{
+	uint32 c, idx;
+
+	if (coded)
+	{
+		if (bpp >= 6) idx = raw & 0x1f; // 6 and 8 bpp keep P mode / MPD bits above the index
+		else if (bpp == 4) idx = ((flags & 1) << 4) | raw;
+		else if (bpp == 2) idx = ((flags & 7) << 2) | raw;
+		else idx = ((flags & CCB_PLUTA_MASK) << 1) | raw;
+
+		c = plut != NULL ? plut[idx] : 0;
+	}
+	else if (bpp == 8) // 3:3:2
+	{
+		c = MakeRGB15((((raw >> 5) & 7) * 31) / 7, (((raw >> 2) & 7) * 31) / 7, ((raw & 3) * 31) / 3);
+	}
+	else
+	{
+		c = raw;
+	}
+
+	if ((c & 0x7fff) == 0 && (flags & CCB_BGND) == 0) c |= CEL_TRANSPARENT;
+
+	return c;
+}
+
+// Packed rows: an offset to the next row, then 2 bit type / 6 bit count packets
+
+static void DecodePacked(CCB *ccb, uint16 *plut, int w, int h, int bpp, bool coded)
+{
+	ubyte *row = (ubyte *)ccb->ccb_SourcePtr;
+	BitReader br;
+	uint32 type, count, raw, i, v;
+	int x, y;
+
+	for (y = 0; y < h; y++)
+	{
+		br.Data = row;
+		br.Bit = 0;
+
+		v = ReadBits(&br, bpp >= 8 ? 16 : 8) & (bpp >= 8 ? 0x3ff : 0xff);
+
+		for (x = 0; x < w; x++) texels[(y * w) + x] = CEL_TRANSPARENT;
+
+		x = 0;
+
+		while (x < w)
+		{
+			type = ReadBits(&br, 2);
+			count = ReadBits(&br, 6) + 1;
+
+			if (type == 0) break;
+
+			if (type == 3) raw = DecodeTexel(ReadBits(&br, bpp), bpp, coded, plut, ccb->ccb_Flags);
+
+			for (i = 0; i < count && x < w; i++, x++)
+			{
+				if (type == 1) texels[(y * w) + x] = DecodeTexel(ReadBits(&br, bpp), bpp, coded, plut, ccb->ccb_Flags);
+				else if (type == 3) texels[(y * w) + x] = raw;
+			}
+		}
+
+		row += (v + 2) * 4;
+	}
+}
+
+static void DecodeUnpacked(CCB *ccb, uint16 *plut, int w, int h, int bpp, bool coded, bool lrform)
+{
+	uint32 rowWords = ((bpp >= 8 ? (ccb->ccb_PRE1 & PRE1_WOFFSET10_MASK) >> PRE1_WOFFSET10_SHIFT : ccb->ccb_PRE1 >> PRE1_WOFFSET8_SHIFT)) + 2;
+	BitReader br;
+	int x, y;
+
+	if (bpp == 16) // LoadCel and CreateCel leave these as host endian uint16
+	{
+		uint16 *src = (uint16 *)ccb->ccb_SourcePtr;
+		uint32 stride = rowWords * 2;
+
+		for (y = 0; y < h; y++)
+		{
+			for (x = 0; x < w; x++)
+			{
+				uint32 raw = lrform ? src[((y >> 1) * stride) + (x * 2) + (y & 1)] : src[(y * stride) + x];
+
+				texels[(y * w) + x] = DecodeTexel(raw, bpp, coded, plut, ccb->ccb_Flags);
+			}
+		}
+
+		return;
+	}
+
+	for (y = 0; y < h; y++)
+	{
+		br.Data = (ubyte *)ccb->ccb_SourcePtr + (y * rowWords * 4);
+		br.Bit = 0;
+
+		if (bpp == 8) // Byte aligned, no need to go through the bit reader
+		{
+			for (x = 0; x < w; x++) texels[(y * w) + x] = DecodeTexel(br.Data[x], bpp, coded, plut, ccb->ccb_Flags);
+
+			continue;
+		}
+
+		for (x = 0; x < w; x++)
+		{
+			texels[(y * w) + x] = DecodeTexel(ReadBits(&br, bpp), bpp, coded, plut, ccb->ccb_Flags);
+		}
+	}
+}
+
+/* ----- Pixel processor ----- */
+
+static uint16 Blend(uint32 ppmp, uint32 src, uint32 dst)
+{
+	uint32 primary = (ppmp & 0x8000) ? dst : src;
+	uint32 mf = ((ppmp >> 10) & 7) + 1;
+	int df = divShift[(ppmp >> 8) & 3];
+	uint32 second = (ppmp >> 6) & 3;
+	uint32 av = (ppmp >> 1) & 0x1f;
+	int d2 = ppmp & 1;
+	uint32 out = 0, p, s;
+	int sh;
+
+	for (sh = 10; sh >= 0; sh -= 5)
+	{
+		p = (((primary >> sh) & 0x1f) * mf) >> df;
+
+		switch (second)
+		{
+			case 0: s = 0; break;
+			case 1: s = av; break;
+			case 2: s = (dst >> sh) & 0x1f; break;
+			default: s = (src >> sh) & 0x1f; break;
+		}
+
+		p = (p + s) >> d2;
+
+		if (p > 0x1f) p = 0x1f;
+
+		out |= p << sh;
+	}
+
+	return (uint16)out;
+}
+
+static bool Write(uint16 *fb, uint32 texel, uint32 pixc)
+{
+	uint32 ppmp;
+
+	if (texel & CEL_TRANSPARENT) return false;
+
+	ppmp = (texel & 0x8000) ? (pixc & 0xffff) : (pixc >> 16); // P mode 0 uses the upper half
+
+	*fb = (ppmp == (PIXC_OPAQUE & 0xffff)) ? (uint16)(texel & 0x7fff) : Blend(ppmp, texel & 0x7fff, *fb & 0x7fff);
+
+	return true;
+}
+
+static bool Plot(Bitmap *bm, int x, int y, uint32 texel, uint32 pixc)
+{
+	uint16 *fb;
+
+	if (texel & CEL_TRANSPARENT) return false;
+	if (x < 0 || y < 0 || x >= bm->bm_Width || y >= bm->bm_Height) return false;
+
+	fb = (uint16 *)bm->bm_Buffer + ((y >> 1) * bm->bm_Width * 2) + (x * 2) + (y & 1); // Line pairs share a word
+
+	return Write(fb, texel, pixc);
+}
+
+/* ----- Projection ----- */
+
+static uint32 DrawMaria(Bitmap *bm, CCB *ccb, CelState *cs, int w, int h)
+{
+	double ox = ccb->ccb_XPos / 65536.0, oy = ccb->ccb_YPos / 65536.0;
+	double hx = cs->HDX / 1048576.0, hy = cs->HDY / 1048576.0;
+	double vx = cs->VDX / 65536.0, vy = cs->VDY / 65536.0;
+	uint32 pixels = 0;
+	int u, v;
+
+	for (v = 0; v < h; v++)
+	{
+		for (u = 0; u < w; u++)
+		{
+			if (Plot(bm, (int)floor(ox + (u * hx) + (v * vx)), (int)floor(oy + (u * hy) + (v * vy)), texels[(v * w) + u], cs->PIXC)) pixels++;
+		}
+	}
+
+	return pixels;
+}
+
+// Inverse maps each frame buffer pixel centre inside the projected quad back to a source texel
+
+static uint32 DrawFilled(Bitmap *bm, CCB *ccb, CelState *cs, int w, int h)
+{
+	double ox = ccb->ccb_XPos / 65536.0, oy = ccb->ccb_YPos / 65536.0;
+	double hx = cs->HDX / 1048576.0, hy = cs->HDY / 1048576.0; // HDX / HDY are 12.20
+	double vx = cs->VDX / 65536.0, vy = cs->VDY / 65536.0;
+	double det = (hx * vy) - (vx * hy);
+	double cx[4], cy[4], minX, maxX, minY, maxY, u, v, du, dv;
+	uint32 pixels = 0;
+	int i, x, y, x0, x1, y0, y1, iu, iv;
+
+	if (det == 0) return 0;
+	if (det > 0 && (ccb->ccb_Flags & CCB_ACW) == 0) return 0; // Clockwise on screen
+	if (det < 0 && (ccb->ccb_Flags & CCB_ACCW) == 0) return 0;
+
+	cx[0] = ox;							cy[0] = oy;
+	cx[1] = ox + (w * hx);				cy[1] = oy + (w * hy);
+	cx[2] = ox + (h * vx);				cy[2] = oy + (h * vy);
+	cx[3] = ox + (w * hx) + (h * vx);	cy[3] = oy + (w * hy) + (h * vy);
+
+	minX = maxX = cx[0];
+	minY = maxY = cy[0];
+
+	for (i = 1; i < 4; i++)
+	{
+		if (cx[i] < minX) minX = cx[i];
+		if (cx[i] > maxX) maxX = cx[i];
+		if (cy[i] < minY) minY = cy[i];
+		if (cy[i] > maxY) maxY = cy[i];
+	}
+
+	x0 = (int)floor(minX); x1 = (int)ceil(maxX);
+	y0 = (int)floor(minY); y1 = (int)ceil(maxY);
+
+	if (x0 < 0) x0 = 0;
+	if (y0 < 0) y0 = 0;
+	if (x1 > bm->bm_Width) x1 = bm->bm_Width;
+	if (y1 > bm->bm_Height) y1 = bm->bm_Height;
+
+	du = vy / det; // d(u, v) / dx from the inverse of [hx vx; hy vy]
+	dv = -hy / det;
+
+	if (hy == 0 && vx == 0 && x1 > x0) // Axis aligned: u only depends on x and v only on y
+	{
+		int *cols = (int *)malloc((x1 - x0) * sizeof(int));
+		uint32 *row;
+		uint16 *fb;
+
+		u = (vy * ((x0 + 0.5) - ox)) / det;
+
+		for (x = x0; x < x1; x++, u += du) cols[x - x0] = (u < 0 || (int)u >= w) ? -1 : (int)u;
+
+		for (y = y0; y < y1; y++)
+		{
+			v = (hx * ((y + 0.5) - oy)) / det;
+
+			if (v < 0 || (int)v >= h) continue;
+
+			row = texels + ((int)v * w);
+			fb = (uint16 *)bm->bm_Buffer + ((y >> 1) * bm->bm_Width * 2) + (y & 1); // Already clipped, so no Plot
+
+			for (x = x0; x < x1; x++)
+			{
+				if (cols[x - x0] >= 0 && Write(fb + (x * 2), row[cols[x - x0]], cs->PIXC)) pixels++;
+			}
+		}
+
+		free(cols);
+
+		return pixels;
+	}
+
+	for (y = y0; y < y1; y++)
+	{
+		double px = (x0 + 0.5) - ox, py = (y + 0.5) - oy;
+
+		u = ((vy * px) - (vx * py)) / det;
+		v = ((hx * py) - (hy * px)) / det;
+
+		for (x = x0; x < x1; x++, u += du, v += dv)
+		{
+			if (u < 0 || v < 0) continue;
+
+			iu = (int)u;
+			iv = (int)v;
+
+			if (iu >= w || iv >= h) continue;
+
+			if (Plot(bm, x, y, texels[(iv * w) + iu], cs->PIXC)) pixels++;
+		}
+	}
+
+	return pixels;
+}
+
+/* ----- Chain ----- */
+
+static uint32 DrawCel(Bitmap *bm, CCB *ccb, CelState *cs)
+{
+	uint32 pre0 = ccb->ccb_PRE0, pre1 = ccb->ccb_PRE1;
+	int bpp = BppBits(pre0);
+	bool coded = (pre0 & PRE0_UNCODED) == 0;
+	bool lrform = bpp == 16 && (pre1 & PRE1_LRFORM) != 0;
+	int w = (pre1 & PRE1_TLHPCNT_MASK) + 1;
+	int h = ((pre0 & PRE0_VCNT_MASK) >> PRE0_VCNT_SHIFT) + 1;
+
+	if (bpp == 0 || ccb->ccb_SourcePtr == NULL) return 0;
+
+	if (lrform) h *= 2;
+
+	if ((uint32)(w * h) > texelCap)
+	{
+		if ((uint32)(w * h) > CEL_MAX_TEXELS) return 0;
+
+		free(texels);
+
+		texelCap = w * h;
+		texels = (uint32 *)malloc(texelCap * sizeof(uint32));
+	}
+
+	if (ccb->ccb_Flags & CCB_PACKED) DecodePacked(ccb, cs->PLUT, w, h, bpp, coded);
+	else DecodeUnpacked(ccb, cs->PLUT, w, h, bpp, coded, lrform);
+
+	return (ccb->ccb_Flags & CCB_MARIA) ? DrawMaria(bm, ccb, cs, w, h) : DrawFilled(bm, ccb, cs, w, h);
+}
+
+void HostRasterCels(Bitmap *bm, CCB *ccb)
+{
+	CelState cs;
+	uint32 pixels;
+
+	memset(&cs, 0, sizeof(cs));
+
+	cs.HDX = 1 << 20;
+	cs.VDY = 1 << 16;
+	cs.PIXC = PIXC_OPAQUE;
+
+	while (ccb != NULL)
+	{
+		if (ccb->ccb_Flags & CCB_SKIP) // Nothing is loaded from a skipped CCB either
+		{
+			Host.CelsSkipped++;
+			Host.Frame.CelsSkipped++;
+		}
+		else
+		{
+			if (ccb->ccb_Flags & CCB_LDSIZE)
+			{
+				cs.HDX = ccb->ccb_HDX;
+				cs.HDY = ccb->ccb_HDY;
+				cs.VDX = ccb->ccb_VDX;
+				cs.VDY = ccb->ccb_VDY;
+			}
+
+			if (ccb->ccb_Flags & CCB_LDPPMP) cs.PIXC = ccb->ccb_PIXC;
+			if ((ccb->ccb_Flags & CCB_LDPLUT) && ccb->ccb_PLUTPtr != NULL) cs.PLUT = (uint16 *)ccb->ccb_PLUTPtr;
+
+			pixels = bm != NULL ? DrawCel(bm, ccb, &cs) : 0;
+
+			Host.CelsDrawn++;
+			Host.PixelsFilled += pixels;
+			Host.Frame.CelsDrawn++;
+			Host.Frame.PixelsFilled += pixels;
+		}
+
+		if (ccb->ccb_Flags & CCB_LAST) break;
+
+		ccb = ccb->ccb_NextPtr;
+	}
+}
@@ -0,0 +1,237 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Juggler and score player stand-ins for HD3DOAudioScore.c, see host3do.h.
+//	One collection, one context and one sequence, which is all the score
+//	music makes. Nothing sounds: BumpJuggler counts the events it plays and
+//	how late each was on the score clock, so tetrisscore (hostscore.c) can
+//	check the clock HD3DOAudioScore.c keeps and the cues it sets
+//
+
+*/
+
+#include "host3do.h"
+
+HostScoreStats HostScore;
+COBClass CollectionClass;
+
+static Collection hostCollection;
+static ScoreContext hostContext;
+static bool hostContextUsed = false;
+
+/* ----- Juggler ----- */
+
+int32 InitJuggler()
+{
+	return 0;
+}
+
+int32 TermJuggler()
+{
+	return 0;
+}
+
+void *CreateObject(COBClass *objClass)
+{
+	if (objClass != &CollectionClass || hostCollection.Used) return NULL;
+
+	memset(&hostCollection, 0, sizeof(hostCollection));
+
+	hostCollection.Used = true;
+
+	return &hostCollection;
+}
+
+int32 DestroyObject(void *object)
+{
+	if (object != &hostCollection) return -1;
+
+	hostCollection.Used = false;
+
+	return 0;
+}
+
+int32 GetNthFromObject(void *object, int32 n, void *nth)
+{
+	if (object != &hostCollection || n != 0) return -1;
+
+	*(Sequence **)nth = &hostCollection.Seq;
+
+	return 0;
+}
+
+int32 SetObjectInfo(void *object, TagArg *tags)
+{
+	Sequence *seq = object;
+
+	for (; tags->ta_Tag != TAG_END; tags++)
+	{
+		if (tags->ta_Tag == JGLR_TAG_INTERPRETER_FUNCTION) seq->Interpreter = tags->ta_Arg;
+		else if (tags->ta_Tag == JGLR_TAG_CONTEXT) seq->Context = tags->ta_Arg;
+	}
+
+	return 0;
+}
+
+int32 StartObject(void *object, Time time, int32 reps, void *parent)
+{
+	Collection *col = object;
+
+	if (col != &hostCollection || HostScore.Beat == 0) return -1;
+
+	col->Active = true;
+	col->Start = time;
+	col->Total = HOST_SCORE_EVENTS * (reps > 0 ? reps : 1);
+	col->Next = 0;
+
+	return 0;
+}
+
+int32 StopObject(void *object, Time time)
+{
+	((Collection *)object)->Active = false;
+
+	return 0;
+}
+
+int32 BumpJuggler(Time currentTime, Time *nextTime, int32 currentSignals, int32 *nextSignals)
+{
+	Collection *col = &hostCollection;
+	Time due;
+	uint32 played = 0;
+
+	HostScore.Bumps++;
+
+	*nextSignals = 0;
+
+	if (col->Active == false) return -1;
+
+	while (col->Next < col->Total && (int32)(currentTime - (due = col->Start + (col->Next * HostScore.Beat))) >= 0)
+	{
+		if (currentTime - due > HostScore.LateMax) HostScore.LateMax = currentTime - due;
+
+		col->Next++;
+		played++;
+	}
+
+	HostScore.Played += played;
+
+	if (played == 0) HostScore.IdleBumps++;
+
+	if (col->Next == col->Total)
+	{
+		col->Active = false; // The last one has played
+
+		return -1;
+	}
+
+	*nextTime = col->Start + (col->Next * HostScore.Beat);
+
+	return 0;
+}
+
+/* ----- MIDI files ----- */
+
+Err MFLoadCollection(MIDIFileParser *mfpptr, char *filename, Collection *colPtr)
+{
+	if (colPtr != &hostCollection || mfpptr->mfp_Rate < 4) return -1;
+
+	HostScore.Beat = mfpptr->mfp_Rate / 4;
+
+	return 0;
+}
+
+Err MFUnloadCollection(Collection *colPtr)
+{
+	HostScore.Beat = 0;
+
+	return 0;
+}
+
+/* ----- Score player ----- */
+
+ScoreContext *CreateScoreContext(int32 maxNumPrograms)
+{
+	if (hostContextUsed) return NULL;
+
+	memset(&hostContext, 0, sizeof(hostContext));
+
+	hostContext.scon_MaxPrograms = maxNumPrograms;
+	hostContextUsed = true;
+
+	return &hostContext;
+}
+
+Err DeleteScoreContext(ScoreContext *scon)
+{
+	hostContextUsed = false;
+
+	return 0;
+}
+
+Err InitScoreMixer(ScoreContext *scon, char *mixerName, int32 maxNumVoices, int32 amplitude)
+{
+	scon->scon_MaxVoices = maxNumVoices;
+
+	return 0;
+}
+
+Err TermScoreMixer(ScoreContext *scon)
+{
+	scon->scon_MaxVoices = 0;
+
+	return 0;
+}
+
+Err LoadPIMap(ScoreContext *scon, char *fileName)
+{
+	scon->scon_PIMapLoaded = true;
+
+	return 0;
+}
+
+Err UnloadPIMap(ScoreContext *scon)
+{
+	scon->scon_PIMapLoaded = false;
+
+	return 0;
+}
+
+Err ChangeScoreControl(ScoreContext *scon, int32 channel, int32 index, int32 value)
+{
+	if (channel < 0 || channel >= HOST_SCORE_CHANNELS) return -1;
+
+	if (index == 7) HostScore.Volume[channel] = value;
+
+	return 0;
+}
+
+Err FreeChannelInstruments(ScoreContext *scon, int32 channel)
+{
+	HostScore.Freed++;
+
+	return 0;
+}
+
+Err InterpretMIDIEvent(Sequence *seqPtr, MIDIEvent *mevCur, ScoreContext *scon)
+{
+	return 0;
+}
@@ -0,0 +1,1284 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Host game runner. Drives the unmodified game loop from an input script
+//	or the bot, stops after a number of frames or games and prints the
+//	stand-in call profile. --soak fails the run if memory grows from one
+//	return to the start menu to the next
+//
+//	In a game the bot steers each block to where the placement bot
+//	(hostbot.c) puts it, one press at a time, and drops it there. --noise is
+//	the percent of blocks it puts somewhere random instead, so games end.
+//	Everywhere else it mashes buttons until a game starts. Every run counts
+//	the line clears of each size and the level ups the game made, --cover
+//	fails the run unless there was at least one of each
+//
+//	Frames are rendered by the software cel engine. --dump writes a frame as
+//	a PPM, --write-golden records the CRC of every --golden-every'th frame
+//	and --golden fails the run if any of those frames come out different.
+//	The first clear of each size and the first level up are recorded frame
+//	by frame for HOST_GOLDEN_BURST frames, so the golden file has every
+//	clear animation and a new level's background. --write-golden fails if
+//	the run didn't get to all of them
+//
+//	--record writes the seeds and pad bits the game reads (HD3DOReplay.c) to
+//	a file when the run stops. --replay plays one back with the cel engine
+//	off, as fast as the CPU goes, and fails unless the final board, score,
+//	level and lines match what was recorded
+//
+//	Every gameplay tick's GameHash goes to ReplayTick. --hash-every sets how
+//	often a recording stores it (1 pinpoints a drift to the tick), --hash-log
+//	prints them all, --hash-check compares them against an earlier --hash-log
+//	and stops at the first tick that differs, --hash-verify checks the
+//	incremental hash against a full recompute every tick
+//
+//	--das, --arr and --sdr set the shift delay and repeat and the soft drop
+//	rate in ticks (HD3DOInput.h), 0 for --arr or --sdr slides to the wall or
+//	floor. --input-ms times them on the clock in milliseconds instead, which
+//	a recording can't reproduce. --late-latch reads the pad again just before
+//	the active block's cels are placed (HD3DOInput.h), which can't be recorded
+//	either
+//
+//	--lockstep plays a second GameState on the rules alone next to the game:
+//	started from the same piece seed, given the same button table every tick
+//	HandleInput reads and settled with GameSettle. Its GameHash has to be the
+//	game's at every tick, through every clear and level up, or the run stops
+//	at the first tick that differs
+//
+//	--snapshot-every saves a snapshot (HD3DOSnapshot.h) every n frames of a
+//	game in progress, restores it straight back and fails the run if saving
+//	again gives different bytes
+//
+//	Script lines are "<polls> <buttons>", buttons joined with + or - for none:
+//
+//		60 -
+//		2 START
+//		10 LEFT+A
+//
+//	or "@<field> <buttons>", the pad changes to those buttons at that field of
+//	the stand-in's clock (Host.Fields) however the game's reads fall. Several
+//	lines on one field make a tap shorter than a frame:
+//
+//		@300 LEFT
+//		@300 -
+//
+//	Pad changes reach the game through the stand-in event broker. The run
+//	fails if the presses it sent and the presses the game's button table saw
+//	(HD3DOInput.c) come out different, a press was dropped, or if a button
+//	the script pushed while the game listened didn't go out as a press
+//
+//	Sound goes through the audio thread (HD3DOAudio.c) on a real second
+//	thread. At the end the run stops it, which runs everything still queued,
+//	and fails if a command came off the ring out of order or the stand-in
+//	CallSound didn't see each play, music start and playlist the game queued
+//
+//	--spool-sim plays the music spooler (HD3DOAudioSpool.c) through the
+//	stand-in sound file player instead of running the game: a pass with the
+//	drive to itself, one with a background load holding the drive every few
+//	seconds, the same with the game saying it's busy, then quiet again. It
+//	fails if the underruns the spooler counted aren't the gaps the stand-in
+//	sampler had, if the busy buffers didn't ride out the loads, or if the
+//	buffers didn't shrink back. Then a playlist, quiet, with loads and busy:
+//	every track change has to be one the spooler counted, and none may leave
+//	a gap unless the loads starved the idle buffers
+//
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "host3do.h"
+#include "HD3DOMem.h"
+#include "HD3DOReplay.h"
+#include "HD3DOInput.h"
+#include "HD3DOSnapshot.h"
+#include "HD3DOPerf.h"
+#include "HD3DOAudio.h"
+#include "HD3DOAudioSoundInterface.h"
+#include "HD3DOAudioSpool.h"
+#include "hostbot.h"
+
+#define HOST_MAX_STEPS 4096
+#define HOST_MAX_DUMPS 16
+#define HOST_MAX_GOLDEN 1024
+#define HOST_GOLDEN_BURST 48 // The 3 row clear's animation is the longest, a row every 15 frames
+#define HOST_DEFAULT_FRAMES 36000 // Ten minutes of game time when nothing else says stop
+#define HOST_REPLAY_BYTES (16 * 1024 * 1024)
+#define HOST_REPLAY_SLACK 60 // Frames past the recorded end before a drifted replay gives up
+#define HOST_MAX_HASHES (1024 * 1024)
+#define HOST_SPOOL_LOAD_EVERY (5 * 240) // A background load every 5 seconds holding the drive for 1.5
+#define HOST_SPOOL_LOAD_TICKS 360
+#define HOST_DEFAULT_NOISE 10
+
+typedef struct ScriptStep
+{
+	uint32 Polls;
+	uint32 Field;				// When Timed
+	bool Timed;
+	uint32 Buttons;
+} ScriptStep;
+
+typedef struct GoldenFrame
+{
+	uint32 Frame;
+	uint32 CRC;
+} GoldenFrame;
+
+typedef struct TickHash
+{
+	uint32 Tick;
+	uint32 Hash;
+} TickHash;
+
+typedef struct ButtonName
+{
+	char *Name;
+	uint32 Bits;
+} ButtonName;
+
+static ButtonName buttonNames[] =
+{
+	{ "UP", ControlUp }, { "DOWN", ControlDown }, { "LEFT", ControlLeft }, { "RIGHT", ControlRight },
+	{ "A", ControlA }, { "B", ControlB }, { "C", ControlC }, { "START", ControlStart }, { "X", ControlX },
+	{ "LS", ControlLeftShift }, { "RS", ControlRightShift }
+};
+
+static uint32 botChoices[] = // Outside a game, weighted towards moving pieces, START often enough to get through the menus
+{
+	ControlLeft, ControlLeft, ControlLeft, ControlRight, ControlRight, ControlRight,
+	ControlA, ControlA, ControlC, ControlDown, ControlDown, ControlUp, ControlStart, 0, 0
+};
+
+static ScriptStep script[HOST_MAX_STEPS];
+static int scriptSteps = 0;
+static int scriptIdx = 0;
+static uint32 scriptPolls = 0;
+
+static bool useBot = false;
+static uint32 botState = 0;
+static uint32 botButtons = 0;
+static int botHold = 0;
+static bool botInGame = false;		// Since the first poll of a game, until it's over or the start menu is back
+static int botNoise = HOST_DEFAULT_NOISE;
+
+static uint32 coverClears[5];		// By rows, from Game.Lines between polls
+static uint32 coverLevels = 0;
+static int coverLines = 0;
+static int coverLevel = 0;
+static bool cover = false;
+
+static uint32 maxFrames = 0;
+static int maxGames = 0;
+static bool soak = false;
+
+static uint32 dumpFrames[HOST_MAX_DUMPS];
+static int dumpCount = 0;
+static char *dumpDir = ".";
+
+static bool frameStats = false;
+
+static GoldenFrame golden[HOST_MAX_GOLDEN];
+static int goldenCount = 0;
+static int goldenIdx = 0;
+static int goldenFailed = 0;
+static uint32 goldenEvery = 30;
+static FILE *goldenOut = NULL;
+static uint32 goldenBurst = 0;		// Frames left to record every one of
+static bool goldenSeen[5];			// Clears of 1 to 4 rows by size, a level up at 0
+static int goldenLines = 0;
+static int goldenLevel = 0;
+
+static char *recordPath = NULL;
+static char *replayPath = NULL;
+static bool replayRaster = false;
+static bool finishAtPoll = false;
+static uint64 runStartNS = 0;
+
+static uint32 hashEvery = REPLAY_HASH_EVERY;
+static bool hashVerify = false;
+static int hashVerifyFailed = 0;
+static TickHash *hashCheck = NULL;
+static int hashCheckCount = 0;
+static int hashCheckIdx = 0;
+static bool hashCheckFailed = false;
+
+static bool inputClock = false;
+
+static bool lockstep = false;
+static bool shadowLive = false;		// From the first poll of a game to its game over tick
+static GameState shadow;
+static uint32 shadowTicks = 0;
+static int shadowGames = 0;
+static bool shadowFailed = false;
+
+static uint32 snapshotEvery = 0;
+static int snapshotTrips = 0;
+static int snapshotFailed = 0;
+
+static int lastCheckpoint = 0;
+static uint32 baselineHostBytes = 0;
+static int32 hostGrowth = 0;
+
+int tetris_main();
+
+static uint32 BotRandom()
+{
+	botState ^= botState << 13; // Separate from the game's rand() so the bot doesn't change the piece sequence
+	botState ^= botState >> 17;
+	botState ^= botState << 5;
+
+	return botState;
+}
+
+static uint32 ParseButtons(char *text)
+{
+	uint32 bits = 0;
+	char *tok;
+	int i;
+
+	for (tok = strtok(text, "+"); tok != NULL; tok = strtok(NULL, "+"))
+	{
+		for (i = 0; i < (int)(sizeof(buttonNames) / sizeof(ButtonName)); i++)
+		{
+			if (strcmp(tok, buttonNames[i].Name) == 0) bits |= buttonNames[i].Bits;
+		}
+	}
+
+	return bits;
+}
+
+static bool LoadScript(char *path)
+{
+	FILE *fp = fopen(path, "r");
+	char line[256], buttons[128];
+	unsigned polls;
+	bool timed;
+
+	if (fp == NULL) return false;
+
+	while (fgets(line, sizeof(line), fp) != NULL && scriptSteps < HOST_MAX_STEPS)
+	{
+		if (line[0] == '#') continue;
+
+		timed = line[0] == '@';
+
+		if (sscanf(line + timed, "%u %127s", &polls, buttons) != 2) continue;
+
+		script[scriptSteps].Timed = timed;
+		script[scriptSteps].Polls = timed ? 0 : polls;
+		script[scriptSteps].Field = timed ? polls : 0;
+		script[scriptSteps].Buttons = ParseButtons(buttons);
+		scriptSteps++;
+	}
+
+	fclose(fp);
+
+	return true;
+}
+
+static bool LoadGolden(char *path)
+{
+	FILE *fp = fopen(path, "r");
+	char line[128];
+	unsigned frame, crc;
+
+	if (fp == NULL) return false;
+
+	while (fgets(line, sizeof(line), fp) != NULL && goldenCount < HOST_MAX_GOLDEN)
+	{
+		if (line[0] == '#') continue;
+
+		if (sscanf(line, "%u %x", &frame, &crc) != 2) continue;
+
+		golden[goldenCount].Frame = frame;
+		golden[goldenCount].CRC = crc;
+		goldenCount++;
+	}
+
+	fclose(fp);
+
+	return true;
+}
+
+static bool LoadReplay(char *path)
+{
+	FILE *fp = fopen(path, "rb");
+	ubyte *data;
+	long size;
+
+	if (fp == NULL) return false;
+
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	data = (ubyte *)malloc(size > 0 ? size : 1);
+
+	if (data == NULL || fread(data, 1, size, fp) != (size_t)size || ReplayStartPlayback(data, size) == false)
+	{
+		fclose(fp);
+		free(data);
+
+		return false;
+	}
+
+	fclose(fp);
+
+	return true;
+}
+
+static void SaveReplay()
+{
+	FILE *fp;
+
+	ReplayFinish(Host.Frames);
+
+	if ((fp = fopen(recordPath, "wb")) == NULL || fwrite(Replay.Data, 1, Replay.Size, fp) != Replay.Size)
+	{
+		fprintf(stderr, "can't write %s\n", recordPath);
+	}
+	else
+	{
+		printf("REPLAY wrote %s: %u bytes, %u ticks, %u runs, %u taps, %u seeds, %u checks, %u hashes%s\n", recordPath, Replay.Size,
+			Replay.EndTicks, Replay.Runs, Replay.Taps, Replay.Seeds, Replay.Checks, Replay.Hashes, Replay.Overflow ? ", OVERFLOW (input after the buffer filled is lost)" : "");
+	}
+
+	if (fp != NULL) fclose(fp);
+}
+
+static int CheckReplay()
+{
+	ReplayCheck now;
+	double secs = (HostNowNS() - runStartNS) / 1e9;
+	bool pass = ReplayVerify() && Host.Frames == Replay.EndMark;
+
+	ReplayLast(&now);
+
+	printf("REPLAY frames %u / %u, ticks %u / %u, checks %u, score %u / %u, level %u / %u, lines %u / %u, board %08x / %08x\n",
+		Host.Frames, Replay.EndMark, Replay.Ticks, Replay.EndTicks, Replay.Checks,
+		now.Score, Replay.EndCheck.Score, now.Level, Replay.EndCheck.Level, now.Lines, Replay.EndCheck.Lines, now.Board, Replay.EndCheck.Board);
+
+	printf("REPLAY %.1f minutes of game time in %.2fs (%.0fx)\n", Host.Frames / 3600.0, secs, secs > 0 ? (Host.Frames / 60.0) / secs : 0);
+
+	if (pass == false)
+	{
+		if (Replay.Mismatches == 0) printf("REPLAY FAIL\n");
+		else if (Replay.HashEvery == 1 || Replay.FirstMismatchTick == Replay.LastHashTick + 1) printf("REPLAY FAIL: drifted at tick %u\n", Replay.FirstMismatchTick);
+		else printf("REPLAY FAIL: drifted after tick %u, by tick %u\n", Replay.LastHashTick, Replay.FirstMismatchTick);
+
+		return 1;
+	}
+
+	printf("REPLAY PASS\n");
+
+	return 0;
+}
+
+static bool LoadHashLog(char *path)
+{
+	FILE *fp = fopen(path, "r");
+	char line[128];
+	unsigned tick, hash;
+
+	if (fp == NULL) return false;
+
+	hashCheck = (TickHash *)malloc(HOST_MAX_HASHES * sizeof(TickHash));
+
+	while (hashCheck != NULL && fgets(line, sizeof(line), fp) != NULL && hashCheckCount < HOST_MAX_HASHES)
+	{
+		if (sscanf(line, "HASH %u %x", &tick, &hash) != 2) continue; // Anything else the other run printed
+
+		hashCheck[hashCheckCount].Tick = tick;
+		hashCheck[hashCheckCount].Hash = hash;
+		hashCheckCount++;
+	}
+
+	fclose(fp);
+
+	return hashCheckCount > 0;
+}
+
+static uint32 BotMash()
+{
+	if (botHold-- <= 0) // Alternate holds and releases so the edge triggered inputs fire
+	{
+		if (botButtons != 0)
+		{
+			botButtons = 0;
+			botHold = 1 + (BotRandom() % 3);
+		}
+		else
+		{
+			botButtons = botChoices[BotRandom() % (sizeof(botChoices) / sizeof(uint32))];
+			botHold = 1 + (BotRandom() % 8);
+		}
+	}
+
+	return botButtons;
+}
+
+static uint32 BotMix(uint32 v)
+{
+	v ^= v >> 16;
+	v *= 0x7feb352d;
+	v ^= v >> 15;
+	v *= 0x846ca68b;
+	v ^= v >> 16;
+
+	return v;
+}
+
+// Re-planned from Game at every press, so it needs nothing but the board. The
+// placement is picked by the board it leaves, not the moves to it, which are
+// counted from wherever the block has got to. The same block in the same
+// spot always gets the same answer, noise included
+
+static uint32 BotSteerPress()
+{
+	BotPlacement options[BOT_MAX_PLACEMENTS];
+	uint32 block = BotMix(Game.BoardHash ^ Game.Pieces.Rng.S ^ ((uint32)Game.Pieces.Head << 24) ^ HostRandomSeed);
+	int i, pick = 0, count = BotPlacements(&Game, options);
+
+	if (count == 0) return ControlUp;
+
+	if ((int)(block % 100) < botNoise)
+	{
+		for (i = 1; i < count; i++)
+		{
+			if (BotMix(options[i].Board ^ block) < BotMix(options[pick].Board ^ block)) pick = i;
+		}
+	}
+	else
+	{
+		pick = BotBest(options, count);
+
+		for (i = 0; i < count; i++)
+		{
+			if (options[i].Score == options[pick].Score && options[i].Board < options[pick].Board) pick = i;
+		}
+	}
+
+	if (options[pick].Turns == 3) return ControlA;
+	if (options[pick].Turns > 0) return ControlC;
+	if (options[pick].Shift < 0) return ControlLeft;
+	if (options[pick].Shift > 0) return ControlRight;
+
+	return ControlUp;
+}
+
+static uint32 BotPad()
+{
+	GameSnapshot snap;
+
+	if (SaveSnapshot(&snap) == false)
+	{
+		if (Game.GameOver) botInGame = false;
+
+		return botInGame ? 0 : BotMash(); // Nothing during a clear, it would land on the next block
+	}
+
+	botInGame = true;
+
+	if (botButtons != 0) return botButtons = 0; // Every press is let go before the next
+
+	botButtons = (snap.Flags & SNAP_PAUSED) ? ControlStart : BotSteerPress();
+
+	return botButtons;
+}
+
+// Whatever is driving the game, script, bot or recording
+
+static void CountClears()
+{
+	int rows = Game.Lines - coverLines;
+
+	if (rows > 0 && rows <= 4) coverClears[rows]++;
+	if (Game.Level > coverLevel && coverLevel > 0) coverLevels++;
+
+	coverLines = Game.Lines;
+	coverLevel = Game.Level;
+}
+
+static int CheckCover()
+{
+	printf("HOST clears 1:%u 2:%u 3:%u 4:%u, level ups %u\n", coverClears[1], coverClears[2], coverClears[3], coverClears[4], coverLevels);
+
+	if (cover == false) return 0;
+
+	if (coverClears[1] && coverClears[2] && coverClears[3] && coverClears[4] && coverLevels)
+	{
+		printf("COVER PASS\n");
+
+		return 0;
+	}
+
+	printf("COVER FAIL: the run needs a clear of every size and a level up\n");
+
+	return 1;
+}
+
+static void HostFinish();
+
+// The game's first poll comes before its first tick, GameStart has dealt the blocks by then
+
+static void StartShadow()
+{
+	GameSnapshot snap;
+
+	if (shadowLive || SaveSnapshot(&snap) == false) return;
+
+	if (shadowGames == 0)
+	{
+		GameInit(&shadow, HostRandom);
+	}
+	else
+	{
+		GameReset(&shadow); // The generator carries on, as the game's does
+	}
+
+	GameStart(&shadow);
+
+	shadowLive = true;
+
+	if (GameHash(&shadow) != GameHash(&Game))
+	{
+		printf("LOCKSTEP game %d starts at %08x, the rules alone at %08x\n", shadowGames + 1, GameHash(&Game), GameHash(&shadow));
+
+		shadowFailed = true;
+
+		HostFinish();
+	}
+}
+
+// HandleInput's calls on the rules, in its order. AllowShiftToRotate is always set
+
+static void StepShadow(uint32 tick, uint32 hash)
+{
+	GameSnapshot snap;
+	int i, result;
+
+	if (shadowLive == false) return;
+
+	if (SaveSnapshot(&snap) && (snap.Flags & SNAP_PAUSED)) return; // Paused or pausing, nothing moved
+
+	if (InputPressed(INPUT_LS) && shadow.CanHold) GameHold(&shadow);
+	if (InputPressed(INPUT_RS)) GameSwapQueue(&shadow);
+	if (InputFires(INPUT_A)) GameRotate(&shadow, true, true);
+	if (InputFires(INPUT_C)) GameRotate(&shadow, false, true);
+	if (InputFires(INPUT_UP)) GameHardDrop(&shadow);
+
+	for (i = 0; i < InputFires(INPUT_DOWN); i++)
+	{
+		if (GameMoveDown(&shadow) == false)
+		{
+			if (InputPressed(INPUT_DOWN)) shadow.Gravity = shadow.Speed;
+
+			break;
+		}
+	}
+
+	for (i = 0; i < InputFires(INPUT_LEFT) && GameShift(&shadow, -1); i++);
+	for (i = 0; i < InputFires(INPUT_RIGHT) && GameShift(&shadow, 1); i++);
+
+	result = GameTick(&shadow);
+
+	if (result == GAME_TICK_LOCKED) GameSettle(&shadow);
+
+	shadowTicks++;
+
+	if (GameHash(&shadow) != hash)
+	{
+		printf("LOCKSTEP first difference at tick %u: the game %08x, the rules alone %08x (score %d / %d, lines %d / %d)\n",
+			tick, hash, GameHash(&shadow), Game.Score, shadow.Score, Game.Lines, shadow.Lines);
+
+		shadowFailed = true;
+
+		HostFinish();
+	}
+
+	if (result == GAME_TICK_OVER)
+	{
+		shadowLive = false;
+		shadowGames++;
+	}
+}
+
+static void HashHook(uint32 tick, uint32 hash)
+{
+	uint32 full;
+
+	if (lockstep) StepShadow(tick, hash);
+
+	if (hashVerify && (full = GameFullHash(&Game)) != hash)
+	{
+		if (hashVerifyFailed++ == 0) printf("HASH tick %u: incremental %08x, recomputed %08x\n", tick, hash, full);
+	}
+
+	if (hashCheck == NULL || hashCheckIdx >= hashCheckCount) return;
+
+	if (hashCheck[hashCheckIdx].Tick != tick || hashCheck[hashCheckIdx].Hash != hash)
+	{
+		printf("HASH first difference at tick %u: %08x, the log has tick %u %08x\n",
+			tick, hash, hashCheck[hashCheckIdx].Tick, hashCheck[hashCheckIdx].Hash);
+
+		hashCheckFailed = true;
+
+		HostFinish();
+	}
+
+	hashCheckIdx++;
+}
+
+static void CheckSnapshot()
+{
+	GameSnapshot a, b;
+
+	if (SaveSnapshot(&a) == false) return; // Not between ticks of a game
+
+	snapshotTrips++;
+
+	if (RestoreSnapshot(&a) == false || SaveSnapshot(&b) == false || memcmp(&a, &b, sizeof(GameSnapshot)) != 0)
+	{
+		printf("SNAPSHOT frame %u doesn't round trip\n", Host.Frames);
+
+		snapshotFailed++;
+	}
+}
+
+static void DumpFrame(char *prefix)
+{
+	char path[512];
+
+	snprintf(path, sizeof(path), "%s/%s%06u.ppm", dumpDir, prefix, Host.Frames);
+
+	if (HostWriteFramePPM(path)) printf("HOST wrote %s\n", path);
+	else fprintf(stderr, "can't write %s\n", path);
+}
+
+static int CheckPresses()
+{
+	InputQueue *q = &Input.Queue;
+	uint32 i, b, bits = q->Bits, queued = 0, slow = q->Events;
+
+	for (i = 0; i < q->Count; i++) // Still in the ring, sent but not read yet
+	{
+		InputEvent *e = &q->Ring[(q->Head + i) & (INPUT_QUEUE_EVENTS - 1)];
+
+		for (b = e->Bits & ~bits; b != 0; b &= b - 1) queued++;
+
+		bits = e->Bits;
+	}
+
+	for (i = 0; i < 3; i++) slow -= q->Latency[i];
+
+	printf("INPUT events %u, presses sent %u, read %u, queued %u, fired %u, taps %u, fields waited 0:%u 1:%u 2:%u 3+:%u\n",
+		Host.PadEvents, Host.PadPresses, q->Presses, queued, Input.Presses, q->Taps, q->Latency[0], q->Latency[1], q->Latency[2], slow);
+
+	printf("INPUT press to display in fields, last %d presses: p50 %u, p95 %u, max %u%s\n", Perf.Channels[PERF_PHOTON].WindowCount,
+		PerfPercentile(PERF_PHOTON, 50) / PERF_VSYNC_US, PerfPercentile(PERF_PHOTON, 95) / PERF_VSYNC_US,
+		Perf.Channels[PERF_PHOTON].PeakUS / PERF_VSYNC_US, Input.LateLatch ? ", late latched" : "");
+
+	if (Host.PadPresses < Host.PadPushes)
+	{
+		printf("INPUT FAIL: %u buttons pushed, only %u sent as presses\n", Host.PadPushes, Host.PadPresses);
+
+		return 1;
+	}
+
+	if (Host.PadPresses != q->Presses + queued || q->Presses != Input.Presses || q->Overflows > 0)
+	{
+		printf("INPUT FAIL: presses dropped, %u events overflowed the ring\n", q->Overflows);
+
+		return 1;
+	}
+
+	return 0;
+}
+
+static int CheckAudio()
+{
+	uint32 queued = Audio.Head;
+
+	AudioStop(); // Whatever is still queued runs first
+
+	printf("AUDIO queued %u, ran %u plays, %u music starts, %u playlists, %u stops, %u tempo changes, dropped %u, out of order %u\n",
+		queued, Audio.Ran[AUDIO_PLAY], Audio.Ran[AUDIO_MUSIC_START], Audio.Ran[AUDIO_MUSIC_PLAYLIST], Audio.Ran[AUDIO_MUSIC_STOP],
+		Audio.Ran[AUDIO_MUSIC_TEMPO], Audio.Full, Audio.Misordered);
+
+	printf("AUDIO SFX flushes to the queue, last %d: p50 %u us, p95 %u us, worst %u us\n", Perf.Channels[PERF_SFX].WindowCount,
+		PerfPercentile(PERF_SFX, 50), PerfPercentile(PERF_SFX, 95), Perf.Channels[PERF_SFX].PeakUS);
+
+	printf("AUDIO %u frames, effects coalesced %u, rate limited %u, capped %u\n", Audio.Frame, Audio.Coalesced, Audio.RateLimited, Audio.Capped);
+
+	if (Audio.Misordered > 0 || Audio.Tail != queued + 1 || Audio.Ran[AUDIO_PLAY] != Host.SoundCommands[kStartRAMSound] ||
+		Audio.Ran[AUDIO_MUSIC_START] != Host.SoundCommands[kSpoolSound] ||
+		Audio.Ran[AUDIO_MUSIC_PLAYLIST] != Host.SoundCommands[kSpoolPlaylist])
+	{
+		printf("AUDIO FAIL: commands lost or run out of order\n");
+
+		return 1;
+	}
+
+	return 0;
+}
+
+static void HostFinish()
+{
+	int status = 0;
+
+	status |= CheckAudio(); // Before the report so the sound counts are final
+
+	HostReport();
+	MemReport();
+
+	if (goldenOut != NULL)
+	{
+		fclose(goldenOut);
+
+		if (goldenSeen[0] && goldenSeen[1] && goldenSeen[2] && goldenSeen[3] && goldenSeen[4])
+		{
+			printf("GOLDEN wrote every clear animation and a level up\n");
+		}
+		else
+		{
+			printf("GOLDEN FAIL: the run needs a clear of every size and a level up to record\n");
+
+			status = 1;
+		}
+	}
+
+	if (snapshotEvery > 0)
+	{
+		if (snapshotFailed > 0 || snapshotTrips == 0)
+		{
+			printf("SNAPSHOT FAIL: %d of %d round trips differ\n", snapshotFailed, snapshotTrips);
+
+			status = 1;
+		}
+		else
+		{
+			printf("SNAPSHOT PASS (%d round trips, %u bytes each)\n", snapshotTrips, (uint32)sizeof(GameSnapshot));
+		}
+	}
+
+	if (hashVerify)
+	{
+		if (hashVerifyFailed > 0) printf("HASH VERIFY FAIL: %d ticks\n", hashVerifyFailed);
+		else printf("HASH VERIFY PASS\n");
+
+		if (hashVerifyFailed > 0) status = 1;
+	}
+
+	if (hashCheck != NULL)
+	{
+		if (hashCheckFailed || hashCheckIdx < hashCheckCount)
+		{
+			printf("HASH CHECK FAIL: %d of %d ticks matched\n", hashCheckIdx, hashCheckCount);
+
+			status = 1;
+		}
+		else
+		{
+			printf("HASH CHECK PASS (%d ticks)\n", hashCheckCount);
+		}
+	}
+
+	status |= CheckCover();
+
+	if (lockstep)
+	{
+		if (shadowFailed || shadowTicks == 0)
+		{
+			printf("LOCKSTEP FAIL\n");
+
+			status = 1;
+		}
+		else
+		{
+			printf("LOCKSTEP PASS (%u ticks, %d games over)\n", shadowTicks, shadowGames);
+		}
+	}
+
+	if (recordPath != NULL) SaveReplay();
+	if (replayPath != NULL) status |= CheckReplay();
+	else status |= CheckPresses();
+
+	if (goldenCount > 0)
+	{
+		if (goldenFailed > 0 || goldenIdx < goldenCount)
+		{
+			printf("GOLDEN FAIL: %d of %d frames differ, %d not reached\n", goldenFailed, goldenCount, goldenCount - goldenIdx);
+
+			status = 1;
+		}
+		else
+		{
+			printf("GOLDEN PASS (%d frames)\n", goldenCount);
+		}
+	}
+
+	printf("HOST games %d, leak checkpoints %d, outstanding %d, tracked growth %d, heap growth %d\n",
+		MemLeaks.Checkpoints > 0 ? MemLeaks.Checkpoints - 1 : 0, MemLeaks.Checkpoints, MemLeaks.Outstanding, MemGrowthBytes(), hostGrowth);
+
+	if (soak)
+	{
+		if (MemLeaks.Outstanding > 0 || MemGrowthBytes() != 0 || hostGrowth != 0)
+		{
+			printf("SOAK FAIL\n");
+
+			status = 1;
+		}
+		else
+		{
+			printf("SOAK PASS\n");
+		}
+	}
+
+	fflush(stdout);
+
+	exit(status);
+}
+
+// Each MemCheckpoint is a return to the start menu. The stand-in heap is compared
+// at the first poll after each one, the start menu has been built by then every time
+
+static void CheckRound()
+{
+	if (MemLeaks.Checkpoints == lastCheckpoint) return;
+
+	lastCheckpoint = MemLeaks.Checkpoints;
+	botInGame = false;
+
+	if (lastCheckpoint == 1)
+	{
+		baselineHostBytes = Host.LiveBytes;
+	}
+	else
+	{
+		hostGrowth = (int32)Host.LiveBytes - (int32)baselineHostBytes;
+	}
+
+	if (maxGames > 0 && lastCheckpoint > maxGames) HostFinish();
+}
+
+int HostPollPad(HostPadEvent *events)
+{
+	int count = 0;
+
+	CheckRound();
+	CountClears();
+
+	if (lockstep) StartShadow();
+
+	// Recordings end at a poll so playback can stop at exactly the same tick
+
+	if (finishAtPoll || (replayPath != NULL && Replay.Ticks >= Replay.EndTicks)) HostFinish();
+
+	events[0].Field = Host.Fields;
+
+	if (scriptIdx < scriptSteps && script[scriptIdx].Timed)
+	{
+		while (scriptIdx < scriptSteps && script[scriptIdx].Timed && script[scriptIdx].Field <= Host.Fields && count < HOST_PAD_EVENTS)
+		{
+			events[count].Bits = script[scriptIdx].Buttons;
+			events[count].Field = script[scriptIdx].Field;
+
+			count++;
+			scriptIdx++;
+		}
+
+		return count;
+	}
+
+	if (scriptIdx < scriptSteps)
+	{
+		events[0].Bits = script[scriptIdx].Buttons;
+
+		if (++scriptPolls >= script[scriptIdx].Polls)
+		{
+			scriptIdx++;
+			scriptPolls = 0;
+		}
+
+		return 1;
+	}
+
+	if (useBot == false) HostFinish(); // Script ran out
+
+	events[0].Bits = BotPad();
+
+	return 1;
+}
+
+static void GoldenBurst()
+{
+	int rows = Game.Lines - goldenLines;
+
+	if (goldenBurst > 0) goldenBurst--;
+
+	if (rows > 0 && rows <= 4 && goldenSeen[rows] == false) // Lines goes up before the animation's first frame
+	{
+		goldenSeen[rows] = true;
+		goldenBurst = HOST_GOLDEN_BURST;
+	}
+
+	if (Game.Level > goldenLevel && goldenLevel > 0 && goldenSeen[0] == false)
+	{
+		goldenSeen[0] = true;
+		goldenBurst = HOST_GOLDEN_BURST;
+	}
+
+	goldenLines = Game.Lines;
+	goldenLevel = Game.Level;
+}
+
+void HostFrameDone()
+{
+	int i;
+	uint32 crc;
+
+	if (frameStats)
+	{
+		printf("FRAME %6u cels %3u skipped %3u pixels %6u\n", Host.Frames,
+			Host.LastFrame.CelsDrawn, Host.LastFrame.CelsSkipped, Host.LastFrame.PixelsFilled);
+	}
+
+	for (i = 0; i < dumpCount; i++)
+	{
+		if (dumpFrames[i] == Host.Frames) DumpFrame("frame");
+	}
+
+	GoldenBurst();
+
+	if (goldenOut != NULL && ((Host.Frames % goldenEvery) == 0 || goldenBurst > 0))
+	{
+		fprintf(goldenOut, "%u %08x\n", Host.Frames, HostFrameCRC());
+	}
+
+	if (snapshotEvery > 0 && (Host.Frames % snapshotEvery) == 0) CheckSnapshot();
+
+	if (goldenIdx < goldenCount && golden[goldenIdx].Frame == Host.Frames)
+	{
+		crc = HostFrameCRC();
+
+		if (crc != golden[goldenIdx].CRC)
+		{
+			printf("GOLDEN frame %u: crc %08x, expected %08x\n", Host.Frames, crc, golden[goldenIdx].CRC);
+
+			DumpFrame("golden_fail_");
+
+			goldenFailed++;
+		}
+
+		goldenIdx++;
+	}
+
+	if (maxFrames > 0 && Host.Frames >= maxFrames)
+	{
+		if (recordPath != NULL) finishAtPoll = true;
+		else HostFinish();
+	}
+}
+
+static char *spoolOneTrack[] = { "music/tetrismono.aiff", NULL };
+static char *spoolPlaylist[] = { "music/track1.aiff", "music/track2.aiff", "music/track3.aiff", NULL };
+
+static int SpoolPass(char *name, char **tracks, int32 reps, bool loads, bool busy)
+{
+	uint32 gaps = HostDrive.Gaps, waits = HostDrive.ReadWaits, trackGaps = HostDrive.TrackGaps, silent = HostDrive.SilentTracks;
+	int status = 0, i;
+
+	HostDrive.LoadEvery = loads ? HOST_SPOOL_LOAD_EVERY : 0;
+	HostDrive.LoadTicks = HOST_SPOOL_LOAD_TICKS;
+
+	SpoolBusy(busy);
+	SpoolResetStats();
+	SpoolPlayTracks(tracks, reps, 0x7fff, -1, 0);
+
+	gaps = HostDrive.Gaps - gaps;
+	trackGaps = HostDrive.TrackGaps - trackGaps;
+	silent = HostDrive.SilentTracks - silent;
+
+	printf("SPOOL %-14s %d x %dK buffers, %3u services, underruns %u (sampler gaps %u), reads waited %u, service avg %u ms peak %u ms\n",
+		name, Spool.Buffers, Spool.BufferSize / 1024, Spool.Services, Spool.Underruns, gaps, HostDrive.ReadWaits - waits,
+		(Spool.ServiceTicks * 1000) / (240 * (Spool.Services ? Spool.Services : 1)), (Spool.ServicePeak * 1000) / 240);
+
+	printf("SPOOL %-14s services by buffers left queued:", "");
+
+	for (i = 0; i <= Spool.Buffers && i < SPOOL_FILL_LEVELS; i++)
+	{
+		printf(" %d:%u", i, Spool.Fill[i]);
+	}
+
+	printf("\n");
+
+	if (Spool.Passes > 1)
+	{
+		printf("SPOOL %-14s %u tracks, %u changes, %u late (gaps between tracks %u)\n", "", Spool.Passes, Spool.Changes,
+			Spool.LateChanges, trackGaps);
+	}
+
+	if (Spool.Underruns != gaps)
+	{
+		printf("SPOOL FAIL: %s counted %u underruns, the sampler ran dry %u times\n", name, Spool.Underruns, gaps);
+
+		status = 1;
+	}
+
+	if (Spool.LateChanges != trackGaps || Spool.Changes + 1 != Spool.Passes)
+	{
+		printf("SPOOL FAIL: %s counted %u late changes of %u, the next track started late %u times\n", name, Spool.LateChanges,
+			Spool.Changes, trackGaps);
+
+		status = 1;
+	}
+
+	if (silent > 0)
+	{
+		printf("SPOOL FAIL: %s started %u tracks at amplitude 0 with no envelope to bring them up\n", name, silent);
+
+		status = 1;
+	}
+
+	if (MemTags[MEM_TAG_MUSIC].LiveBytes != (uint32)(Spool.Buffers * Spool.BufferSize))
+	{
+		printf("SPOOL FAIL: %s tracks %u bytes for %d buffers\n", name, MemTags[MEM_TAG_MUSIC].LiveBytes, Spool.Buffers);
+
+		status = 1;
+	}
+
+	return status;
+}
+
+static int SpoolSim()
+{
+	int status = 0;
+
+	MemTrack(MEM_TAG_MUSIC, &Spool, 0); // This thread stands in for the game's, see AudioStart
+
+	SpoolCreatePlayer();
+
+	status |= SpoolPass("quiet", spoolOneTrack, 1, false, false);
+
+	if (Spool.Underruns > 0) printf("SPOOL FAIL: idle buffers underran with the drive to themselves\n"), status = 1;
+
+	status |= SpoolPass("loads", spoolOneTrack, 1, true, false);
+
+	if (Spool.Underruns == 0) printf("SPOOL FAIL: the loads never starved the idle buffers, the pass tests nothing\n"), status = 1;
+
+	status |= SpoolPass("loads busy", spoolOneTrack, 1, true, true);
+
+	if (Spool.Underruns > 0) printf("SPOOL FAIL: busy buffers underran\n"), status = 1;
+
+	status |= SpoolPass("quiet again", spoolOneTrack, 1, false, false);
+
+	if (Spool.Buffers != Spool.IdleBuffers) printf("SPOOL FAIL: %d buffers after going quiet, not %d\n", Spool.Buffers, Spool.IdleBuffers), status = 1;
+
+	status |= SpoolPass("playlist", spoolPlaylist, 2, false, false);
+
+	if (Spool.Passes != 6 || Spool.LateChanges > 0) printf("SPOOL FAIL: the playlist didn't play twice through without a gap\n"), status = 1;
+
+	status |= SpoolPass("playlist loads", spoolPlaylist, 2, true, false);
+	status |= SpoolPass("playlist busy", spoolPlaylist, 2, true, true);
+
+	if (Spool.LateChanges > 0 || Spool.Underruns > 0) printf("SPOOL FAIL: busy buffers left a gap in the playlist\n"), status = 1;
+
+	SpoolDeletePlayer();
+
+	if (MemTags[MEM_TAG_MUSIC].LiveBytes != 0) printf("SPOOL FAIL: %u bytes still tracked\n", MemTags[MEM_TAG_MUSIC].LiveBytes), status = 1;
+
+	MemUntrack(&Spool);
+
+	printf(status ? "SPOOL FAIL\n" : "SPOOL PASS\n");
+
+	return status;
+}
+
+static void Usage()
+{
+	printf("tetrishost [--root dir] [--script file] [--bot] [--noise pct] [--seed n] [--frames n] [--games n] [--soak n] [--vsync]\n");
+	printf("           [--cover] [--lockstep]\n");
+	printf("           [--noraster] [--frame-stats] [--dump frame] [--dumpdir dir]\n");
+	printf("           [--golden file] [--write-golden file] [--golden-every n]\n");
+	printf("           [--record file] [--replay file] [--raster] [--snapshot-every n]\n");
+	printf("           [--hash-every n] [--hash-log] [--hash-check file] [--hash-verify]\n");
+	printf("           [--das ticks] [--arr ticks] [--sdr ticks] [--input-ms] [--late-latch]\n");
+	printf("tetrishost --spool-sim\n");
+
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	int i;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--vsync") == 0) HostVsync = true;
+		else if (strcmp(argv[i], "--bot") == 0) useBot = true;
+		else if (strcmp(argv[i], "--noraster") == 0) HostRaster = false;
+		else if (strcmp(argv[i], "--frame-stats") == 0) frameStats = true;
+		else if (strcmp(argv[i], "--raster") == 0) replayRaster = true;
+		else if (strcmp(argv[i], "--hash-log") == 0) Replay.LogHashes = true;
+		else if (strcmp(argv[i], "--hash-verify") == 0) hashVerify = true;
+		else if (strcmp(argv[i], "--input-ms") == 0) inputClock = true;
+		else if (strcmp(argv[i], "--late-latch") == 0) Input.LateLatch = true;
+		else if (strcmp(argv[i], "--cover") == 0) cover = true;
+		else if (strcmp(argv[i], "--lockstep") == 0) lockstep = true;
+		else if (strcmp(argv[i], "--spool-sim") == 0) return SpoolSim();
+		else if (i + 1 >= argc) Usage();
+		else if (strcmp(argv[i], "--root") == 0) HostDataRoot = argv[++i];
+		else if (strcmp(argv[i], "--seed") == 0) HostRandomSeed = strtoul(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "--frames") == 0) maxFrames = strtoul(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "--games") == 0) maxGames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--noise") == 0) botNoise = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--dumpdir") == 0) dumpDir = argv[++i];
+		else if (strcmp(argv[i], "--golden-every") == 0) goldenEvery = strtoul(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "--dump") == 0)
+		{
+			if (dumpCount < HOST_MAX_DUMPS) dumpFrames[dumpCount++] = strtoul(argv[++i], NULL, 0);
+			else i++;
+		}
+		else if (strcmp(argv[i], "--golden") == 0)
+		{
+			if (LoadGolden(argv[++i]) == false || goldenCount == 0)
+			{
+				fprintf(stderr, "can't read golden frames from %s\n", argv[i]);
+
+				return 2;
+			}
+		}
+		else if (strcmp(argv[i], "--write-golden") == 0)
+		{
+			if ((goldenOut = fopen(argv[++i], "w")) == NULL)
+			{
+				fprintf(stderr, "can't write %s\n", argv[i]);
+
+				return 2;
+			}
+
+			fprintf(goldenOut, "# frame crc32\n");
+		}
+		else if (strcmp(argv[i], "--soak") == 0)
+		{
+			maxGames = atoi(argv[++i]);
+			useBot = true;
+			soak = true;
+		}
+		else if (strcmp(argv[i], "--record") == 0) recordPath = argv[++i];
+		else if (strcmp(argv[i], "--hash-every") == 0) hashEvery = strtoul(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "--hash-check") == 0)
+		{
+			if (LoadHashLog(argv[++i]) == false)
+			{
+				fprintf(stderr, "can't read HASH lines from %s\n", argv[i]);
+
+				return 2;
+			}
+		}
+		else if (strcmp(argv[i], "--das") == 0) Input.Repeats[INPUT_REPEAT_SHIFT].Delay = strtoul(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "--arr") == 0) Input.Repeats[INPUT_REPEAT_SHIFT].Rate = strtoul(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "--sdr") == 0)
+		{
+			Input.Repeats[INPUT_REPEAT_SOFT_DROP].Delay = strtoul(argv[++i], NULL, 0);
+			Input.Repeats[INPUT_REPEAT_SOFT_DROP].Rate = Input.Repeats[INPUT_REPEAT_SOFT_DROP].Delay;
+		}
+		else if (strcmp(argv[i], "--snapshot-every") == 0) snapshotEvery = strtoul(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "--replay") == 0)
+		{
+			replayPath = argv[++i];
+
+			if (LoadReplay(replayPath) == false)
+			{
+				fprintf(stderr, "can't read a finished recording from %s\n", replayPath);
+
+				return 2;
+			}
+		}
+		else if (strcmp(argv[i], "--script") == 0)
+		{
+			if (LoadScript(argv[++i]) == false)
+			{
+				fprintf(stderr, "can't read script %s\n", argv[i]);
+
+				return 2;
+			}
+		}
+		else Usage();
+	}
+
+	if (scriptSteps == 0) useBot = true;
+	if (goldenEvery == 0) goldenEvery = 1;
+
+	if (replayPath != NULL) // The recording decides when to stop, the pad bits come from it too
+	{
+		recordPath = NULL;
+		maxGames = 0;
+		maxFrames = Replay.EndMark + HOST_REPLAY_SLACK;
+
+		if (replayRaster == false && dumpCount == 0 && goldenCount == 0 && goldenOut == NULL) HostRaster = false;
+	}
+	else if (recordPath != NULL && ReplayStartRecord(HOST_REPLAY_BYTES, hashEvery) == false)
+	{
+		fprintf(stderr, "can't start recording\n");
+
+		return 2;
+	}
+
+	if (inputClock)
+	{
+		if (replayPath != NULL || recordPath != NULL)
+		{
+			fprintf(stderr, "--input-ms repeats can't be recorded, they depend on how fast the frames run\n");
+
+			return 2;
+		}
+
+		InputUseClock(true);
+	}
+
+	if (Input.LateLatch && (replayPath != NULL || recordPath != NULL))
+	{
+		fprintf(stderr, "--late-latch reads can't be recorded, they land between ticks\n");
+
+		return 2;
+	}
+
+	if (lockstep && (Input.LateLatch || replayPath != NULL))
+	{
+		fprintf(stderr, "--lockstep needs every move in HandleInput and the seed from ReadHardwareRandomNumber\n");
+
+		return 2;
+	}
+
+	if (maxFrames == 0 && maxGames == 0) maxFrames = HOST_DEFAULT_FRAMES;
+
+	ReplayHashHook = HashHook;
+
+	runStartNS = HostNowNS();
+
+	botState = HostRandomSeed ^ 0x9e3779b9;
+
+	tetris_main(); // Never returns, HostFinish exits
+
+	return 0;
+}
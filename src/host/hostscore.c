@@ -0,0 +1,242 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Score music (HD3DOAudioScore.c, built with AUDIO_MUSIC_SCORE set) on the
+//	juggler and score stand-ins in hostjuggler.c. The console build is the
+//	only one that plays it, so this is where the clock it keeps and the cue
+//	it sets get checked:
+//
+//	tempo		Beats at the file's tempo, then changes between events to
+//				faster, slightly faster and slower. The driver keeps the
+//				exact score time, real ticks times tempo in 64 bits, and each
+//				wake has to play the event due then, not one early and no
+//				later than the audio tick the cue rounds up to. One cue is set
+//				after every service, never none and never two
+//	fade		ScoreStop with a fade steps every channel's volume down and
+//				stops the music within the fade, the cue going with it
+//	end			A score left to play out stops itself after its repetitions
+//	signal		ScoreSignal is 0 while nothing plays and the cue's while it does
+//
+//	The audio clock only moves to the cue the score waits on, or when this
+//	says so, so every run is the same
+//
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#define AUDIO_MUSIC_SCORE 1			// The calls, not the macros that stand in for them
+
+#include "host3do.h"
+#include "HD3DOAudioScore.h"
+
+#define SCORE_FILE "music/tetris.mf"	// Not read, see hostjuggler.c
+#define SCORE_MAX_WAKES 1000
+
+static int failures = 0;
+
+static frac16 tempo;				// The driver's copy of the score's
+static uint64 exact;				// Score ticks << 16 up to lastReal
+static AudioTime lastReal;
+static uint32 firstPlayed;			// HostScore.Played when the score started
+
+/* ----- What host3do.c wants from the rest of the game ----- */
+
+int HostPollPad(HostPadEvent *events) { return 0; }
+void HostFrameDone() {}
+
+/* ----- Helpers ----- */
+
+static void Fail(char *pass, char *what)
+{
+	printf("SCORE FAIL: %s, %s\n", pass, what);
+
+	failures++;
+}
+
+static uint64 Exact()
+{
+	return exact + ((uint64)(GetAudioTime() - lastReal) * tempo);
+}
+
+static void SetTempo(frac16 t)
+{
+	exact = Exact();
+	lastReal = GetAudioTime();
+	tempo = t;
+
+	ScoreTempo(t);
+}
+
+static void Start(int32 reps)
+{
+	ScoreStart(reps); // Plays the first event at once
+
+	exact = 0;
+	lastReal = GetAudioTime();
+	firstPlayed = HostScore.Played - 1;
+}
+
+// Sleeps until the score's cue and services it, false once the score has stopped
+
+static bool Wake(char *pass, bool fading)
+{
+	int32 signal = ScoreSignal();
+	uint32 idle = HostScore.IdleBumps, played;
+	uint64 due;
+
+	if (signal == 0 || HostCuesSet(signal) != 1)
+	{
+		Fail(pass, "playing without a cue set");
+
+		return false;
+	}
+
+	WaitSignal(signal);
+	ScoreService();
+
+	if (ScorePlaying() == false) return false;
+
+	if (HostCuesSet(signal) != 1) Fail(pass, "the cue wasn't set again, or was set twice");
+
+	if (fading) return true; // Volume steps wake between events
+
+	played = HostScore.Played - firstPlayed;
+	due = (uint64)(played - 1) * HostScore.Beat << 16; // Of the last one played
+
+	if (HostScore.IdleBumps != idle || Exact() < due) Fail(pass, "woke before the next event was due");
+	else if (Exact() - due >= (((uint64)tempo + 0xffff) >> 16) << 16) Fail(pass, "woke later than the audio tick the event falls in");
+
+	if ((Exact() >> 16) / HostScore.Beat + 1 != played) Fail(pass, "played a different number of events than the score time says");
+
+	return true;
+}
+
+static void Wakes(char *pass, int n)
+{
+	while (n-- > 0 && Wake(pass, false));
+}
+
+/* ----- Passes ----- */
+
+static void Tempo()
+{
+	SetTempo(SCORE_TEMPO_ONE);
+	Start(2);
+
+	Wakes("tempo", 8);
+
+	HostAudioRun(HostScore.Beat / 3); // Between events
+	SetTempo(SCORE_TEMPO_ONE + (SCORE_TEMPO_ONE / 2));
+	Wakes("tempo", 8);
+
+	HostAudioRun(7);
+	SetTempo(0x11999); // 1.1, nothing comes out even
+	Wakes("tempo", 20);
+
+	SetTempo((SCORE_TEMPO_ONE * 3) / 4); // Right on an event
+	Wakes("tempo", 8);
+
+	printf("tempo: %u events, latest %u score ticks after it was due, %u bumps\n", HostScore.Played - firstPlayed,
+		HostScore.LateMax, HostScore.Bumps);
+}
+
+static void Fade()
+{
+	AudioTime start = GetAudioTime();
+	int32 volume = HostScore.Volume[0], ch;
+	int wakes = 0;
+
+	ScoreStop(1);
+
+	while (wakes++ < SCORE_MAX_WAKES && Wake("fade", true))
+	{
+		for (ch = 1; ch < HOST_SCORE_CHANNELS; ch++)
+		{
+			if (HostScore.Volume[ch] != HostScore.Volume[0]) Fail("fade", "channels at different volumes");
+		}
+
+		if (HostScore.Volume[0] > volume) Fail("fade", "volume went up");
+
+		volume = HostScore.Volume[0];
+	}
+
+	if (ScorePlaying()) Fail("fade", "still playing");
+	else if (GetAudioTime() - start > 240 + (2 * SCORE_FADE_STEP)) Fail("fade", "took longer than the fade");
+
+	if (HostScore.Freed < HOST_SCORE_CHANNELS) Fail("fade", "notes left on when it stopped");
+
+	printf("fade: stopped %u ticks after ScoreStop, volume down to %d\n", GetAudioTime() - start, volume);
+}
+
+static void End()
+{
+	int wakes = 0;
+
+	SetTempo(SCORE_TEMPO_ONE * 2);
+	Start(2);
+
+	while (wakes++ < SCORE_MAX_WAKES && Wake("end", false));
+
+	if (ScorePlaying() || HostScore.Played - firstPlayed != 2 * HOST_SCORE_EVENTS) Fail("end", "didn't stop after its repetitions");
+
+	if (ScoreSignal() != 0) Fail("end", "signal left to wait on with nothing playing");
+
+	printf("end: %u events in %u wakes\n", HostScore.Played - firstPlayed, wakes);
+}
+
+/* ----- Main ----- */
+
+int main(int argc, char **argv)
+{
+	if (argc > 1)
+	{
+		printf("tetrisscore\n");
+		printf("  Plays score music on the juggler stand-in, checks its clock through tempo changes, fades and the end\n");
+
+		return 1;
+	}
+
+	if (ScoreLoad(SCORE_FILE) == false)
+	{
+		printf("SCORE FAIL: ScoreLoad\n");
+
+		return 1;
+	}
+
+	if (ScoreSignal() != 0) Fail("signal", "loaded but not playing, and there's a signal to wait on");
+
+	Tempo();
+	Fade();
+
+	if (ScoreSignal() != 0) Fail("signal", "faded out, and there's a signal to wait on");
+
+	End();
+
+	ScoreUnload();
+
+	if (HostCuesSet(~0) != 0) Fail("signal", "a cue left set after ScoreUnload");
+
+	printf(failures == 0 ? "SCORE PASS\n" : "SCORE FAIL\n");
+
+	return failures != 0;
+}
@@ -0,0 +1,739 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Sound effects through the real sound library, HD3DOAudioSoundInterface.c,
+//	on the host mixer in hostaudio.c. Six passes, each checked against what
+//	the library promises:
+//
+//	channels	Every effect gets a voice on a mixer input of its own with
+//				its gains up, the inputs nobody has are at 0, and each one
+//				plays to its end and is heard
+//	panning		Every pan position of the positional effects: the voice's
+//				gains move across with the same power, and nothing but its
+//				two gain knobs changes, no instrument, input or other gain
+//	stealing	Effects started back to back: past kMaxPlayingSounds the
+//				lowest priority one playing stops for a higher one, and one
+//				lower than everything playing doesn't start. Then the DSP cut
+//				to five voices, the lowest priority effects lose theirs at load
+//	latency		AudioPlay through the audio thread, --reps of every effect.
+//				Trigger to StartInstrument in real time (thread wake-up and
+//				CallSound), then start to the first audible frame in the
+//				mix, which is the sample's own lead-in
+//	scheduler	AudioTrigger and AudioFlush: repeats on a frame send one
+//				play, a retrigger inside the effect's interval is dropped,
+//				and a frame with every effect sends the highest priority
+//				ones the category and frame caps allow
+//	callsound	Real time per CallSound for a start, a stop and a query, the
+//				library's own cost with the folio calls it makes
+//
+//	The mix is recorded from the start, --wav writes it out with its events
+//	alongside. The audio clock only moves when this says so, or when the
+//	library sleeps, so the recording is the same every run
+//
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host3do.h"
+#include "HD3DOAudio.h"
+#include "HD3DOAudioSFX.h"
+#include "HD3DOAudioSoundInterface.h"
+#include "HD3DOMem.h"
+
+#define SFX_EFFECTS (MAX_SFX - 1)
+#define SFX_RECORD_SECONDS 60
+#define SFX_DEFAULT_REPS 5
+#define SFX_MAX_REPS 100
+#define SFX_STEP_TICKS 12			// Clock steps waiting for a sound to end, 50ms
+#define SFX_MAX_TICKS (10 * 240)	// Longer than any effect
+#define SFX_TIMEOUT_NS 2000000000ULL
+#define SFX_BENCH_CALLS 1000		// A batch, the best batch is reported
+#define SFX_BENCH_BATCHES 20
+#define SFX_STARVED_VOICES 5
+
+static int failures = 0;
+static char names[MAX_SFX][32];		// Sample each effect played, from its first START
+static uint64 onset[MAX_SFX];		// Frames from START to audible
+
+/* ----- What host3do.c and HD3DOMem.c want from the rest of the game ----- */
+
+int HostPollPad(HostPadEvent *events) { return 0; }
+void HostFrameDone() {}
+CCB *CopyCel(CCB *src) { return NULL; }		// Cels and the overlay, never reached from the sound paths
+void drawText(int xtp, int ytp, char *text, Item bitmapItem) {}
+
+/* ----- Helpers ----- */
+
+static void Fail(char *what, int32 id)
+{
+	printf("SFX FAIL: %s%s%s\n", what, id > 0 ? ", " : "", id > 0 ? names[id] : "");
+
+	failures++;
+}
+
+static int32 Call(int32 what, int32 id)
+{
+	RAMSoundRec rs;
+
+	rs.whatIWant = what;
+	rs.soundID = id;
+
+	return CallSound((CallSoundRec *)&rs);
+}
+
+// The one event of a type since mark, NULL if there isn't exactly one
+
+static HostMixEvent *Event(uint32 mark, uint32 type, Item voice)
+{
+	HostMixEvent *found = NULL;
+	uint32 i;
+
+	for (i = mark; i < HostMix.Events; i++)
+	{
+		if (HostMixEvents[i].Type != type || (voice != 0 && HostMixEvents[i].Voice != voice)) continue;
+
+		if (found != NULL) return NULL;
+
+		found = &HostMixEvents[i];
+	}
+
+	return found;
+}
+
+static uint32 Count(uint32 mark, uint32 type)
+{
+	uint32 i, n = 0;
+
+	for (i = mark; i < HostMix.Events; i++)
+	{
+		if (HostMixEvents[i].Type == type) n++;
+	}
+
+	return n;
+}
+
+static bool Connected(Item voice)
+{
+	int i;
+
+	for (i = 0; i < HOST_MIX_INPUTS; i++)
+	{
+		if (voice != 0 && HostMix.Voice[i] == voice) return true;
+	}
+
+	return false;
+}
+
+static int Playing()
+{
+	int i, n = 0;
+
+	for (i = 0; i < HOST_MIX_INPUTS; i++)
+	{
+		if (HostMix.Voice[i] != 0 && HostMixPlaying(HostMix.Voice[i])) n++;
+	}
+
+	return n;
+}
+
+static void RunUntilQuiet()
+{
+	uint32 ticks;
+
+	for (ticks = 0; ticks < SFX_MAX_TICKS && Playing() > 0; ticks += SFX_STEP_TICKS)
+	{
+		HostAudioRun(SFX_STEP_TICKS);
+	}
+
+	HostAudioRun(240); // And past the library's idea of when they end, it rounds up
+	HostMixFlush();
+}
+
+// The spooler thread reserves its room instrument as it starts, on the console it runs first
+
+static void Init()
+{
+	uint64 t0 = HostNowNS();
+
+	initsound();
+
+	while (HostMix.Instruments < 2 + RESERVE_SPOOLER_ROOM && HostNowNS() - t0 < SFX_TIMEOUT_NS) Yield();
+}
+
+static void Close(char *pass)
+{
+	closesound();
+
+	if (HostMix.DSPUsed != 0 || HostMix.Samples != 0) Fail(pass, 0), printf("  %u DSP ticks and %u samples left after closesound\n", HostMix.DSPUsed, HostMix.Samples);
+}
+
+/* ----- Passes ----- */
+
+// The library's own count of what it holds against what the mixer was asked for
+
+static void Resources(char *pass, uint32 inputs)
+{
+	SoundResourceRec sr;
+
+	GetSoundResources(&sr);
+
+	if (sr.dspTicks != (int32)HostMix.DSPUsed || sr.instruments != (int32)HostMix.Instruments ||
+		sr.channelsFree != HOST_MIX_INPUTS - (int32)inputs || sr.dspTicksPeak < sr.dspTicks)
+	{
+		Fail(pass, 0);
+
+		printf("  library has %d DSP ticks, %d instruments, %d channels free, the mixer %u, %u, %d\n", sr.dspTicks, sr.instruments,
+			sr.channelsFree, HostMix.DSPUsed, HostMix.Instruments, HOST_MIX_INPUTS - (int)inputs);
+	}
+}
+
+static uint32 Channels()
+{
+	HostMixEvent *start, *audible;
+	uint32 mark, base, inputs = 0;
+	int i, id;
+
+	Init();
+
+	base = HostMix.DSPUsed;
+
+	loadsfx();
+
+	for (i = 0; i < HOST_MIX_INPUTS; i++)
+	{
+		if (HostMix.Voice[i] != 0) inputs++;
+
+		if ((HostMix.Voice[i] != 0) != (HostMix.Gain[i][0] != 0 && HostMix.Gain[i][1] != 0)) Fail("gains don't follow the inputs in use", 0);
+	}
+
+	if (inputs != SFX_EFFECTS) Fail("effects without a mixer input", 0);
+
+	Resources("resource counts are off", inputs);
+
+	printf("channels: %u inputs, DSP %u of %u ticks, %u for the mixer and spooler\n", inputs, HostMix.DSPUsed, HostMix.DSPTicks, base);
+
+	for (id = 1; id < MAX_SFX; id++)
+	{
+		mark = HostMix.Events;
+
+		if (Call(kStartRAMSound, id) != 0) Fail("start failed", id);
+
+		start = Event(mark, HOST_MIX_START, 0);
+
+		if (start == NULL || Connected(start->Voice) == false)
+		{
+			Fail("didn't start on a connected voice", id);
+
+			continue;
+		}
+
+		strcpy(names[id], start->Sample);
+
+		RunUntilQuiet();
+
+		audible = Event(mark, HOST_MIX_AUDIBLE_AT, start->Voice);
+
+		if (audible == NULL || Event(mark, HOST_MIX_END, start->Voice) == NULL)
+		{
+			Fail("not heard to its end", id);
+
+			continue;
+		}
+
+		onset[id] = audible->Frame - start->Frame;
+
+		printf("  %-14s input %d, priority %d\n", names[id], start->Input, soundpriority(id));
+	}
+
+	return HostMix.DSPUsed - base;
+}
+
+// Between channels and stealing, on the same load of the effects
+
+static void Panning()
+{
+	static int32 positional[] = { SFX_DROP, SFX_CLEAR, SFX_CLEAR4 };
+	HostMixEvent *start;
+	int32 gains[HOST_MIX_INPUTS][2], centre, power, id;
+	uint32 mark, instruments;
+	int i, k, pos, in = 0;
+
+	for (k = 0; k < (int)(sizeof(positional) / sizeof(positional[0])); k++)
+	{
+		id = positional[k];
+		centre = 0;
+
+		for (pos = 0; pos < SFX_PAN_POSITIONS; pos++)
+		{
+			memcpy(gains, HostMix.Gain, sizeof(gains));
+
+			mark = HostMix.Events;
+			instruments = HostMix.Instruments;
+
+			pansound(id, pos);
+			Call(kStartRAMSound, id);
+
+			start = Event(mark, HOST_MIX_START, 0);
+
+			if (start == NULL)
+			{
+				Fail("didn't start after panning", id);
+
+				break;
+			}
+
+			in = start->Input;
+
+			if (HostMix.Instruments != instruments || Count(mark, HOST_MIX_CONNECT) != 0 || Count(mark, HOST_MIX_DISCONNECT) != 0) Fail("panning reconnected", id);
+
+			for (i = 0; i < HOST_MIX_INPUTS; i++)
+			{
+				if (i != in && (HostMix.Gain[i][0] != gains[i][0] || HostMix.Gain[i][1] != gains[i][1])) Fail("panning moved another input", id);
+			}
+
+			if (pos > 0 && (HostMix.Gain[in][0] >= gains[in][0] || HostMix.Gain[in][1] <= gains[in][1])) Fail("pan positions out of order", id);
+
+			if (pos == SFX_PAN_CENTRE)
+			{
+				centre = HostMix.Gain[in][0];
+
+				if (HostMix.Gain[in][1] != centre) Fail("centre isn't centred", id);
+			}
+		}
+
+		for (pos = 0; pos < SFX_PAN_POSITIONS && centre > 0; pos++) // Same power all the way across, to 2%
+		{
+			pansound(id, pos);
+
+			power = HostMix.Gain[in][0] * HostMix.Gain[in][0] + HostMix.Gain[in][1] * HostMix.Gain[in][1];
+
+			if (power < (2 * centre * centre) * 49 / 50 || power > (2 * centre * centre) * 51 / 50) Fail("louder at some pan positions", id);
+		}
+
+		pansound(id, 0);
+
+		printf("panning: %-14s left %d/%d, centre %d/%d", names[id], HostMix.Gain[in][0], HostMix.Gain[in][1], centre, centre);
+
+		pansound(id, SFX_PAN_POSITIONS - 1);
+
+		printf(", right %d/%d\n", HostMix.Gain[in][0], HostMix.Gain[in][1]);
+
+		pansound(id, SFX_PAN_CENTRE); // Where the passes after expect it
+	}
+
+	RunUntilQuiet();
+}
+
+// Every effect twice, back to back. Nothing ends between them, so past kMaxPlayingSounds each
+// start has to steal or drop, or restart itself if it's still playing
+
+static void Stealing(uint32 voiceTicks)
+{
+	SoundResourceRec sr;
+	bool playing[MAX_SFX];
+	int32 result, lowest;
+	uint32 mark, n = 0, steals = 0, drops = 0, refused;
+	int i, id, k;
+
+	memset(playing, 0, sizeof(playing));
+
+	for (k = 0; k < 2 * SFX_EFFECTS; k++)
+	{
+		id = 1 + (k % SFX_EFFECTS);
+
+		for (lowest = 0, i = 1; i < MAX_SFX; i++)
+		{
+			if (playing[i] && (lowest == 0 || soundpriority(i) < soundpriority(lowest))) lowest = i;
+		}
+
+		mark = HostMix.Events;
+		result = Call(kStartRAMSound, id);
+
+		if (playing[id])
+		{
+			if (result != 0 || Count(mark, HOST_MIX_STOP) != 1 || Event(mark, HOST_MIX_STOP, 0) == NULL ||
+				strcmp(Event(mark, HOST_MIX_STOP, 0)->Sample, names[id]) != 0) Fail("didn't restart its own voice", id);
+		}
+		else if (n < kMaxPlayingSounds)
+		{
+			if (result != 0 || Count(mark, HOST_MIX_STOP) != 0) Fail("started with voices to spare but something stopped", id);
+
+			playing[id] = true;
+			n++;
+		}
+		else if (soundpriority(lowest) < soundpriority(id))
+		{
+			if (result != 0 || Count(mark, HOST_MIX_STOP) != 1 || Event(mark, HOST_MIX_STOP, 0) == NULL ||
+				strcmp(Event(mark, HOST_MIX_STOP, 0)->Sample, names[lowest]) != 0) Fail("didn't take the lowest priority voice", id);
+			else printf("stealing: %s stops %s\n", names[id], names[lowest]);
+
+			steals++;
+
+			playing[lowest] = false;
+			playing[id] = true;
+		}
+		else
+		{
+			if (result == 0 || Count(mark, HOST_MIX_START) != 0 || Count(mark, HOST_MIX_STOP) != 0) Fail("started over higher priority sounds", id);
+			else printf("stealing: %s dropped, everything playing outranks it\n", names[id]);
+
+			drops++;
+		}
+
+		if (Playing() != (int)n) Fail("voices playing don't match", id);
+	}
+
+	GetSoundResources(&sr);
+
+	if (sr.steals != steals || sr.drops != drops || sr.evictions != 0 || sr.silentStarts != 0) Fail("steals and drops miscounted", 0);
+
+	RunUntilQuiet();
+	Close("stealing");
+
+	// A DSP with room for SFX_STARVED_VOICES, the ones left out are the lowest priority
+
+	Init();
+
+	HostMix.DSPTicks = HostMix.DSPUsed + (SFX_STARVED_VOICES * voiceTicks);
+	refused = HostMix.NoResource;
+
+	loadsfx();
+
+	GetSoundResources(&sr);
+
+	if (sr.noResource != HostMix.NoResource - refused || sr.failedAssigns + sr.evictions != SFX_EFFECTS - SFX_STARVED_VOICES ||
+		sr.voices != SFX_STARVED_VOICES || sr.dspTicks != (int32)HostMix.DSPUsed) Fail("starved DSP miscounted", 0);
+
+	for (id = 1; id < MAX_SFX; id++)
+	{
+		for (n = 0, i = 1; i < MAX_SFX; i++)
+		{
+			if (soundpriority(i) > soundpriority(id)) n++; // Outranked by
+		}
+
+		result = Call(kStartRAMSound, id);
+
+		if ((result == 0) != (n < SFX_STARVED_VOICES)) Fail(result == 0 ? "kept a voice it should have lost" : "lost a voice it should have kept", id);
+
+		Call(kStopRAMSound, id);
+	}
+
+	GetSoundResources(&sr);
+
+	if (sr.silentStarts != SFX_EFFECTS - SFX_STARVED_VOICES) Fail("silent starts miscounted", 0);
+
+	printf("stealing: DSP for %d voices, %u refused, %u evicted, the %d lowest priority effects are silent\n", SFX_STARVED_VOICES,
+		sr.noResource, sr.evictions, SFX_EFFECTS - SFX_STARVED_VOICES);
+
+	Close("stealing");
+
+	HostMix.DSPTicks = HOST_MIX_DSP_TICKS;
+}
+
+static int CompareNS(const void *a, const void *b)
+{
+	uint64 x = *(uint64 *)a, y = *(uint64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void Latency(int reps, uint32 voiceTicks)
+{
+	static uint64 handoff[SFX_MAX_REPS * SFX_EFFECTS];
+	HostMixEvent *start, *audible;
+	uint32 mark, ran;
+	uint64 t0;
+	int n = 0, rep, id;
+
+	if (AudioStart() == false)
+	{
+		Fail("AudioStart", 0);
+
+		return;
+	}
+
+	if (SoundSampleBytes == 0 || MemTags[MEM_TAG_AUDIO].LiveBytes != SoundSampleBytes || MemTags[MEM_TAG_AUDIO].LiveCount != 1)
+	{
+		Fail("the loaded samples aren't the audio thread's one record", 0);
+	}
+
+	for (rep = 0; rep < reps; rep++)
+	{
+		for (id = 1; id < MAX_SFX; id++)
+		{
+			mark = HostMix.Events;
+			ran = Audio.Ran[AUDIO_PLAY];
+			t0 = HostNowNS();
+
+			AudioPlay(id);
+
+			while (Audio.Ran[AUDIO_PLAY] == ran && HostNowNS() - t0 < SFX_TIMEOUT_NS) Yield();
+
+			start = Event(mark, HOST_MIX_START, 0);
+
+			if (start == NULL || strcmp(start->Sample, names[id]) != 0)
+			{
+				Fail("queued play didn't start", id);
+
+				continue;
+			}
+
+			handoff[n++] = start->NS - t0;
+
+			RunUntilQuiet();
+
+			audible = Event(mark, HOST_MIX_AUDIBLE_AT, start->Voice);
+
+			if (audible == NULL || audible->Frame - start->Frame != onset[id]) Fail("heard at a different point through the queue", id);
+		}
+	}
+
+	AudioStop();
+
+	if (HostMix.DSPUsed != 0 || HostMix.Samples != 0) Fail("AudioStop left voices", 0);
+
+	if (SoundSampleBytes != 0 || MemTags[MEM_TAG_AUDIO].LiveCount != 0 || MemTags[MEM_TAG_MUSIC].LiveCount != 0)
+	{
+		Fail("AudioStop left sample bytes or records tracked", 0);
+	}
+
+	if ((Audio.ResourcesSeq & 1) != 0 || Audio.Resources.instruments == 0 || Audio.Resources.dspTicksPeak < voiceTicks)
+	{
+		Fail("the thread didn't publish its resources", 0);
+	}
+
+	if (n == 0) return;
+
+	qsort(handoff, n, sizeof(handoff[0]), CompareNS);
+
+	printf("latency: trigger to start %.1fus median, %.1fus p99, %.1fus worst of %d\n", handoff[n / 2] / 1000.0,
+		handoff[(n * 99) / 100] / 1000.0, handoff[n - 1] / 1000.0, n);
+
+	for (id = 1; id < MAX_SFX; id++)
+	{
+		printf("  %-14s audible %.2fms after it starts\n", names[id], onset[id] * 1000.0 / HOST_MIX_RATE);
+	}
+}
+
+// The effect id of the play queued n commands back
+
+static int32 Queued(uint32 n)
+{
+	return Audio.Ring[(Audio.Head - n) & (AUDIO_QUEUE_COMMANDS - 1)].Id;
+}
+
+static void Flushes(int n)
+{
+	while (n-- > 0) AudioFlush();
+}
+
+static void Scheduler()
+{
+	HostMixEvent *start;
+	uint32 coalesced, limited, capped, queued, head, mark, ran;
+	uint64 t0;
+	int32 sent, id, expect[2];
+	int i;
+
+	if (AudioStart() == false)
+	{
+		Fail("AudioStart", 0);
+
+		return;
+	}
+
+	coalesced = Audio.Coalesced;
+	limited = Audio.RateLimited;
+	capped = Audio.Capped;
+	head = Audio.Head;
+
+	for (i = 0; i < 3; i++) AudioTrigger(SFX_TICK);
+
+	if (AudioFlush() != 1 || Queued(1) != SFX_TICK || Audio.Coalesced - coalesced != 2) Fail("repeats on a frame weren't collapsed", SFX_TICK);
+
+	AudioTrigger(SFX_TICK);
+
+	if (AudioFlush() != 0 || Audio.RateLimited - limited != 1) Fail("retriggered inside its interval", SFX_TICK);
+
+	Flushes(soundinterval(SFX_TICK) - 2);
+	AudioTrigger(SFX_TICK);
+
+	if (AudioFlush() != 1) Fail("held back past its interval", SFX_TICK);
+
+	// Every effect on one frame, past all their intervals. The expected pair by hand from the tables
+
+	Flushes(soundinterval(SFX_GAMEOVER));
+
+	expect[0] = expect[1] = 0;
+
+	for (id = 1; id < MAX_SFX; id++)
+	{
+		AudioTrigger(id);
+
+		if (expect[0] == 0 || soundpriority(id) > soundpriority(expect[0])) expect[0] = id;
+	}
+
+	for (id = 1; id < MAX_SFX; id++)
+	{
+		if (soundcategory(id) != soundcategory(expect[0]) && (expect[1] == 0 || soundpriority(id) > soundpriority(expect[1]))) expect[1] = id;
+	}
+
+	sent = AudioFlush();
+
+	if (sent != AUDIO_SFX_PER_FRAME || Queued(2) != expect[0] || Queued(1) != expect[1] || Audio.Capped - capped != SFX_EFFECTS - AUDIO_SFX_PER_FRAME)
+	{
+		Fail("a busy frame didn't send the highest priority effects", 0);
+	}
+
+	printf("scheduler: %d of %d effects on one frame, %s and %s, %u plays for %u triggers\n", sent, SFX_EFFECTS, names[expect[0]],
+		names[expect[1]], Audio.Head - head, 3 + 1 + 1 + SFX_EFFECTS);
+
+	queued = Audio.Head - head;
+	t0 = HostNowNS();
+
+	while (Audio.Tail != Audio.Head && HostNowNS() - t0 < SFX_TIMEOUT_NS) Yield();
+
+	if (Audio.Tail != Audio.Head || queued != 2 + (uint32)sent) Fail("plays lost on the way to the thread", 0);
+
+	RunUntilQuiet();
+
+	// A position goes with the play, the last one triggered on the frame
+
+	mark = HostMix.Events;
+	ran = Audio.Ran[AUDIO_PLAY];
+	t0 = HostNowNS();
+
+	AudioTriggerAt(SFX_DROP, SFX_PAN_POSITIONS - 1);
+	AudioTriggerAt(SFX_DROP, 0);
+	AudioFlush();
+
+	while (Audio.Ran[AUDIO_PLAY] == ran && HostNowNS() - t0 < SFX_TIMEOUT_NS) Yield(); // Tail moves before the play runs
+
+	start = Event(mark, HOST_MIX_START, 0);
+
+	if (start == NULL || HostMix.Gain[start->Input][0] <= HostMix.Gain[start->Input][1]) Fail("the pan didn't go with the play", SFX_DROP);
+
+	RunUntilQuiet();
+	AudioStop();
+}
+
+static double Bench(int32 what)
+{
+	double best = 0, ns;
+	uint64 t0;
+	int batch, i;
+
+	for (batch = 0; batch < SFX_BENCH_BATCHES; batch++)
+	{
+		t0 = HostNowNS();
+
+		for (i = 0; i < SFX_BENCH_CALLS; i++)
+		{
+			if (what == kSetRAMSoundPan) pansound(1 + (i % SFX_EFFECTS), i % SFX_PAN_POSITIONS); // 7 and 15 share nothing, every call moves it
+			else Call(what, 1 + (i % SFX_EFFECTS)); // Starts cycle through stealing, nothing ends while the clock stands still
+		}
+
+		ns = (double)(HostNowNS() - t0) / SFX_BENCH_CALLS;
+
+		if (batch == 0 || ns < best) best = ns;
+	}
+
+	return best;
+}
+
+static void CallSoundCost()
+{
+	double start, stop, query, pan;
+
+	Init();
+	loadsfx();
+
+	start = Bench(kStartRAMSound);
+	stop = Bench(kStopRAMSound);
+	query = Bench(kIsSoundSpooling);
+	pan = Bench(kSetRAMSoundPan);
+
+	printf("callsound: start %.0fns, stop %.0fns, query %.0fns, pan %.0fns\n", start, stop, query, pan);
+
+	Close("callsound");
+}
+
+/* ----- Main ----- */
+
+static void Usage()
+{
+	printf("tetrissfx [--root dir] [--reps n] [--wav file]\n");
+	printf("  Plays the sound effects through the sound library on the host mixer, checks voices and stealing\n");
+	printf("  and reports trigger to sound latency and CallSound cost. --wav writes the mix, events in file.log\n");
+}
+
+int main(int argc, char **argv)
+{
+	char *wav = NULL;
+	int reps = SFX_DEFAULT_REPS;
+	uint32 voiceTicks;
+	int i;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) HostDataRoot = argv[++i];
+		else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) reps = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--wav") == 0 && i + 1 < argc) wav = argv[++i];
+		else
+		{
+			Usage();
+
+			return 1;
+		}
+	}
+
+	if (reps < 1) reps = 1;
+	if (reps > SFX_MAX_REPS) reps = SFX_MAX_REPS;
+
+	HostMixRecord(SFX_RECORD_SECONDS);
+
+	voiceTicks = Channels() / SFX_EFFECTS;
+
+	Panning();
+	Stealing(voiceTicks);
+	Latency(reps, voiceTicks);
+	Scheduler();
+	AudioReport(); // What the game logs, as the audio thread left it
+
+	if (HostMix.Dropped > 0) Fail("event list overflowed", 0); // The benchmark's fill it, nothing checks those
+
+	CallSoundCost();
+
+	HostMixFlush();
+
+	if (HostMix.Clipped > 0) printf("mix: %u frames clipped\n", HostMix.Clipped);
+
+	if (wav != NULL && HostMixWriteWAV(wav)) printf("mix: the first %ds of %.1fs to %s\n", SFX_RECORD_SECONDS, (double)HostMix.Frames / HOST_MIX_RATE, wav);
+
+	if (failures > 0) return 1;
+
+	printf("SFX PASS\n");
+
+	return 0;
+}
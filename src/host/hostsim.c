@@ -0,0 +1,307 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Headless board simulator. Runs --boards independent games on the rules in
+//	HD3DOGame.c, no tetris.c, no cels, and reports games, blocks and ticks per
+//	second. Each board is stepped one tick at a time in turn, --threads splits
+//	the boards between threads since the only shared state is the hash keys
+//
+//	Every board is played by the placement bot (hostbot.c): each new block is
+//	tried in every rotation and column on a copy of the state, the copies are
+//	scored on lines, height, holes and bumpiness, and the real board is then
+//	driven there with the moves the pad would make. --noise is the percent of blocks dropped
+//	somewhere random instead, without it a game can run for hours
+//
+//	At each game over the incremental hash is checked against a full
+//	recompute, any difference fails the run
+//
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "types.h"
+#include "HD3DOGame.h"
+#include "hostbot.h"
+
+#define SIM_DEFAULT_BOARDS 4096
+#define SIM_DEFAULT_SECONDS 5
+#define SIM_DEFAULT_NOISE 10
+#define SIM_MAX_THREADS 64
+
+typedef struct SimBoard
+{
+	GameState Game;
+	RandomState Bot;			// Separate from the piece generator so the bot doesn't change the sequence
+	bool Placed;				// Current block has been driven to its spot
+	uint32 Blocks;
+} SimBoard;
+
+typedef struct SimThread
+{
+	pthread_t Thread;
+	SimBoard *Boards;
+	int Count;
+	uint64 Games;
+	uint64 Blocks;
+	uint64 GameBlocks;			// Blocks in the games that finished
+	uint64 Ticks;
+	uint64 Lines;
+	uint64 Score;
+	int BestScore;
+	int HashFailed;
+} SimThread;
+
+static int boardCount = SIM_DEFAULT_BOARDS;
+static int threadCount = 1;
+static int seconds = SIM_DEFAULT_SECONDS;
+static uint64 maxGames = 0;
+static int noise = SIM_DEFAULT_NOISE;
+static uint32 seed = 1;
+
+static volatile bool stop = false;
+
+static uint64 NowNS()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+/* ----- Bot ----- */
+
+static void PlaceBlock(SimBoard *sb)
+{
+	BotPlacement options[BOT_MAX_PLACEMENTS];
+	int best = 0, count;
+
+	count = BotPlacements(&sb->Game, options);
+
+	if (count > 0)
+	{
+		if ((int)RandomBelow(&sb->Bot, 100) < noise)
+		{
+			best = RandomBelow(&sb->Bot, count);
+		}
+		else
+		{
+			best = BotBest(options, count);
+		}
+
+		BotSteer(&sb->Game, options[best].Turns, options[best].Shift);
+	}
+
+	GameHardDrop(&sb->Game); // With nowhere to go it drops where it spawned and the game ends
+
+	sb->Placed = true;
+}
+
+/* ----- Boards ----- */
+
+static void StartBoard(SimBoard *sb, uint32 boardSeed)
+{
+	GameInit(&sb->Game, boardSeed);
+	GameStart(&sb->Game);
+
+	RandomSeed(&sb->Bot, boardSeed ^ 0x5bd1e995);
+
+	sb->Placed = false;
+	sb->Blocks = 0;
+}
+
+static void StepBoard(SimThread *st, SimBoard *sb)
+{
+	int tick;
+
+	if (sb->Placed == false) PlaceBlock(sb);
+
+	tick = GameTick(&sb->Game);
+
+	st->Ticks++;
+
+	if (tick == GAME_TICK_LOCKED)
+	{
+		GameSettle(&sb->Game);
+
+		sb->Placed = false;
+		sb->Blocks++;
+		st->Blocks++;
+	}
+	else if (tick == GAME_TICK_OVER)
+	{
+		if (GameHash(&sb->Game) != GameFullHash(&sb->Game)) st->HashFailed++;
+
+		st->Games++;
+		st->GameBlocks += sb->Blocks;
+		st->Lines += sb->Game.Lines;
+		st->Score += sb->Game.Score;
+
+		if (sb->Game.Score > st->BestScore) st->BestScore = sb->Game.Score;
+
+		GameReset(&sb->Game);
+		GameStart(&sb->Game);
+
+		sb->Placed = false;
+		sb->Blocks = 0;
+	}
+}
+
+static void *RunThread(void *arg)
+{
+	SimThread *st = (SimThread *)arg;
+	uint64 gamesEach = maxGames / threadCount;
+	int i;
+
+	while (stop == false && (gamesEach == 0 || st->Games < gamesEach))
+	{
+		for (i = 0; i < st->Count; i++)
+		{
+			StepBoard(st, &st->Boards[i]);
+		}
+	}
+
+	return NULL;
+}
+
+static void Usage()
+{
+	printf("tetrissim [--boards n] [--threads n] [--seconds n] [--games n] [--noise pct] [--seed n]\n");
+
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	SimThread threads[SIM_MAX_THREADS];
+	SimBoard *boards;
+	SimThread total;
+	uint64 t0, elapsed;
+	double secs;
+	int i, per;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (i + 1 >= argc) Usage();
+		else if (strcmp(argv[i], "--boards") == 0) boardCount = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--threads") == 0) threadCount = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seconds") == 0) seconds = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--games") == 0) maxGames = strtoull(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "--noise") == 0) noise = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0) seed = strtoul(argv[++i], NULL, 0);
+		else Usage();
+	}
+
+	if (boardCount < 1) boardCount = 1;
+	if (threadCount < 1) threadCount = 1;
+	if (threadCount > SIM_MAX_THREADS) threadCount = SIM_MAX_THREADS;
+	if (threadCount > boardCount) threadCount = boardCount;
+
+	if ((boards = (SimBoard *)malloc(sizeof(SimBoard) * boardCount)) == NULL)
+	{
+		fprintf(stderr, "no memory for %d boards\n", boardCount);
+
+		return 2;
+	}
+
+	GameInitKeys();
+
+	for (i = 0; i < boardCount; i++)
+	{
+		StartBoard(&boards[i], seed + (uint32)i * 0x9e3779b9); // Golden ratio steps keep the seeds apart
+	}
+
+	memset(threads, 0, sizeof(threads));
+
+	per = boardCount / threadCount;
+
+	for (i = 0; i < threadCount; i++)
+	{
+		threads[i].Boards = boards + (i * per);
+		threads[i].Count = i == threadCount - 1 ? boardCount - (i * per) : per;
+	}
+
+	t0 = NowNS();
+
+	for (i = 0; i < threadCount; i++)
+	{
+		pthread_create(&threads[i].Thread, NULL, RunThread, &threads[i]);
+	}
+
+	if (maxGames == 0) // Otherwise each thread stops at its share of the games
+	{
+		struct timespec ts;
+
+		ts.tv_sec = seconds;
+		ts.tv_nsec = 0;
+
+		nanosleep(&ts, NULL);
+
+		stop = true;
+	}
+
+	memset(&total, 0, sizeof(total));
+
+	for (i = 0; i < threadCount; i++)
+	{
+		pthread_join(threads[i].Thread, NULL);
+
+		total.Games += threads[i].Games;
+		total.Blocks += threads[i].Blocks;
+		total.GameBlocks += threads[i].GameBlocks;
+		total.Ticks += threads[i].Ticks;
+		total.Lines += threads[i].Lines;
+		total.Score += threads[i].Score;
+		total.HashFailed += threads[i].HashFailed;
+
+		if (threads[i].BestScore > total.BestScore) total.BestScore = threads[i].BestScore;
+	}
+
+	elapsed = NowNS() - t0;
+	secs = elapsed / 1e9;
+
+	printf("SIM %d boards, %d threads, %u byte states, %.2fs\n", boardCount, threadCount, (unsigned)sizeof(GameState), secs);
+	printf("SIM games %llu (%.1f/s), blocks %llu (%.0f/s), ticks %llu (%.0f/s)\n",
+		(unsigned long long)total.Games, total.Games / secs, (unsigned long long)total.Blocks, total.Blocks / secs,
+		(unsigned long long)total.Ticks, total.Ticks / secs);
+
+	if (total.Games > 0)
+	{
+		printf("SIM per game: %.1f blocks, %.1f lines, score %.0f, best %d\n",
+			(double)total.GameBlocks / total.Games, (double)total.Lines / total.Games, (double)total.Score / total.Games, total.BestScore);
+	}
+
+	free(boards);
+
+	if (total.HashFailed > 0)
+	{
+		printf("SIM FAIL: %d games ended with the incremental hash out of step\n", total.HashFailed);
+
+		return 1;
+	}
+
+	return 0;
+}
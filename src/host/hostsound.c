@@ -0,0 +1,65 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	CallSound counted and timed instead of run, for the game runner and the
+//	benchmarks. Everything the sound library would do lands in
+//	Host.SoundCommands, and spooling is remembered so kIsSoundSpooling
+//	answers the way the library would. Nothing is loaded, so the resource
+//	counters stay at 0. tetrissfx links the real library in its place, see
+//	hostsfx.c
+//
+
+*/
+
+#include "host3do.h"
+#include "HD3DOAudioSoundInterface.h"
+
+static bool hostSpooling = false;
+
+uint32 SoundSampleBytes = 0; // Nothing is loaded here, AudioStart still tracks it
+
+int32 CallSound(union CallSoundRec *soundPtr)
+{
+	uint64 t0 = HostNowNS();
+	int32 what = soundPtr->whatIWant;
+	int32 result = 0;
+
+	if (what >= 0 && what < 32) Host.SoundCommands[what]++;
+
+	switch (what)
+	{
+		case kSpoolSound:
+		case kSpoolPlaylist: hostSpooling = true; break;
+		case kStopSpoolingSound:
+		case kStopFadeSpoolSound:
+		case kCleanupSound: hostSpooling = false; break;
+		case kIsSoundSpooling: result = hostSpooling; break;
+	}
+
+	HostRecordCall(HOST_CALL_CALLSOUND, t0);
+
+	return result;
+}
+
+void GetSoundResources(SoundResourcePtr resources)
+{
+	memset(resources, 0, sizeof(*resources));
+}
@@ -0,0 +1,827 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Host stand-in for the parts of the 3DO folios and Lib3DO the game uses.
+//	Every SDK header name in this directory forwards here, so the game
+//	sources build unchanged with gcc on Linux. Only what tetris.c, HD3DO.c,
+//	tools.c and friends actually call is declared
+//
+
+*/
+
+#ifndef HOST3DO_H
+#define HOST3DO_H
+
+#include <stddef.h>
+#include <stdlib.h>		// mem.h brings in malloc / free on the console
+#include <string.h>
+
+/* ----- types.h ----- */
+
+typedef signed char int8;
+typedef unsigned char uint8;
+typedef short int16;
+typedef unsigned short uint16;
+typedef int int32;
+typedef unsigned int uint32;
+typedef long long int64;
+typedef unsigned long long uint64;
+
+typedef unsigned char uchar;
+typedef unsigned char ubyte;
+typedef volatile long vlong;
+
+typedef uint8 bool;
+typedef uint8 Boolean;
+
+typedef int32 Item;
+typedef int32 Err;
+typedef int32 frac16;
+typedef int32 Coord;
+
+typedef struct TagArg
+{
+	uint32 ta_Tag;
+	void *ta_Arg;
+} TagArg;
+
+#define TAG_END 0
+
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+
+#define true 1
+#define false 0
+
+/* ----- macros3do.h ----- */
+
+#define SetFlag(v, f) ((v) |= (f))
+#define ClearFlag(v, f) ((v) &= ~(f))
+#define AddToPtr(ptr, val) ((void *)((char *)(ptr) + (val)))
+
+/* ----- operror.h ----- */
+
+#define MakeErrId(a, b) (((a) << 6) | ((b) & 0x3f))
+#define MakeErr(a, b, c, d, e, f) (0x80000000 | ((b) << 16) | (f))
+#define ER_USER 0
+#define ER_SEVERE 0
+#define ER_E_USER 0
+#define ER_C_STND 0
+#define ER_C_NSTND 1
+#define ER_NoMem 1
+
+/* ----- graphics.h ----- */
+
+#define CCB_SKIP		0x80000000
+#define CCB_LAST		0x40000000
+#define CCB_NPABS		0x20000000
+#define CCB_SPABS		0x10000000
+#define CCB_PPABS		0x08000000
+#define CCB_LDSIZE		0x04000000
+#define CCB_LDPRS		0x02000000
+#define CCB_LDPPMP		0x01000000
+#define CCB_LDPLUT		0x00800000
+#define CCB_CCBPRE		0x00400000
+#define CCB_YOXY		0x00200000
+#define CCB_ACSC		0x00100000
+#define CCB_ALSC		0x00080000
+#define CCB_ACW			0x00040000
+#define CCB_ACCW		0x00020000
+#define CCB_TWD			0x00010000
+#define CCB_LCE			0x00008000
+#define CCB_ACE			0x00004000
+#define CCB_MARIA		0x00001000
+#define CCB_PXOR		0x00000800
+#define CCB_USEAV		0x00000400
+#define CCB_PACKED		0x00000200
+#define CCB_POVER_MASK	0x00000180
+#define CCB_PLUTPOS		0x00000040
+#define CCB_BGND		0x00000020
+#define CCB_NOBLK		0x00000010
+#define CCB_PLUTA_MASK	0x0000000F
+
+#define PRE0_BGND		0x40000000
+#define PRE0_UNCODED	0x00000010
+#define PRE0_REP8		0x00000008
+#define PRE0_BPP_MASK	0x00000007
+#define PRE0_BPP_1		1
+#define PRE0_BPP_2		2
+#define PRE0_BPP_4		3
+#define PRE0_BPP_6		4
+#define PRE0_BPP_8		5
+#define PRE0_BPP_16		6
+#define PRE0_VCNT_SHIFT	6
+#define PRE0_VCNT_MASK	0x0000FFC0
+#define PRE0_LINEAR		PRE0_UNCODED
+
+#define PRE1_WOFFSET8_SHIFT		24
+#define PRE1_WOFFSET10_SHIFT	16
+#define PRE1_WOFFSET10_MASK		0x03FF0000
+#define PRE1_LRFORM				0x00000800
+#define PRE1_TLLSB_PDC0			0x00001000
+#define PRE1_TLHPCNT_MASK		0x000007FF
+
+#define PIXC_OPAQUE		0x1F001F00
+
+#define MakeRGB15(r, g, b) (((r) << 10) | ((g) << 5) | (b))
+
+#define DI_TYPE_DEFAULT 0
+#define MAXSCREENS 6
+
+#define FLASHWRITE_CMD 5
+#define SPORTCMD_COPY 6
+
+typedef struct CelData
+{
+	uint32 celData[1];
+} CelData;
+
+typedef struct PLUTChunk
+{
+	int32 chunk_ID;
+	int32 chunk_size;
+	uint16 PLUT[32];
+} PLUTChunk;
+
+typedef struct CCB
+{
+	uint32 ccb_Flags;
+	struct CCB *ccb_NextPtr;
+	CelData *ccb_SourcePtr;
+	void *ccb_PLUTPtr;			// Host endian uint16 entries
+	Coord ccb_XPos;
+	Coord ccb_YPos;
+	int32 ccb_HDX;
+	int32 ccb_HDY;
+	int32 ccb_VDX;
+	int32 ccb_VDY;
+	int32 ccb_HDDX;
+	int32 ccb_HDDY;
+	uint32 ccb_PIXC;
+	uint32 ccb_PRE0;
+	uint32 ccb_PRE1;
+	int32 ccb_Width;
+	int32 ccb_Height;
+} CCB;
+
+typedef struct Bitmap
+{
+	ubyte *bm_Buffer;			// 3DO line pair layout, host endian uint16 pixels
+	int32 bm_Width;
+	int32 bm_Height;
+} Bitmap;
+
+typedef struct VdlChunk VdlChunk;
+
+typedef struct ScreenContext
+{
+	int32 sc_nScreens;
+	int32 sc_curScreen;
+	int32 sc_nFrameBufferPages;
+	int32 sc_nFrameByteCount;
+	Item sc_Screens[MAXSCREENS];
+	Item sc_BitmapItems[MAXSCREENS];
+	Bitmap *sc_Bitmaps[MAXSCREENS];
+} ScreenContext;
+
+Err OpenGraphicsFolio(void);
+Err CloseGraphicsFolio(void);
+bool CreateBasicDisplay(ScreenContext *sc, uint32 displayType, uint32 numScreens);
+void CloseGraphics(ScreenContext *sc);
+Err DisplayScreen(Item screenItem0, Item screenItem1);
+Err DrawCels(Item bitmapItem, CCB *ccb);
+Err DrawScreenCels(Item screenItem, CCB *ccb);
+bool DrawImage(Item screenItem, ubyte *image, ScreenContext *sc);
+Err DisableVAVG(Item screenItem);
+Err DisableHAVG(Item screenItem);
+void FadeToBlack(ScreenContext *sc, int32 frameCount);
+void FadeFromBlack(ScreenContext *sc, int32 frameCount);
+
+/* ----- celutils.h ----- */
+
+#define CLONECEL_CCB_ONLY		0x00000000
+#define CLONECEL_COPY_PIXELS	0x00000001
+#define CLONECEL_COPY_PLUT		0x00000002
+
+#define CREATECEL_UNCODED		0x00000000
+#define CREATECEL_CODED			0x00000001
+
+CCB *LoadCel(char *name, uint32 memTypeBits);
+void UnloadCel(CCB *cel);
+CCB *CloneCel(CCB *src, int32 options);
+CCB *CreateCel(int32 width, int32 height, int32 bitsPerPixel, int32 options, void *dataBuf);
+CCB *CreateBackdropCel(int32 width, int32 height, int32 color, int32 opacityPercent);
+void LinkCel(CCB *ccb, CCB *nextCCB);
+CCB *AllocMagicCel_(int32 extraBytes, uint32 magic, void *dataBuf, void *plutBuf);
+
+/* ----- displayutils.h / utils3do.h ----- */
+
+ubyte *LoadImage(char *name, ubyte *dest, VdlChunk **rawVDLPtr, ScreenContext *sc);
+void UnloadImage(ubyte *image);
+int32 GetFileSize(char *path);
+
+/* ----- mem.h ----- */
+
+#define MEMTYPE_ANY		0x00000000
+#define MEMTYPE_VRAM	0x00000001
+#define MEMTYPE_DRAM	0x00000002
+#define MEMTYPE_CEL		0x00000010
+
+typedef struct MemInfo
+{
+	uint32 minfo_SysFree;
+	uint32 minfo_SysLargest;
+	uint32 minfo_TaskFree;
+	uint32 minfo_TaskLargest;
+} MemInfo;
+
+void AvailMem(MemInfo *minfo, uint32 flags);
+
+/* ----- io.h ----- */
+
+typedef struct IOBuf
+{
+	void *iob_Buffer;
+	int32 iob_Len;
+} IOBuf;
+
+typedef struct IOInfo
+{
+	uint8 ioi_Command;
+	uint8 ioi_Flags;
+	uint8 ioi_Unit;
+	uint8 ioi_Flags2;
+	uint32 ioi_CmdOptions;
+	uint32 ioi_User;
+	int32 ioi_Offset;
+	IOBuf ioi_Send;
+	IOBuf ioi_Recv;
+} IOInfo;
+
+Item CreateVRAMIOReq(void);
+Item GetVBLIOReq(void);
+Err WaitVBL(Item ioreq, uint32 numFields);
+Err DoIO(Item ioreq, IOInfo *ioInfo);
+
+/* ----- timerutils.h ----- */
+
+typedef struct TimeVal
+{
+	int32 tv_Seconds;
+	int32 tv_Microseconds;
+} TimeVal;
+
+typedef struct VBlankTimeVal
+{
+	uint32 vbltv_VBlankHi32;
+	uint32 vbltv_VBlankLo32;
+} VBlankTimeVal;
+
+void SampleSystemTimeTV(TimeVal *tv);
+void SampleSystemTimeVBL(VBlankTimeVal *vbl);	// Host.Fields, see below
+void SubTimes(TimeVal *tv1, TimeVal *tv2, TimeVal *tv3);
+Item GetTimerIOReq(void);
+int32 GetMSecTime(Item ioreq);
+uint32 GetTime(Item ioreq);
+
+/* ----- event.h / controlpad.h ----- */
+
+#define ControlDown			0x80000000
+#define ControlUp			0x40000000
+#define ControlRight		0x20000000
+#define ControlLeft			0x10000000
+#define ControlA			0x08000000
+#define ControlB			0x04000000
+#define ControlC			0x02000000
+#define ControlStart		0x01000000
+#define ControlX			0x00800000
+#define ControlRightShift	0x00400000
+#define ControlLeftShift	0x00200000
+
+enum ListenerCategory
+{
+	LC_FocusListener = 0,
+	LC_Observer,
+	LC_FocusUI,
+	LC_NoSeeUms
+};
+
+typedef struct ControlPadEventData
+{
+	uint32 cped_ButtonBits;
+} ControlPadEventData;
+
+// Event broker, only control pad events and only observers
+
+#define EventPortName "eventbroker"
+#define EVENT_QUEUE_MAX_PERMITTED 20
+
+#define EVENTNUM_ControlButtonPressed 0x01
+#define EVENTNUM_ControlButtonReleased 0x02
+
+#define EVENTBIT0_ControlButtonPressed 0x40000000
+#define EVENTBIT0_ControlButtonReleased 0x20000000
+
+enum EventBrokerFlavor
+{
+	EB_NoOp = 0,
+	EB_Configure,
+	EB_ConfigureReply,
+	EB_EventRecord,
+	EB_EventReply
+};
+
+typedef struct EventBrokerHeader
+{
+	enum EventBrokerFlavor ebh_Flavor;
+} EventBrokerHeader;
+
+typedef struct ConfigurationRequest
+{
+	EventBrokerHeader cr;
+	enum ListenerCategory cr_Category;
+	uint32 cr_TriggerMask[8];
+	uint32 cr_CaptureMask[8];
+	int32 cr_QueueMax;
+	uint32 rfu[8];
+} ConfigurationRequest;
+
+typedef struct EventFrame
+{
+	uint32 ef_ByteCount;		// To the next frame, 0 ends the record
+	uint32 ef_SystemID;
+	uint32 ef_SystemTimeStamp;	// Field the event happened in
+	int32 ef_Submitter;
+	uint8 ef_EventNumber;
+	uint8 ef_PodNumber;
+	uint8 ef_PodPosition;
+	uint8 ef_GenericPosition;
+	uint8 ef_Trigger;
+	uint8 rfu1[3];
+	uint32 rfu2;
+	uint32 ef_EventData[1];
+} EventFrame;
+
+/* ----- msgport.h ----- */
+
+typedef struct Message
+{
+	Item msg_ReplyPort;
+	Err msg_Result;
+	void *msg_DataPtr;
+	int32 msg_DataSize;
+} Message;
+
+Item CreateMsgPort(const char *name, uint8 pri, uint32 signal);
+Err DeleteMsgPort(Item port);
+Item FindMsgPort(const char *name);
+Item CreateMsg(const char *name, uint8 pri, Item replyPort);
+Err DeleteMsg(Item msg);
+Err SendMsg(Item port, Item msg, const void *data, int32 size);
+Item GetMsg(Item port);
+Item WaitPort(Item port, Item msg);
+Err ReplyMsg(Item msg, int32 result, const void *data, int32 size);
+void *LookupItem(Item item);
+
+/* ----- operamath.h ----- */
+
+#define Convert32_F16(x) ((frac16)((x) << 16))
+#define ConvertF16_32(x) ((int32)((x) >> 16))
+
+Err OpenMathFolio(void);
+Err CloseMathFolio(void);
+frac16 DivSF16(frac16 d1, frac16 d2);
+frac16 MulSF16(frac16 m1, frac16 m2);
+
+/* ----- audio.h ----- */
+
+// Instruments, samples, knobs and envelopes are hostaudio.c's, mixed on the
+// audio clock, see the host mixer below. The clock moves for the sound file
+// player, SleepAudioTicks and HostAudioRun
+
+typedef uint32 AudioTime;
+
+typedef struct DataTimePair
+{
+	int32 dtpr_Time;				// Milliseconds from the start of the envelope
+	int32 dtpr_Data;
+} DataTimePair;
+
+#define AF_TAG_AMPLITUDE 1			// StartInstrument, 0..0x7FFF
+#define AF_TAG_RATE 2				// StartInstrument, variable rate players, 0x8000 is the sampled rate
+#define AF_TAG_NUMBYTES 3			// GetAudioItemInfo on a sample, as stored
+#define AF_TAG_FRAMES 4
+#define AF_TAG_SAMPLE_RATE 5		// ufrac16 Hz
+#define AF_TAG_CHANNELS 6
+
+#define AF_ERR_NORSRC (-1001)		// Not enough DSP left for the instrument
+#define AF_ERR_BADNAME (-1002)		// No such knob or port on the instrument
+#define AF_ERR_BADITEM (-1003)
+
+Err OpenAudioFolio(void);
+Err CloseAudioFolio(void);
+AudioTime GetAudioTime(void);
+Err SleepAudioTicks(int32 ticks);
+
+Item LoadInsTemplate(char *name, Item aiffFile);
+Err UnloadInsTemplate(Item tmpl);
+Item AllocInstrument(Item tmpl, uint8 priority);
+Err FreeInstrument(Item ins);
+Item LoadInstrument(char *name, Item aiffFile, uint8 priority);
+Err UnloadInstrument(Item ins);
+Err StartInstrument(Item ins, TagArg *tags);
+Err ReleaseInstrument(Item ins, TagArg *tags);
+Err StopInstrument(Item ins, TagArg *tags);
+Err PauseInstrument(Item ins);		// A sound file player's sampler only, host3do.c
+Err ResumeInstrument(Item ins);
+Err ConnectInstruments(Item src, char *srcName, Item dst, char *dstName);
+Err DisconnectInstruments(Item src, char *srcName, Item dst, char *dstName);
+
+Item GrabKnob(Item ins, char *name);
+Err ReleaseKnob(Item knob);
+Err TweakKnob(Item knob, int32 value);
+Err TweakRawKnob(Item knob, int32 value);
+
+Item LoadSample(char *name);		// AIFF, or AIFC SDX2
+Item MakeSample(uint32 numBytes, TagArg *tags);	// Silent, 16 bit mono 44.1kHz
+Err UnloadSample(Item sample);
+Item AttachSample(Item ins, Item sample, char *hookName);
+Err DetachSample(Item attachment);
+char *SelectSamplePlayer(Item sample, bool ifVariable);	// NULL if no player takes its format
+Err GetAudioItemInfo(Item item, TagArg *tags);
+
+Item CreateEnvelope(DataTimePair *points, int32 numPoints, int32 sustainBegin, int32 sustainEnd);
+Err DeleteEnvelope(Item env);
+Item AttachEnvelope(Item ins, Item env, char *hookName);
+Err DetachEnvelope(Item attachment);
+
+// Cues are host3do.c's, on the audio clock with the sound file player's
+// buffers. Each one has a signal of the task that made it, and setting one
+// that is already set moves it rather than adding a second
+
+#define AUDIONODE 4
+#define AUDIO_CUE_NODE 9
+#define MKNODEID(folio, node) (((folio) << 8) | (node))
+
+int32 GetCueSignal(Item cue);
+Err SignalAtTime(Item cue, AudioTime time);
+
+/* ----- kernel ----- */
+
+uint32 ReadHardwareRandomNumber(void);
+Item CreateItem(int32 cType, TagArg *tags);	// Audio cues only
+Err DeleteItem(Item item);
+
+/* ----- kernel.h / task.h ----- */
+
+// Threads are pthreads, signals a mask per thread under one lock
+
+typedef struct ItemNode
+{
+	Item n_Item;
+} ItemNode;
+
+typedef struct Task
+{
+	ItemNode t;
+} Task;
+
+#define CURRENTTASK (HostCurrentTask())
+
+Task *HostCurrentTask(void);
+Item CreateThread(const char *name, uint8 pri, void (*code)(), int32 stacksize);
+Err DeleteThread(Item thread);
+int32 AllocSignal(int32 sigMask);
+Err FreeSignal(int32 sigMask);
+Err SendSignal(Item task, int32 sigMask);
+int32 WaitSignal(int32 sigMask);	// 0 ends the thread, only DeleteThread is left to come
+int32 GetCurrentSignals(void);		// A macro on the 3DO, sent and not waited for yet
+void Yield(void);
+
+/* ----- soundfile.h ----- */
+
+// A simulated drive and sampler on a virtual audio clock, so a spooler run
+// takes no real time and comes out the same every time. Each buffer has a
+// signal, sent when it has played. The clock moves by the read time while
+// StartSoundFile / ServiceSoundFile read, and jumps to the next buffer's end
+// when the spooler waits with nothing sent. HostDrive.LoadTicks out of every
+// LoadEvery the drive is busy with something else, a background load, and a
+// read that lands there waits for it. StartSoundFile fills every buffer
+// before the sampler starts, a paused sampler holds what it has queued and
+// resuming plays it from then on
+
+#define HOST_SFP_BUFFERS 16
+
+typedef struct SoundFilePlayer
+{
+	int32 sfp_NumBuffers;
+	int32 sfp_BufSize;
+	Item sfp_SamplerIns;
+	Item Owner;						// Host only from here, the task the signals are for
+	int32 Signal[HOST_SFP_BUFFERS];
+	bool Queued[HOST_SFP_BUFFERS];
+	int Next;						// Next to refill, they play in turn
+	uint32 FileBytes;
+	uint32 Cursor;					// Next byte to read
+	AudioTime PlayedTo;				// When the last queued buffer ends
+	uint32 Bytes[HOST_SFP_BUFFERS];	// In each queued buffer
+	bool Paused;
+	int32 Amplitude;				// StartSoundFile's, then whatever its Amplitude knob was set to
+	void *Buffers;
+} SoundFilePlayer;
+
+typedef struct HostDriveModel
+{
+	uint32 PlayBytesPerSecond;
+	uint32 ReadBytesPerSecond;
+	uint32 FileSeconds;				// Of every file LoadSoundFile opens
+	uint32 LoadEvery;				// Audio ticks, 0 for a drive to ourselves
+	uint32 LoadTicks;
+	uint32 Reads;
+	uint32 ReadWaits;				// Reads that waited for a load to finish
+	uint32 Gaps;					// Buffers queued after the sampler had run dry
+	uint32 TrackGaps;				// Samplers resumed after the one playing before had run dry
+	uint32 SilentTracks;			// Samplers resumed at amplitude 0, nothing here drives it from an envelope
+} HostDriveModel;
+
+extern HostDriveModel HostDrive;
+
+SoundFilePlayer *CreateSoundFilePlayer(int32 numBuffers, int32 bufSize, void *buffers[]);
+int32 DeleteSoundFilePlayer(SoundFilePlayer *sfp);
+int32 LoadSoundFile(SoundFilePlayer *sfp, char *fileName);
+int32 UnloadSoundFile(SoundFilePlayer *sfp);
+int32 RewindSoundFile(SoundFilePlayer *sfp);
+int32 StartSoundFile(SoundFilePlayer *sfp, int32 amplitude);
+int32 StopSoundFile(SoundFilePlayer *sfp);
+int32 *HostSamplerAmplitude(Item ins);	// For the stand-in's knobs, NULL if ins isn't a sampler
+int32 ServiceSoundFile(SoundFilePlayer *sfp, int32 signalIn, int32 *signalNeeded);
+
+/* ----- juggler.h / midifile.h / score.h, hostjuggler.c ----- */
+
+// Just enough of the juggler and the score player for HD3DOAudioScore.c.
+// MFLoadCollection doesn't read the file, the collection it makes is one
+// sequence of HOST_SCORE_EVENTS events a beat apart, a beat being a quarter
+// of the parser's mfp_Rate. BumpJuggler plays the ones due on the time it's
+// given, returns the next one's time and goes negative once the last
+// repetition has played, which is how HD3DOAudioScore.c hears the music
+// has ended. MIDI volume lands in HostScore.Volume, the rest of the context
+// is only made and freed
+
+#define __SCORE_H					// The SDK's score.h sits next to the game sources and is found first, its guard keeps it out
+
+#define HOST_SCORE_EVENTS 32
+#define HOST_SCORE_CHANNELS 16
+#define NUMMIDICHANNELS HOST_SCORE_CHANNELS
+
+#define JGLR_TAG_INTERPRETER_FUNCTION 1
+#define JGLR_TAG_CONTEXT 2
+
+typedef uint32 Time;
+
+typedef struct COBClass
+{
+	int32 Kind;
+} COBClass;
+
+typedef struct Sequence
+{
+	void *Interpreter;				// From SetObjectInfo
+	void *Context;
+} Sequence;
+
+typedef struct Collection
+{
+	Sequence Seq;
+	bool Used;
+	bool Active;					// Started and not all played
+	Time Start;
+	uint32 Total;					// Events in all the repetitions
+	uint32 Next;					// To play
+} Collection;
+
+typedef struct MIDIEvent
+{
+	uint32 mev_Time;
+	uint8 mev_Command;
+	uint8 mev_Data1;
+	uint8 mev_Data2;
+} MIDIEvent;
+
+typedef struct MIDIFileParser
+{
+	int32 mfp_Rate;					// Ticks per second the collection's times are in
+} MIDIFileParser;
+
+typedef struct ScoreContext
+{
+	int32 scon_MaxPrograms;
+	int32 scon_MaxVoices;			// InitScoreMixer's
+	bool scon_PIMapLoaded;
+} ScoreContext;
+
+typedef struct HostScoreStats
+{
+	Time Beat;						// Score ticks between events
+	uint32 Played;					// Events BumpJuggler has played
+	uint32 Bumps;
+	uint32 IdleBumps;				// Bumps with nothing due
+	Time LateMax;					// Score ticks the latest event played after it was due
+	int32 Volume[HOST_SCORE_CHANNELS];	// MIDI controller 7 by channel
+	uint32 Freed;					// FreeChannelInstruments calls
+} HostScoreStats;
+
+extern HostScoreStats HostScore;
+extern COBClass CollectionClass;
+
+int32 InitJuggler(void);
+int32 TermJuggler(void);
+void *CreateObject(COBClass *objClass);	// A Collection, the one the stand-in has
+int32 DestroyObject(void *object);
+int32 GetNthFromObject(void *object, int32 n, void *nth);
+int32 SetObjectInfo(void *object, TagArg *tags);
+int32 StartObject(void *object, Time time, int32 reps, void *parent);
+int32 StopObject(void *object, Time time);
+int32 BumpJuggler(Time currentTime, Time *nextTime, int32 currentSignals, int32 *nextSignals);
+
+Err MFLoadCollection(MIDIFileParser *mfpptr, char *filename, Collection *colPtr);
+Err MFUnloadCollection(Collection *colPtr);
+
+ScoreContext *CreateScoreContext(int32 maxNumPrograms);
+Err DeleteScoreContext(ScoreContext *scon);
+Err InitScoreMixer(ScoreContext *scon, char *mixerName, int32 maxNumVoices, int32 amplitude);
+Err TermScoreMixer(ScoreContext *scon);
+Err LoadPIMap(ScoreContext *scon, char *fileName);
+Err UnloadPIMap(ScoreContext *scon);
+Err ChangeScoreControl(ScoreContext *scon, int32 channel, int32 index, int32 value);
+Err FreeChannelInstruments(ScoreContext *scon, int32 channel);
+Err InterpretMIDIEvent(Sequence *seqPtr, MIDIEvent *mevCur, ScoreContext *scon);
+
+/* ----- Host only ----- */
+
+#define HOST_CALL_DRAWCELS		0
+#define HOST_CALL_DISPLAYSCREEN	1
+#define HOST_CALL_DOIO			2
+#define HOST_CALL_DRAWIMAGE		3
+#define HOST_CALL_LOADCEL		4
+#define HOST_CALL_UNLOADCEL		5
+#define HOST_CALL_CREATECEL		6
+#define HOST_CALL_LOADIMAGE		7
+#define HOST_CALL_UNLOADIMAGE	8
+#define HOST_CALL_GETMSG		9
+#define HOST_CALL_SYSTEMTIME	10
+#define HOST_CALL_CALLSOUND		11
+#define HOST_CALL_WAITVBL		12
+#define HOST_CALLS				13
+
+typedef struct HostCallStats
+{
+	uint32 Count;
+	uint64 TotalNS;
+	uint64 MaxNS;
+} HostCallStats;
+
+typedef struct HostFrameStats
+{
+	uint32 CelsDrawn;
+	uint32 CelsSkipped;
+	uint32 PixelsFilled;		// Frame buffer writes, a pixel drawn twice counts twice
+} HostFrameStats;
+
+typedef struct HostStats
+{
+	HostCallStats Calls[HOST_CALLS];
+	uint32 Frames;				// DisplayScreen calls
+	uint32 Fields;				// One per DisplayScreen plus every WaitVBL field, the event broker's clock
+	uint64 CelsDrawn;
+	uint64 CelsSkipped;
+	uint64 PixelsFilled;
+	HostFrameStats Frame;		// Since the last DisplayScreen
+	HostFrameStats LastFrame;	// The frame DisplayScreen just showed
+	HostFrameStats PeakFrame;	// The frame with the most pixels filled
+	uint32 PeakFrameNum;
+	uint32 LiveBytes;			// Everything the stand-in allocated for the game
+	uint32 HighBytes;
+	int LiveBlocks;
+	uint32 SoundCommands[32];	// CallSound by whatIWant
+	uint32 PadEvents;			// Pad changes the event broker sent
+	uint32 PadPresses;			// Button down edges in them
+	uint32 PadPushes;			// Buttons the driver pushed while someone listened, each one a press sent
+} HostStats;
+
+extern HostStats Host;
+extern char *HostDataRoot;		// Prepended to the CD relative paths the game uses
+extern uint32 HostRandomSeed;
+extern uint32 HostRandom;		// ReadHardwareRandomNumber's last number, the game's only one is its piece seed
+extern bool HostVsync;			// Pace DisplayScreen to 60Hz, otherwise run flat out
+extern bool HostRaster;			// Draw cels into the frame buffers, otherwise only count them
+
+uint64 HostNowNS(void);
+void HostRecordCall(int call, uint64 startNS);
+void HostReport(void);
+ubyte *HostReadFile(char *path, int32 *size);	// Under HostDataRoot, free() it
+void HostAudioRun(uint32 ticks);				// Moves the audio clock on, cues that fall due are sent
+int HostCuesSet(int32 signals);					// This task's cues waiting on the audio clock for any of signals
+
+/* ----- Host mixer, hostaudio.c ----- */
+
+// The instruments the audio folio calls above make, mixed into a 44.1kHz
+// stereo recording on the audio clock. A call that changes what's playing
+// first mixes everything up to now as it was, so the recording is right to
+// the frame whatever moved the clock. Sample players play their attached
+// sample from StartInstrument to its end or StopInstrument, into the mixer
+// input they are connected to, and mixer8x2.dsp sums the inputs through its
+// LeftGain / RightGain knobs. Envelopes and the room instruments only take
+// DSP, the sound file player's sampler is timing only
+//
+// Each instrument takes its template's ticks from HostMix.DSPTicks and
+// AF_ERR_NORSRC comes back when they're gone, the way the DSP runs out.
+// Starts, stops and ends go in an event list with the frame they happened
+// at, a voice's first audible frame (past HOST_MIX_AUDIBLE) too
+
+#define HOST_MIX_RATE 44100
+#define HOST_MIX_INPUTS 8			// mixer8x2.dsp
+#define HOST_MIX_DSP_TICKS 565		// Per frame on the DSP, what the templates share
+#define HOST_MIX_AUDIBLE 328		// -40dB of full scale, before the mixer's gain
+#define HOST_MIX_EVENTS 4096
+
+#define HOST_MIX_START 0
+#define HOST_MIX_STOP 1				// StopInstrument on a voice that was playing
+#define HOST_MIX_END 2				// Played to the end of its sample
+#define HOST_MIX_AUDIBLE_AT 3
+#define HOST_MIX_CONNECT 4
+#define HOST_MIX_DISCONNECT 5
+#define HOST_MIX_NORSRC 6			// An instrument the DSP had no room for
+
+typedef struct HostMixEvent
+{
+	uint32 Type;					// HOST_MIX_*
+	Item Voice;
+	int32 Input;					// Mixer input it is on, -1 for none
+	uint64 Frame;					// Of the recording
+	uint64 NS;						// HostNowNS when the call was made, for AUDIBLE_AT the START's
+	char Sample[32];				// Attached when it happened, the file's name without the directory
+} HostMixEvent;
+
+typedef struct HostMixStats
+{
+	uint32 DSPTicks;				// Budget, set before instruments are allocated
+	uint32 DSPUsed;
+	uint32 DSPPeak;
+	uint32 NoResource;
+	uint32 Instruments;				// Allocated now
+	uint32 Samples;
+	uint32 SampleBytes;				// As stored, SDX2 is half of 16 bit
+	uint64 Frames;					// Mixed
+	uint32 Clipped;					// Frames either side hit full scale
+	uint32 Events;					// In HostMixEvents, any past HOST_MIX_EVENTS are counted in Dropped
+	uint32 Dropped;
+	int32 Gain[HOST_MIX_INPUTS][2];	// The mixer's knobs, left then right
+	Item Voice[HOST_MIX_INPUTS];	// Connected to each input, 0 for none
+} HostMixStats;
+
+extern HostMixStats HostMix;
+extern HostMixEvent HostMixEvents[HOST_MIX_EVENTS];
+
+void HostMixRecord(uint32 seconds);	// Keep what's mixed from now, up to seconds of it
+void HostMixFlush(void);			// Mixes up to the clock
+bool HostMixPlaying(Item voice);
+bool HostMixWriteWAV(char *path);	// The recording, its events to path with .log on the end
+
+void HostRasterCels(Bitmap *bm, CCB *ccb);	// hostcel.c, bm NULL only counts
+uint32 HostFrameCRC(void);					// Of the screen DisplayScreen last showed
+bool HostWriteFramePPM(char *path);
+
+// Provided by whichever driver is linked (hostmain.c for the game runner, hostbench.c for the benchmarks)
+
+typedef struct HostPadEvent
+{
+	uint32 Bits;
+	uint32 Field;				// Host.Fields it happened in
+} HostPadEvent;
+
+#define HOST_PAD_EVENTS 32
+
+int HostPollPad(HostPadEvent *events);	// Pad changes since the last call, up to HOST_PAD_EVENTS, once per event read
+void HostFrameDone(void);		// After every DisplayScreen, may exit()
+
+#endif
@@ -0,0 +1,51 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	Placement bot shared by tetrissim and tetrishost, on the rules in
+//	HD3DOGame.c alone. Each rotation and column for the active block is tried
+//	on a copy of the state, locked, and the board scored on lines, height,
+//	holes and bumpiness
+//
+
+*/
+
+#ifndef HOSTBOT_H
+#define HOSTBOT_H
+
+#include "HD3DOGame.h"
+
+#define BOT_MAX_PLACEMENTS (4 * (BOARD_WIDTH + 1))	// Rotations by shifts of -5 to 5 on 10 wide
+
+typedef struct BotPlacement
+{
+	int Turns;					// Clockwise rotations from where the block is
+	int Shift;					// Columns from where the block is
+	int Score;
+	int Lines;					// It would clear
+	uint32 Board;				// BoardHash once it's locked, the same placement whatever path led there
+} BotPlacement;
+
+int BotScoreBoard(GameState *gs, int lines);
+bool BotSteer(GameState *gs, int turns, int shift);		// The way the pad would, false if it can't get there
+int BotPlacements(GameState *gs, BotPlacement *out);	// Up to BOT_MAX_PLACEMENTS, none if every one ends the game
+int BotBest(BotPlacement *options, int count);			// Highest score, the first found on a tie
+
+#endif
@@ -0,0 +1 @@
+#include "host3do.h" /* Host stand-in, see host3do.h */
@@ -0,0 +1,9 @@
+#ifndef HOST_STRINGS_H
+#define HOST_STRINGS_H
+
+/* The 3DO strings.h carries the string.h functions too */
+
+#include_next <strings.h>
+#include <string.h>
+
+#endif
@@ -0,0 +1,488 @@
+/*
+Copyright 2023 Shaun Nicholson - 3DOHD
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the “Software”), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//
+//	16 bit AIFF to the 3DO's 2:1 compressed AIFC, SDX2 (squareroot delta
+//	exact). Each sample is one signed byte n: an even n is the sample
+//	2 * n * |n| outright, an odd n adds that to the one before. The audio
+//	folio decodes it on the DSP, so SelectSamplePlayer hands back a
+//	decompressing instrument for these samples and nothing else changes
+//
+//	Every byte is chosen against the decoded sample before it, not the
+//	original, so the error never builds up. --half low passes and drops
+//	every other frame first, for sounds with nothing above a quarter of
+//	their rate
+//
+//	sdx2enc [--half] in.aiff out.aiff		encodes one file
+//	sdx2enc --check masters dir				every 16 bit AIFF in masters against
+//											dir: each must be the encoding of its
+//											master, sizes and SNR reported
+//	sdx2enc --update masters dir			writes the encodings into dir
+//
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <dirent.h>
+
+#define SDX2_MAX_CHANNELS 2
+#define SDX2_MAX_FILES 64
+#define SDX2_HALF_TAPS 31			// Odd, windowed sinc for --half
+#define SDX2_MIN_SNR 25.0			// dB, below this --check fails the file. The smallest steps are 2, 8 and 18, quiet sounds score lowest
+#define SDX2_FVER 0xA2805140		// AIFC version 1
+#define SDX2_NAME "Squareroot Delta Exact"
+
+typedef struct Sound
+{
+	int Channels;
+	int Frames;
+	int Rate;
+	short *Samples;					// Interleaved
+} Sound;
+
+static short squares[256];			// By byte, 2 * n * |n|
+
+/* ----- Big endian ----- */
+
+static unsigned Get16(unsigned char *p) { return (p[0] << 8) | p[1]; }
+static unsigned Get32(unsigned char *p) { return ((unsigned)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+
+static void Put16(unsigned char *p, unsigned v) { p[0] = v >> 8; p[1] = v; }
+static void Put32(unsigned char *p, unsigned v) { p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v; }
+
+static int GetRate(unsigned char *p) // 80 bit extended, whole numbers only
+{
+	int exp = (Get16(p) & 0x7fff) - 16383;
+	unsigned mant = Get32(p + 2);
+
+	return exp < 0 || exp > 31 ? 0 : (int)(mant >> (31 - exp));
+}
+
+static void PutRate(unsigned char *p, int rate)
+{
+	int exp = 31;
+
+	memset(p, 0, 10);
+
+	if (rate <= 0) return;
+
+	while (((unsigned)rate & 0x80000000u) == 0)
+	{
+		rate <<= 1;
+		exp--;
+	}
+
+	Put16(p, 16383 + exp);
+	Put32(p + 2, (unsigned)rate);
+}
+
+/* ----- Files ----- */
+
+static unsigned char *ReadFile(char *path, long *size)
+{
+	FILE *f = fopen(path, "rb");
+	unsigned char *data;
+
+	if (f == NULL) return NULL;
+
+	fseek(f, 0, SEEK_END);
+	*size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	data = (unsigned char *)malloc(*size + 1);
+
+	if (data != NULL && fread(data, 1, *size, f) != (size_t)*size)
+	{
+		free(data);
+		data = NULL;
+	}
+
+	fclose(f);
+
+	return data;
+}
+
+// Chunks of a FORM, NULL if it isn't there
+
+static unsigned char *FindChunk(unsigned char *data, long size, char *id, unsigned *length)
+{
+	long p = 12;
+
+	while (p + 8 <= size)
+	{
+		*length = Get32(data + p + 4);
+
+		if (memcmp(data + p, id, 4) == 0 && p + 8 + (long)*length <= size) return data + p + 8;
+
+		p += 8 + *length + (*length & 1);
+	}
+
+	return NULL;
+}
+
+// 16 bit AIFF, false for anything else including files already compressed
+
+static int LoadAIFF(char *path, Sound *s)
+{
+	unsigned char *data, *comm, *ssnd;
+	unsigned length, offset;
+	long size;
+	int i, n;
+
+	data = ReadFile(path, &size);
+
+	if (data == NULL) return 0;
+
+	if (size < 12 || memcmp(data, "FORM", 4) != 0 || memcmp(data + 8, "AIFF", 4) != 0 ||
+		(comm = FindChunk(data, size, "COMM", &length)) == NULL || length < 18 ||
+		(ssnd = FindChunk(data, size, "SSND", &length)) == NULL || length < 8)
+	{
+		free(data);
+
+		return 0;
+	}
+
+	s->Channels = Get16(comm);
+	s->Frames = Get32(comm + 2);
+	s->Rate = GetRate(comm + 8);
+
+	offset = Get32(ssnd);
+	n = s->Frames * s->Channels;
+
+	if (Get16(comm + 6) != 16 || s->Channels < 1 || s->Channels > SDX2_MAX_CHANNELS || 8 + offset + 2 * (unsigned)n > length)
+	{
+		free(data);
+
+		return 0;
+	}
+
+	s->Samples = (short *)malloc(n * sizeof(short) + 1);
+
+	for (i = 0; i < n; i++)
+	{
+		s->Samples[i] = (short)Get16(ssnd + 8 + offset + 2 * i);
+	}
+
+	free(data);
+
+	return 1;
+}
+
+#define SDX2_HEADER (12 + 12 + 8 + 44 + 16)	// FORM, FVER, COMM, SSND up to the data
+
+static unsigned char *BuildAIFC(Sound *s, signed char *codes, long *length)
+{
+	int n = s->Frames * s->Channels, name = strlen(SDX2_NAME);
+	unsigned char *data, *p;
+
+	*length = SDX2_HEADER + n + (n & 1);
+	data = p = (unsigned char *)calloc(1, *length);
+
+	memcpy(p, "FORM", 4); Put32(p + 4, *length - 8); memcpy(p + 8, "AIFC", 4); p += 12;
+	memcpy(p, "FVER", 4); Put32(p + 4, 4); Put32(p + 8, SDX2_FVER); p += 12;
+
+	memcpy(p, "COMM", 4); Put32(p + 4, 44); p += 8;
+	Put16(p, s->Channels);
+	Put32(p + 2, s->Frames);
+	Put16(p + 6, 16); // What it decodes to
+	PutRate(p + 8, s->Rate);
+	memcpy(p + 18, "SDX2", 4);
+	p[22] = name;
+	memcpy(p + 23, SDX2_NAME, name); // Pascal string, padded to even
+	p += 44;
+
+	memcpy(p, "SSND", 4); Put32(p + 4, 8 + n + (n & 1)); p += 16; // Offset and block size 0
+
+	memcpy(p, codes, n);
+
+	return data;
+}
+
+static long SaveAIFC(char *path, Sound *s, signed char *codes)
+{
+	unsigned char *data;
+	long length;
+	FILE *f;
+
+	data = BuildAIFC(s, codes, &length);
+	f = fopen(path, "wb");
+
+	if (f == NULL || fwrite(data, 1, length, f) != (size_t)length) length = -1;
+
+	if (f != NULL) fclose(f);
+
+	free(data);
+
+	return length;
+}
+
+/* ----- Coding ----- */
+
+static void InitSquares()
+{
+	int i, n;
+
+	for (i = 0; i < 256; i++)
+	{
+		n = (signed char)i;
+		squares[i] = (short)(2 * n * (n < 0 ? -n : n));
+	}
+}
+
+static int Decode(int code, int prev)
+{
+	int v = squares[code & 0xff];
+
+	if (code & 1) v += prev;
+
+	return v < -32768 ? -32768 : v > 32767 ? 32767 : v;
+}
+
+// Closest byte to each sample given the decoded one before it. Returns the SNR in dB
+
+static double Encode(Sound *s, signed char *codes)
+{
+	int prev[SDX2_MAX_CHANNELS] = { 0 };
+	int i, c, best, bestErr, err, v, ch;
+	double signal = 0, noise = 0;
+
+	for (i = 0; i < s->Frames * s->Channels; i++)
+	{
+		ch = i % s->Channels;
+		best = 0;
+		bestErr = 0x7fffffff;
+
+		for (c = -128; c < 128; c++)
+		{
+			err = Decode(c, prev[ch]) - s->Samples[i];
+
+			if (err < 0) err = -err;
+
+			if (err < bestErr)
+			{
+				bestErr = err;
+				best = c;
+			}
+		}
+
+		codes[i] = (signed char)best;
+		v = prev[ch] = Decode(best, prev[ch]);
+
+		signal += (double)s->Samples[i] * s->Samples[i];
+		noise += (double)(v - s->Samples[i]) * (v - s->Samples[i]);
+	}
+
+	return noise == 0 ? 99.0 : 10.0 * log10(signal / noise);
+}
+
+// Low pass at half the new Nyquist and every other frame kept
+
+static void Half(Sound *s)
+{
+	double taps[SDX2_HALF_TAPS], sum, x;
+	int frames = s->Frames / 2, mid = SDX2_HALF_TAPS / 2;
+	short *out = (short *)malloc(frames * s->Channels * sizeof(short) + 1);
+	int i, k, ch, j;
+
+	for (k = 0; k < SDX2_HALF_TAPS; k++)
+	{
+		x = k - mid;
+		taps[k] = (x == 0 ? 0.45 : sin(M_PI * 0.45 * x) / (M_PI * x)) * (0.54 - 0.46 * cos(2 * M_PI * k / (SDX2_HALF_TAPS - 1)));
+	}
+
+	for (i = 0; i < frames; i++)
+	{
+		for (ch = 0; ch < s->Channels; ch++)
+		{
+			sum = 0;
+
+			for (k = 0; k < SDX2_HALF_TAPS; k++)
+			{
+				j = 2 * i + k - mid;
+
+				if (j >= 0 && j < s->Frames) sum += taps[k] * s->Samples[j * s->Channels + ch];
+			}
+
+			sum = floor(sum + 0.5);
+			out[i * s->Channels + ch] = (short)(sum < -32768 ? -32768 : sum > 32767 ? 32767 : sum);
+		}
+	}
+
+	free(s->Samples);
+
+	s->Samples = out;
+	s->Frames = frames;
+	s->Rate /= 2;
+}
+
+/* ----- Commands ----- */
+
+static int EncodeFile(char *in, char *out, int half)
+{
+	Sound s;
+	signed char *codes;
+	long before, after;
+	double snr;
+
+	if (LoadAIFF(in, &s) == 0)
+	{
+		printf("SDX2 FAIL: %s isn't a 16 bit AIFF\n", in);
+
+		return 1;
+	}
+
+	before = 54 + 2L * s.Frames * s.Channels;
+
+	if (half) Half(&s);
+
+	codes = (signed char *)malloc(s.Frames * s.Channels + 1);
+	snr = Encode(&s, codes);
+	after = SaveAIFC(out, &s, codes);
+
+	printf("SDX2 %-24s %7ld -> %7ld bytes %d Hz, SNR %.1f dB\n", in, before, after, s.Rate, snr);
+
+	free(codes);
+	free(s.Samples);
+
+	return after < 0;
+}
+
+static int CompareNames(const void *a, const void *b)
+{
+	return strcmp(*(char **)a, *(char **)b);
+}
+
+// Each master's encoding against the file of the same name in dir, or written there
+
+static int CheckDir(char *masters, char *dir, int update)
+{
+	char *names[SDX2_MAX_FILES], in[512], out[512];
+	long before = 0, after = 0, length, onDisc, size;
+	int count = 0, status = 0, i, len;
+	unsigned char *data, *mine;
+	signed char *codes;
+	struct dirent *e;
+	double snr;
+	DIR *d;
+	Sound s;
+
+	d = opendir(masters);
+
+	if (d == NULL)
+	{
+		printf("SDX2 FAIL: no %s\n", masters);
+
+		return 1;
+	}
+
+	while ((e = readdir(d)) != NULL && count < SDX2_MAX_FILES)
+	{
+		len = strlen(e->d_name);
+
+		if (len > 5 && strcmp(e->d_name + len - 5, ".aiff") == 0) names[count++] = strdup(e->d_name);
+	}
+
+	closedir(d);
+
+	qsort(names, count, sizeof(char *), CompareNames); // readdir order is the filesystem's
+
+	for (i = 0; i < count; i++)
+	{
+		sprintf(in, "%s/%s", masters, names[i]);
+		sprintf(out, "%s/%s", dir, names[i]);
+
+		if (LoadAIFF(in, &s) == 0)
+		{
+			printf("SDX2 FAIL: master %s isn't a 16 bit AIFF\n", in);
+
+			status = 1;
+
+			continue;
+		}
+
+		size = 54 + 2L * s.Frames * s.Channels;
+		codes = (signed char *)malloc(s.Frames * s.Channels + 1);
+		snr = Encode(&s, codes);
+		mine = BuildAIFC(&s, codes, &length);
+
+		if (update) SaveAIFC(out, &s, codes);
+
+		data = ReadFile(out, &onDisc);
+
+		if (data == NULL || onDisc != length || memcmp(data, mine, length) != 0)
+		{
+			printf("SDX2 FAIL: %s isn't the SDX2 encoding of %s, make sdx2-update writes it\n", out, in);
+
+			status = 1;
+		}
+
+		if (snr < SDX2_MIN_SNR)
+		{
+			printf("SDX2 FAIL: %s only %.1f dB\n", in, snr);
+
+			status = 1;
+		}
+
+		printf("SDX2 %-16s %7ld -> %7ld bytes, %5.1f%%, SNR %.1f dB\n", names[i], size, length, (100.0 * length) / size, snr);
+
+		before += size;
+		after += length;
+
+		free(mine);
+		free(data);
+		free(codes);
+		free(s.Samples);
+		free(names[i]);
+	}
+
+	printf("SDX2 %d files %ld -> %ld bytes, %.1f%%\n", count, before, after, before ? (100.0 * after) / before : 0.0);
+
+	if (count == 0) status = 1;
+
+	printf(status ? "SDX2 FAIL\n" : "SDX2 PASS\n");
+
+	return status;
+}
+
+static void Usage()
+{
+	printf("sdx2enc [--half] in.aiff out.aiff\n");
+	printf("sdx2enc --check masters dir\n");
+	printf("sdx2enc --update masters dir\n");
+
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	InitSquares();
+
+	if (argc == 4 && strcmp(argv[1], "--check") == 0) return CheckDir(argv[2], argv[3], 0);
+	if (argc == 4 && strcmp(argv[1], "--update") == 0) return CheckDir(argv[2], argv[3], 1);
+	if (argc == 4 && strcmp(argv[1], "--half") == 0) return EncodeFile(argv[2], argv[3], 1);
+	if (argc == 3) return EncodeFile(argv[1], argv[2], 0);
+
+	Usage();
+
+	return 2;
+}
@@ -27,11 +27,16 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "tetris.h"
 #include "celutils.h"
 #include "HD3DO.h"
-//#include "HD3DOAudio.h"
+#include "HD3DOAudio.h"
 #include "HD3DOAudioSFX.h"
 #include "HD3DOAudioSoundInterface.h"
 
 #include "tools.h"
+#include "HD3DOPerf.h"
+#include "HD3DOMem.h"
+#include "HD3DOReplay.h"
+#include "HD3DOInput.h"
+#include "HD3DOSnapshot.h"
 
 void CleanupTempCels();
 void Cleanup();
@@ -41,22 +46,15 @@ void InitCCBFlags(CCB *cel);
 
 void GameLoop();
 void HandleInput();
+void LateLatchInput();
+void MarkPhoton(uint32 field);
+uint32 InputClockMS();
 void HandleInputOptionsMenu(uint32 joyBits);
 void HandleInputStartMenu(uint32 joyBits);
 void HandleOptionsMenuLogic();
 void HandleStartMenuLogic();
 void HandleGameplayLogic();
 void HandleSelectedOptions();
-bool TryMoveLeft();
-bool TryMoveRight();
-bool TryMoveUp();
-bool TryMoveDown();
-bool TryRotate(bool counterClockwise);
-void Rotate(bool counterClockwise);
-void MoveLeft();
-void MoveRight(); 
-void MoveUp();
-void MoveDown(bool);
 
 void DisplayBackgroundOnly();
 void DisplayStartScreen();
@@ -66,12 +64,13 @@ void ToggleStartMenuSelection();
 void ToggleOptionsMenuSelection(int);
 
 void ApplySelectedColorPalette();
+void PositionBoardCel(CCB *cel, int x, int y);
+void ScaleBoardCel(CCB *cel);
 void DrawGamePlayScreen();
 void Explode();
 void GameOverKillBlocks();
 void ReadyIn321();
 void PauseScreen();
-void CheckForNextLevel();
 void ApplyCurrentThemeBackground();
 void ShowStartMenu();
 void HideStartMenu();
@@ -83,15 +82,21 @@ void HideOptionsMenu();
 void ToggleOptionsMenu(bool optionsMenuSelected);
 void SwapBackgroundImage(char *file, int imgIdx);
 
-void QueueNextBlock();
-void LoadNextBlockFromQueue();
-void HoldBlock();
+void ShowQueuedBlock(int shape);
+void ShowHeldBlock(int shape);
+void ShowActiveBlock(bool fromQueue);
 void SwapActiveBlockWithHeldBlock();
 
 void InitGame();
 
 void PlayBackgroundMusic();
+void ApplyCurrentThemeMusic();
+char **ThemePlaylist();
+void SetMusicTempo();
 void PlaySFX(int id);
+void PlaySFXAt(int id, int pan);
+int PiecePan();
+void FlushSFX();
 
 void ShowIntroSplash();
 
@@ -110,21 +115,8 @@ static DebugData dData;
 
 static int visibleScreenPage = 0;
 
-static bool GamePlayBlocks[10][18] =
-{
-    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
-    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
-	{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
-	{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
-	{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
-	{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
-	{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
-	{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
-	{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
-	{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 }
-};
+GameState Game; // The board on screen. The rules in HD3DOGame.c work on any number of them
 
-static int BlockPivotIdx[7] = { 2, -1, 1, 1, 1, 2, 2}; // The pivot / rotation point of each respective Tetrimino block
 static int BlockImageIdx[7] =  { 0, 1, 2, 3, 4, 5, 6 }; // Can be customized
 
 static int Palettes[7][7] =
@@ -141,20 +133,6 @@ static int Palettes[7][7] =
 static CCB *cel_AllBlockImages[32]; // TODO - Load all game block data
 static CCB *cel_GuideBlock;
 
-static Tetrimino ActiveBlock;
-
-static BlockCoord DefaultBlockCoords[7][4] = // Relative to it's queue position
-{
-	{ { 21, 3 }, { 22, 3 }, { 23, 3 }, { 24, 3 } }, // 1.) I-Block
-	{ { 22, 3 }, { 22, 4 }, { 23, 3 }, { 23, 4 } }, // 2.) O-Block
-	{ { 21, 3 }, { 22, 3 }, { 22, 4 }, { 23, 3 } }, // 3.) T-Block
-	{ { 21, 4 }, { 22, 3 }, { 22, 4 }, { 23, 3 } }, // 4.) S-Block
-	{ { 21, 3 }, { 22, 3 }, { 22, 4 }, { 23, 4 } }, // 5.) Z-Block
-	{ { 21, 3 }, { 21, 4 }, { 22, 4 }, { 23, 4 } }, // 6.) J-Block
-	{ { 21, 4 }, { 21, 3 }, { 22, 3 }, { 23, 3 } }  // 7.) L-Block
-};
-
-static bool GameOver = false;
 static bool QuickReset = false;
 static bool GameStarted = false;
 static bool OptionsMenuSelected = false;
@@ -171,14 +149,19 @@ static int debugMode = 0;
 
 static int frames = 0;
 
-static int swGame = 0;
-static int lvSpeed = 48;
-
 static bool localShowGuides = true;
+
+static bool photonPending = false; // A press changed the game, the next DisplayScreen shows it
+static uint32 photonField = 0;
 static bool localPlayMusic = true;
 static bool localPlaySFX = true;
 static bool localDefaultTheme = true; // Synth or Sci-Fi
 
+#define MUSIC_TRACKS 1 // In each theme's turn
+
+static char *musicSynth[] = { AUDIO_MUSIC_FILE, NULL }; // Each theme's tracks, played in turn with no gap between them, then all
+static char *musicSciFi[] = { AUDIO_MUSIC_FILE, NULL }; // but the last again so a list can start a whole turn from any of them
+
 static int localMainPalette = 0;
 
 static bool OptionsPlayMusic = true;
@@ -194,45 +177,12 @@ const int BLOCK_3DO = 24;
 
 int HighlightedOption = 0;
 
-int QueueSwaps = 3;
-
 static int frameNum = 0;
 static int sfxPlay = 0;
 static int sfxInit = 0;
-static int sfxLoad = 0;
-
-bool kpLeft = false;
-bool kpRight = false;
-bool kpUp = false;
-bool kpDown = false;
-bool kpLS = false;
-bool kpRS = false;
-bool kpA = false;
-bool kpB = false;
-bool kpC = false;
-bool kpStart = false;
-bool kpStop = false;
-
-bool movingLeft = false;
-bool movingRight = false;
 
 int32 rNum = 0;
 
-int QueuedShapeIdx = -1;
-int HeldShapeIdx = -1;
-
-bool CanHold = true;
-
-int swLeft = 0;
-int swRight = 0;
-int swUp = 0;
-int swDown = 0;
-int swLS = 0;
-int swRS = 0;
-int swA = 0;
-int swB = 0;
-int swC = 0;
-
 int bPresses = 0;
 
 CCB *cel_Options;
@@ -247,7 +197,7 @@ CCB *cel_OptionSFX;
 CCB *cel_OptionTheme;
 CCB *cel_OptionColors;
 
-CCB *cels_GPB[10][18]; 	// Potential screen block CELs
+CCB *cels_GPB[BOARD_WIDTH][BOARD_HEIGHT]; 	// Potential screen block CELs
 CCB *cels_AB[4]; 		// ActiveBlock
 CCB *cels_NB[4]; 		// Next Block
 CCB *cels_HB[4]; 		// Hold Block
@@ -268,64 +218,68 @@ CCB *cel_PausedOptions;
 
 int HighScore = 50000;
 int HighLevel = 15;
-int TotScore = 0;
-int CurrScore = 0;
-
-int CurrLevel = 1;
+static ubyte *backgroundBufferPtr1 = NULL;
 
-int CurrLines = 0;
-int TotLines = 0;
+static int isLast = 0;
 
-int TargetLines = 10;
+static ubyte mariaHoles[10] = { 2, 1, 2, 1, 2, 2, 1, 2, 1, 2 }; // Columns the 4 row clear knocks out first, bit 0 on the 1st and 3rd rows, bit 1 the 2nd and 4th
 
-static ubyte *backgroundBufferPtr1 = NULL;
+void PositionBoardCel(CCB *cel, int x, int y) // Board column and row, rows above the board are negative
+{
+	cel->ccb_XPos = Convert32_F16(BOARD_LEFT + (x * BLOCK_PIXELS));
+	cel->ccb_YPos = Convert32_F16(BOARD_TOP + (y * BLOCK_PIXELS));
+}
 
-static int isLast = 0;
+void ScaleBoardCel(CCB *cel) // Block art drawn at BLOCK_PIXELS
+{
+	cel->ccb_HDX = BLOCK_SCALED(DivSF16(Convert32_F16(12), Convert32_F16(12)) << 4);
+	cel->ccb_VDY = BLOCK_SCALED(DivSF16(Convert32_F16(12), Convert32_F16(12)));
+}
 
 void loadData()
 {
 	int x, y;
 	
 	// Keep in memory for frequent in-game usage	
-	cel_GuideBlock = LoadCel("data/t9.cel", MEMTYPE_CEL);
+	cel_GuideBlock = MemLoadCel(MEM_TAG_BOARD, "data/t9.cel");
 	InitCCBFlags(cel_GuideBlock);
 		
-	cel_AllBlockImages[0] = LoadCel("data/block_teal.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[1] = LoadCel("data/block_red.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[2] = LoadCel("data/block_orange.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[3] = LoadCel("data/block_yellow.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[4] = LoadCel("data/block_green.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[5] = LoadCel("data/block_blue.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[6] = LoadCel("data/block_purple.cel", MEMTYPE_CEL);
-	
-	cel_AllBlockImages[7] = LoadCel("data/j1.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[8] = LoadCel("data/j2.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[9] = LoadCel("data/j3.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[10] = LoadCel("data/j4.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[11] = LoadCel("data/j5.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[12] = LoadCel("data/j6.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[13] = LoadCel("data/j7.cel", MEMTYPE_CEL);
-	
-	cel_AllBlockImages[14] = LoadCel("data/b1.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[15] = LoadCel("data/b2.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[16] = LoadCel("data/b3.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[17] = LoadCel("data/b4.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[18] = LoadCel("data/b5.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[19] = LoadCel("data/b6.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[20] = LoadCel("data/b7.cel", MEMTYPE_CEL);
-	
-	cel_AllBlockImages[21] = LoadCel("data/block_white.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[22] = LoadCel("data/block_grey.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[23] = LoadCel("data/block_black.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[24] = LoadCel("data/block_disc8.cel", MEMTYPE_CEL);
-	
-	cel_AllBlockImages[25] = LoadCel("data/block_disc1.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[26] = LoadCel("data/block_disc2.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[27] = LoadCel("data/block_disc3.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[28] = LoadCel("data/block_disc4.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[29] = LoadCel("data/block_disc5.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[30] = LoadCel("data/block_disc6.cel", MEMTYPE_CEL);
-	cel_AllBlockImages[31] = LoadCel("data/block_disc7.cel", MEMTYPE_CEL);
+	cel_AllBlockImages[0] = MemLoadCel(MEM_TAG_BOARD, "data/block_teal.cel");
+	cel_AllBlockImages[1] = MemLoadCel(MEM_TAG_BOARD, "data/block_red.cel");
+	cel_AllBlockImages[2] = MemLoadCel(MEM_TAG_BOARD, "data/block_orange.cel");
+	cel_AllBlockImages[3] = MemLoadCel(MEM_TAG_BOARD, "data/block_yellow.cel");
+	cel_AllBlockImages[4] = MemLoadCel(MEM_TAG_BOARD, "data/block_green.cel");
+	cel_AllBlockImages[5] = MemLoadCel(MEM_TAG_BOARD, "data/block_blue.cel");
+	cel_AllBlockImages[6] = MemLoadCel(MEM_TAG_BOARD, "data/block_purple.cel");
+	
+	cel_AllBlockImages[7] = MemLoadCel(MEM_TAG_BOARD, "data/j1.cel");
+	cel_AllBlockImages[8] = MemLoadCel(MEM_TAG_BOARD, "data/j2.cel");
+	cel_AllBlockImages[9] = MemLoadCel(MEM_TAG_BOARD, "data/j3.cel");
+	cel_AllBlockImages[10] = MemLoadCel(MEM_TAG_BOARD, "data/j4.cel");
+	cel_AllBlockImages[11] = MemLoadCel(MEM_TAG_BOARD, "data/j5.cel");
+	cel_AllBlockImages[12] = MemLoadCel(MEM_TAG_BOARD, "data/j6.cel");
+	cel_AllBlockImages[13] = MemLoadCel(MEM_TAG_BOARD, "data/j7.cel");
+	
+	cel_AllBlockImages[14] = MemLoadCel(MEM_TAG_BOARD, "data/b1.cel");
+	cel_AllBlockImages[15] = MemLoadCel(MEM_TAG_BOARD, "data/b2.cel");
+	cel_AllBlockImages[16] = MemLoadCel(MEM_TAG_BOARD, "data/b3.cel");
+	cel_AllBlockImages[17] = MemLoadCel(MEM_TAG_BOARD, "data/b4.cel");
+	cel_AllBlockImages[18] = MemLoadCel(MEM_TAG_BOARD, "data/b5.cel");
+	cel_AllBlockImages[19] = MemLoadCel(MEM_TAG_BOARD, "data/b6.cel");
+	cel_AllBlockImages[20] = MemLoadCel(MEM_TAG_BOARD, "data/b7.cel");
+	
+	cel_AllBlockImages[21] = MemLoadCel(MEM_TAG_BOARD, "data/block_white.cel");
+	cel_AllBlockImages[22] = MemLoadCel(MEM_TAG_BOARD, "data/block_grey.cel");
+	cel_AllBlockImages[23] = MemLoadCel(MEM_TAG_BOARD, "data/block_black.cel");
+	cel_AllBlockImages[24] = MemLoadCel(MEM_TAG_BOARD, "data/block_disc8.cel");
+	
+	cel_AllBlockImages[25] = MemLoadCel(MEM_TAG_BOARD, "data/block_disc1.cel");
+	cel_AllBlockImages[26] = MemLoadCel(MEM_TAG_BOARD, "data/block_disc2.cel");
+	cel_AllBlockImages[27] = MemLoadCel(MEM_TAG_BOARD, "data/block_disc3.cel");
+	cel_AllBlockImages[28] = MemLoadCel(MEM_TAG_BOARD, "data/block_disc4.cel");
+	cel_AllBlockImages[29] = MemLoadCel(MEM_TAG_BOARD, "data/block_disc5.cel");
+	cel_AllBlockImages[30] = MemLoadCel(MEM_TAG_BOARD, "data/block_disc6.cel");
+	cel_AllBlockImages[31] = MemLoadCel(MEM_TAG_BOARD, "data/block_disc7.cel");
 	
 	for (x = 0; x < 32; x++)
 	{		
@@ -333,36 +287,37 @@ void loadData()
 	}
 	
 	// Initialize the Gameplay Block CCBs
-	for (x = 0; x < 10; x++)
+	for (x = 0; x < BOARD_WIDTH; x++)
 	{
-		for (y = 0; y < 18; y++)
+		for (y = 0; y < BOARD_HEIGHT; y++)
 		{
-			cels_GPB[x][y] = CopyCel(cel_AllBlockImages[0]); // Doesn't matter which
+			cels_GPB[x][y] = MemCopyCel(MEM_TAG_BOARD, cel_AllBlockImages[0]); // Doesn't matter which
 			
-			PositionCelColumn(cels_GPB[x][y], x + 8, y + 1, 4, 0); // Offset 8 columns from the screen origin, 1 down
+			PositionBoardCel(cels_GPB[x][y], x, y);
+			ScaleBoardCel(cels_GPB[x][y]);
 		}
 	}
 	
 	// Now chain them together
-	for (x = 0; x < 10; x++)
+	for (x = 0; x < BOARD_WIDTH; x++)
 	{
-		for (y = 0; y < 17; y++)  
+		for (y = 0; y < BOARD_HEIGHT - 1; y++)  
 		{
 			cels_GPB[x][y]->ccb_NextPtr = cels_GPB[x][y + 1]; // (CCB *)MakeCCBRelative( &cel-> ccb_NextPtr, &NextCel )		
 		}
 
-		if (x < 9)
+		if (x < BOARD_WIDTH - 1)
 		{
-			cels_GPB[x][17]->ccb_NextPtr = cels_GPB[x + 1][0];
+			cels_GPB[x][BOARD_HEIGHT - 1]->ccb_NextPtr = cels_GPB[x + 1][0];
 		}
 	}
 	
 	for (x = 0; x < 4; x++)
 	{
-		cels_AB[x] = CopyCel(cel_AllBlockImages[0]);
-		cels_NB[x] = CopyCel(cel_AllBlockImages[0]);
-		cels_HB[x] = CopyCel(cel_AllBlockImages[0]);
-		cels_GB[x] = CopyCel(cel_GuideBlock); // White - This never changes
+		cels_AB[x] = MemCopyCel(MEM_TAG_BOARD, cel_AllBlockImages[0]);
+		cels_NB[x] = MemCopyCel(MEM_TAG_HUD, cel_AllBlockImages[0]);
+		cels_HB[x] = MemCopyCel(MEM_TAG_HUD, cel_AllBlockImages[0]);
+		cels_GB[x] = MemCopyCel(MEM_TAG_BOARD, cel_GuideBlock); // White - This never changes
 
 		if (x > 0)
 		{
@@ -373,6 +328,9 @@ void loadData()
 		}
 		
 		cels_GB[x]->ccb_PIXC = 0x1f811f81; 
+
+		ScaleBoardCel(cels_AB[x]);
+		ScaleBoardCel(cels_GB[x]);
 		
 		SetFlag(cels_AB[x]->ccb_Flags, CCB_SKIP);
 		SetFlag(cels_NB[x]->ccb_Flags, CCB_SKIP);
@@ -380,7 +338,7 @@ void loadData()
 		SetFlag(cels_GB[x]->ccb_Flags, CCB_SKIP);
 	}
 
-	cels_GPB[9][17]->ccb_NextPtr = cels_AB[0];
+	cels_GPB[BOARD_WIDTH - 1][BOARD_HEIGHT - 1]->ccb_NextPtr = cels_AB[0];
 	cels_AB[3]->ccb_NextPtr = cels_NB[0];
 	cels_NB[3]->ccb_NextPtr = cels_HB[0];
 	cels_HB[3]->ccb_NextPtr = cels_GB[0];
@@ -435,11 +393,13 @@ void SwapBackgroundImage(char *file, int imgIdx)
 		
 		if (backgroundBufferPtr1 != NULL)
 		{
-			UnloadImage(backgroundBufferPtr1);
+			MemUnloadImage(backgroundBufferPtr1);
 			backgroundBufferPtr1 = NULL;
 		}
 
-		backgroundBufferPtr1 = LoadImage(file, NULL, (VdlChunk **)NULL, &screen);
+		backgroundBufferPtr1 = MemLoadImage(MEM_TAG_BACKGROUND, file, &screen);
+
+		ioInfo.ioi_Send.iob_Buffer = backgroundBufferPtr1; // The SPORT copy would otherwise keep reading the freed image
 	}
 }
 
@@ -482,6 +442,8 @@ int getFrameNum()
 
 void DisplayBackgroundOnly()
 {
+	FlushSFX();
+
 	DisplayScreen(screen.sc_Screens[visibleScreenPage], 0);	
 	visibleScreenPage = (1 - visibleScreenPage);
 
@@ -493,6 +455,8 @@ void DisplayStartScreen()
 {
 	DrawCels(screen.sc_BitmapItems[ visibleScreenPage ], cels_SM[0]);
 
+	FlushSFX();
+
 	DisplayScreen(screen.sc_Screens[visibleScreenPage], 0);	
 
 	//WaitVBL(vsyncItem, 0);
@@ -508,6 +472,8 @@ void DisplayOptionsScreen()
 {
 	DrawCels(screen.sc_BitmapItems[ visibleScreenPage ], cel_OptionsOverlay);
 
+	FlushSFX();
+
 	DisplayScreen(screen.sc_Screens[visibleScreenPage], 0);
 
 	//WaitVBL(vsyncItem, 0);
@@ -523,9 +489,20 @@ int32 lastRoundTrip = 0;
 int32 last60Time = 0;
 int32 avgFrameMS = 0;
 int32 frameCount = 0;
-int32 msCount = 0;
-int32 avgMS = 0;
-int32 totElapsedMS = 0;
+
+uint32 TimeValToUS(TimeVal *tv)
+{
+	return (tv->tv_Seconds * 1000000) + tv->tv_Microseconds;
+}
+
+uint32 InputClockMS() // For Input.Clock, milliseconds don't wrap for 49 days where microseconds would in 71 minutes
+{
+	TimeVal tv;
+
+	SampleSystemTimeTV(&tv);
+
+	return (tv.tv_Seconds * 1000) + (tv.tv_Microseconds / 1000);
+}
 
 void DisplayGameplayScreen()
 {
@@ -549,26 +526,6 @@ void DisplayGameplayScreen()
 		frameCount = 0;
 	}
 	
-	if (debugMode > 0)
-	{		
-		TimeVal tvCurrLoopElapsed;
-		
-		SampleSystemTimeTV(&dData.tvCurrLoopEnd);
-		
-		SubTimes(&dData.tvCurrLoopStart, &dData.tvCurrLoopEnd, &tvCurrLoopElapsed);
-		
-		msCount++;
-		totElapsedMS += tvCurrLoopElapsed.tv_Microseconds / 1000;
-		avgMS = totElapsedMS / msCount;
-		
-		if (msCount > 120)
-		{
-			msCount = totElapsedMS = 0;
-		}
-		
-		SampleSystemTimeTV(&dData.tvCurrLoopStart);
-	}
-	
 	SampleSystemTimeTV(&dData.tvRenderStart);	
 	
 	if (debugMode < 3) DrawGamePlayScreen();
@@ -580,7 +537,7 @@ void DisplayGameplayScreen()
 		SetCelNumbers(2, lastDrawCels);
 		SetCelNumbers(3, lastRoundTrip);
 		SetCelNumbers(4, last60Time);
-		SetCelNumbers(5, avgMS);
+		SetCelNumbers(5, PerfPercentile(PERF_FRAME, 50) / 1000);
 	}
 	else
 	{
@@ -598,7 +555,14 @@ void DisplayGameplayScreen()
 		DrawCels(screen.sc_BitmapItems[ visibleScreenPage ], cels_GPB[0][0]); 
 	}
 	
-	//displayMem(screen.sc_BitmapItems[ visibleScreenPage ]);
+	if (debugMode > 0)
+	{
+		PerfDrawOverlay(screen.sc_BitmapItems[ visibleScreenPage ]);
+		MemDrawOverlay(screen.sc_BitmapItems[ visibleScreenPage ]);
+		AudioDrawOverlay(screen.sc_BitmapItems[ visibleScreenPage ]);
+	}
+	
+	if (debugMode > 1) displayMem(screen.sc_BitmapItems[ visibleScreenPage ]); // AvailMem walks the free lists, only when frozen
 	
 	SampleSystemTimeTV(&dData.tvDrawCelsEnd);	
 	
@@ -615,14 +579,40 @@ void DisplayGameplayScreen()
 		lastRoundTrip = tvRoundTrip.tv_Microseconds;
 	}	
 	
+	FlushSFX(); // The frame's effects start as it's shown
+	
     DisplayScreen(screen.sc_Screens[visibleScreenPage], 0);
+
+	if (photonPending)
+	{
+		VBlankTimeVal vbl;
+
+		SampleSystemTimeVBL(&vbl);
+
+		PerfAddSample(PERF_PHOTON, (vbl.vbltv_VBlankLo32 - photonField) * PERF_VSYNC_US);
+
+		photonPending = false;
+	}
 	
 	visibleScreenPage = (1 - visibleScreenPage);
 
 	ioInfo.ioi_Recv.iob_Buffer = bitmaps[visibleScreenPage]->bm_Buffer;
 	DoIO(VRAMIOReq, &ioInfo);
 
-	SampleSystemTimeTV(&dData.tvRenderEnd);	
+	SampleSystemTimeTV(&dData.tvCurrLoopEnd);
+	
+	// Previous frame end -> render start is logic, render start -> now is render. Always sampled so the overlay has history when it's switched on
+	{
+		TimeVal tvLogic, tvRender, tvFrame;
+		
+		SubTimes(&dData.tvRenderEnd, &dData.tvRenderStart, &tvLogic);
+		SubTimes(&dData.tvRenderStart, &dData.tvCurrLoopEnd, &tvRender);
+		SubTimes(&dData.tvRenderEnd, &dData.tvCurrLoopEnd, &tvFrame);
+		
+		PerfAddFrame(TimeValToUS(&tvLogic), TimeValToUS(&tvRender), TimeValToUS(&tvFrame));
+	}
+
+	dData.tvRenderEnd = dData.tvCurrLoopEnd;
 }
 
 void DrawGamePlayScreen()
@@ -639,9 +629,9 @@ void DrawGamePlayScreen()
 			SetFlag(cels_AB[x]->ccb_Flags, CCB_SKIP);
 		}
 		
-		for (x = 0; x < 10; x++)
+		for (x = 0; x < BOARD_WIDTH; x++)
 		{
-			for (y = 0; y < 18; y++)
+			for (y = 0; y < BOARD_HEIGHT; y++)
 			{
 				SetFlag(cels_GPB[x][y]->ccb_Flags, CCB_SKIP);
 			}
@@ -652,11 +642,11 @@ void DrawGamePlayScreen()
 
 	if (ClearingLines == false) // TODO OPTIMIZE THIS
 	{
-		for (x = 0; x < 10; x++)
+		for (x = 0; x < BOARD_WIDTH; x++)
 		{
-			for (y = 0; y < 18; y++)
+			for (y = 0; y < BOARD_HEIGHT; y++)
 			{
-				if (GamePlayBlocks[x][y] == true) // 10x19 Grid Blocks
+				if (Game.Board[x][y] == true) // 10x19 Grid Blocks
 				{
 					if (y < minY) minY = y; // For guide blocks
 
@@ -669,9 +659,11 @@ void DrawGamePlayScreen()
 			}
 		}
 
+		LateLatchInput(); // Last chance for this frame's moves
+
 		for (x = 0; x < 4; x++) // Activeblock is the Tetrimino / state
 		{
-			PositionCelColumn(cels_AB[x], ActiveBlock.Blocks[x].X + 8, ActiveBlock.Blocks[x].Y + 1, 4, 0); // +1 for the offset from 20 blocks to 19
+			PositionBoardCel(cels_AB[x], Game.Active.Blocks[x].X, Game.Active.Blocks[x].Y);
 
 			ClearFlag(cels_AB[x]->ccb_Flags, CCB_SKIP);
 		}
@@ -681,28 +673,15 @@ void DrawGamePlayScreen()
 	{
 		if (IsPaused == false && ClearingLines == false) // Guide Blocks First 2 Levels TODO Configure
 		{
-			gbOffset = 0;
+			gbOffset = GameDropDistance(&Game);
 
-			while (TryMoveDown() && gbOffset < 20) // Failsafe
-			{
-				MoveDown(false);
-
-				gbOffset++;
-			}
-
-			if (gbOffset > 0)
-			{
-				for (x = 0; x < gbOffset; x++)
-				{
-					MoveUp();
-				}
-			}
+			if (gbOffset > BOARD_HEIGHT + 2) gbOffset = BOARD_HEIGHT + 2; // Failsafe
 
 			if (gbOffset > 1)
 			{
 				for (x = 0; x < 4; x++)
 				{
-					PositionCelColumn(cels_GB[x], ActiveBlock.Blocks[x].X + 8, ActiveBlock.Blocks[x].Y + gbOffset + 1, 4, 0);
+					PositionBoardCel(cels_GB[x], Game.Active.Blocks[x].X, Game.Active.Blocks[x].Y + gbOffset);
 
 					ClearFlag(cels_GB[x]->ccb_Flags, CCB_SKIP); // Guide blocks off by default
 				}
@@ -720,16 +699,16 @@ void DrawGamePlayScreen()
 
 void UpdateOnScreenStats()
 {
-	int rem = TargetLines - CurrLines;
+	int rem = Game.TargetLines - Game.LevelLines;
 
 	if (rem < 0) rem = 0;
 
 	SetCelNumbers(0, HighScore);
 	SetCelNumbers(1, HighLevel);
-	SetCelNumbers(2, TotScore);
-	SetCelNumbers(3, CurrLines);
+	SetCelNumbers(2, Game.Score);
+	SetCelNumbers(3, Game.LevelLines);
 	SetCelNumbers(4, rem);
-	SetCelNumbers(5, CurrLevel);
+	SetCelNumbers(5, Game.Level);
 
 	//RenderCelNumbers(screen.sc_BitmapItems[ visibleScreenPage ]); // TODO - no need for a separate call here, just chain the exposed CCB
 }
@@ -782,16 +761,51 @@ int32 HandleEEInput(uint32 joyBits)
 	return 0;
 }
 
-static ControlPadEventData cped;
+void MarkPhoton(uint32 field)
+{
+	if (photonPending == false || (int32)(field - photonField) < 0) photonField = field; // The oldest press on screen
+
+	photonPending = true;
+}
+
+void LateLatchInput() // Shifts and rotations pressed since HandleInput, the cels haven't been placed yet
+{
+	uint32 joyBits, taps, hash;
+
+	if (Input.LateLatch == false || Replay.Mode != REPLAY_OFF || AcceptGameInput == false || Game.GameOver) return;
+
+	joyBits = InputReadLatch(ControlLeft | ControlRight | ControlA | ControlC, &taps); // Stops short of anything else, HandleInput takes it next tick
+
+	if (Input.Queue.ReadEvents == 0) return;
+
+	PerfAddSample(PERF_INPUT, Input.Queue.ReadLatency * PERF_VSYNC_US);
+
+	InputLatch(joyBits, taps);
+
+	hash = GameHash(&Game);
+
+	if (InputFires(INPUT_A)) GameRotate(&Game, true, AllowShiftToRotate);
+	if (InputFires(INPUT_C)) GameRotate(&Game, false, AllowShiftToRotate);
+	if (InputFires(INPUT_LEFT)) GameShift(&Game, -1);
+	if (InputFires(INPUT_RIGHT)) GameShift(&Game, 1);
+
+	if (Input.Queue.ReadPresses > 0 && GameHash(&Game) != hash) MarkPhoton(Input.Queue.ReadPressField);
+}
 
 void HandleInput()
 {
-	int x;
-	uint32 joyBits;
+	int i;
+	uint32 joyBits, taps, hash;
 	
-	GetControlPad(1, 0, &cped); //  
+	joyBits = InputRead(&taps); // Every pad event since the last tick
+
+	if (Input.Queue.ReadEvents > 0) PerfAddSample(PERF_INPUT, Input.Queue.ReadLatency * PERF_VSYNC_US);
+
+	joyBits = ReplayInput(joyBits, &taps); // Recorded, or swapped for the recorded bits when replaying
 
-	joyBits = cped.cped_ButtonBits;
+	InputUpdate(joyBits, taps, Input.Clock ? InputClockMS() : 0); // Every button's press, release and repeats for this tick
+
+	joyBits |= taps; // A tap was down for part of the tick, the menus and the B count see it as held
 
 	if (OptionsMenuSelected == true) // Options Menu
 	{
@@ -806,18 +820,13 @@ void HandleInput()
 		return;
 	}
 
-	if (AcceptGameInput == false)
-	{
-		cped.cped_ButtonBits = 0;
-		
-		return;
-	}
+	if (AcceptGameInput == false) return;
 	
 	// In gameplay mode now
 	
-	if (IsPaused && (joyBits & ControlLeftShift) && (joyBits & ControlRightShift))
+	if (IsPaused && InputDown(INPUT_LS) && InputDown(INPUT_RS))
 	{
-		GameOver = true;
+		Game.GameOver = true;
 		GameStarted = false;
 
 		QuickReset = true;
@@ -825,852 +834,361 @@ void HandleInput()
 		return;
 	}
 	
-	if (joyBits & ControlX) // Reset
+	if (InputPressed(INPUT_STOP)) // Reset
 	{
-		if (kpStop == false)
+		if (IsPaused == true)
 		{
-			if (IsPaused == true)
-			{
-				ToggleOptionsMenu(true);
-			}
-			else
-			{
-				TogglePaused(true);
-			}
+			ToggleOptionsMenu(true);
 		}
-
-		kpStop = true;
-	}
-	else
-	{
-		kpStop = false;
-	}
-
-	if (joyBits & ControlStart)
-	{
-		if (kpStart == false)
-		{
-			TogglePaused(!IsPaused);
-		}
-
-		kpStart = true;
-	}
-	else
-	{
-		kpStart = false;
-	}
-
-	if (IsPaused) return;
-
-	if (joyBits & ControlLeftShift) // Hold block
-	{
-		if (kpLS == false && CanHold == true)
+		else
 		{
-			SwapActiveBlockWithHeldBlock();
+			TogglePaused(true);
 		}
-
-		kpLS = true;
-		swLS++;
-
-		bPresses = 0;
-	}
-	else
-	{
-		swLS = 0;
-		kpLS = false;
 	}
 
-	if (joyBits & ControlRightShift) // Queue Swap? Kind of fun
-	{
-		if (kpRS == false && QueueSwaps > 0)
-		{
-			QueueNextBlock();
+	if (InputPressed(INPUT_START)) TogglePaused(!IsPaused);
 
-			QueueSwaps--;
-		}
+	if (IsPaused) return;
 
-		kpRS = true;
-		swRS++;
+	hash = GameHash(&Game);
 
-		if (swRS >= 60) swRS = 0;
+	if (joyBits & (ControlLeftShift | ControlRightShift | ControlA)) bPresses = 0; // Anything else held between B presses breaks the count
 
-		bPresses = 0;
-	}
-	else
-	{
-		swRS = 0;
-		kpRS = false;
-	}
-
-	if (joyBits & ControlA)
-	{
-		if (kpA == false || ++swA >= 15)
-		{
-			if (TryRotate(true) == true)
-			{
-				Rotate(true);
-			}
-			else if (AllowShiftToRotate == true) // Try to move over 1 then rotate if you allowed. Otherwise undo
-			{
-				bool didRotate = false;
-				
-				if (TryMoveRight()) // TODO THIS NEEDS SOME WORK
-				{
-					MoveRight();
+	if (InputPressed(INPUT_LS) && Game.CanHold == true) SwapActiveBlockWithHeldBlock(); // Hold block
 
-					if (TryRotate(true) == true)
-					{
-						Rotate(true);
-						
-						didRotate = true;
-					}
-					else
-					{
-						MoveLeft(); // Undo
-					}
-				}
-				else if (TryMoveLeft())
-				{
-					MoveLeft();
-					
-					if (TryRotate(true) == true)
-					{
-						Rotate(true);
-						
-						didRotate = true;
-					}
-					else
-					{
-						MoveRight(); // Undo
-					}
-				}
-				
-				if (didRotate == false)
-				{
-					if (TryMoveUp())
-					{
-						MoveUp();
-						
-						if (TryRotate(true) == true)
-						{
-							Rotate(true);
-						}
-						else
-						{
-							MoveDown(false); // Undo
-						}
-					}
-				}
-			}
-		}
+	if (InputPressed(INPUT_RS) && GameSwapQueue(&Game)) ShowQueuedBlock(Game.QueuedShape); // Queue Swap? Kind of fun
 
-		kpA = true;
+	if (InputFires(INPUT_A)) GameRotate(&Game, true, AllowShiftToRotate); // Shifts over or up a block to make room if allowed
 
-		if (swA >= 15) swA = 0;
+	if (InputDown(INPUT_A) && debugMode > 1) debugMode = 0;
 
-		bPresses = 0;
-		
-		if (debugMode > 1) debugMode = 0;
-	}
-	else
+	if (InputPressed(INPUT_B))
 	{
-		kpA = false;
-		swA = 0;
-	}
+		bPresses++;
 
-	if (joyBits & ControlB)
-	{
-		if (kpB == false)
+		if (bPresses >= 10)
 		{
-			bPresses++;
-
-			if (bPresses >=10)
+			debugMode++;
+			
+			if (bPresses >= 20)
 			{
-				debugMode++;
-				
-				if (bPresses >= 20)
-				{
-					debugMode = 0;
-				}
+				debugMode = 0;
 			}
 		}
-
-		kpB = true;
 	}
-	else
-	{
-		kpB = false;
-		swB = 0;
-	}
-
-	if (joyBits & ControlC)
-	{
-		if (kpC == false || ++swC >= 15)
-		{
-			if (TryRotate(false) == true)
-			{
-				Rotate(false);
-			}
-			else if (AllowShiftToRotate == true) // Try to move over 1 then rotate if you allowed. Otherwise undo
-			{
-				bool didRotate = false;
-				
-				if (TryMoveRight()) // TODO THIS NEEDS SOME WORK
-				{
-					MoveRight();
 
-					if (TryRotate(false) == true)
-					{
-						Rotate(false);
-						
-						didRotate = true;
-					}
-					else
-					{
-						MoveLeft(); // Undo
-					}
-				}
-				else if (TryMoveLeft())
-				{
-					MoveLeft();
-					
-					if (TryRotate(false) == true)
-					{
-						Rotate(false);
-						
-						didRotate = true;
-					}
-					else
-					{
-						MoveRight(); // Undo
-					}
-				}
-				
-				if (didRotate == false)
-				{
-					if (TryMoveUp())
-					{
-						MoveUp();
-						
-						if (TryRotate(false) == true)
-						{
-							Rotate(false);
-						}
-						else
-						{
-							MoveDown(false); // Undo
-						}
-					}
-				}
-			}
-		}
+	if (joyBits & (ControlC | ControlUp | ControlDown | ControlLeft | ControlRight)) bPresses = 0;
 
-		kpC = true;
+	if (InputFires(INPUT_C)) GameRotate(&Game, false, AllowShiftToRotate);
 
-		if (swC >= 15) swC = 0;
+	if (InputDown(INPUT_C) && debugMode > 1) debugMode = 0;
 
-		bPresses = 0;
-		
-		if (debugMode > 1) debugMode = 0;
-	}
-	else
+	if (InputFires(INPUT_UP))
 	{
-		kpC = false;
-		swC = 0;
+		if (GameHardDrop(&Game)) PlaySFXAt(SFX_DROP, PiecePan()); // Locks in the piece
 	}
 
-	if (joyBits & ControlUp)
+	for (i = 0; i < InputFires(INPUT_DOWN); i++) // More than once only at a soft drop rate of 0, or on the clock
 	{
-		if (kpUp == false || ++swUp >= 15) // Check if can move down obviously
+		if (GameMoveDown(&Game) == false)
 		{
-			if (TryMoveDown() == true)
-			{
-				PlaySFX(SFX_DROP); 
-				
-				while (TryMoveDown() == true)
-				{
-					MoveDown(true);
-				}
-			}
+			if (InputPressed(INPUT_DOWN)) Game.Gravity = Game.Speed; // Lock in the piece
 
-			swGame = lvSpeed; // Lock in the piece
-			
-			TotScore = TotScore + 25;
+			break;
 		}
-
-		kpUp = true;
-
-		if (swUp >= 15) swUp = 0;
-
-		bPresses = 0;
-	}
-	else
-	{
-		swUp = 0;
-		kpUp = false;
 	}
 
-	if (joyBits & ControlDown)
+	for (i = 0; i < InputFires(INPUT_LEFT); i++)
 	{
-		if (kpDown == false || ++swDown >= 3) // Check if can move down obviously
-		{
-			if (TryMoveDown() == true)
-			{
-				MoveDown(true);
-			}
-			else if (kpDown == false)
-			{
-				swGame = lvSpeed; // Lock in the piece
-			}
-		}
-
-		kpDown = true;
-
-		if (swDown >= 3) swDown = 0;
-
-		bPresses = 0;
-	}
-	else
-	{
-		swDown = 0;
-		kpDown = false;
+		if (GameShift(&Game, -1) == false) break;
 	}
 
-	if (joyBits & ControlLeft)
+	for (i = 0; i < InputFires(INPUT_RIGHT); i++)
 	{
-		if (kpLeft == false || (swLeft >= 8 && movingLeft == false) || (swLeft >= 4 && movingLeft == true)) // Slightly stagger the increase speed
-		{
-			if (TryMoveLeft() == true)
-			{
-				MoveLeft();
-			}
-		}
-
-		kpLeft = true;
-		swLeft++;
-
-		if (movingLeft && swLeft > 4) swLeft = 0;
-
-		if (movingLeft == false && swLeft > 8)
-		{
-			movingLeft = true;
-		}
-
-		 bPresses = 0;
-	}
-	else
-	{
-		swLeft = 0;
-		kpLeft = false;
-		movingLeft = false;
+		if (GameShift(&Game, 1) == false) break;
 	}
 
-	if (joyBits & ControlRight)
-	{
-		if (kpRight == false || (swRight >= 8 && movingRight == false) || (swRight >= 4 && movingRight == true)) // Slightly stagger the increase speed
-		{
-			if (TryMoveRight() == true)
-			{
-				MoveRight();
-			}
-		}
-
-		kpRight = true;
-		swRight++;
-
-		if (movingRight && swRight > 4) swRight = 0;
-
-		if (movingRight == false && swRight > 8)
-		{
-			movingRight = true;
-		}
-
-		bPresses = 0;
-	}
-	else
-	{
-		swRight = 0;
-		kpRight = false;
-		movingRight = false;
-	}
+	if (Input.Queue.ReadPresses > 0 && Replay.Mode != REPLAY_PLAY && GameHash(&Game) != hash) MarkPhoton(Input.Queue.ReadPressField);
 }
 
 void HandleInputOptionsMenu(uint32 joyBits)
 {
-	if (joyBits & ControlUp)
-	{
-		if (kpUp == false)
-		{
-			ToggleOptionsMenuSelection(1);
-		}
-
-		kpUp = true;
-	}
-	else
-	{
-		kpUp = false;
-	}
+	if (InputPressed(INPUT_UP)) ToggleOptionsMenuSelection(1);
+	if (InputPressed(INPUT_DOWN)) ToggleOptionsMenuSelection(2);
+	if (InputPressed(INPUT_LEFT)) ToggleOptionsMenuSelection(3);
+	if (InputPressed(INPUT_RIGHT)) ToggleOptionsMenuSelection(4);
 
-	if (joyBits & ControlDown)
+	if (InputPressed(INPUT_START)) // Save and Close
 	{
-		if (kpDown == false)
-		{
-			ToggleOptionsMenuSelection(2);
-		}
+		HandleSelectedOptions();
 
-		kpDown = true;
-	}
-	else
-	{
-		kpDown = false;
+		ToggleOptionsMenu(false);
 	}
 
-	if (joyBits & ControlLeft)
+	if (InputPressed(INPUT_STOP)) // Cancel and Close
 	{
-		if (kpLeft == false)
-		{
-			ToggleOptionsMenuSelection(3);
-		}
-
-		kpLeft = true;
-	}
-	else
-	{
-		kpLeft = false;
-	}
-
-	if (joyBits & ControlRight)
-	{
-		if (kpRight == false)
-		{
-			ToggleOptionsMenuSelection(4);
-		}
-
-		kpRight = true;
-	}
-	else
-	{
-		kpRight = false;
-	}
-
-	if (joyBits & ControlStart) // Save and Close
-	{
-		if (kpStart == false)
-		{
-			HandleSelectedOptions();
-
-			ToggleOptionsMenu(false);
-		}
-
-		kpStart = true;
-	}
-	else
-	{
-		kpStart = false;
-	}
-
-	if (joyBits & ControlX) // Cancel and Close
-	{
-		if (kpStop == false)
-		{
-			ToggleOptionsMenu(false);
-		}
-
-		kpStop = true;
-	}
-	else
-	{
-		kpStop = false;
+		ToggleOptionsMenu(false);
 	}
 }
 
 void HandleInputStartMenu(uint32 joyBits)
 {
-	if (joyBits & ControlUp)
+	if (InputPressed(INPUT_UP))
 	{
-		if (kpUp == false)
-		{
-			ToggleStartMenuSelection();
-
-			HandleEEInput(joyBits);
-		}
+		ToggleStartMenuSelection();
 
-		kpUp = true;
-	}
-	else
-	{
-		kpUp = false;
+		HandleEEInput(joyBits);
 	}
 
-	if (joyBits & ControlDown)
+	if (InputPressed(INPUT_DOWN))
 	{
-		if (kpDown == false)
-		{
-			ToggleStartMenuSelection();
-
-			HandleEEInput(joyBits);
-		}
+		ToggleStartMenuSelection();
 
-		kpDown = true;
+		HandleEEInput(joyBits);
 	}
-	else
-	{
-		kpDown = false;
-	}
-
-	if (joyBits & ControlLeft)
-	{
-		if (kpLeft == false)
-		{
-			HandleEEInput(joyBits);
-		}
 
-		kpLeft = true;
-	}
-	else
-	{
-		kpLeft = false;
-	}
+	if (InputPressed(INPUT_LEFT)) HandleEEInput(joyBits);
+	if (InputPressed(INPUT_RIGHT)) HandleEEInput(joyBits);
+	if (InputPressed(INPUT_A)) HandleEEInput(joyBits);
+	if (InputPressed(INPUT_B)) HandleEEInput(joyBits);
 
-	if (joyBits & ControlRight)
+	if (InputPressed(INPUT_START))
 	{
-		if (kpRight == false)
+		if (HandleEEInput(joyBits)) // Enable Konami code
 		{
-			HandleEEInput(joyBits);
-		}
+			EasterEggEnabled = true; 
+			
+			localMainPalette = 6;
+			
+			ApplySelectedColorPalette();
 
-		kpRight = true;
-	}
-	else
-	{
-		kpRight = false;
-	}
+			cels_SM[0]->ccb_SourcePtr = cel_AllBlockImages[BLOCK_3DO]->ccb_SourcePtr;
+			cels_SM[1]->ccb_SourcePtr = cel_AllBlockImages[BLOCK_3DO]->ccb_SourcePtr;
+			cels_SM[2]->ccb_SourcePtr = cel_AllBlockImages[BLOCK_3DO]->ccb_SourcePtr;
+			cels_SM[3]->ccb_SourcePtr = cel_AllBlockImages[BLOCK_3DO]->ccb_SourcePtr;
 
-	if (joyBits & ControlA)
-	{
-		if (kpA == false)
-		{
-			HandleEEInput(joyBits);
+			return;
 		}
 
-		kpA = true;
-	}
-	else
-	{
-		kpA = false;
-	}
-
-	if (joyBits & ControlB)
-	{
-		if (kpB == false)
-		{
-			HandleEEInput(joyBits);
+		if (smStartSelected == true)
+		{				
+			GameStarted = true;
 		}
-
-		kpB = true;
-	}
-	else
-	{
-		kpB = false;
-	}
-
-	if (joyBits & ControlStart)
-	{
-		if (kpStart == false)
+		else
 		{
-			kpStart = true;
-
-			if (HandleEEInput(joyBits)) // Enable Konami code
-			{
-				EasterEggEnabled = true; 
-				
-				localMainPalette = 6;
-				
-				ApplySelectedColorPalette();
-
-				cels_SM[0]->ccb_SourcePtr = cel_AllBlockImages[BLOCK_3DO]->ccb_SourcePtr;
-				cels_SM[1]->ccb_SourcePtr = cel_AllBlockImages[BLOCK_3DO]->ccb_SourcePtr;
-				cels_SM[2]->ccb_SourcePtr = cel_AllBlockImages[BLOCK_3DO]->ccb_SourcePtr;
-				cels_SM[3]->ccb_SourcePtr = cel_AllBlockImages[BLOCK_3DO]->ccb_SourcePtr;
-
-				return;
-			}
-
-			if (smStartSelected == true)
-			{				
-				GameStarted = true;
-			}
-			else
-			{
-				ToggleOptionsMenu(true);
-			}
-		}
-	}
-	else
-	{
-		kpStart = false;
+			ToggleOptionsMenu(true);
+		}
 	}
 }
 
-void QueueNextBlock()
+void ShowQueuedBlock(int shape)
 {
 	int x;
-	int rNum = rand() % 7;
-	
-	if (rNum == QueuedShapeIdx)
-	{
-		rNum = rand() % 7; // Roll the dice again. Doesn't guarantee no duplicates but odds are it will reduce them
-	}
 
 	for (x = 0; x < 4; x++)
 	{
-		cels_NB[x]->ccb_SourcePtr = cel_AllBlockImages[BlockImageIdx[rNum]]->ccb_SourcePtr; // cel_BlockYellow->ccb_SourcePtr;
+		cels_NB[x]->ccb_SourcePtr = cel_AllBlockImages[BlockImageIdx[shape]]->ccb_SourcePtr; // cel_BlockYellow->ccb_SourcePtr;
 
-		PositionCelColumn(cels_NB[x], DefaultBlockCoords[rNum][x].X - (rNum <= 1 ? 1 : 0), DefaultBlockCoords[rNum][x].Y, (rNum <= 1 ? 8 : 2), (rNum == 0 ? 11 : 5)); // Ajustments to center the I-Block and O-Block
+		PositionCelColumn(cels_NB[x], DefaultBlockCoords[shape][x].X - (shape <= 1 ? 1 : 0), DefaultBlockCoords[shape][x].Y, (shape <= 1 ? 8 : 2), (shape == 0 ? 11 : 5)); // Ajustments to center the I-Block and O-Block
 
 		ClearFlag(cels_NB[x]->ccb_Flags, CCB_SKIP);
 	}
-
-	QueuedShapeIdx = rNum;
 }
 
-void LoadNextBlockFromQueue() // Convert from queued block pixel position to column position, X offset 18 / 4
+void ShowActiveBlock(bool fromQueue) // After the rules place a new active block
 {
 	int x;
 
 	for (x = 0; x < 4; x++)
 	{
-		cels_AB[x]->ccb_SourcePtr = cel_AllBlockImages[BlockImageIdx[QueuedShapeIdx]]->ccb_SourcePtr; // cels_NB[x]->ccb_SourcePtr;
-
-		ActiveBlock.Blocks[x].X = DefaultBlockCoords[QueuedShapeIdx][x].X - 18;
-		ActiveBlock.Blocks[x].Y = DefaultBlockCoords[QueuedShapeIdx][x].Y - 5;
+		cels_AB[x]->ccb_SourcePtr = cel_AllBlockImages[BlockImageIdx[Game.Active.ShapeType]]->ccb_SourcePtr;
 
 		SetFlag(cels_AB[x]->ccb_Flags, CCB_SKIP); // Visibility will be set if needed
-		SetFlag(cels_GB[x]->ccb_Flags, CCB_SKIP);
-	}
 
-	ActiveBlock.PivotIdx = BlockPivotIdx[QueuedShapeIdx];
-
-	ActiveBlock.ShapeType = QueuedShapeIdx;
+		if (fromQueue) SetFlag(cels_GB[x]->ccb_Flags, CCB_SKIP);
+	}
 
-	QueueNextBlock();
+	if (fromQueue) ShowQueuedBlock(Game.QueuedShape);
 }
 
-void HoldBlock() // Save current block to hold block
+void ShowHeldBlock(int shape)
 {
 	int x;
 
-	//PlaySample(gSampleHold);
-
 	for (x = 0; x < 4; x++)
 	{
-		cels_HB[x]->ccb_SourcePtr = cel_AllBlockImages[BlockImageIdx[ActiveBlock.ShapeType]]->ccb_SourcePtr; // cel_BlockYellow->ccb_SourcePtr;
+		cels_HB[x]->ccb_SourcePtr = cel_AllBlockImages[BlockImageIdx[shape]]->ccb_SourcePtr; // cel_BlockYellow->ccb_SourcePtr;
 
-		PositionCelColumn(cels_HB[x], DefaultBlockCoords[ActiveBlock.ShapeType][x].X - 19, DefaultBlockCoords[ActiveBlock.ShapeType][x].Y, (ActiveBlock.ShapeType <= 1 ? 0 : 6), (ActiveBlock.ShapeType == 0 ? 11 : 5)); // Ajustments to center the I-Block and O-Block
+		PositionCelColumn(cels_HB[x], DefaultBlockCoords[shape][x].X - 19, DefaultBlockCoords[shape][x].Y, (shape <= 1 ? 0 : 6), (shape == 0 ? 11 : 5)); // Ajustments to center the I-Block and O-Block
 
 		ClearFlag(cels_HB[x]->ccb_Flags, CCB_SKIP);
 	}
-
-	HeldShapeIdx = ActiveBlock.ShapeType; 
-
-	CanHold = false; // Can't swap until next turn
 }
 
 void SwapActiveBlockWithHeldBlock()
 {
-	int x;
-	int heldShape = HeldShapeIdx;
-	int activeShape = ActiveBlock.ShapeType;
-	
+	bool fromQueue;
+
 	PlaySFX(SFX_HOLD); 
 
-	HoldBlock();
+	fromQueue = GameHold(&Game); // Nothing held yet, the queued block comes in
 
-	if (heldShape >= 0)
-	{
-		for (x = 0; x < 4; x++)
-		{
-			cels_AB[x]->ccb_SourcePtr = cel_AllBlockImages[BlockImageIdx[heldShape]]->ccb_SourcePtr;
+	ShowHeldBlock(Game.HeldShape);
 
-			ActiveBlock.Blocks[x].X = DefaultBlockCoords[heldShape][x].X - 18;
-			ActiveBlock.Blocks[x].Y = DefaultBlockCoords[heldShape][x].Y - 4;
+	ShowActiveBlock(fromQueue);
+}
 
-			SetFlag(cels_AB[x]->ccb_Flags, CCB_SKIP); // Visibility will be set if needed
-		}
+// See HD3DOSnapshot.h. Only valid between ticks of a game in progress
 
-		ActiveBlock.PivotIdx = BlockPivotIdx[heldShape];
+bool SaveSnapshot(GameSnapshot *gs)
+{
+	int x, y, i;
+	uint32 bits = 0;
 
-		ActiveBlock.ShapeType = heldShape;
-	}
-	else
+	if (GameStarted == false || Game.GameOver == true || ClearingLines == true || AcceptGameInput == false) return false;
+
+	memset(gs, 0, sizeof(GameSnapshot));
+
+	for (y = 0; y < BOARD_HEIGHT; y++)
 	{
-		LoadNextBlockFromQueue();
+		for (x = 0; x < BOARD_WIDTH; x++)
+		{
+			if (Game.Board[x][y]) gs->Board[y / SNAPSHOT_ROWS_PER_WORD] |= 1 << (((y % SNAPSHOT_ROWS_PER_WORD) * BOARD_WIDTH) + x);
+		}
 	}
-}
 
-bool TryRotate(bool counterClockwise) // Build new block in position.. See if any conflicts
-{
-	int x, pivotX, pivotY, offsetX, offsetY, newX, newY;
-	bool collision = false;
+	gs->Rng = Game.Pieces.Rng.S;
 
-	pivotX = ActiveBlock.Blocks[ActiveBlock.PivotIdx].X;
-	pivotY = ActiveBlock.Blocks[ActiveBlock.PivotIdx].Y;
+	for (i = 0; i < Game.Pieces.BagLeft; i++) bits |= Game.Pieces.Bag[i] << (i * 3);
 
-	if (ActiveBlock.PivotIdx < 0) return false;
+	gs->Bag = bits | (Game.Pieces.BagLeft << 21);
 
-	for (x = 0; x < 4; x++)
-	{
-		offsetX = ActiveBlock.Blocks[x].X - pivotX; // Current X Position Relative to Pivot Point
-		offsetY = ActiveBlock.Blocks[x].Y - pivotY; // Current Y Position Relative to Pivot Point
+	bits = 0;
 
-		newX = pivotX + ( offsetY * ( counterClockwise ? 1 : -1 ) );
-		newY = pivotY - ( offsetX * ( counterClockwise ? 1 : -1 ) );
+	for (i = 0; i < Game.Pieces.Count; i++) bits |= Game.Pieces.Ahead[(Game.Pieces.Head + i) & (PIECE_AHEAD - 1)] << (i * 3);
 
-		if (newX < 0 || newX > 9) // TODO MAYBE SHIFT LEFT OR RIGHT IF OPEN
-		{
-			collision = true;
-		}
-		else if ( newY > 17)
-		{
-			collision = true;
-		}
-		else if (newY >= 0 && GamePlayBlocks[newX][newY] == true)
-		{
-			collision = true;
-		}
+	gs->Ahead = bits | (Game.Pieces.Count << 24);
+
+	bits = 0;
+
+	for (i = 0, y = 0; i < INPUT_BUTTONS; i++) // Time to each held button's next repeat
+	{
+		if (Input.Buttons[i].Repeat < 0) continue;
+
+		x = Input.Buttons[i].Down ? Input.Buttons[i].Next - Input.Now : 0;
 
-		if (collision == true) break;
+		bits |= (x < SNAPSHOT_WAIT_MAX ? x : SNAPSHOT_WAIT_MAX) << (y++ * SNAPSHOT_WAIT_BITS);
 	}
 
-	return !collision;
-}
+	gs->Counters = bits;
 
-void Rotate(bool counterClockwise)
-{
-	int x, pivotX, pivotY, offsetX, offsetY;
-	
-	pivotX = ActiveBlock.Blocks[ActiveBlock.PivotIdx].X;
-	pivotY = ActiveBlock.Blocks[ActiveBlock.PivotIdx].Y;
+	gs->Flags = InputDownBits() | (Game.CanHold ? SNAP_CAN_HOLD : 0) | (IsPaused ? SNAP_PAUSED : 0);
 
-	if (ActiveBlock.PivotIdx < 0) return;
+	gs->Shapes = Game.Active.ShapeType | ((Game.QueuedShape >= 0 ? Game.QueuedShape : SNAPSHOT_NONE) << 3) |
+		((Game.HeldShape >= 0 ? Game.HeldShape : SNAPSHOT_NONE) << 6) | ((Game.QueueSwaps & 3) << 9);
 
-	for (x = 0; x < 4; x++)
-	{
-		offsetX = ActiveBlock.Blocks[x].X - pivotX; // Current X Position Relative to Pivot Point
-		offsetY = ActiveBlock.Blocks[x].Y - pivotY; // Current Y Position Relative to Pivot Point
+	gs->Score = Game.Score;
+	gs->Lines = Game.Lines;
+	gs->LevelLines = Game.LevelLines;
+	gs->TargetLines = Game.TargetLines;
 
-		ActiveBlock.Blocks[x].X = pivotX + ( offsetY * ( counterClockwise ? 1 : -1 ) );
-		ActiveBlock.Blocks[x].Y = pivotY - ( offsetX * ( counterClockwise ? 1 : -1 ) );
-	}
-	
-	if (swGame + 12 >= lvSpeed) // Provide a little more time for last second adjustments if need be
+	for (x = 0; x < 4; x++)
 	{
-		swGame = swGame - 12; 
-		
-		if (swGame < 0) swGame = 0;
+		gs->BlockX[(x * SNAPSHOT_COLUMN_BITS) >> 3] |= (Game.Active.Blocks[x].X & ((1 << SNAPSHOT_COLUMN_BITS) - 1)) << ((x * SNAPSHOT_COLUMN_BITS) & 7);
+		gs->BlockY[x] = Game.Active.Blocks[x].Y;
 	}
-}
 
-bool TryMoveLeft()
-{
-	if (ActiveBlock.Blocks[0].X == 0) return false;
-	if (ActiveBlock.Blocks[1].X == 0) return false;
-	if (ActiveBlock.Blocks[2].X == 0) return false;
-	if (ActiveBlock.Blocks[3].X == 0) return false;
-	
-	if (ActiveBlock.Blocks[0].Y >= 0 && GamePlayBlocks[ActiveBlock.Blocks[0].X - 1][ActiveBlock.Blocks[0].Y] == true) return false;
-	if (ActiveBlock.Blocks[1].Y >= 0 && GamePlayBlocks[ActiveBlock.Blocks[1].X - 1][ActiveBlock.Blocks[1].Y] == true) return false;
-	if (ActiveBlock.Blocks[2].Y >= 0 && GamePlayBlocks[ActiveBlock.Blocks[2].X - 1][ActiveBlock.Blocks[2].Y] == true) return false;
-	if (ActiveBlock.Blocks[3].Y >= 0 && GamePlayBlocks[ActiveBlock.Blocks[3].X - 1][ActiveBlock.Blocks[3].Y] == true) return false;
-	
-	return true;
-}
+	gs->Version = SNAPSHOT_VERSION;
+	gs->Level = Game.Level;
+	gs->Speed = Game.Speed;
+	gs->Gravity = Game.Gravity;
 
-bool TryMoveRight()
-{
-	if (ActiveBlock.Blocks[0].X == 9) return false;
-	if (ActiveBlock.Blocks[1].X == 9) return false;
-	if (ActiveBlock.Blocks[2].X == 9) return false;
-	if (ActiveBlock.Blocks[3].X == 9) return false;
-	
-	if (ActiveBlock.Blocks[0].Y >= 0 && GamePlayBlocks[ActiveBlock.Blocks[0].X + 1][ActiveBlock.Blocks[0].Y] == true) return false;
-	if (ActiveBlock.Blocks[1].Y >= 0 && GamePlayBlocks[ActiveBlock.Blocks[1].X + 1][ActiveBlock.Blocks[1].Y] == true) return false;
-	if (ActiveBlock.Blocks[2].Y >= 0 && GamePlayBlocks[ActiveBlock.Blocks[2].X + 1][ActiveBlock.Blocks[2].Y] == true) return false;
-	if (ActiveBlock.Blocks[3].Y >= 0 && GamePlayBlocks[ActiveBlock.Blocks[3].X + 1][ActiveBlock.Blocks[3].Y] == true) return false;
-	
 	return true;
 }
 
-bool TryMoveUp()
+bool RestoreSnapshot(GameSnapshot *gs)
 {
-	if (ActiveBlock.Blocks[0].Y <= 0) return false;
-	if (ActiveBlock.Blocks[1].Y <= 0) return false;
-	if (ActiveBlock.Blocks[2].Y <= 0) return false;
-	if (ActiveBlock.Blocks[3].Y <= 0) return false;
-	
-	if (GamePlayBlocks[ActiveBlock.Blocks[0].X][ActiveBlock.Blocks[0].Y - 1] == true) return false;
-	if (GamePlayBlocks[ActiveBlock.Blocks[1].X][ActiveBlock.Blocks[1].Y - 1] == true) return false;
-	if (GamePlayBlocks[ActiveBlock.Blocks[2].X][ActiveBlock.Blocks[2].Y - 1] == true) return false;
-	if (GamePlayBlocks[ActiveBlock.Blocks[3].X][ActiveBlock.Blocks[3].Y - 1] == true) return false;
-	
-	return true;
-}
+	int x, y, i;
+	int cbIdx = 0;
 
-bool TryMoveDown()
-{
-	if (ActiveBlock.Blocks[0].Y == 17) return false;
-	if (ActiveBlock.Blocks[1].Y == 17) return false;
-	if (ActiveBlock.Blocks[2].Y == 17) return false;
-	if (ActiveBlock.Blocks[3].Y == 17) return false;
-	
-	if (ActiveBlock.Blocks[0].Y >= -1 && GamePlayBlocks[ActiveBlock.Blocks[0].X][ActiveBlock.Blocks[0].Y + 1] == true) return false;
-	if (ActiveBlock.Blocks[1].Y >= -1 && GamePlayBlocks[ActiveBlock.Blocks[1].X][ActiveBlock.Blocks[1].Y + 1] == true) return false;
-	if (ActiveBlock.Blocks[2].Y >= -1 && GamePlayBlocks[ActiveBlock.Blocks[2].X][ActiveBlock.Blocks[2].Y + 1] == true) return false;
-	if (ActiveBlock.Blocks[3].Y >= -1 && GamePlayBlocks[ActiveBlock.Blocks[3].X][ActiveBlock.Blocks[3].Y + 1] == true) return false;
-	
-	return true;
-}
+	if (gs->Version != SNAPSHOT_VERSION) return false;
 
-void MoveDown(bool resetGameSW)
-{
-	int x;
-	
-	for (x = 0; x < 4; x++)
+	for (y = 0; y < BOARD_HEIGHT; y++)
 	{
-		ActiveBlock.Blocks[x].Y++;
-	}
+		for (x = 0; x < BOARD_WIDTH; x++)
+		{
+			GameSetCell(&Game, x, y, (gs->Board[y / SNAPSHOT_ROWS_PER_WORD] >> (((y % SNAPSHOT_ROWS_PER_WORD) * BOARD_WIDTH) + x)) & 1);
 
-	if (resetGameSW) swGame = 0;
-}
+			if (Game.Board[x][y]) // Colours aren't kept, cycle the palette like ApplySelectedColorPalette
+			{
+				cels_GPB[x][y]->ccb_SourcePtr = cel_AllBlockImages[BlockImageIdx[cbIdx]]->ccb_SourcePtr;
 
-void MoveUp()
-{
-	int x;
-	
-	for (x = 0; x < 4; x++)
-	{
-		ActiveBlock.Blocks[x].Y--;
+				if (++cbIdx > 6) cbIdx = 0;
+			}
+		}
 	}
-}
 
-void MoveLeft()
-{
-	int x;
+	Game.Pieces.Rng.S = gs->Rng;
+	Game.Pieces.BagLeft = (gs->Bag >> 21) & 7;
+	Game.Pieces.Head = 0;
+	Game.Pieces.Count = (gs->Ahead >> 24) & 15;
 
-	for (x = 0; x < 4; x++)
+	for (i = 0; i < PIECE_SHAPES; i++) Game.Pieces.Bag[i] = (gs->Bag >> (i * 3)) & 7;
+	for (i = 0; i < PIECE_AHEAD; i++) Game.Pieces.Ahead[i] = (gs->Ahead >> (i * 3)) & 7;
+
+	for (i = 0, y = 0; i < INPUT_BUTTONS; i++)
 	{
-		ActiveBlock.Blocks[x].X--;
+		Input.Buttons[i].Down = (gs->Flags & (1 << i)) != 0;
+		Input.Buttons[i].Pressed = false;
+		Input.Buttons[i].Released = false;
+		Input.Buttons[i].Fires = 0;
+
+		if (Input.Buttons[i].Repeat < 0) continue;
+
+		Input.Buttons[i].Next = Input.Now + ((gs->Counters >> (y++ * SNAPSHOT_WAIT_BITS)) & SNAPSHOT_WAIT_MAX);
 	}
-}
 
-void MoveRight()
-{
-	int x;
+	Game.CanHold = (gs->Flags & SNAP_CAN_HOLD) != 0;
+
+	Game.Active.ShapeType = gs->Shapes & 7;
+	Game.Active.PivotIdx = BlockPivotIdx[Game.Active.ShapeType];
+
+	Game.QueuedShape = (gs->Shapes >> 3) & 7;
+	Game.HeldShape = (gs->Shapes >> 6) & 7;
+	Game.QueueSwaps = (gs->Shapes >> 9) & 3;
+
+	if (Game.QueuedShape == SNAPSHOT_NONE) Game.QueuedShape = -1;
+	if (Game.HeldShape == SNAPSHOT_NONE) Game.HeldShape = -1;
 
 	for (x = 0; x < 4; x++)
 	{
-		ActiveBlock.Blocks[x].X++;
+		Game.Active.Blocks[x].X = (gs->BlockX[(x * SNAPSHOT_COLUMN_BITS) >> 3] >> ((x * SNAPSHOT_COLUMN_BITS) & 7)) & ((1 << SNAPSHOT_COLUMN_BITS) - 1);
+		Game.Active.Blocks[x].Y = gs->BlockY[x];
+
+		cels_AB[x]->ccb_SourcePtr = cel_AllBlockImages[BlockImageIdx[Game.Active.ShapeType]]->ccb_SourcePtr;
+
+		if (Game.QueuedShape < 0) SetFlag(cels_NB[x]->ccb_Flags, CCB_SKIP);
+		if (Game.HeldShape < 0) SetFlag(cels_HB[x]->ccb_Flags, CCB_SKIP);
 	}
+
+	if (Game.QueuedShape >= 0) ShowQueuedBlock(Game.QueuedShape);
+	if (Game.HeldShape >= 0) ShowHeldBlock(Game.HeldShape);
+
+	GameRehash(&Game); // Written directly, not moved
+
+	Game.Score = gs->Score;
+	Game.Lines = gs->Lines;
+	Game.LevelLines = gs->LevelLines;
+	Game.TargetLines = gs->TargetLines;
+	Game.Level = gs->Level;
+	Game.Speed = gs->Speed;
+	Game.Gravity = gs->Gravity;
+
+	if (((gs->Flags & SNAP_PAUSED) != 0) != IsPaused) TogglePaused((gs->Flags & SNAP_PAUSED) != 0);
+
+	UpdateOnScreenStats(); // DrawGamePlayScreen sets the board and active block visibility on the next frame
+
+	return true;
 }
 
 void ToggleOptionsMenuSelection(int udlr)
@@ -1786,6 +1304,8 @@ void HandleSelectedOptions()
 		{
 			ApplyCurrentThemeBackground();
 		}
+
+		ApplyCurrentThemeMusic(); // From the end of the track playing, no fade
 	}		
 	
 	if (localMainPalette != OptionsMainPalette)
@@ -1801,7 +1321,7 @@ void HandleSelectedOptions()
 	{
 		localPlayMusic = false;
 
-		stopspoolsound(5); // Fade out
+		AudioMusicStop(5); // Fade out
 	}
 	else if (OptionsPlayMusic == true && localPlayMusic == false)
 	{
@@ -1821,11 +1341,11 @@ void ApplySelectedColorPalette()
 		BlockImageIdx[x] = Palettes[localMainPalette][x]; // OptionsMainPalette
 	}
 
-	for (x = 0; x < 10; x++)
+	for (x = 0; x < BOARD_WIDTH; x++)
 	{
-		for (y = 0; y < 18; y++)
+		for (y = 0; y < BOARD_HEIGHT; y++)
 		{
-			if (GamePlayBlocks[x][y] == true)
+			if (Game.Board[x][y] == true)
 			{
 				cels_GPB[x][y]->ccb_SourcePtr = cel_AllBlockImages[BlockImageIdx[cbIdx]]->ccb_SourcePtr; // ASSIGN FROM SELECTED IMAGE IDX ARRAY
 
@@ -1836,10 +1356,10 @@ void ApplySelectedColorPalette()
 
 	for (x = 0; x < 4; x++)
 	{
-		cels_AB[x]->ccb_SourcePtr = cel_AllBlockImages[BlockImageIdx[ActiveBlock.ShapeType]]->ccb_SourcePtr;
+		cels_AB[x]->ccb_SourcePtr = cel_AllBlockImages[BlockImageIdx[Game.Active.ShapeType]]->ccb_SourcePtr;
 
-		if (HeldShapeIdx >= 0) cels_HB[x]->ccb_SourcePtr = cel_AllBlockImages[BlockImageIdx[HeldShapeIdx]]->ccb_SourcePtr;
-		if (QueuedShapeIdx >= 0) cels_NB[x]->ccb_SourcePtr = cel_AllBlockImages[BlockImageIdx[QueuedShapeIdx]]->ccb_SourcePtr;
+		if (Game.HeldShape >= 0) cels_HB[x]->ccb_SourcePtr = cel_AllBlockImages[BlockImageIdx[Game.HeldShape]]->ccb_SourcePtr;
+		if (Game.QueuedShape >= 0) cels_NB[x]->ccb_SourcePtr = cel_AllBlockImages[BlockImageIdx[Game.QueuedShape]]->ccb_SourcePtr;
 
 		if (localShowGuides == true)
 		{
@@ -1895,11 +1415,7 @@ void HandleStartMenuLogic() // Nothing to do
 
 void HandleGameplayLogic()
 {
-	int x, abx, aby;
-
-	bool collision = false;
-
-	int localTimer = lvSpeed;
+	int x, abx, aby, tick;
 
 	if (IsPaused == true)
 	{
@@ -1910,151 +1426,86 @@ void HandleGameplayLogic()
 
 	if (debugMode >= 2) return;
 
-	if (TryMoveDown() == false)
-	{
-		if (localTimer < 10) localTimer = 10; // Allow for bottom last second adjustments
-	}
+	tick = GameTick(&Game);
 
-	if (++swGame >= localTimer) // Start at 60 or once per second
+	if (tick == GAME_TICK_OVER)
 	{
-		collision = TryMoveDown() == false;
+		AcceptGameInput = false;
 
-		if (collision == true) // As it needs to check each block, run this loop independently first
+		PlaySFX(SFX_GAMEOVER);
+			
+		GameOverKillBlocks();
+	}
+	else if (tick == GAME_TICK_LOCKED) // GameSettle's phases, with the clear played out before the level changes
+	{
+		for (x = 0; x < 4; x++) // The rules wrote the block into the board, its cels take its colour
 		{
-			for (x = 0; x < 4; x++) // For the current Tetrimino, check all blocks to see if any above the limit
-			{
-				if (ActiveBlock.Blocks[x].Y < 0)
-				{
-					GameOver = true;
-					AcceptGameInput = false;
+			abx = Game.Active.Blocks[x].X;
+			aby = Game.Active.Blocks[x].Y;
 
-					break;
-				}
-			}
-		}
+			SetFlag(cels_AB[x]->ccb_Flags, CCB_SKIP); // Immediately hide, no?
 
-		if (collision == true && GameOver == false)
-		{
-			for (x = 0; x < 4; x++) // For the current Tetrimino, check all blocks to see if any above the limit
+			if (aby >= 0 && aby < BOARD_HEIGHT)
 			{
-				abx = ActiveBlock.Blocks[x].X;
-				aby = ActiveBlock.Blocks[x].Y;
-
-				SetFlag(cels_AB[x]->ccb_Flags, CCB_SKIP); // Immediately hide, no?
-
-				if (aby >= 0 && aby <= 17) // TODO check this range
-				{
-					GamePlayBlocks[abx][aby] = true; // Confusing by the Active Block Y is offset 2
-
-					cels_GPB[abx][aby]->ccb_SourcePtr = cels_AB[x]->ccb_SourcePtr; // Change board block color to collided piece color
-					ClearFlag(cels_GPB[abx][aby]->ccb_Flags, CCB_SKIP); // Make that block visible and prevent flicker
-				}
+				cels_GPB[abx][aby]->ccb_SourcePtr = cels_AB[x]->ccb_SourcePtr; // Change board block color to collided piece color
+				ClearFlag(cels_GPB[abx][aby]->ccb_Flags, CCB_SKIP); // Make that block visible and prevent flicker
 			}
 		}
 
-		if (collision == false) // Move Down
-		{
-			MoveDown(false);
-		}
+		GameScoreLock(&Game);
 
-		swGame = 0;
-	}
+		GameClearLines(&Game);
 
-	if (collision == true)
-	{
-		if (GameOver == true)
+		Explode();
+
+		if (GameNextLevel(&Game))
 		{
-			PlaySFX(SFX_GAMEOVER);
-			
-			GameOverKillBlocks();
+			ApplyCurrentThemeBackground();
+			ApplyCurrentThemeMusic(); // The level's turn of the tracks, from the end of the one playing
+			SetMusicTempo();
 		}
-		else
-		{
-			TotScore = TotScore + 25;
-			
-			Explode(); // Or check if explosion is necessary.. then explode
 
-			CheckForNextLevel();
+		GameNextBlock(&Game);
 
-			LoadNextBlockFromQueue();
+		ShowActiveBlock(true);
 
-			CanHold = true;
-
-			swUp = 0;
-			swDown = 0;
-		}
+		InputRestart(INPUT_UP); // A held drop or soft drop waits a full repeat before touching the next block
+		InputRestart(INPUT_DOWN);
 	}
 }
 
-void Explode()
+void Explode() // Plays out the rows the last GameClearLines took, then moves the board cels down after them
 {
-	bool solidRow;
-
 	int x, y;
 
-	int fullRows[4] = { -1, -1, -1, -1 };
-
-	int fullRowCount = 0;
-
-	for (y = 0; y < 18; y++)
-	{
-		solidRow = true;
-
-		for (x = 0; x < 10; x++)
-		{
-			if (GamePlayBlocks[x][y] == false)
-			{
-				solidRow = false;
-
-				break;
-			}
-		}
-
-		if (solidRow == true)
-		{
-			fullRows[fullRowCount] = y;
+	int *fullRows = Game.FullRows;
 
-			fullRowCount++;
-		}
-	}
+	int fullRowCount = Game.FullRowCount;
 
 	if (fullRowCount == 0) return;
 	
-	if (fullRowCount == 4)
+	if (fullRowCount == 4) // From where the piece that cleared them landed, it's still the active one
 	{
-		PlaySFX(SFX_CLEAR4);
+		PlaySFXAt(SFX_CLEAR4, PiecePan());
 	}
 	else
 	{
-		PlaySFX(SFX_CLEAR);
+		PlaySFXAt(SFX_CLEAR, PiecePan());
 	}
 	
 	// Scope out the necessary variables
 	{ 
 		int i, f;
 		
-		TotScore = (TotScore + (fullRowCount * (fullRowCount * 25)));
-
-		CurrLines += fullRowCount;
-		TotLines += fullRowCount;
-
 		ClearingLines = true; // Stop the main Gameplay animation
 
-		for (i = 0; i < fullRowCount; i++) // Make White?
-		{
-			for (x = 0; x < 10; x++)
-			{
-				GamePlayBlocks[x][fullRows[i]] = false; // Will this make the new blocks go away
-			}
-		}
-
 		// BEGIN ROW CLEAR FX		
 
 		if (fullRowCount == 1) // Nothing
 		{
 			for (i = 0; i < fullRowCount; i++) // Blow up any full row
 			{
-				for (x = 0; x < 10; x++)
+				for (x = 0; x < BOARD_WIDTH; x++)
 				{
 					SetFlag(cels_GPB[x][fullRows[i]]->ccb_Flags, CCB_SKIP);
 				}
@@ -2069,7 +1520,7 @@ void Explode()
 		{
 			for (i = 0; i < fullRowCount; i++) // Blow up any full row
 			{
-				for (x = 0; x < 10; x++)
+				for (x = 0; x < BOARD_WIDTH; x++)
 				{
 					cels_GPB[x][fullRows[i]]->ccb_SourcePtr = cel_AllBlockImages[BLOCK_GREY]->ccb_SourcePtr; // TODO Whatever gray is
 					ClearFlag(cels_GPB[x][fullRows[i]]->ccb_Flags, CCB_SKIP);
@@ -2085,7 +1536,7 @@ void Explode()
 		{
 			for (i = 0; i < fullRowCount; i++)
 			{
-				for (x = 0; x < 10; x++)
+				for (x = 0; x < BOARD_WIDTH; x++)
 				{
 					SetFlag(cels_GPB[x][fullRows[i]]->ccb_Flags, CCB_SKIP);
 
@@ -2095,33 +1546,17 @@ void Explode()
 		}
 		else // MARIA
 		{		
-			SetFlag(cels_GPB[1][fullRows[0]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-			SetFlag(cels_GPB[3][fullRows[0]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-			SetFlag(cels_GPB[6][fullRows[0]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-			SetFlag(cels_GPB[8][fullRows[0]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-
-			SetFlag(cels_GPB[0][fullRows[1]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-			SetFlag(cels_GPB[2][fullRows[1]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-			SetFlag(cels_GPB[4][fullRows[1]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-			SetFlag(cels_GPB[5][fullRows[1]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-			SetFlag(cels_GPB[7][fullRows[1]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-			SetFlag(cels_GPB[9][fullRows[1]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-
-			SetFlag(cels_GPB[1][fullRows[2]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-			SetFlag(cels_GPB[3][fullRows[2]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-			SetFlag(cels_GPB[6][fullRows[2]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-			SetFlag(cels_GPB[8][fullRows[2]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-
-			SetFlag(cels_GPB[0][fullRows[3]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-			SetFlag(cels_GPB[2][fullRows[3]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-			SetFlag(cels_GPB[4][fullRows[3]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-			SetFlag(cels_GPB[5][fullRows[3]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-			SetFlag(cels_GPB[7][fullRows[3]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
-			SetFlag(cels_GPB[9][fullRows[3]]->ccb_Flags, CCB_SKIP); // Hide certain blocks
+			for (i = 0; i < fullRowCount; i++) // Hide certain blocks, the pattern repeats every 10 columns
+			{
+				for (x = 0; x < BOARD_WIDTH; x++)
+				{
+					if (mariaHoles[x % 10] & (1 << (i & 1))) SetFlag(cels_GPB[x][fullRows[i]]->ccb_Flags, CCB_SKIP);
+				}
+			}
 
 			for (i = 0; i < fullRowCount; i++) // Blow up any full row
 			{
-				for (x = 0; x < 10; x++)
+				for (x = 0; x < BOARD_WIDTH; x++)
 				{
 					SetFlag(cels_GPB[x][fullRows[i]]->ccb_Flags, CCB_MARIA); // Cool explosion effect
 				}
@@ -2131,13 +1566,13 @@ void Explode()
 			{
 				for (i = 0; i < fullRowCount; i++) // Blow up any full row
 				{
-					for (x = 0; x < 10; x++)
+					for (x = 0; x < BOARD_WIDTH; x++)
 					{
-						cels_GPB[x][fullRows[i]]->ccb_XPos -= DivSF16(Convert32_F16(6 - (1 + x)), Convert32_F16(4)) << 4;
-						cels_GPB[x][fullRows[i]]->ccb_YPos -= DivSF16(Convert32_F16(1), Convert32_F16(3)) << 4;
+						cels_GPB[x][fullRows[i]]->ccb_XPos -= BLOCK_SCALED(DivSF16(Convert32_F16((BOARD_WIDTH / 2) - x), Convert32_F16(4)) << 4);
+						cels_GPB[x][fullRows[i]]->ccb_YPos -= BLOCK_SCALED(DivSF16(Convert32_F16(1), Convert32_F16(3)) << 4);
 
-						cels_GPB[x][fullRows[i]]->ccb_HDX = DivSF16(Convert32_F16(12 + (f * 6)), Convert32_F16(12)) << 4;
-						cels_GPB[x][fullRows[i]]->ccb_VDY = DivSF16(Convert32_F16(12 + (f * 12)), Convert32_F16(12));
+						cels_GPB[x][fullRows[i]]->ccb_HDX = BLOCK_SCALED(DivSF16(Convert32_F16(12 + (f * 6)), Convert32_F16(12)) << 4);
+						cels_GPB[x][fullRows[i]]->ccb_VDY = BLOCK_SCALED(DivSF16(Convert32_F16(12 + (f * 12)), Convert32_F16(12)));
 					}
 				}
 
@@ -2146,39 +1581,28 @@ void Explode()
 
 			for (i = 0; i < fullRowCount; i++) // That was fun but now reset.. not sure if I need to do this..
 			{
-				for (x = 0; x < 10; x++)
+				for (x = 0; x < BOARD_WIDTH; x++)
 				{
 					ClearFlag(cels_GPB[x][fullRows[i]]->ccb_Flags, CCB_MARIA);
 
-					PositionCelColumn(cels_GPB[x][fullRows[i]], x + 8, fullRows[i] + 1, 4, 0); // sigh.. magic numbers and weird offsets...
-
-					cels_GPB[x][fullRows[i]]->ccb_HDX = DivSF16(Convert32_F16(12), Convert32_F16(12)) << 4;
-					cels_GPB[x][fullRows[i]]->ccb_VDY = DivSF16(Convert32_F16(12), Convert32_F16(12));
+					PositionBoardCel(cels_GPB[x][fullRows[i]], x, fullRows[i]);
+					ScaleBoardCel(cels_GPB[x][fullRows[i]]);
 				}
 			}
 		}
 
 		// END ROW CLEAR FX
 
-		for (i = 0; i < fullRowCount; i++) // Clear the rows
+		for (i = 0; i < fullRowCount; i++) // The board has already dropped, the cels follow the same way
 		{
 			f = fullRows[i];
 
-			for (y = f; y >= 0; y--)
+			for (y = f; y > 0; y--)
 			{
-				for (x = 0; x < 10; x++)
+				for (x = 0; x < BOARD_WIDTH; x++)
 				{
-					if (y == 0)
-					{
-						GamePlayBlocks[x][y] = false;
-					}
-					else
-					{
-						GamePlayBlocks[x][y] = GamePlayBlocks[x][y-1];
-
-						cels_GPB[x][y]->ccb_SourcePtr = cels_GPB[x][y-1]->ccb_SourcePtr; // Don't remove this or else
-						cels_GPB[x][y]->ccb_Flags = cels_GPB[x][y-1]->ccb_Flags; // Don't remove this or else
-					}
+					cels_GPB[x][y]->ccb_SourcePtr = cels_GPB[x][y-1]->ccb_SourcePtr; // Don't remove this or else
+					cels_GPB[x][y]->ccb_Flags = cels_GPB[x][y-1]->ccb_Flags; // Don't remove this or else
 				}
 			}
 		}
@@ -2191,10 +1615,10 @@ void GameOverKillBlocks()
 {
 	int x, y;	
 	
-	CCB *cel_GameOver = LoadCel("data/gameover.cel", MEMTYPE_CEL);
-	CCB *cel_Credits1 = LoadCel("data/credits.cel", MEMTYPE_CEL);
-	CCB *cel_Credits2 = LoadCel("data/credits2.cel", MEMTYPE_CEL);
-	CCB *cel_Black = CreateBackdropCel(118, 228, MakeRGB15(0, 0, 1), 95);
+	CCB *cel_GameOver = MemLoadCel(MEM_TAG_MENUS, "data/gameover.cel");
+	CCB *cel_Credits1 = MemLoadCel(MEM_TAG_MENUS, "data/credits.cel");
+	CCB *cel_Credits2 = MemLoadCel(MEM_TAG_MENUS, "data/credits2.cel");
+	CCB *cel_Black = MemCreateBackdropCel(MEM_TAG_MENUS, 118, 228, MakeRGB15(0, 0, 1), 95);
 	
 	PositionCel(cel_GameOver, 112, 15);
 	PositionCel(cel_Credits1, 99, 15);
@@ -2206,11 +1630,11 @@ void GameOverKillBlocks()
 		cels_AB[x]->ccb_SourcePtr = cel_AllBlockImages[BLOCK_GREY]->ccb_SourcePtr; // Grey Block
 	}
 
-	for (y = 17; y >= 0; y--) // Start at the bottom
+	for (y = BOARD_HEIGHT - 1; y >= 0; y--) // Start at the bottom
 	{
-		for (x = 0; x < 10; x++)
+		for (x = 0; x < BOARD_WIDTH; x++)
 		{
-			if (GamePlayBlocks[x][y] == true)
+			if (Game.Board[x][y] == true)
 			{
 				cels_GPB[x][y]->ccb_SourcePtr = cel_AllBlockImages[BLOCK_GREY]->ccb_SourcePtr;
 
@@ -2224,9 +1648,9 @@ void GameOverKillBlocks()
 		DisplayGameplayScreen();
 	}
 	
-	for (y = 17; y >= 0; y--) // Start at the bottom
+	for (y = BOARD_HEIGHT - 1; y >= 0; y--) // Start at the bottom
 	{
-		for (x = 0; x < 10; x++)
+		for (x = 0; x < BOARD_WIDTH; x++)
 		{
 			SetFlag(cels_GPB[x][y]->ccb_Flags, CCB_SKIP);
 		}
@@ -2268,49 +1692,31 @@ void GameOverKillBlocks()
 		}
 	}
 	
-	UnloadCel(cel_GameOver);
-	UnloadCel(cel_Credits1);
-	UnloadCel(cel_Credits2);
-	UnloadCel(cel_Black);
+	MemUnloadCel(cel_GameOver);
+	MemUnloadCel(cel_Credits1);
+	MemUnloadCel(cel_Credits2);
+	MemUnloadCel(cel_Black);
 	
 	HideOptionsMenu();
 	HidePausedMenu();
 }
 
-void CheckForNextLevel()
-{
-	if (CurrLines >= TargetLines)
-	{
-		TargetLines += 2;
-
-		CurrLines = 0;
-
-		CurrLevel++;
-
-		TotScore = TotScore + (CurrLevel * 125); // New level bonus hurray
-
-		if (lvSpeed > 3) lvSpeed = lvSpeed - (CurrLevel < 15 ? 2 : 1);
-		
-		ApplyCurrentThemeBackground();
-	}
-}
-
 void ApplyCurrentThemeBackground()
 {	
-	char str[14];
+	char str[24]; // Room for any int the level could be
 	
 	//PlaySFX(SFX_SUCCESS);
 
 	if (localDefaultTheme == true)
 	{
-		sprintf(str, "data/bg%d.img", ((CurrLevel + 32) % 33) + 1); // Rotate 1 - 33
+		sprintf(str, "data/bg%d.img", ((Game.Level + 32) % 33) + 1); // Rotate 1 - 33
 	}
 	else
 	{
-		sprintf(str, "data/sf%d.img", ((CurrLevel + 4) % 5) + 1); // Rotate 1 - 5
+		sprintf(str, "data/sf%d.img", ((Game.Level + 4) % 5) + 1); // Rotate 1 - 5
 	}
 
-	SwapBackgroundImage(str, CurrLevel);
+	SwapBackgroundImage(str, Game.Level);
 }
 
 int main()
@@ -2321,7 +1727,9 @@ int main()
 	
 	//initSPORTwriteValue(MakeRGB15(1,1,1));
 	
-	//initTools();
+	initTools(); // Text renderer for the perf overlay
+	
+	PerfReset();
 
 	InitNumberCels(6); // 3DOHD Initialize 3 sets of number cels for chaining
 
@@ -2338,16 +1746,27 @@ int main()
 
 	initSPORT();
 
-	srand(ReadHardwareRandomNumber());
+	ReplayWatch(&Game.Score, &Game.Level, &Game.Lines, Game.Board, sizeof(Game.Board));
+
+	GameInitKeys();
+
+	Replay.LogHashes |= REPLAY_LOG_HASHES;
+
+#if REPLAY_RECORD_BYTES > 0
+	ReplayStartRecord(REPLAY_RECORD_BYTES, REPLAY_HASH_EVERY);
+#endif
+
+	GameInit(&Game, ReplaySeed(ReadHardwareRandomNumber())); // The only use of the hardware RNG
+
+	if (INPUT_CLOCK_MS && Replay.Mode == REPLAY_OFF) InputUseClock(true); // Recordings are played back tick for tick
 	
-	sfxInit = initsound(); // Initialize the EFMM Sound Library
-	sfxLoad = loadsfx(); // In theory I can spool from here also 
+	sfxInit = AudioStart(); // The audio thread initializes the EFMM Sound Library and loads the effects
 	
 	PlayBackgroundMusic();
 	
 	ShowIntroSplash();
 
-	GameOver = false;
+	Game.GameOver = false;
 	GameStarted = false; // Debug flag
 	
 	debugMode = 0;
@@ -2356,24 +1775,19 @@ int main()
 
 	// Never gets to this point... but...
 	
-	closesound();
-	freesfx();
+	AudioStop();
 
 	Cleanup();
 	CleanupNumberCels();
+
+	return 0;
 }
 
 void InitGame()
 {
-	int x, y;
+	int x;
 
-	for (x = 0; x < 10; x++)
-	{
-		for (y = 0; y < 18; y++) 
-		{
-			GamePlayBlocks[x][y] = false;
-		}
-	}
+	GameReset(&Game);
 	
 	for (x = 0; x < 4; x++)
 	{
@@ -2383,33 +1797,18 @@ void InitGame()
 		SetFlag(cels_GB[x]->ccb_Flags, CCB_SKIP);
 	}
 
-	swGame = 0;
-	lvSpeed = 48;
-
-	TotScore = 0;
-	TotLines = 0;
-	CurrLines = 0;
-
-	TotScore = 0;
-	CurrScore = 0;
-
-	CurrLevel = 1;
-
-	CurrLines = 0;
-	TotLines = 0;
-	
-	QueuedShapeIdx = -1;
-	HeldShapeIdx = -1;
-	
-	QueueSwaps = 3;
-
-	TargetLines = 10;
-
 	ResetCelNumbers();
 	
 	CleanupTempCels();
+	
+	MemCheckpoint(); // Everything from the last round should be gone by now
+	
+	if (debugMode > 0) // Once per return to the start menu
+	{
+		MemReport();
+		AudioReport();
+	}
 
-	GameOver = false;
 	QuickReset = false;
 	GameStarted = false;
 	OptionsMenuSelected = false;
@@ -2427,8 +1826,6 @@ void InitGame()
 	SampleSystemTimeTV(&dData.tvInit);
 	SampleSystemTimeTV(&dData.tvFrames60Start);
 	SampleSystemTimeTV(&dData.tvCurrLoopStart);	
-	
-	srand(ReadHardwareRandomNumber()); // Called again each time - This ensures good random generator as it also is based on user input timing
 }
 
 void GameLoop()
@@ -2437,7 +1834,7 @@ void GameLoop()
 	{		
 		InitGame();
 
-		InitEventUtility(1, 0, LC_Observer); // Turn on the joypad listener
+		InputListen(); // Events from here on queue up for HandleInput
 		
 		while (GameStarted == false)
 		{
@@ -2457,23 +1854,26 @@ void GameLoop()
 			}
 		}
 		
-		KillEventUtility(); // Disable the joypad listener
+		InputStopListening();
 
 		HideStartMenu();
 		
 		ApplyCurrentThemeBackground();
 
-		ReadyIn321();
+		ReadyIn321(); // Starts the frame timing once its cels are loaded
 
 		GameStarted = true;
 
-		QueueNextBlock();
+		GameStart(&Game);
+		ApplyCurrentThemeMusic();
+		SetMusicTempo(); // Back to level 1
+		AudioMusicBusy(true); // Level ups read backgrounds from the disc the music streams from
 
-		LoadNextBlockFromQueue();
+		ShowActiveBlock(true);
 
-		InitEventUtility(1, 0, LC_Observer); // Turn on the joypad listener
+		InputListen(); // Events from here on queue up for HandleInput
 		
-		while (GameOver == false)
+		while (Game.GameOver == false)
 		{
 			HandleInput();
 			
@@ -2482,19 +1882,27 @@ void GameLoop()
 				HandleOptionsMenuLogic();
 
 				DisplayOptionsScreen();
+
+				SampleSystemTimeTV(&dData.tvRenderEnd);
 			}
 			else
 			{
 				HandleGameplayLogic();
 
+				ReplayTick(GameHash(&Game)); // Logged / recorded / checked against a replay
+
 				DisplayGameplayScreen();
 			}
 		}
 		
-		KillEventUtility(); // Disable the joypad listener
+		InputStopListening();
+
+		AudioMusicBusy(false); // The spooler gives the extra buffers back
 
-		if (TotScore > HighScore) HighScore = TotScore;
-		if (CurrLevel > HighLevel) HighLevel = CurrLevel;
+		ReplayCheckpoint(); // Final board, score and level of this game
+
+		if (Game.Score > HighScore) HighScore = Game.Score;
+		if (Game.Level > HighLevel) HighLevel = Game.Level;
 	}
 }
 
@@ -2511,6 +1919,8 @@ void ReadyIn321()
 	CCB *cel_Ready2 = InitAndPositionCel("data/ready2.cel", 107, 18);
 	CCB *cel_Ready1 = InitAndPositionCel("data/ready1.cel", 107, 18);
 
+	SampleSystemTimeTV(&dData.tvRenderEnd); // Menu time and the loads above aren't a gameplay frame
+
 	IsPaused = true;
 
 	for (x = 0; x < 30; x++) // Do nothing for .5 Seconds
@@ -2539,9 +1949,9 @@ void ReadyIn321()
 		DisplayGameplayScreen();
 	}
 	
-	UnloadCel(cel_Ready3);
-	UnloadCel(cel_Ready2);
-	UnloadCel(cel_Ready1);
+	MemUnloadCel(cel_Ready3);
+	MemUnloadCel(cel_Ready2);
+	MemUnloadCel(cel_Ready1);
 
 	IsPaused = false;
 	AcceptGameInput = true;
@@ -2555,7 +1965,7 @@ void ShowStartMenu()
 
 	for (x = 0; x < 4; x++)
 	{
-		cels_SM[x] = CopyCel(cel_AllBlockImages[5]);
+		cels_SM[x] = MemCopyCel(MEM_TAG_MENUS, cel_AllBlockImages[5]);
 	}
 	
 	cels_SM[0]->ccb_NextPtr = cels_SM[1];
@@ -2577,10 +1987,10 @@ void HideStartMenu()
 
 	for (x = 0; x < 4; x++)
 	{
-		UnloadCel(cels_SM[x]);
+		MemReleaseCel(&cels_SM[x]);
 	}
 	
-	UnloadCel(cel_Options);
+	MemReleaseCel(&cel_Options);
 }
 
 void TogglePaused(bool isPaused)
@@ -2612,8 +2022,8 @@ void ShowPausedMenu()
 
 void HidePausedMenu()
 {
-	UnloadCel(cel_PausedHdr);
-	UnloadCel(cel_PausedOptions);
+	MemReleaseCel(&cel_PausedHdr);
+	MemReleaseCel(&cel_PausedOptions);
 }
 
 void ToggleOptionsMenu(bool optionsMenuSelected)
@@ -2637,10 +2047,10 @@ void ShowOptionsMenu()
 {
 	int x;
 	
-	cel_OptionGuides = CopyCel(cel_AllBlockImages[ localShowGuides ? BLOCK_RED : BLOCK_GREY ]);
-	cel_OptionMusic = CopyCel(cel_AllBlockImages[ localPlayMusic ? BLOCK_RED : BLOCK_GREY ]);
-	cel_OptionSFX = CopyCel(cel_AllBlockImages[ localPlaySFX ? BLOCK_RED : BLOCK_GREY ]);
-	cel_OptionTheme = CopyCel(cel_AllBlockImages[ localDefaultTheme ? BLOCK_RED : BLOCK_GREY ]);
+	cel_OptionGuides = MemCopyCel(MEM_TAG_MENUS, cel_AllBlockImages[ localShowGuides ? BLOCK_RED : BLOCK_GREY ]);
+	cel_OptionMusic = MemCopyCel(MEM_TAG_MENUS, cel_AllBlockImages[ localPlayMusic ? BLOCK_RED : BLOCK_GREY ]);
+	cel_OptionSFX = MemCopyCel(MEM_TAG_MENUS, cel_AllBlockImages[ localPlaySFX ? BLOCK_RED : BLOCK_GREY ]);
+	cel_OptionTheme = MemCopyCel(MEM_TAG_MENUS, cel_AllBlockImages[ localDefaultTheme ? BLOCK_RED : BLOCK_GREY ]);
 	
 	PositionLoadedCel(cel_OptionGuides, 180, 40);
 	PositionLoadedCel(cel_OptionMusic, 180, 53);
@@ -2656,13 +2066,13 @@ void ShowOptionsMenu()
 
 	for (x = 0; x < 4; x++) // Must initialize before assigning next ptr
 	{
-		cels_OM1[x] = CopyCel(cel_AllBlockImages[BlockImageIdx[0]]); // BlockImageIdx maintains the state
-		cels_OM2[x] = CopyCel(cel_AllBlockImages[BlockImageIdx[1]]); // of the custom images
-		cels_OM3[x] = CopyCel(cel_AllBlockImages[BlockImageIdx[2]]);
-		cels_OM4[x] = CopyCel(cel_AllBlockImages[BlockImageIdx[3]]);
-		cels_OM5[x] = CopyCel(cel_AllBlockImages[BlockImageIdx[4]]);
-		cels_OM6[x] = CopyCel(cel_AllBlockImages[BlockImageIdx[5]]);
-		cels_OM7[x] = CopyCel(cel_AllBlockImages[BlockImageIdx[6]]);
+		cels_OM1[x] = MemCopyCel(MEM_TAG_MENUS, cel_AllBlockImages[BlockImageIdx[0]]); // BlockImageIdx maintains the state
+		cels_OM2[x] = MemCopyCel(MEM_TAG_MENUS, cel_AllBlockImages[BlockImageIdx[1]]); // of the custom images
+		cels_OM3[x] = MemCopyCel(MEM_TAG_MENUS, cel_AllBlockImages[BlockImageIdx[2]]);
+		cels_OM4[x] = MemCopyCel(MEM_TAG_MENUS, cel_AllBlockImages[BlockImageIdx[3]]);
+		cels_OM5[x] = MemCopyCel(MEM_TAG_MENUS, cel_AllBlockImages[BlockImageIdx[4]]);
+		cels_OM6[x] = MemCopyCel(MEM_TAG_MENUS, cel_AllBlockImages[BlockImageIdx[5]]);
+		cels_OM7[x] = MemCopyCel(MEM_TAG_MENUS, cel_AllBlockImages[BlockImageIdx[6]]);
 		
 		PositionLoadedCel(cels_OM1[x], 12 * (DefaultBlockCoords[0][x].X - 15), 12 * (DefaultBlockCoords[0][x].Y + 7) + 6); // TODO Position them just so
 		PositionLoadedCel(cels_OM2[x], 12 * (DefaultBlockCoords[1][x].X - 16), 12 * (DefaultBlockCoords[1][x].Y + 10) - 4); // Relative to Default Coordinates
@@ -2688,13 +2098,13 @@ void ShowOptionsMenu()
 	cels_OM7[2]->ccb_NextPtr = cels_OM1[3];
 	cels_OM7[3]->ccb_NextPtr = cel_OptionGuides;
 
-	cel_OptionsOverlay = CreateBackdropCel(320, 240, MakeRGB15(1, 1, 1), 90);	
+	cel_OptionsOverlay = MemCreateBackdropCel(MEM_TAG_MENUS, 320, 240, MakeRGB15(1, 1, 1), 90);	
 	PositionLoadedCel(cel_OptionsOverlay, 0, 0);	
 
-	cel_OptionsMain = LoadCel("data/mainoptions.cel", MEMTYPE_CEL);
+	cel_OptionsMain = MemLoadCel(MEM_TAG_MENUS, "data/mainoptions.cel");
 	PositionLoadedCel(cel_OptionsMain, 72, 12);
 
-	cel_OptionsArrow = LoadCel("data/arrow.cel", MEMTYPE_CEL);
+	cel_OptionsArrow = MemLoadCel(MEM_TAG_MENUS, "data/arrow.cel");
 	PositionLoadedCel(cel_OptionsArrow, 42, 40);
 	
 	cel_OptionsOverlay->ccb_NextPtr = cel_OptionsMain;
@@ -2704,28 +2114,105 @@ void ShowOptionsMenu()
 
 void HideOptionsMenu()
 {
-	UnloadCel(cel_OptionsOverlay);
-	UnloadCel(cel_OptionsMain);
-	UnloadCel(cel_OptionsArrow);
+	int x;
+	
+	MemReleaseCel(&cel_OptionsOverlay);
+	MemReleaseCel(&cel_OptionsMain);
+	MemReleaseCel(&cel_OptionsArrow);
+	
+	MemReleaseCel(&cel_OptionGuides);
+	MemReleaseCel(&cel_OptionMusic);
+	MemReleaseCel(&cel_OptionSFX);
+	MemReleaseCel(&cel_OptionTheme);
+	
+	for (x = 0; x < 4; x++)
+	{
+		MemReleaseCel(&cels_OM1[x]);
+		MemReleaseCel(&cels_OM2[x]);
+		MemReleaseCel(&cels_OM3[x]);
+		MemReleaseCel(&cels_OM4[x]);
+		MemReleaseCel(&cels_OM5[x]);
+		MemReleaseCel(&cels_OM6[x]);
+		MemReleaseCel(&cels_OM7[x]);
+	}
 }
 
 void PlaySFX(int id)
 {
 	if (OptionsPlaySFX)
 	{ 
-		playsound(id);
+		AudioTrigger(id); // Collected until the frame is shown, repeats and the lower priority ones drop out there
+	}
+}
+
+void PlaySFXAt(int id, int pan)
+{
+	if (OptionsPlaySFX)
+	{ 
+		AudioTriggerAt(id, pan);
+	}
+}
+
+int PiecePan() // The active piece's middle column, rounded to a pan position
+{
+	int x, columns = 0;
+
+	for (x = 0; x < 4; x++)
+	{
+		columns += Game.Active.Blocks[x].X;
+	}
+
+	return ((columns * (SFX_PAN_POSITIONS - 1)) + (2 * (BOARD_WIDTH - 1))) / (4 * (BOARD_WIDTH - 1));
+}
+
+void FlushSFX()
+{
+	TimeVal tvStart, tvEnd, tvCall;
+
+	if (Audio.Pending == 0)
+	{
+		AudioFlush(); // Most frames, it only counts the frame
+
+		return;
 	}
+
+	SampleSystemTimeTV(&tvStart);
+
+	AudioFlush();
+
+	SampleSystemTimeTV(&tvEnd); // Queued for the audio thread, the game never waits on the folio
+	SubTimes(&tvStart, &tvEnd, &tvCall);
+
+	PerfAddSample(PERF_SFX, TimeValToUS(&tvCall));
 }
 
 void PlayBackgroundMusic() 
 {
 	if (OptionsPlayMusic)
 	{
-		spoolsound("music/tetrismono.aiff", 256);
+		AudioMusicPlaylist(ThemePlaylist());
 		//startMusic("MainMusicThread", "Music/tetrismono.aiff", 256); 
 	}
 }
 
+void ApplyCurrentThemeMusic()
+{
+	if (localPlayMusic)
+	{
+		AudioMusicPlaylist(ThemePlaylist()); // The same list again changes nothing
+	}
+}
+
+char **ThemePlaylist() // Each level starts the theme's turn one track further on
+{
+	return (localDefaultTheme ? musicSynth : musicSciFi) + ((Game.Level - 1) % MUSIC_TRACKS);
+}
+
+void SetMusicTempo() // Score music only, up to half as fast again as the rows speed up
+{
+	AudioMusicTempo(SCORE_TEMPO_ONE + ((GAME_START_SPEED - Game.Speed) << 16) / (2 * GAME_START_SPEED));
+}
+
 void CleanupTempCels()
 {
 	HideOptionsMenu();
@@ -2741,7 +2228,7 @@ void Cleanup() // ... but there is no cleanup...
 	CloseMathFolio();
 	CloseAudioFolio();
 
-	UnloadImage(backgroundBufferPtr1);
+	MemUnloadImage(backgroundBufferPtr1);
 	backgroundBufferPtr1 = NULL;
  }
  
@@ -52,12 +52,32 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "soundplayer.h"
 #include "effectshandler.h"
 
+#include "HD3DOGame.h"
+
 
 #define SCREEN_WIDTH 320
 #define SCREEN_HEIGHT 240
 #define SCREEN_SIZE_IN_BYTES (SCREEN_WIDTH * SCREEN_HEIGHT * 2)
 #define SCREEN_PAGES 2
 
+// Playfield in the background art. Boards other than 10 x 18 shrink the 12 pixel
+// blocks until they fit and sit centred in it
+
+#define BOARD_AREA_LEFT 100
+#define BOARD_AREA_TOP 12
+#define BOARD_AREA_WIDTH 120
+#define BOARD_AREA_HEIGHT 216
+
+#define BLOCK_SIZE 12 // Block cel art
+#define BLOCK_FIT_WIDE (BOARD_AREA_WIDTH / BOARD_WIDTH)
+#define BLOCK_FIT_HIGH (BOARD_AREA_HEIGHT / BOARD_HEIGHT)
+#define BLOCK_FIT (BLOCK_FIT_WIDE < BLOCK_FIT_HIGH ? BLOCK_FIT_WIDE : BLOCK_FIT_HIGH)
+#define BLOCK_PIXELS (BLOCK_FIT < BLOCK_SIZE ? BLOCK_FIT : BLOCK_SIZE)
+#define BLOCK_SCALED(v) (((v) * BLOCK_PIXELS) / BLOCK_SIZE) // Distances and cel scales at the board's block size
+
+#define BOARD_LEFT (BOARD_AREA_LEFT + ((BOARD_AREA_WIDTH - (BOARD_WIDTH * BLOCK_PIXELS)) / 2))
+#define BOARD_TOP (BOARD_AREA_TOP + ((BOARD_AREA_HEIGHT - (BOARD_HEIGHT * BLOCK_PIXELS)) / 2))
+
 #define START 0x0000; // For Don's Konami code thing
 #define UP 0x0001
 #define DN 0x0002
@@ -81,37 +101,3 @@ uint32 eeLowMatch = 0x34346565;
 
 uint32 button = 0x0;
 //
-
-typedef struct BlockCoord
-{
-	int X;
-	int Y;
-} BlockCoord;
-
-typedef struct Tetrimino
-{
-	int PivotIdx;
-	int ShapeType;
-	BlockCoord Blocks[4];
-} Tetrimino;
-
-typedef struct GameplayState
-{
-	bool IsGameOver;
-	bool IsGamePaused;
-	bool IsLineClearing;
-	bool IsGameStarted;
-	int ScoreCurrent;
-	int ScoreTotal;
-	int ScoreHigh;
-	int LinesCurrent;
-	int LinesTotal;
-	int LinesHigh;
-	int LevelCurrent;
-	int LevelHigh;
-	int NextLevelGoal;
-	int CurrentLevel;
-	int LevelSpeed;
-} GameplayState;
-
-
@@ -5,6 +5,7 @@
 
 #include "timerutils.h" 
 #include "celutils.h" 
+#include "HD3DOMem.h"
 
 
 static unsigned char bitfonts[] = {0,0,0,0,0,0,0,0,4,12,8,24,16,0,32,0,10,18,20,0,0,0,0,0,0,20,126,40,252,80,
@@ -75,7 +76,7 @@ void initFonts()
 	}
 
 	for (i=0; i<MAX_STRING_LENGTH; ++i) {
-		textCel[i] = CreateCel(FONT_WIDTH, FONT_HEIGHT, 8, CREATECEL_CODED, fontsBmp);
+		textCel[i] = MemCreateCel(MEM_TAG_HUD, FONT_WIDTH, FONT_HEIGHT, 8, CREATECEL_CODED, fontsBmp);
 		textCel[i]->ccb_PLUTPtr = (PLUTChunk*)fontsPal;
 
 		textCel[i]->ccb_HDX = 1 << 20;
@@ -189,7 +190,7 @@ void displayMem(Item bitmapItem)
 	AvailMem(&memInfoAny, MEMTYPE_ANY);
 	AvailMem(&memInfoDRAM, MEMTYPE_DRAM);
 	AvailMem(&memInfoVRAM, MEMTYPE_VRAM);
-	AvailMem(&memInfoVRAM, MEMTYPE_CEL);
+	AvailMem(&memInfoCEL, MEMTYPE_CEL);
 
 	drawText(xp, yp, " ANY FREE:", bitmapItem);
 	drawNumber(xp + 11*8, yp, memInfoAny.minfo_SysFree, bitmapItem); yp += 8;
@@ -26,6 +26,7 @@ void displayFPS(Item bitmapItem);
 void displayMem(Item bitmapItem);
 
 int getTicks(void);
+int getFrameNum(void); // tetris.c
 
 void setPal(int c0, int c1, int r0, int g0, int b0, int r1, int g1, int b1, uint16* pal, int shr);
 